@@ -0,0 +1,177 @@
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+#include "packet.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace altair {
+
+/// Budgets for client commands sent up the UART links. Tokens are bytes
+/// of wire time.
+struct AdmissionOptions {
+    /// Share of each link's capacity (baud / 10 bytes/s) client commands
+    /// may use together; the rest is left to the gateway's own traffic.
+    double                      uplink_share{0.1};
+    /// Share of that budget one client may use.
+    double                      client_share{0.25};
+    /// Share of each link's capacity the replies to range requests may
+    /// use together.
+    double                      downlink_share{1.0};
+    /// Reply bytes a range request is charged per day it asks for: a day
+    /// of one sample a minute, as the satellite logs them.
+    double                      range_day_bytes{1440 * 40};
+    /// Bucket depth, as time at the refill rate: how long a burst may be.
+    std::chrono::milliseconds   burst{1000};
+    /// Commands a client may have waiting; further ones are rejected.
+    size_t                      max_queued{8};
+};
+
+/// Counters since start; read with relaxed loads.
+struct AdmissionStats {
+    std::atomic<uint64_t> admitted{0};  ///< sent, at once or after waiting
+    std::atomic<uint64_t> queued{0};    ///< had to wait for tokens
+    std::atomic<uint64_t> rejected{0};  ///< refused: the client's queue was full
+    std::atomic<uint64_t> dropped{0};   ///< discarded while waiting (client left)
+};
+
+/// Refills at rate tokens per second, up to depth.
+struct TokenBucket {
+    using Clock = std::chrono::steady_clock;
+
+    double              rate{0};
+    double              depth{0};
+    double              tokens{0};
+    Clock::time_point   last{};
+
+    TokenBucket() = default;
+    TokenBucket(double rate_, double depth_, Clock::time_point now)
+        : rate(rate_), depth(depth_), tokens(depth_), last(now) {}
+
+    void refill(Clock::time_point now) {
+        double dt = std::chrono::duration<double>(now - last).count();
+        tokens = std::min(depth, tokens + dt * rate);
+        last   = now;
+    }
+
+    /// How long until cost tokens are available (zero if they are).
+    Clock::duration wait(double cost) const {
+        if (tokens >= cost) return Clock::duration::zero();
+        return std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>((cost - tokens) / rate));
+    }
+};
+
+/// Token-bucket admission of client commands to the satellite links.
+///
+/// Every link has a global bucket and every client one per link, so no
+/// client can take the whole uplink (and the satellite's logger task) for
+/// itself. A range request also costs the reply it will bring down, up to
+/// a full bucket, from a downlink bucket per link. A command that finds a
+/// bucket short waits in its client's queue, in order, and is sent by a
+/// pacing thread once the buckets have the tokens; clients take turns.
+/// Beyond max_queued waiting commands, the command is rejected.
+///
+/// Thread-safe.
+class CommandAdmission {
+public:
+
+    using Clock = TokenBucket::Clock;
+    using Send  = std::function<void(uint8_t sat, const Packet&)>;
+
+    enum class Verdict {
+        Sent,       ///< handed to send() at once
+        Queued,     ///< will be sent when the buckets allow
+        Rejected,   ///< the client has max_queued commands waiting
+    };
+
+    /// link_bytes_per_s gives each satellite's link capacity; send() is
+    /// called with every admitted command, on the caller's thread or the
+    /// pacing thread.
+    CommandAdmission(AdmissionOptions options, std::map<uint8_t, double> link_bytes_per_s,
+                     Send send);
+
+    /// Stops the pacing thread; commands still waiting are dropped.
+    ~CommandAdmission();
+
+    CommandAdmission(const CommandAdmission&) = delete;
+    CommandAdmission& operator=(const CommandAdmission&) = delete;
+
+    /// Admits, queues or rejects pkt from client for satellite sat, which
+    /// must be a known link. On rejection, retry_after (if given) is set
+    /// to when the client's queue should have room again.
+    Verdict submit(int client, uint8_t sat, const Packet& pkt,
+                   std::chrono::milliseconds* retry_after = nullptr);
+
+    /// Drops the client's buckets and waiting commands.
+    void forget(int client);
+
+    const AdmissionStats& stats() const { return stats_; }
+
+    /// Commands waiting for tokens, across clients.
+    size_t waiting();
+
+    const AdmissionOptions& options() const { return options_; }
+
+private:
+
+    struct Command {
+        uint8_t sat;
+        Packet  pkt;
+        double  cost;
+        double  reply_cost;
+    };
+
+    struct Client {
+        std::map<uint8_t, TokenBucket>  buckets;    ///< per link
+        std::deque<Command>             waiting;
+        double                          waiting_cost{0};
+        double                          waiting_reply_cost{0};
+    };
+
+    /// Expected reply bytes for pkt: range_day_bytes per day of a range
+    /// request, 0 for other commands.
+    double replyCost(const Packet& pkt) const;
+
+    /// Client's bucket for sat, created full.
+    TokenBucket& clientBucket(Client& c, uint8_t sat, Clock::time_point now);
+
+    /// Takes cost from both uplink buckets and reply_cost from the
+    /// downlink one if they have it; otherwise sets wait to how long until
+    /// they might.
+    bool tryTake(Client& c, uint8_t sat, double cost, double reply_cost,
+                 Clock::time_point now, Clock::duration& wait);
+
+    /// Pacing thread: sends waiting commands as tokens come in.
+    void paceLoop();
+
+private:
+
+    AdmissionOptions                    options_;
+    std::map<uint8_t, double>           link_rate_;     ///< command bytes/s per link
+    Send                                send_;
+    AdmissionStats                      stats_;
+
+    std::mutex                          mutex_;
+    std::condition_variable             cv_;
+    std::map<uint8_t, TokenBucket>      global_;
+    std::map<uint8_t, TokenBucket>      downlink_;
+    std::unordered_map<int, Client>     clients_;
+    int                                 last_served_{0};    ///< pacing turns go on after it
+    bool                                stopping_{false};
+    std::thread                         pacer_;
+};
+
+} // namespace altair
+
+#endif // ADMISSION_HPP
@@ -0,0 +1,85 @@
+#ifndef ASYNC_CONNECTION_HPP
+#define ASYNC_CONNECTION_HPP
+
+#include "coro.hpp"
+#include "eventloop.hpp"
+#include "packet.hpp"
+#include "protocol.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace altair {
+
+/// Coroutine counterpart of ClientConnection: a non-blocking TCP socket
+/// driven by an EventLoop instead of a reader thread.
+///
+/// At most one coroutine may be inside readFrame() and one inside write()
+/// at any time. All calls must happen on the loop thread.
+class AsyncConnection {
+public:
+    using Clock = EventLoop::Clock;
+
+    /// Takes ownership of an already connected socket.
+    AsyncConnection(EventLoop& loop, int socket_fd);
+    ~AsyncConnection();
+
+    AsyncConnection(const AsyncConnection&) = delete;
+    AsyncConnection& operator=(const AsyncConnection&) = delete;
+
+    /// Connects to host:port without blocking the loop. Throws on failure.
+    static Task<std::unique_ptr<AsyncConnection>> connect(EventLoop& loop,
+                                                          std::string host,
+                                                          uint16_t port);
+
+    /// Next complete frame, or nullopt on timeout, disconnect or error.
+    Task<std::optional<Packet>> readFrame(
+        std::optional<std::chrono::milliseconds> timeout = std::nullopt);
+
+    /// Writes a ready-framed packet in full; false if the socket failed.
+    Task<bool> write(std::vector<uint8_t> frame);
+
+    bool isOpen() const { return socket_ >= 0; }
+
+    /// Closes the socket and wakes any suspended reader/writer.
+    void close();
+
+private:
+
+    /// Suspends until the socket is readable/writable or the deadline
+    /// passes; resumes with false on timeout.
+    struct IoAwaiter {
+        AsyncConnection&                  conn;
+        std::coroutine_handle<>&          slot;
+        std::optional<Clock::time_point>  deadline;
+        EventLoop::TimerId                timer{0};
+        bool                              timedOut{false};
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h);
+        bool await_resume();
+    };
+
+    void onEvents(uint32_t events);
+
+    static void resume(std::coroutine_handle<>& slot);
+
+    static void wake(std::coroutine_handle<> reader, std::coroutine_handle<> writer);
+
+private:
+
+    EventLoop&                  loop_;
+    int                         socket_;
+    FrameDecoder                decoder_;
+    std::coroutine_handle<>     reader_;
+    std::coroutine_handle<>     writer_;
+};
+
+} // namespace altair
+
+#endif // ASYNC_CONNECTION_HPP
@@ -0,0 +1,47 @@
+#ifndef ASYNC_LOGCLIENT_HPP
+#define ASYNC_LOGCLIENT_HPP
+
+#include "async_connection.hpp"
+#include "coro.hpp"
+#include "protocol_defs.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace altair {
+
+/// Coroutine-based log retrieval client; the awaitable counterpart of
+/// LogClient. Many clients can share one EventLoop thread.
+class AsyncLogClient {
+public:
+
+    explicit AsyncLogClient(std::unique_ptr<AsyncConnection> connection);
+
+    /// Connects to the gateway at host:port.
+    static Task<std::unique_ptr<AsyncLogClient>> connect(EventLoop& loop,
+                                                         std::string host,
+                                                         uint16_t port);
+
+    /// Requests [from, to] logs of the given type and collects the
+    /// payloads of matching frames: those of the type dated in the range,
+    /// not today, each line once, as the gateway also forwards live
+    /// samples and other clients' replies. The protocol has no end-of-range marker, so the
+    /// range is complete once no matching frame arrives for idle_timeout.
+    /// One fetch per client at a time.
+    Task<std::vector<std::string>> fetchRange(
+        uint8_t type, std::string from, std::string to,
+        std::chrono::milliseconds idle_timeout = std::chrono::seconds(2));
+
+    AsyncConnection& connection() { return *connection_; }
+
+private:
+
+    std::unique_ptr<AsyncConnection> connection_;
+};
+
+} // namespace altair
+
+#endif // ASYNC_LOGCLIENT_HPP
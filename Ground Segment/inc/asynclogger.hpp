@@ -0,0 +1,324 @@
+#ifndef ASYNCLOGGER_HPP
+#define ASYNCLOGGER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace altair {
+
+enum class LogLevel : uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+/// Parses "trace", "debug", "info", "warn", "error" or "off"; defaults to Info.
+LogLevel parseLogLevel(std::string_view name);
+
+/// Argument wrapper: a byte range rendered as space-separated hex.
+struct LogHexBytes {
+    const uint8_t* data;
+    size_t         size;
+};
+
+/// Argument wrapper: a byte range rendered as ASCII, '.' for non-printables.
+struct LogAsciiBytes {
+    const uint8_t* data;
+    size_t         size;
+};
+
+/// Argument wrapper: an integer rendered in hex.
+struct LogHexValue {
+    uint64_t value;
+};
+
+inline LogHexBytes   logHex(const std::vector<uint8_t>& v)   { return {v.data(), v.size()}; }
+inline LogAsciiBytes logAscii(const std::vector<uint8_t>& v) { return {v.data(), v.size()}; }
+inline LogHexBytes   logHex(const std::pmr::vector<uint8_t>& v)   { return {v.data(), v.size()}; }
+inline LogAsciiBytes logAscii(const std::pmr::vector<uint8_t>& v) { return {v.data(), v.size()}; }
+inline LogHexValue   logHex(uint64_t v)                      { return {v}; }
+
+/// Single-producer / single-consumer byte ring holding variable-length
+/// records. Positions grow monotonically; only the low bits index the
+/// buffer. A zero size word tells the reader to skip to the start.
+class LogRing {
+public:
+    explicit LogRing(size_t capacity);
+
+    /// Producer: returns space for n bytes (n multiple of 8), or nullptr
+    /// if the reader has not caught up.
+    uint8_t* reserve(size_t n);
+
+    /// Producer: publish the n bytes handed out by the last reserve().
+    void commit(size_t n);
+
+    /// Consumer: visit every published record, then free its space.
+    template <class Visitor>
+    void consume(Visitor&& visit);
+
+    size_t capacity() const { return capacity_; }
+
+    /// Consumer: true if nothing is published and unread.
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<uint8_t[]> buf_;
+    size_t                     capacity_;
+    size_t                     mask_;
+    uint64_t                   reserved_{0};    // producer only
+    uint64_t                   tail_cache_{0};  // producer only
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+/// Leveled asynchronous logger.
+///
+/// A call stores a compact binary record (a pointer to the format string
+/// acting as its id, a decoder for the argument types, and the raw
+/// arguments) in the calling thread's own LogRing; no lock, no syscall.
+/// A background thread decodes, formats and writes the records: Warn and
+/// above to stderr, the rest to stdout. Format strings must have static
+/// storage duration and use "{}" placeholders.
+///
+/// Records are dropped, and counted, when a thread's ring is full.
+class AsyncLogger {
+public:
+
+    /// Returns the singleton instance; its writer thread starts on first use.
+    static AsyncLogger& instance();
+
+    ~AsyncLogger();
+
+    void setLevel(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const        { return level_.load(std::memory_order_relaxed); }
+
+    bool enabled(LogLevel level) const {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    /// Ring size for threads that have not logged yet (rounded up to 2^n).
+    void setBufferCapacity(size_t bytes) { buffer_capacity_ = bytes; }
+
+    /// Record a message if level is enabled.
+    template <class... Args>
+    void log(LogLevel level, const char* fmt, const Args&... args);
+
+    /// Block until every record published so far has been written.
+    void flush();
+
+    /// Records dropped so far because a ring was full.
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+
+    AsyncLogger();
+
+    using DecodeFn = void (*)(const char* fmt, const uint8_t* args, std::string& out);
+
+    struct RecordHeader {
+        uint32_t    size;   // whole record, 8-byte aligned; 0 = wrap marker
+        LogLevel    level;
+        DecodeFn    decode;
+        const char* fmt;
+    };
+
+    struct ThreadBuffer {
+        explicit ThreadBuffer(size_t capacity) : ring(capacity) {}
+        LogRing           ring;
+        std::atomic<bool> retired{false};
+    };
+
+    /// Holds the calling thread's buffer and marks it retired on thread exit.
+    struct ThreadHandle {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~ThreadHandle();
+    };
+
+    ThreadBuffer& localBuffer();
+
+    void writerLoop();
+
+    /// Drains every ring once; returns true if anything was written.
+    bool drainOnce();
+
+    // --- argument (de)serialisation ---------------------------------
+
+    /// Type an argument is recorded as; string literals become const char*.
+    template <class T>
+    using StoredArg = std::conditional_t<std::is_same_v<std::decay_t<T>, char*>,
+                                         const char*, std::decay_t<T>>;
+
+    template <class T> static size_t encodedSize(const T& v);
+    template <class T> static void   encode(uint8_t*& p, const T& v);
+    template <class T> static void   decodeArg(const uint8_t*& p, std::string& out);
+    template <class... Args>
+    static void decodeRecord(const char* fmt, const uint8_t* args, std::string& out);
+
+    /// Appends fmt up to the next "{}" and advances past it.
+    static void appendLiteral(const char*& fmt, std::string& out, bool toEnd);
+
+    static void encodeBytes(uint8_t*& p, const void* data, size_t n);
+    static std::string_view decodeBytes(const uint8_t*& p);
+
+private:
+
+    std::atomic<LogLevel>                       level_{LogLevel::Info};
+    size_t                                      buffer_capacity_{64 * 1024};
+    std::atomic<uint64_t>                       dropped_{0};
+    uint64_t                                    reported_dropped_{0};
+
+    std::mutex                                  buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>>  buffers_;
+
+    std::mutex                                  wake_mutex_;
+    std::condition_variable                     wake_cv_;
+    std::condition_variable                     flushed_cv_;
+    uint64_t                                    flush_requests_{0};
+    uint64_t                                    flushes_done_{0};
+    bool                                        stopping_{false};
+    std::thread                                 writer_;
+};
+
+// ------------------------------------------------------------------------
+// Template implementation
+// ------------------------------------------------------------------------
+
+template <class Visitor>
+void LogRing::consume(Visitor&& visit) {
+    uint64_t r = tail_.load(std::memory_order_relaxed);
+    uint64_t h = head_.load(std::memory_order_acquire);
+    while (r != h) {
+        size_t   idx = r & mask_;
+        uint32_t size;
+        std::memcpy(&size, buf_.get() + idx, sizeof(size));
+        if (size == 0) {
+            r += capacity_ - idx;
+            continue;
+        }
+        visit(buf_.get() + idx);
+        r += size;
+    }
+    tail_.store(r, std::memory_order_release);
+}
+
+template <class T>
+size_t AsyncLogger::encodedSize(const T& v) {
+    if constexpr (std::is_same_v<T, LogHexBytes> || std::is_same_v<T, LogAsciiBytes>) {
+        return sizeof(uint16_t) + std::min<size_t>(v.size, UINT16_MAX);
+    } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+        return sizeof(uint16_t) + std::min<size_t>(v.size(), UINT16_MAX);
+    } else if constexpr (std::is_same_v<T, const char*>) {
+        return sizeof(uint16_t) + std::min<size_t>(v ? std::strlen(v) : 0, UINT16_MAX);
+    } else {
+        static_assert(std::is_trivially_copyable_v<T>, "unsupported log argument type");
+        return sizeof(T);
+    }
+}
+
+template <class T>
+void AsyncLogger::encode(uint8_t*& p, const T& v) {
+    if constexpr (std::is_same_v<T, LogHexBytes> || std::is_same_v<T, LogAsciiBytes>) {
+        encodeBytes(p, v.data, v.size);
+    } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+        encodeBytes(p, v.data(), v.size());
+    } else if constexpr (std::is_same_v<T, const char*>) {
+        encodeBytes(p, v, v ? std::strlen(v) : 0);
+    } else {
+        std::memcpy(p, &v, sizeof(T));
+        p += sizeof(T);
+    }
+}
+
+template <class T>
+void AsyncLogger::decodeArg(const uint8_t*& p, std::string& out) {
+    static constexpr char digits[] = "0123456789abcdef";
+
+    if constexpr (std::is_same_v<T, LogHexBytes>) {
+        for (unsigned char b : decodeBytes(p)) {
+            out += digits[b >> 4];
+            out += digits[b & 0xF];
+            out += ' ';
+        }
+    } else if constexpr (std::is_same_v<T, LogAsciiBytes>) {
+        for (unsigned char b : decodeBytes(p)) {
+            out += (b >= 0x20 && b < 0x7F) ? static_cast<char>(b) : '.';
+        }
+    } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+                         || std::is_same_v<T, const char*>) {
+        out += decodeBytes(p);
+    } else {
+        T v;
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+
+        if constexpr (std::is_same_v<T, LogHexValue>) {
+            char tmp[17];
+            int i = 16;
+            tmp[i] = '\0';
+            uint64_t x = v.value;
+            do { tmp[--i] = digits[x & 0xF]; x >>= 4; } while (x);
+            out += &tmp[i];
+        } else if constexpr (std::is_same_v<T, bool>) {
+            out += v ? "true" : "false";
+        } else if constexpr (std::is_same_v<T, char>) {
+            out += v;
+        } else if constexpr (std::is_enum_v<T>) {
+            out += std::to_string(static_cast<long long>(v));
+        } else if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>) {
+            out += std::to_string(v);
+        } else {
+            out += "<?>";
+        }
+    }
+}
+
+template <class... Args>
+void AsyncLogger::decodeRecord(const char* fmt, [[maybe_unused]] const uint8_t* args,
+                               std::string& out) {
+    ((appendLiteral(fmt, out, false), decodeArg<Args>(args, out)), ...);
+    appendLiteral(fmt, out, true);
+}
+
+template <class... Args>
+void AsyncLogger::log(LogLevel level, const char* fmt, const Args&... args) {
+    if (!enabled(level)) return;
+
+    size_t size = sizeof(RecordHeader)
+                + (size_t{0} + ... + encodedSize<StoredArg<Args>>(args));
+    size = (size + 7) & ~size_t{7};
+
+    LogRing& ring = localBuffer().ring;
+    uint8_t* p = size <= ring.capacity() ? ring.reserve(size) : nullptr;
+    if (!p) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    RecordHeader hdr{static_cast<uint32_t>(size), level,
+                     &decodeRecord<StoredArg<Args>...>, fmt};
+    std::memcpy(p, &hdr, sizeof(hdr));
+    [[maybe_unused]] uint8_t* cursor = p + sizeof(hdr);
+    (encode<StoredArg<Args>>(cursor, args), ...);
+    ring.commit(size);
+}
+
+} // namespace altair
+
+#endif // ASYNCLOGGER_HPP
@@ -1,6 +1,8 @@
 #ifndef CLIENTCONNECTION_HPP
 #define CLIENTCONNECTION_HPP
 
+#include "latency.hpp"
+#include "metrics.hpp"
 #include "packet.hpp"
 #include "protocol.hpp"
 
@@ -9,12 +11,35 @@
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
 
 
 namespace altair {
 
-/// Represents one TCP client; reads framed Packets and invokes a callback.
+class EventLoop;
+
+/// Represents one TCP client; reads framed Packets and hands them to a sink.
+///
+/// A sink is any object with
+///     void onPacket(ClientConnection& client, const Packet& pkt);
+/// installed with setSink(). Its type is fixed when it is installed, so
+/// the frame loop calls onPacket() directly and the compiler can inline
+/// it; the only indirect call is one per socket read. onMessage() is the
+/// std::function adapter on top of that.
+///
+/// The packets of one read are allocated from a monotonic arena that is
+/// released when the sink has seen them all, backed by a pool owned by the
+/// connection; steady traffic does not touch the global heap. A sink that
+/// keeps a packet must copy it.
+///
+/// On a non-blocking socket (TCPServer accepts them so) send() never
+/// blocks: what the kernel does not take is queued and written out when
+/// the socket turns writable on the connection's loop. A reader that lets
+/// more than the output limit pile up is disconnected rather than queued
+/// for without bound; frames are never dropped from the middle of a stream.
 class ClientConnection : public std::enable_shared_from_this<ClientConnection> {
 public:
     using PacketCallback = std::function<void(const Packet&)>;
@@ -26,14 +51,47 @@ public:
     /// Begin the background read loop.
     void start();
 
-    /// Stop the background read loop and close the socket.
+    /// Serve reads from loop instead of a thread of its own. Must be called
+    /// on the loop's thread; callbacks then run there too.
+    void start(EventLoop& loop);
+
+    /// Stop the background read loop. A loop-driven connection is shut
+    /// down, which reports the disconnect on its loop. A threaded one is
+    /// shut down and its reader joined, so no callback runs after this
+    /// returns and no disconnect is reported.
     void stop();
 
-    /// Register to be called on each received Packet.
+    /// Register to be called on each received Packet. Replaces any sink.
     void onMessage(PacketCallback cb);
 
-    /// Send a ready‑framed packet (i.e. output of Protocol::pack).
-    void send(const std::vector<uint8_t>& raw);
+    /// Deliver every received Packet to sink.onPacket(*this, pkt). The
+    /// sink must outlive the connection's reads; install it before start().
+    template <class Sink>
+    void setSink(Sink& sink);
+
+    /// Send a ready‑framed packet (i.e. output of Protocol::pack). Thread-safe.
+    /// With trace, records the Write and Total stages once the bytes have
+    /// left, when written now or flushed from the queue later; not for
+    /// bytes lost to a slow reader's disconnect.
+    void send(const uint8_t* data, size_t size, const SendTrace* trace = nullptr);
+    void send(const std::vector<uint8_t>& raw, const SendTrace* trace = nullptr) {
+        send(raw.data(), raw.size(), trace);
+    }
+    void send(const std::pmr::vector<uint8_t>& raw, const SendTrace* trace = nullptr) {
+        send(raw.data(), raw.size(), trace);
+    }
+
+    /// Count traffic in metrics, which must outlive the connection (see
+    /// TCPServer::instrument()). Call before start().
+    void setMetrics(const LinkMetrics* metrics) { metrics_ = metrics; }
+
+    /// Most bytes send() may queue on a non-blocking socket before the
+    /// connection is shut down as a slow reader; each such shutdown adds
+    /// one to slow, if given. Call before start().
+    void setOutputLimit(size_t bytes, Counter* slow = nullptr);
+
+    /// Default output limit.
+    static constexpr size_t kDefaultOutputLimit = 4 << 20;
 
     /// Assign and retrieve its unique ID.
     void setId(int id);
@@ -47,17 +105,81 @@ private:
     /// Read from the socket in a loop until stopped.
     void readLoop();
 
+    /// Drain the readable socket without blocking (loop mode).
+    void onReadable();
+
+    /// Write out what send() queued (loop mode).
+    void onWritable();
+
+    /// Watch the socket for reads, and for writes while output is queued.
+    /// Loop thread only; requires output_mutex_.
+    void watchSocket();
+
+    /// Queue the unsent tail of a write, or shut the connection down when
+    /// the queue would pass the limit. Requires output_mutex_; false when
+    /// the connection was shut down instead.
+    bool queueOutput(const uint8_t* data, size_t size);
+
+    /// Record the traced sends whose bytes have all been written out.
+    /// Requires output_mutex_.
+    void recordWritten(uint64_t now_ns);
+
+    /// Parse every complete frame in decoder_ and pass it to Sink.
+    template <class Sink>
+    static void drainInto(ClientConnection& self, void* sink);
+
+    /// Default sink: the onMessage() callback.
+    void onPacket(ClientConnection& self, const Packet& pkt);
+
+    /// Report the disconnect once.
+    void closed();
+
 private:
 
     DisconnectCallback        disconnectCallback_;
     int                       socket_;
     int                       id_{0};
     PacketCallback            callback_;
+    void*                     sink_{this};
+    void                    (*drain_)(ClientConnection&, void*){&drainInto<ClientConnection>};
     std::thread               reader_;
+    EventLoop*                loop_{nullptr};
     std::atomic<bool>         running_{false};
-    std::vector<uint8_t>      buffer_;
+    // Pooled blocks must cover the arena's buffers, or every read would
+    // reach the heap; few blocks per chunk keep idle connections small.
+    std::pmr::unsynchronized_pool_resource pool_{std::pmr::pool_options{2, 16 * 1024}};
+    std::pmr::monotonic_buffer_resource    batch_{1024, &pool_};
+    FrameDecoder              decoder_{&batch_};
+    const LinkMetrics*        metrics_{nullptr};
+    DecoderTally              tally_;     // read thread only
+    bool                      nonblocking_{false};
+    std::mutex                output_mutex_;
+    std::vector<uint8_t>      output_;    // written from output_sent_ on
+    size_t                    output_sent_{0};
+    uint64_t                  output_queued_total_{0};  // bytes ever queued
+    uint64_t                  output_sent_total_{0};    // of those, written
+    // Traced sends still queued, with the total their last byte ends at.
+    std::deque<std::pair<uint64_t, SendTrace>> output_traces_;
+    size_t                    output_limit_{kDefaultOutputLimit};
+    bool                      shut_{false};     // shut down as a slow reader
+    Counter*                  slow_{nullptr};
 };
 
+template <class Sink>
+void ClientConnection::setSink(Sink& sink) {
+    sink_  = &sink;
+    drain_ = &drainInto<Sink>;
+}
+
+template <class Sink>
+void ClientConnection::drainInto(ClientConnection& self, void* sink) {
+    Sink& target = *static_cast<Sink*>(sink);
+    while (auto pkt = self.decoder_.next()) {
+        target.onPacket(self, *pkt);
+    }
+    self.batch_.release();
+}
+
 } // namespace altair
 
 #endif // CLIENTCONNECTION_HPP
@@ -1,9 +1,17 @@
 #ifndef CLIENTMANAGER_HPP
 #define CLIENTMANAGER_HPP
 
+#include "latency.hpp"
+#include "packet.hpp"
+#include "rate_limit.hpp"
+
+#include <cstdint>
+#include <functional>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
 #include <memory>
+#include <memory_resource>
 #include <vector>
 
 namespace altair {
@@ -25,13 +33,71 @@ public:
     /// Returns the shared pointer to the client, or nullptr if not found.
     std::shared_ptr<ClientConnection> getClient(int clientId);
 
+    /// Times the sends of traced broadcasts into tracer (the Fanout,
+    /// Write and Total stages), which must outlive the manager.
+    void traceSends(LatencyTracer* tracer) { tracer_ = tracer; }
+
     /// Broadcasts data to all connected clients.
     void broadcastToAll(const std::vector<uint8_t>& data);
 
+    /// Marks a client as understanding satellite-tagged (ROUTED) frames.
+    /// The first time, greet(client) runs under the broadcast lock, so
+    /// what it sends reaches the client ahead of any routed broadcast.
+    void setRouted(int clientId,
+                   const std::function<void(ClientConnection&)>& greet = {});
+
+    /// Sends the live sample from satellite sat: routed (unless empty) to
+    /// clients marked with setRouted() and, if given, legacy to every
+    /// other client, each thinned out as it asked with setRate().
+    void broadcastRouted(uint8_t sat, const Packet& sample,
+                         const std::pmr::vector<uint8_t>& routed,
+                         const std::pmr::vector<uint8_t>* legacy,
+                         const FrameTrace& trace = {});
+
+    /// Thins out the live samples of sat (PROTO_SAT_ALL: of every
+    /// satellite) sent to a client. False if the client is unknown.
+    bool setRate(int clientId, uint8_t sat, RateSpec spec);
+
+    /// Marks a client as taking journal (JOURNAL) frames only, while its
+    /// replay catches up. False if it is unknown or already one.
+    bool startJournal(int clientId);
+
+    /// Ends a client's catch-up: catch_up() runs under the broadcast lock,
+    /// sends what is left and returns the next offset, from which on
+    /// broadcastJournal() frames reach the client. False if the client
+    /// has gone.
+    bool followJournal(int clientId, const std::function<uint64_t()>& catch_up);
+
+    /// Sends entry (unless empty) to the journal clients that have not
+    /// seen offset yet.
+    void broadcastJournal(uint64_t offset, const std::pmr::vector<uint8_t>& entry,
+                          const FrameTrace& trace = {});
+
 private:
 
+    /// Runs send(const SendTrace*), with stamps for the client's Write and
+    /// Total stages if trace is stamped; the connection records those once
+    /// the bytes have left (see ClientConnection::send()).
+    template <class Send>
+    void traced(const FrameTrace& trace, Send&& send) {
+        if (!tracer_ || !trace.rx_ns) {
+            send(nullptr);
+            return;
+        }
+        const SendTrace stamps{tracer_, trace.rx_ns, monotonicNs()};
+        tracer_->record(LatencyStage::Fanout, trace.handled_ns, stamps.start_ns);
+        send(&stamps);
+    }
+
     std::mutex mutex_;
     std::unordered_map<int, std::shared_ptr<ClientConnection>> clients_;
+    std::unordered_set<int> routed_;
+    // Clients that asked for fewer samples than arrive.
+    std::unordered_map<int, ClientRates> rates_;
+    // Journal clients and the next offset each expects; UINT64_MAX
+    // while catching up.
+    std::unordered_map<int, uint64_t> journal_;
+    LatencyTracer* tracer_{nullptr};
     
 };
 
@@ -0,0 +1,182 @@
+#ifndef CORO_HPP
+#define CORO_HPP
+
+#if !defined(__cpp_impl_coroutine)
+#error "coro.hpp requires C++20 coroutines (build with -std=c++20)"
+#endif
+
+#include "eventloop.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace altair {
+
+/// Lazily started coroutine returning T. Awaiting a Task starts it and
+/// resumes the awaiter when it finishes (symmetric transfer, so long
+/// chains of co_await do not grow the stack).
+template <class T = void>
+class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation_{std::noop_coroutine()};
+    std::exception_ptr      error_;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            return h.promise().continuation_;
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error_ = std::current_exception(); }
+};
+
+template <class T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value_;
+
+    Task<T> get_return_object() noexcept;
+
+    template <class U>
+    void return_value(U&& v) { value_.emplace(std::forward<U>(v)); }
+
+    T result() {
+        if (error_) std::rethrow_exception(error_);
+        return std::move(*value_);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+
+    void result() {
+        if (error_) std::rethrow_exception(error_);
+    }
+};
+
+} // namespace detail
+
+template <class T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle       = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(Handle h) : handle_(h) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return !handle_ || handle_.done(); }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation_ = awaiter;
+        return handle_;
+    }
+
+    T await_resume() { return handle_.promise().result(); }
+
+    /// Releases the coroutine frame to the caller (used by spawn()).
+    Handle release() noexcept { return std::exchange(handle_, {}); }
+
+private:
+    Handle handle_;
+};
+
+namespace detail {
+
+template <class T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/// Fire-and-forget wrapper that owns itself and frees its frame on exit.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+template <class T, class OnDone>
+Detached runDetached(Task<T> task, OnDone onDone) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            onDone(std::exception_ptr{});
+        } else {
+            (void)co_await task;
+            onDone(std::exception_ptr{});
+        }
+    } catch (...) {
+        onDone(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+/// Start a task without awaiting it. onDone(std::exception_ptr) runs when
+/// it finishes; the pointer is null on success.
+template <class T, class OnDone>
+void spawn(Task<T> task, OnDone onDone) {
+    detail::runDetached(std::move(task), std::move(onDone));
+}
+
+/// Suspends the coroutine until the given time, resuming on loop.
+class SleepAwaiter {
+public:
+    SleepAwaiter(EventLoop& loop, EventLoop::Clock::time_point when)
+        : loop_(loop), when_(when) {}
+
+    bool await_ready() const noexcept { return when_ <= EventLoop::Clock::now(); }
+
+    void await_suspend(std::coroutine_handle<> h) {
+        loop_.addTimer(when_, [h]() { h.resume(); });
+    }
+
+    void await_resume() const noexcept {}
+
+private:
+    EventLoop&                    loop_;
+    EventLoop::Clock::time_point  when_;
+};
+
+inline SleepAwaiter sleepFor(EventLoop& loop, std::chrono::milliseconds d) {
+    return SleepAwaiter(loop, EventLoop::Clock::now() + d);
+}
+
+} // namespace altair
+
+#endif // CORO_HPP
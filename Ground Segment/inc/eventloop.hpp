@@ -0,0 +1,84 @@
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace altair {
+
+/// Single-threaded epoll reactor with timers and a thread-safe post queue.
+///
+/// All callbacks run on the thread inside run(). Only post() and stop()
+/// may be called from other threads.
+class EventLoop {
+public:
+    using Clock         = std::chrono::steady_clock;
+    using IoCallback    = std::function<void(uint32_t events)>;
+    using Callback      = std::function<void()>;
+    using TimerId       = uint64_t;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /// Watch fd for the given epoll events (EPOLLIN, EPOLLOUT, EPOLLET...).
+    /// Re-watching an fd replaces its callback and event mask.
+    void watch(int fd, uint32_t events, IoCallback cb);
+
+    /// Stop watching fd. Safe to call from within its own callback.
+    void unwatch(int fd);
+
+    /// Run cb once at the given time (or on the next iteration if past).
+    TimerId addTimer(Clock::time_point when, Callback cb);
+
+    /// Cancel a timer that has not fired yet; no-op otherwise.
+    void cancelTimer(TimerId id);
+
+    /// Queue cb to run on the loop thread. Thread-safe.
+    void post(Callback cb);
+
+    /// Dispatch events until stop() is called, returning at once if it
+    /// was called since the last run() returned.
+    void run();
+
+    /// Wait at most timeout for events and dispatch them once.
+    void runOnce(std::chrono::milliseconds timeout);
+
+    /// Make run() return after the current iteration, or the next run()
+    /// return at once if none is running. Thread-safe.
+    void stop();
+
+private:
+
+    void wake();
+    void runPosted();
+    void runTimers();
+    int  nextTimeoutMs(std::chrono::milliseconds cap) const;
+
+private:
+
+    int                                             epoll_fd_{-1};
+    int                                             wake_fd_{-1};
+    std::atomic<bool>                               stopping_{false};
+    std::unordered_map<int, std::shared_ptr<IoCallback>> watchers_;
+
+    TimerId                                         next_timer_{1};
+    std::multimap<Clock::time_point, TimerId>       timers_;
+    std::unordered_map<TimerId, Callback>           timer_callbacks_;
+
+    mutable std::mutex                              posted_mutex_;
+    std::vector<Callback>                           posted_;
+};
+
+} // namespace altair
+
+#endif // EVENTLOOP_HPP
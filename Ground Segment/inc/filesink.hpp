@@ -0,0 +1,80 @@
+#ifndef FILESINK_HPP
+#define FILESINK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace altair {
+
+struct FileSinkOptions {
+    /// Size of each of the two buffers.
+    size_t                      buffer_size{1 << 20};
+    /// Partially filled buffers are written at least this often.
+    std::chrono::milliseconds   flush_interval{200};
+    /// fdatasync after this many bytes; 0 syncs only on close().
+    size_t                      fsync_every_bytes{0};
+};
+
+/// Append-only file kept open for its whole lifetime, written through two
+/// buffers by a background thread. Producers copy into the active buffer
+/// while the writer thread drains the other, so a slow disk only stalls
+/// a producer once both buffers are full.
+class FileSink {
+public:
+
+    /// Opens (creating, appending) path. Throws std::runtime_error on failure.
+    explicit FileSink(const std::string& path, FileSinkOptions options = {});
+    ~FileSink();
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    /// Queues bytes for writing.
+    void write(const uint8_t* data, size_t len);
+    void write(const std::vector<uint8_t>& data) { write(data.data(), data.size()); }
+
+    /// Blocks until everything queued so far has reached the kernel.
+    void flush();
+
+    /// Flushes, syncs and closes the file. Further writes are ignored.
+    void close();
+
+    const std::string& path() const { return path_; }
+
+    uint64_t bytesWritten() const { return written_.load(std::memory_order_relaxed); }
+
+private:
+
+    void writerLoop();
+
+    /// Writes buf in full, retrying on short writes; false on error.
+    bool writeAll(const std::vector<uint8_t>& buf);
+
+private:
+
+    std::string             path_;
+    FileSinkOptions         options_;
+    int                     fd_{-1};
+
+    std::mutex              mutex_;
+    std::condition_variable writer_cv_;
+    std::condition_variable producer_cv_;
+    std::vector<uint8_t>    active_;
+    std::vector<uint8_t>    standby_;
+    uint64_t                appended_{0};
+    std::atomic<uint64_t>   written_{0};
+    uint64_t                unsynced_{0};
+    bool                    flush_requested_{false};
+    bool                    closing_{false};
+    std::thread             writer_;
+};
+
+} // namespace altair
+
+#endif // FILESINK_HPP
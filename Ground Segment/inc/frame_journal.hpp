@@ -0,0 +1,246 @@
+#ifndef FRAME_JOURNAL_HPP
+#define FRAME_JOURNAL_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace altair {
+
+/// Segment file layout (host byte order), <dir>/<base offset>.seg:
+///
+///   header  "ALTJRN01" | u64 offset of the first record | zero padding
+///   record  u64 offset | u64 t_ns | u8 sat | u8 0 | u16 size | size bytes
+///
+/// Records are framed packets as received from the satellites; offsets
+/// count frames and follow each other without gaps across segments.
+/// t_ns is CLOCK_REALTIME, so age-based retention survives restarts.
+constexpr char   kJournalMagic[8]     = {'A', 'L', 'T', 'J', 'R', 'N', '0', '1'};
+constexpr size_t kJournalHeaderSize   = 64;
+constexpr size_t kJournalRecordHead   = 20;
+/// Largest framed packet: length byte, id, 254 payload bytes, xor, end.
+constexpr size_t kJournalMaxFrame     = 258;
+/// Every this many records a segment's in-memory index notes a position.
+constexpr size_t kJournalIndexStride  = 256;
+
+struct JournalOptions {
+    /// Size of each segment file, allocated up front.
+    size_t                      segment_bytes{64 << 20};
+    /// Oldest segments are deleted while the journal is larger (0 = no limit).
+    uint64_t                    max_bytes{1ull << 30};
+    /// Segments whose newest frame is older are deleted (0 = no limit).
+    std::chrono::seconds        max_age{std::chrono::hours(24 * 7)};
+    /// Group commit: appended frames reach the disk at least this often...
+    std::chrono::milliseconds   sync_interval{50};
+    /// ...or as soon as this many bytes are waiting.
+    size_t                      sync_bytes{1 << 20};
+};
+
+/// One mapped segment file. Shared with readers, so a segment removed by
+/// retention stays readable until the last reader has moved past it.
+struct JournalSegment {
+    std::string             path;
+    uint64_t                base{0};            ///< offset of the first record
+    int                     fd{-1};
+    uint8_t*                map{nullptr};
+    size_t                  mapped{0};
+    std::atomic<uint64_t>   used{kJournalHeaderSize};   ///< bytes of complete records
+    std::atomic<uint64_t>   next{0};            ///< offset after the last record
+    std::atomic<uint64_t>   last_ns{0};         ///< t_ns of the last record
+    std::atomic<bool>       sealed{false};      ///< no more records will follow
+    uint64_t                synced{0};          ///< flusher only: next at the last sync
+    /// index[k] is the position of record base + k * kJournalIndexStride,
+    /// filled in before the record is published.
+    std::unique_ptr<uint64_t[]> index;
+
+    ~JournalSegment();
+
+    /// Sizes the index for every record the mapping can hold.
+    void allocateIndex();
+};
+
+/// Append-only journal of every downlinked frame, in segment files mapped
+/// into memory: an append is a memcpy into the active segment.
+///
+/// Durability is group commit: a flusher thread fdatasync()s the appended
+/// data every sync_interval, or earlier once sync_bytes are waiting, so
+/// one disk flush covers all frames since the previous one and the writer
+/// never waits for the disk. The same thread applies retention.
+///
+/// On start-up existing segments are validated record by record and
+/// appending resumes after the last complete one.
+///
+/// One writer thread (append()); any number of JournalReaders.
+class FrameJournal {
+public:
+
+    /// Opens or creates the journal in dir. Throws std::runtime_error on
+    /// failure.
+    explicit FrameJournal(const std::string& dir, JournalOptions options = {});
+
+    /// Flushes what is left and closes the segments.
+    ~FrameJournal();
+
+    FrameJournal(const FrameJournal&) = delete;
+    FrameJournal& operator=(const FrameJournal&) = delete;
+
+    /// Appends one framed packet from satellite sat and returns its
+    /// offset. Frames longer than kJournalMaxFrame are refused (throws
+    /// std::invalid_argument). Not thread-safe.
+    uint64_t append(uint8_t sat, const uint8_t* frame, size_t len);
+
+    /// Oldest offset still retained.
+    uint64_t begin() const { return begin_.load(std::memory_order_acquire); }
+
+    /// Offset the next frame will get.
+    uint64_t end() const { return end_.load(std::memory_order_acquire); }
+
+    /// Frames below this offset are on disk.
+    uint64_t durable() const { return durable_.load(std::memory_order_acquire); }
+
+    /// Flushes everything appended so far and waits for it.
+    void sync();
+
+    const std::string& dir() const { return dir_; }
+
+private:
+
+    friend class JournalReader;
+
+    /// Segment holding offset: the oldest one if offset was dropped
+    /// already, the active one if it is not written yet.
+    std::shared_ptr<JournalSegment> segmentFor(uint64_t offset) const;
+
+    /// First segment after the one starting at base, even if that one has
+    /// been dropped; nullptr if there is none yet.
+    std::shared_ptr<JournalSegment> segmentAfter(uint64_t base) const;
+
+    /// Maps an existing segment and finds its last complete record.
+    std::shared_ptr<JournalSegment> openSegment(const std::string& path, bool writable);
+
+    /// Creates the segment starting at base and makes it the active one.
+    void roll(uint64_t base);
+
+    /// Flusher thread: group commit and retention.
+    void flushLoop();
+
+    /// Flushes every segment with unsynced records.
+    void flushPending();
+
+    /// Deletes sealed segments beyond the size or age limit.
+    void applyRetention();
+
+private:
+
+    std::string     dir_;
+    JournalOptions  options_;
+    int             dir_fd_{-1};
+    // A segment was created since the directory was last flushed.
+    std::atomic<bool> dir_dirty_{false};
+
+    // Writer only.
+    std::shared_ptr<JournalSegment> active_;
+    uint64_t        unsynced_bytes_{0};
+
+    mutable std::mutex                          segments_mutex_;
+    std::deque<std::shared_ptr<JournalSegment>> segments_;
+
+    std::atomic<uint64_t>   begin_{0};
+    std::atomic<uint64_t>   end_{0};
+    std::atomic<uint64_t>   durable_{0};
+
+    std::mutex              flush_mutex_;
+    std::condition_variable flush_cv_;
+    std::condition_variable synced_cv_;
+    bool                    flush_requested_{false};
+    bool                    stopping_{false};
+    std::thread             flusher_;
+};
+
+/// Reads a journal from a given offset on, straight from the mapped
+/// segments, and keeps up as frames are appended.
+class JournalReader {
+public:
+
+    /// A frame as handed to the visitor; data points into the segment and
+    /// stays valid until the next call to poll().
+    struct Frame {
+        uint64_t        offset;
+        uint64_t        t_ns;
+        uint8_t         sat;
+        const uint8_t*  data;
+        size_t          size;
+    };
+
+    /// Starts at offset from, or at the oldest retained frame if from has
+    /// been dropped, or at end() if from lies in the future.
+    JournalReader(const FrameJournal& journal, uint64_t from);
+
+    /// Hands every available frame to visit(const Frame&); returns how many.
+    template <class Visitor>
+    size_t poll(Visitor&& visit, size_t max_frames = SIZE_MAX);
+
+    /// Offset of the next frame to read.
+    uint64_t position() const { return next_; }
+
+    /// True once every appended frame has been read.
+    bool caughtUp() const { return next_ >= journal_.end(); }
+
+    /// Frames skipped because retention dropped them before they were read.
+    uint64_t lost() const { return lost_; }
+
+private:
+
+    /// Positions the reader at next_ in the segment that holds it: the
+    /// index gives a nearby record, the rest is a short walk over heads.
+    void seek();
+
+    /// Moves to the following segment once the current one is exhausted.
+    bool advance();
+
+private:
+
+    const FrameJournal&             journal_;
+    std::shared_ptr<JournalSegment> segment_;
+    uint64_t                        pos_{0};
+    uint64_t                        next_{0};
+    uint64_t                        lost_{0};
+};
+
+template <class Visitor>
+size_t JournalReader::poll(Visitor&& visit, size_t max_frames) {
+    size_t n = 0;
+    if (!segment_) seek();
+
+    while (n < max_frames) {
+        if (pos_ >= segment_->used.load(std::memory_order_acquire) && !advance()) break;
+
+        const uint8_t* p = segment_->map + pos_;
+        Frame frame;
+        uint16_t size;
+        std::memcpy(&frame.offset, p, sizeof(frame.offset));
+        std::memcpy(&frame.t_ns, p + 8, sizeof(frame.t_ns));
+        frame.sat  = p[16];
+        std::memcpy(&size, p + 18, sizeof(size));
+        frame.data = p + kJournalRecordHead;
+        frame.size = size;
+
+        pos_  += kJournalRecordHead + size;
+        next_  = frame.offset + 1;
+        visit(static_cast<const Frame&>(frame));
+        ++n;
+    }
+    return n;
+}
+
+} // namespace altair
+
+#endif // FRAME_JOURNAL_HPP
@@ -1,28 +1,117 @@
 #ifndef GATEWAY_HPP
 #define GATEWAY_HPP
 
+#include "admission.hpp"
 #include "tcpserver.hpp"
-#include "uart_communicator.hpp"
+#include "uart_reactor.hpp"
 #include "clientmanager.hpp"
-
+#include "frame_journal.hpp"
+#include "latency.hpp"
+#include "metrics.hpp"
+#include "metrics_server.hpp"
+#include "multicast.hpp"
+#include "sat_state.hpp"
+#include "shm_ring.hpp"
+#include "threadpool.hpp"
+#include "strand.hpp"
+
+#include <atomic>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace altair {
 
+/// Where received packets are handled.
+enum class DispatchMode {
+    Inline,     ///< On the TCP shard / UART thread that decoded them.
+    Pool        ///< On a worker pool, FIFO per source (each client, UART).
+};
+
 /// Gateway class that manages TCP and UART communication.
+///
+/// Serves one or more satellites. Frames from satellite N reach clients
+/// that have sent a PROTO_PKT_ROUTED packet as ROUTED frames tagged N;
+/// other clients get plain frames from the default (first) satellite only,
+/// and their requests go to it.
 class Gateway {
 public:
 
-    Gateway(uint16_t tcp_port, const std::string& uart_device);
+    /// Single satellite (id 0) on uart_device.
+    Gateway(uint16_t tcp_port, const std::string& uart_device,
+            DispatchMode mode = DispatchMode::Inline,
+            unsigned worker_threads = 0);
+
+    /// One satellite per entry, all served by one UartReactor thread.
+    /// tcp_shards acceptor loops share the port (0 = one per core).
+    Gateway(uint16_t tcp_port, std::vector<SatelliteConfig> satellites,
+            DispatchMode mode = DispatchMode::Inline,
+            unsigned worker_threads = 0,
+            unsigned tcp_shards = 0);
     ~Gateway();
 
-    /// Starts the TCP server and UART communicator.
+    /// Starts the TCP server and the UART reactor.
     void start();
 
-    /// Stops the TCP server and UART communicator.
+    /// Stops the TCP server and the UART reactor.
     void stop();
 
+    /// Records all UART traffic to capture_path for uart_replay.
+    /// Call before start().
+    void recordUart(const std::string& capture_path);
+
+    /// Also publishes every frame received from any satellite to the
+    /// shared-memory ring /dev/shm/<name> for same-host readers
+    /// (ShmRingReader). Call before start().
+    void shareFrames(const std::string& name, size_t capacity = 8 << 20);
+
+    /// Also sends every frame received from any satellite to a multicast
+    /// group, once, for read-only audiences (MulticastReceiver).
+    /// Call before start().
+    void multicastFrames(const MulticastOptions& options);
+
+    /// Also appends every frame received from any satellite to a journal
+    /// in dir. A client that sends PROTO_PKT_REPLAY gets the journaled
+    /// frames from its offset on, then live ones. Call before start().
+    void journalFrames(const std::string& dir, const JournalOptions& options = {});
+
+    /// Publishes the state of every satellite (last keep-alive, sample,
+    /// event and mode) as /dev/shm/<name> for same-host readers
+    /// (SatStateReader). Call before start().
+    void shareState(const std::string& name);
+
+    /// Replaces the default budgets for client commands to the
+    /// satellites (see CommandAdmission). Call before start().
+    void limitCommands(const AdmissionOptions& options);
+
+    /// Disconnects a client once more than bytes of replies and broadcasts
+    /// wait unread for it (default ClientConnection::kDefaultOutputLimit).
+    /// Call before start().
+    void limitClientQueues(size_t bytes);
+
+    /// Lets the worker pool grow and shrink between config's bounds with
+    /// its measured queue wait (see ElasticConfig). Pool dispatch only.
+    /// Call before start().
+    void elasticWorkers(const ThreadPool::ElasticConfig& config);
+
+    /// Serves the gateway's metrics (traffic per link, corrupt frames,
+    /// clients, queue depths, handler latency) in the Prometheus text
+    /// format at http://address:port/metrics. Call before start().
+    void serveMetrics(const std::string& address, uint16_t port);
+
+    /// Logs, every interval, the p50/p99/p999 of each stage from UART
+    /// ingress to client egress (see LatencyTracer); they are in the
+    /// metrics either way.
+    void reportLatency(std::chrono::seconds interval);
+
+    /// The metrics served by serveMetrics(), kept whether served or not.
+    MetricsRegistry& metrics() { return metrics_; }
+
 private:
 
     /// Handles a new TCP client connection.
@@ -32,20 +121,111 @@ private:
     void handleClientDisconnect(std::shared_ptr<ClientConnection> client);
 
     /// Handles a received Packet from a TCP client.
-    void handleTcpPacket(std::shared_ptr<ClientConnection> client, const Packet& pkt);
+    void handleTcpPacket(ClientConnection& client, const Packet& pkt);
+
+    /// Handles a received Packet from satellite sat, dispatched at
+    /// decoded_ns (monotonicNs()).
+    void handleUartPacket(uint8_t sat, const Packet& pkt, uint64_t decoded_ns);
+
+    /// Passes a client's command for satellite sat (PROTO_SAT_ALL: every
+    /// one) through admission control; a refused one is answered with
+    /// PROTO_PKT_REJECTED.
+    void submitCommand(ClientConnection& client, uint8_t sat, const Packet& pkt);
+
+    /// Sends a time synchronization packet to satellite sat.
+    void sendTimeSync(uint8_t sat);
+
+    /// Routes a client packet to its handler according to the dispatch mode.
+    void dispatchTcpPacket(ClientConnection& client, const Packet& pkt);
+
+    /// Routes a UART packet to its handler according to the dispatch mode.
+    void dispatchUartPacket(uint8_t sat, const Packet& pkt);
 
-    /// Handles a received Packet from the UART device.
-    void handleUartPacket(const Packet& pkt);
+    /// Journals a framed packet and sends it to the live journal clients.
+    void journalFrame(uint8_t sat, const uint8_t* frame, size_t len, const FrameTrace& trace);
 
-    /// Sends a time synchronization packet to the UART device.
-    void sendTimeSync();
+    /// Sends the client the cached state of every satellite as STATE
+    /// frames, in one write.
+    void sendSnapshot(ClientConnection& client);
+
+    /// Starts a replay thread for the client, from journal offset from.
+    void startReplay(ClientConnection& client, uint64_t from);
+
+    /// Sends the journal from offset from to the client until it has
+    /// caught up, then hands it over to live broadcasts.
+    void serveReplay(ClientConnection& client, uint64_t from);
+
+    /// Registers the metrics the gateway reads from its parts when scraped.
+    void registerMetrics();
+
+    /// Returns the strand that serialises packets from the given client.
+    std::shared_ptr<ThreadPool::Strand> clientStrand(int clientId);
+
+    /// Sinks wired into the TCP server and the UART reactor: received
+    /// frames reach dispatch*Packet() through direct calls, with no
+    /// std::function hop and no shared_ptr copy per packet.
+    struct TcpSink {
+        Gateway& gateway;
+        void onPacket(ClientConnection& client, const Packet& pkt) {
+            gateway.dispatchTcpPacket(client, pkt);
+        }
+    };
+
+    struct UartSink {
+        Gateway& gateway;
+        void onPacket(uint8_t sat, const Packet& pkt) {
+            gateway.dispatchUartPacket(sat, pkt);
+        }
+    };
 
 private:
 
+    // Outlives everything that records into it.
+    MetricsRegistry metrics_;
+    Histogram* uart_handler_time_{nullptr};
+    Histogram* tcp_handler_time_{nullptr};
+    // Stamps of satellite frames, up to the client writes.
+    LatencyTracer latency_;
+
+    TcpSink tcp_sink_{*this};
+    UartSink uart_sink_{*this};
+
     std::unique_ptr<TCPServer> tcp_server_;
-    std::unique_ptr<UartCommunicator> uart_comm_;
+    std::unique_ptr<UartReactor> uart_;
+    // Command bytes/s each link carries (baud / 10 for 8N1).
+    std::map<uint8_t, double> link_capacity_;
+    // Destroyed before uart_, which its pacing thread sends to.
+    std::unique_ptr<CommandAdmission> admission_;
+    // Written only from the UART reactor thread.
+    std::unique_ptr<ShmRingWriter> shm_ring_;
+    std::unique_ptr<MulticastPublisher> multicast_;
+    // Appended only from the UART reactor thread.
+    std::unique_ptr<FrameJournal> journal_;
+    // Last known state per satellite, sent to clients as they subscribe;
+    // updated only from the UART reactor thread.
+    std::unique_ptr<SatStateTable> state_;
+    uint8_t default_sat_;
     ClientManager client_manager_;
-    bool running_{false};
+    std::atomic<bool> running_{false};
+
+    DispatchMode dispatch_mode_;
+    std::unique_ptr<ThreadPool::ThreadPool> pool_;
+    // One per satellite; built in the constructor, read-only afterwards.
+    std::unordered_map<uint8_t, std::shared_ptr<ThreadPool::Strand>> sat_strands_;
+    std::mutex strands_mutex_;
+    std::unordered_map<int, std::shared_ptr<ThreadPool::Strand>> client_strands_;
+
+    /// One catch-up per replaying client, on a thread of its own so a
+    /// slow reader only holds up itself.
+    struct Replay {
+        std::thread         thread;
+        std::atomic<bool>   done{false};
+    };
+    std::mutex replays_mutex_;
+    std::list<Replay> replays_;
+
+    // Stopped first: its scrapes read the members above.
+    std::unique_ptr<MetricsServer> metrics_server_;
 };
 
 } // namespace altair
@@ -0,0 +1,145 @@
+#ifndef LATENCY_HPP
+#define LATENCY_HPP
+
+#include "metrics.hpp"
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace altair {
+
+/// CLOCK_MONOTONIC, in nanoseconds.
+inline uint64_t monotonicNs() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/// Where a frame from a satellite has got to, in monotonicNs(); 0 where
+/// it was not stamped.
+struct FrameTrace {
+    uint64_t rx_ns{0};          ///< its last byte was read from the UART
+    uint64_t handled_ns{0};     ///< its handler started
+};
+
+/// Histogram with a fixed relative precision over a wide range, in the
+/// HdrHistogram layout: values up to max_value fall in buckets at most
+/// 1 / 2^(sub-bucket bits - 1) of their value wide (under 1% for 2
+/// significant digits), whatever their magnitude.
+///
+/// record() is one relaxed atomic add; readers take a snapshot of the
+/// counts.
+class HdrHistogram {
+public:
+
+    explicit HdrHistogram(uint64_t max_value = 3600ull * 1000000000ull,
+                          int significant_digits = 2);
+
+    /// Records v, clamped to max_value.
+    void record(uint64_t v) {
+        if (v > max_value_) v = max_value_;
+        counts_[indexOf(v)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Current counts, one per bucket.
+    std::vector<uint64_t> snapshot() const;
+
+    /// Highest value equivalent to the q-quantile (0..1) of counts, a
+    /// snapshot or a difference of two; 0 if counts is empty.
+    uint64_t valueAt(const std::vector<uint64_t>& counts, double q) const;
+
+private:
+
+    size_t indexOf(uint64_t v) const {
+        const int bucket = 64 - __builtin_clzll(v | sub_bucket_mask_) - (half_magnitude_ + 1);
+        const uint64_t sub = v >> bucket;
+        return (size_t(bucket + 1) << half_magnitude_) + size_t(sub - half_count_);
+    }
+
+    /// Highest value recorded at index i.
+    uint64_t highestAt(size_t i) const;
+
+    uint64_t                                    max_value_;
+    int                                         half_magnitude_;  ///< log2(half_count_)
+    uint64_t                                    half_count_;
+    uint64_t                                    sub_bucket_mask_;
+    size_t                                      size_;
+    std::unique_ptr<std::atomic<uint64_t>[]>    counts_;
+};
+
+/// Stages of a satellite frame on its way to a client.
+enum class LatencyStage {
+    Decode,     ///< UART read -> decoded and dispatched
+    Dispatch,   ///< dispatched -> its handler starts (ring, journal, worker queue)
+    Fanout,     ///< handler starts -> this client's write starts
+    Write,      ///< this client's write, until the kernel has taken it all
+    Total,      ///< UART read -> this client's write done
+    Count
+};
+
+/// Per-stage latency of frames from UART ingress to client egress.
+///
+/// Stages are recorded from the stamps a frame carries; the client stages
+/// once per client the frame is written to. report() logs each stage's
+/// p50/p99/p999 over every interval, exportTo() makes them metrics.
+class LatencyTracer {
+public:
+
+    LatencyTracer();
+    ~LatencyTracer();
+
+    LatencyTracer(const LatencyTracer&) = delete;
+    LatencyTracer& operator=(const LatencyTracer&) = delete;
+
+    /// Records to - from in stage; skipped if from was not stamped.
+    void record(LatencyStage stage, uint64_t from_ns, uint64_t to_ns) {
+        if (from_ns && to_ns >= from_ns) {
+            stages_[static_cast<size_t>(stage)].record(to_ns - from_ns);
+        }
+    }
+
+    /// Starts logging, every interval, each stage's quantiles over that
+    /// interval. Replaces an earlier report().
+    void report(std::chrono::seconds interval);
+
+    /// Stops the reports.
+    void stop();
+
+    /// Registers altair_latency_seconds{stage, quantile} (since start)
+    /// and altair_latency_frames_total{stage}.
+    void exportTo(MetricsRegistry& registry);
+
+    static const char* stageName(LatencyStage stage);
+
+private:
+
+    void reportLoop(std::chrono::seconds interval);
+
+    HdrHistogram            stages_[static_cast<size_t>(LatencyStage::Count)];
+
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    bool                    stopping_{false};
+    std::thread             reporter_;
+};
+
+/// Stamps of a traced client send (ClientConnection::send()): its Write
+/// stage runs from start_ns until the last byte is taken by the kernel,
+/// which also ends the frame's Total.
+struct SendTrace {
+    LatencyTracer* tracer{nullptr};
+    uint64_t       rx_ns{0};        ///< FrameTrace::rx_ns
+    uint64_t       start_ns{0};     ///< the send started
+};
+
+} // namespace altair
+
+#endif // LATENCY_HPP
@@ -0,0 +1,119 @@
+#ifndef LOADGEN_HPP
+#define LOADGEN_HPP
+
+#include "eventloop.hpp"
+#include "protocol.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace altair {
+
+/// Workload for LoadGenerator.
+struct LoadProfile {
+    std::string                                 host{"127.0.0.1"};
+    uint16_t                                    port{8064};
+    /// Clients issuing range requests back to back.
+    unsigned                                    clients{10};
+    /// Clients that only listen to live broadcasts.
+    unsigned                                    subscribers{0};
+    /// (packet type, weight) pairs the request clients pick from.
+    std::vector<std::pair<uint8_t, unsigned>>   mix{{PROTO_PKT_SAMPLE, 1}};
+    std::string                                 from;
+    std::string                                 to;
+    std::chrono::seconds                        duration{10};
+    /// A response is complete after this long without a frame. Only lines
+    /// of the requested type dated in [from, to], and not today, count as
+    /// the response; live samples and other clients' replies do not.
+    std::chrono::milliseconds                   idle_timeout{500};
+    /// A request with no frame at all within this is counted as timed out.
+    std::chrono::milliseconds                   response_timeout{5000};
+    /// Pause between a response completing and the next request.
+    std::chrono::milliseconds                   think_time{0};
+    /// Subscribers disconnect and reconnect after this long; 0 = never.
+    std::chrono::milliseconds                   churn_interval{0};
+    /// Subscribers ask for satellite-tagged (ROUTED) frames from every
+    /// satellite instead of plain frames from the default one.
+    bool                                        routed_subscribers{false};
+    /// Sent by subscribers after connecting, subscriber i taking entry
+    /// i % size (e.g. PROTO_PKT_RATE requests).
+    std::vector<Packet>                         subscriber_requests;
+};
+
+/// Results of a LoadGenerator run. Latencies are in microseconds.
+struct LoadReport {
+    double              seconds{0};
+    uint64_t            requests{0};
+    uint64_t            frames_in{0};
+    uint64_t            bytes_in{0};
+    uint64_t            subscriber_frames{0};
+    uint64_t            connects{0};
+    uint64_t            connect_errors{0};
+    uint64_t            disconnects{0};
+    uint64_t            timeouts{0};
+    uint64_t            rejected{0};    ///< requests refused by admission control
+    std::vector<double> first_frame_us;
+    std::vector<double> complete_us;
+
+    /// Prints a human-readable summary.
+    void print(std::ostream& os);
+
+    /// Prints one JSON object (machine readable, for regression tracking).
+    void printJson(std::ostream& os);
+};
+
+/// Drives many simulated clients against a gateway from one event-loop
+/// thread and measures throughput, latency and errors.
+class LoadGenerator {
+public:
+
+    /// Called on the loop thread for every frame any session receives.
+    using FrameHook = std::function<void(size_t session, const Packet&,
+                                         EventLoop::Clock::time_point)>;
+
+    explicit LoadGenerator(LoadProfile profile);
+    ~LoadGenerator();
+
+    /// Installs a per-frame hook; must be called before run().
+    void onFrame(FrameHook hook) { frame_hook_ = std::move(hook); }
+
+    /// Runs the workload for profile.duration and returns the results.
+    LoadReport run();
+
+private:
+
+    struct Session;
+
+    void connect(Session& s);
+    void onEvents(Session& s, uint32_t events);
+    void onFrame(Session& s, const Packet& pkt);
+    bool inRange(const Session& s, const Packet& pkt) const;
+    void sendRequest(Session& s);
+    void finishRequest(Session& s);
+    void scheduleReconnect(Session& s);
+    void closeSession(Session& s);
+    uint8_t pickType();
+
+private:
+
+    LoadProfile                             profile_;
+    EventLoop                               loop_;
+    std::vector<std::unique_ptr<Session>>   sessions_;
+    LoadReport                              report_;
+    FrameHook                               frame_hook_;
+    bool                                    running_{false};
+    unsigned                                mix_total_{0};
+    std::string                             first_day_;     // "YYYY-MM-DD"
+    std::string                             last_day_;
+    uint64_t                                rng_{0x9E3779B97F4A7C15ull};
+};
+
+} // namespace altair
+
+#endif // LOADGEN_HPP
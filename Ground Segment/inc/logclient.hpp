@@ -4,23 +4,54 @@
 #include "clientconnection.hpp"
 #include "protocol.hpp"
 #include "protocol_defs.hpp"
+#include "filesink.hpp"
 
 #include <string>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace altair {
 
+/// How LogClient retrieves a multi-day range.
+struct RangeFetchOptions {
+    /// Split the range into one request per day (also used for
+    /// single-day ranges) instead of sending it as one request.
+    bool                        split_by_day{true};
+    /// Per-day requests kept in flight at once.
+    unsigned                    window{4};
+    /// A request with no further traffic for this long is considered complete.
+    std::chrono::milliseconds   idle_timeout{2000};
+};
+
 /// LogClient class that connects to a TCP server and handles log data.
 class LogClient {
 public:
 
-    LogClient(const std::string& host, uint16_t port);
+    LogClient(const std::string& host, uint16_t port,
+              FileSinkOptions sink_options = {});
     ~LogClient();
 
     /// Starts the client and connects to the server.
     void run();
 
+    /// Sets how multi-day ranges are fetched.
+    void setRangeFetchOptions(RangeFetchOptions options);
+
+    /// Overrides the output file for a log type (default samples.txt / events.txt).
+    void setOutputPath(uint8_t type, const std::string& path);
+
+    /// Requests a date range and stores it; blocks until complete.
+    void requestLogs(uint8_t type, const std::string& start_date, const std::string& end_date);
+
+    /// Prints every frame the gateway journaled from offset from on, then
+    /// live ones, as "<offset> [Sat N] <payload>"; blocks until disconnected.
+    void follow(uint64_t from);
+
 private:
     /// Handles incoming packets from the server.
     void connectToServer();
@@ -29,18 +60,62 @@ private:
     void handlePacket(const Packet& pkt);
 
     /// Saves the log data to a file.
-    void saveLogData(const std::vector<uint8_t>& data);
+    void saveLogData(const Packet::Payload& data);
 
-    /// Connects to the server and sets up the connection.
-    void requestLogs(uint8_t type, const std::string& start_date, const std::string& end_date);
+    /// Returns the (lazily opened) output file for a log type.
+    FileSink& sinkFor(uint8_t type);
+
+    /// Fetches each [first, last] date range as one of a window of
+    /// pipelined requests and writes them to the output file in order.
+    /// Blocks until every range is complete.
+    void fetchRanges(uint8_t type,
+                     const std::vector<std::pair<std::string, std::string>>& ranges);
+
+    /// Adds a received line to the outstanding request whose range it is
+    /// dated in, and completes the earlier requests it shows are over;
+    /// other lines are dropped (fetch_mutex_ held).
+    void routeLine(const Packet::Payload& data);
+
+    /// Marks outstanding requests whose lines stopped idle_timeout ago
+    /// complete (fetch_mutex_ held).
+    void completeIdleDays();
 
 private:
 
+    /// One request of a range fetch: a day, or the whole range unsplit.
+    struct DayFetch {
+        std::string                             date;       // YYYY-MM-DD, first day
+        std::string                             last;       // YYYY-MM-DD, last day
+        std::vector<uint8_t>                    data;
+        size_t                                  lines{0};
+        bool                                    complete{false};
+        std::chrono::steady_clock::time_point   sent;
+        std::chrono::steady_clock::time_point   last_line;
+        std::chrono::steady_clock::time_point   finished;
+    };
+
     std::string host_;
     uint16_t port_;
     std::shared_ptr<ClientConnection> connection_;
     std::atomic<bool> running_{false};
-    uint8_t current_type_{0};
+    std::atomic<bool> connected_{false};
+    std::atomic<uint8_t> current_type_{0};
+
+    FileSinkOptions sink_options_;
+    std::string samples_path_{"samples.txt"};
+    std::string events_path_{"events.txt"};
+    std::mutex sinks_mutex_;
+    std::unique_ptr<FileSink> samples_sink_;
+    std::unique_ptr<FileSink> events_sink_;
+
+    RangeFetchOptions fetch_options_;
+    std::mutex fetch_mutex_;
+    std::condition_variable fetch_cv_;
+    bool fetch_active_{false};
+    std::vector<DayFetch> days_;
+    size_t first_incomplete_{0};
+    size_t next_to_send_{0};
+    std::string fetch_today_;
 };
 
 } // namespace altair
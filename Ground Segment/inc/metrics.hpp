@@ -0,0 +1,239 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace altair {
+
+/// Cells per counter or histogram. Threads are spread over them, so a
+/// recording thread rarely shares a cache line with another one.
+constexpr size_t kMetricShards = 16;
+
+/// Label name/value pairs of one series, in the order they are rendered.
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+/// The calling thread's cell; threads take the cells in turn.
+inline size_t metricShard() {
+    static std::atomic<size_t> next{0};
+    thread_local const size_t shard = next.fetch_add(1, std::memory_order_relaxed)
+                                      % kMetricShards;
+    return shard;
+}
+
+/// Monotonic count. add() is one relaxed add on the thread's own cell;
+/// value() sums the cells.
+class Counter {
+public:
+
+    void add(uint64_t n = 1) {
+        cells_[metricShard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t sum = 0;
+        for (const auto& cell : cells_) sum += cell.value.load(std::memory_order_relaxed);
+        return sum;
+    }
+
+private:
+
+    struct alignas(64) Cell {
+        std::atomic<uint64_t> value{0};
+    };
+    Cell cells_[kMetricShards];
+};
+
+/// Value that goes up and down. Not sharded: set() must win outright.
+class Gauge {
+public:
+
+    void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { value_.fetch_add(n, std::memory_order_relaxed); }
+
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+
+    alignas(64) std::atomic<int64_t> value_{0};
+};
+
+/// Distribution of integer observations over fixed upper bounds (each
+/// bucket counts values <= its bound; the last one is +Inf). Every shard
+/// has its own buckets and sum.
+class Histogram {
+public:
+
+    /// bounds must be ascending.
+    explicit Histogram(std::vector<uint64_t> bounds)
+        : bounds_(std::move(bounds))
+        , lines_per_shard_((bounds_.size() + 2 + kPerLine - 1) / kPerLine)
+        , lines_(new Line[kMetricShards * lines_per_shard_])
+    {}
+
+    void observe(uint64_t v) {
+        size_t bucket = std::lower_bound(bounds_.begin(), bounds_.end(), v) - bounds_.begin();
+        const size_t base = metricShard() * lines_per_shard_ * kPerLine;
+        cell(base + bucket).fetch_add(1, std::memory_order_relaxed);
+        cell(base + bounds_.size() + 1).fetch_add(v, std::memory_order_relaxed);
+    }
+
+    const std::vector<uint64_t>& bounds() const { return bounds_; }
+
+    /// Observations per bucket (bounds().size() + 1 of them, not
+    /// cumulative) and their sum.
+    void snapshot(std::vector<uint64_t>& buckets, uint64_t& sum) const;
+
+private:
+
+    static constexpr size_t kPerLine = 64 / sizeof(std::atomic<uint64_t>);
+
+    struct alignas(64) Line {
+        std::atomic<uint64_t> cells[kPerLine] = {};
+    };
+
+    std::atomic<uint64_t>& cell(size_t i) const {
+        return lines_[i / kPerLine].cells[i % kPerLine];
+    }
+
+    std::vector<uint64_t>   bounds_;
+    size_t                  lines_per_shard_;
+    std::unique_ptr<Line[]> lines_;
+};
+
+/// Observes the nanoseconds it lived into a histogram.
+class ScopedTimer {
+public:
+
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        histogram_.observe(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+
+    Histogram&                              histogram_;
+    std::chrono::steady_clock::time_point   start_;
+};
+
+/// Named metrics, rendered in the Prometheus text format.
+///
+/// Registering takes a lock and returns a reference that stays valid for
+/// the registry's lifetime; keep it and record through it, which takes no
+/// lock. Asking again for the same name and labels returns the same
+/// metric. Callback metrics are read when rendering, for values that
+/// already live elsewhere (queue lengths, existing counters).
+class MetricsRegistry {
+public:
+
+    using ValueFn = std::function<double()>;
+
+    Counter& counter(const std::string& name, const std::string& help,
+                     const MetricLabels& labels = {});
+
+    Gauge& gauge(const std::string& name, const std::string& help,
+                 const MetricLabels& labels = {});
+
+    /// Observations are rendered multiplied by scale: 1e-9 turns
+    /// nanoseconds into the seconds Prometheus expects.
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         std::vector<uint64_t> bounds, double scale = 1.0,
+                         const MetricLabels& labels = {});
+
+    /// A counter or gauge whose value fn returns when rendered; fn runs
+    /// under the registry lock and must not register metrics.
+    void counterFn(const std::string& name, const std::string& help,
+                   const MetricLabels& labels, ValueFn fn);
+    void gaugeFn(const std::string& name, const std::string& help,
+                 const MetricLabels& labels, ValueFn fn);
+
+    /// Every metric, in the text exposition format (version 0.0.4).
+    std::string render() const;
+
+private:
+
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        MetricLabels                labels;
+        std::unique_ptr<Counter>    counter;
+        std::unique_ptr<Gauge>      gauge;
+        std::unique_ptr<Histogram>  histogram;
+        double                      scale{1.0};
+        ValueFn                     fn;
+    };
+
+    struct Family {
+        std::string                             name;
+        std::string                             help;
+        Type                                    type;
+        std::vector<std::unique_ptr<Series>>    series;
+    };
+
+    /// The series of name with labels, created empty if new. Throws
+    /// std::invalid_argument if name is registered with another type.
+    Series& series(const std::string& name, const std::string& help, Type type,
+                   const MetricLabels& labels);
+
+    mutable std::mutex                      mutex_;
+    std::vector<std::unique_ptr<Family>>    families_;
+};
+
+/// Traffic counters of one source of frames: a satellite link or the TCP
+/// clients together.
+struct LinkMetrics {
+    Counter* frames_in{nullptr};
+    Counter* bytes_in{nullptr};
+    Counter* frames_out{nullptr};
+    Counter* bytes_out{nullptr};
+    Counter* checksum_errors{nullptr};
+    Counter* resync_bytes{nullptr};
+
+    /// The altair_{frames,bytes}_{in,out}_total, altair_checksum_errors_total
+    /// and altair_resync_bytes_total series labelled source.
+    static LinkMetrics registerIn(MetricsRegistry& registry, const std::string& source);
+};
+
+/// Turns a FrameDecoder's running totals into LinkMetrics increments.
+/// Call report() after draining the decoder and reset() when it is
+/// replaced.
+class DecoderTally {
+public:
+
+    template <class Decoder>
+    void report(const Decoder& decoder, const LinkMetrics& metrics) {
+        metrics.frames_in->add(decoder.frames() - frames_);
+        metrics.checksum_errors->add(decoder.corruptFrames() - corrupt_);
+        metrics.resync_bytes->add(decoder.skippedBytes() - skipped_);
+        frames_  = decoder.frames();
+        corrupt_ = decoder.corruptFrames();
+        skipped_ = decoder.skippedBytes();
+    }
+
+    void reset() { frames_ = corrupt_ = skipped_ = 0; }
+
+private:
+
+    uint64_t frames_{0};
+    uint64_t corrupt_{0};
+    uint64_t skipped_{0};
+};
+
+} // namespace altair
+
+#endif // METRICS_HPP
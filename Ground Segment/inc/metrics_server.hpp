@@ -0,0 +1,60 @@
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include "eventloop.hpp"
+#include "metrics.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace altair {
+
+/// Parses "[ADDR:]PORT" into address (default 0.0.0.0) and port.
+bool parseMetricsEndpoint(const std::string& text, std::string& address, uint16_t& port);
+
+/// Minimal HTTP/1.0 server answering GET /metrics with registry.render().
+///
+/// Runs on an EventLoop thread of its own, one request per connection,
+/// so scrapes never run on a thread that moves frames. A client gets one
+/// second to send its request.
+class MetricsServer {
+public:
+
+    MetricsServer(const MetricsRegistry& registry, std::string address, uint16_t port);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /// Binds and starts serving; throws std::runtime_error if the
+    /// address cannot be bound.
+    void start();
+
+    void stop();
+
+    /// Port being listened on (resolved after start() when 0 was given).
+    uint16_t port() const { return port_; }
+
+private:
+
+    void acceptPending();
+
+    /// Reads one request from fd, answers it and closes fd.
+    void serve(int fd);
+
+private:
+
+    const MetricsRegistry&  registry_;
+    std::string             address_;
+    uint16_t                port_;
+    int                     listen_fd_{-1};
+    EventLoop               loop_;
+    std::thread             thread_;
+    std::atomic<bool>       running_{false};
+};
+
+} // namespace altair
+
+#endif // METRICS_SERVER_HPP
@@ -0,0 +1,179 @@
+#ifndef MULTICAST_HPP
+#define MULTICAST_HPP
+
+#include "packet.hpp"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace altair {
+
+/// Where multicast telemetry goes.
+struct MulticastOptions {
+    std::string group{"239.255.42.99"};
+    uint16_t    port{8065};
+    /// Local address of the interface to send or join on; empty lets the
+    /// routing table choose (use 127.0.0.1 to stay on loopback).
+    std::string interface;
+    uint8_t     ttl{1};
+    /// Frames queued for the sender thread before new ones are dropped.
+    size_t      max_queue{8192};
+};
+
+/// Parses "group:port" (port optional) into options. Returns false if
+/// the text is malformed.
+bool parseMulticastEndpoint(const std::string& text, MulticastOptions& options);
+
+/// Datagram layout, one frame per datagram (multi-byte fields big-endian):
+///
+///   "AM" | u8 version | u8 sat | u32 session | u64 seq | framed packet
+///
+/// seq counts every frame the publisher accepted, starting at 0; session
+/// is random per publisher so receivers notice a restarted gateway.
+constexpr uint8_t kMulticastVersion    = 1;
+constexpr size_t  kMulticastHeaderSize = 16;
+constexpr size_t  kMulticastMaxFrame   = 258;
+
+/// Sends frames to a multicast group from a background thread. Frames
+/// queued while the thread is busy go out together in sendmmsg() calls.
+class MulticastPublisher {
+public:
+
+    /// Opens the socket. Throws std::runtime_error on failure.
+    explicit MulticastPublisher(MulticastOptions options);
+    ~MulticastPublisher();
+
+    MulticastPublisher(const MulticastPublisher&) = delete;
+    MulticastPublisher& operator=(const MulticastPublisher&) = delete;
+
+    /// Queues one framed packet from satellite sat. Thread-safe; returns
+    /// false (and still consumes a sequence number, so receivers see the
+    /// gap) if the queue is full or the frame too long.
+    bool publish(uint8_t sat, const uint8_t* frame, size_t len);
+
+    /// Sends what is queued and stops the thread.
+    void close();
+
+    uint64_t sent() const;
+    uint64_t dropped() const;
+    /// sendmmsg() calls made; sent() / batches() is the mean batch size.
+    uint64_t batches() const;
+
+private:
+
+    struct Datagram {
+        std::array<uint8_t, kMulticastHeaderSize + kMulticastMaxFrame> bytes;
+        uint16_t size;
+    };
+
+    void senderLoop();
+    void sendBatch(const std::vector<Datagram>& batch);
+
+private:
+
+    MulticastOptions        options_;
+    int                     fd_{-1};
+    uint32_t                session_;
+
+    mutable std::mutex      mutex_;
+    std::condition_variable cv_;
+    std::vector<Datagram>   queue_;
+    uint64_t                next_seq_{0};
+    uint64_t                sent_{0};
+    uint64_t                dropped_{0};
+    uint64_t                batches_{0};
+    bool                    closing_{false};
+    std::thread             sender_;
+};
+
+/// Counters reported by MulticastReceiver::stats().
+struct MulticastStats {
+    uint64_t received{0};       ///< datagrams read
+    uint64_t delivered{0};      ///< frames handed to onFrame
+    uint64_t lost{0};           ///< sequence numbers reported as gaps
+    uint64_t reordered{0};      ///< frames that arrived ahead of a missing one
+    uint64_t late{0};           ///< duplicates, or frames after their gap was reported
+    uint64_t malformed{0};
+    uint64_t sessions{0};       ///< publishers (re)started while listening
+};
+
+/// Joins a multicast group and delivers frames in sequence order.
+///
+/// A frame that arrives ahead of a missing one is held until the missing
+/// one shows up, or until it has waited reorder_timeout (or the window is
+/// full); the missing range is then reported through onGap and delivery
+/// carries on. Single-threaded: call poll() from one thread, or watch
+/// fd() in an EventLoop and call drain().
+class MulticastReceiver {
+public:
+    using FrameCallback = std::function<void(uint8_t sat, uint64_t seq, const Packet&)>;
+    using GapCallback   = std::function<void(uint64_t first_missing, uint64_t count)>;
+
+    /// Joins the group. Throws std::runtime_error on failure.
+    explicit MulticastReceiver(const MulticastOptions& options,
+                               std::chrono::milliseconds reorder_timeout = std::chrono::milliseconds(20),
+                               size_t reorder_window = 1024);
+    ~MulticastReceiver();
+
+    MulticastReceiver(const MulticastReceiver&) = delete;
+    MulticastReceiver& operator=(const MulticastReceiver&) = delete;
+
+    void onFrame(FrameCallback cb) { frame_cb_ = std::move(cb); }
+    void onGap(GapCallback cb)     { gap_cb_ = std::move(cb); }
+
+    /// Waits up to timeout for datagrams, then delivers what is in order.
+    /// Returns the number of frames delivered.
+    size_t poll(std::chrono::milliseconds timeout);
+
+    /// Reads whatever is queued without blocking and delivers it.
+    size_t drain();
+
+    /// Delivers frames held past their reorder timeout; drain() does this
+    /// too, but an EventLoop user should also call it from a timer.
+    size_t expire();
+
+    int fd() const { return fd_; }
+
+    const MulticastStats& stats() const { return stats_; }
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Held {
+        uint8_t           sat;
+        Packet            packet;
+        Clock::time_point arrived;
+    };
+
+    void handleDatagram(const uint8_t* data, size_t len, Clock::time_point now);
+    size_t deliverInOrder();
+    void deliver(uint8_t sat, uint64_t seq, const Packet& pkt);
+
+private:
+
+    int                             fd_{-1};
+    std::chrono::milliseconds       reorder_timeout_;
+    size_t                          reorder_window_;
+    FrameCallback                   frame_cb_;
+    GapCallback                     gap_cb_;
+
+    bool                            synced_{false};
+    uint32_t                        session_{0};
+    uint64_t                        expected_{0};
+    std::map<uint64_t, Held>        held_;
+    size_t                          delivered_now_{0};
+    MulticastStats                  stats_;
+};
+
+} // namespace altair
+
+#endif // MULTICAST_HPP
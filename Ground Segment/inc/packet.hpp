@@ -5,16 +5,25 @@
 #include "protocol_defs.hpp"
 
 #include <cstdint>
+#include <memory_resource>
 #include <vector>
 
 namespace altair {
 
+/// The payload is allocated from the memory resource it was built with
+/// (see FrameDecoder). A copy allocates from the default resource, so
+/// copy a Packet, never move it, to keep it past the arena's lifetime.
 struct Packet {
 
+  using Payload = std::pmr::vector<uint8_t>;
+
   uint8_t length; 
   uint8_t packetId;
-  std::vector<uint8_t> payload;
+  Payload payload;
   uint8_t checksum;
+  /// CLOCK_MONOTONIC ns its last byte was read from a satellite link
+  /// (see monotonicNs()); 0 for packets that did not come from one.
+  uint64_t rx_ns{0};
   static constexpr uint8_t END_BYTE = PROTO_END_BYTE;
 
 };
@@ -0,0 +1,400 @@
+#ifndef PACKET_REGISTRY_HPP
+#define PACKET_REGISTRY_HPP
+
+#include "packet.hpp"
+#include "protocol_defs.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace altair {
+namespace packets {
+
+/// Largest payload one frame can carry: the length byte counts payload + id.
+constexpr size_t MAX_FRAME_PAYLOAD = 254;
+
+// ------------------------------------------------------------------------
+// Payload types
+//
+// Each type names its packet id, the payload sizes it accepts, and a
+// parse()/serialize() pair. parse() only sees payloads already inside
+// [min_size, max_size]. Views (std::string_view) point into the packet
+// they were parsed from and are valid for the handler call only.
+// ------------------------------------------------------------------------
+
+namespace detail {
+
+constexpr bool allDigits(std::string_view s) {
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+    }
+    return true;
+}
+
+inline std::string_view textOf(const Packet& pkt) {
+    return {reinterpret_cast<const char*>(pkt.payload.data()), pkt.payload.size()};
+}
+
+inline void appendText(Packet::Payload& out, std::string_view s) {
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+inline uint64_t loadBe64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v = (v << 8) | p[i];
+    return v;
+}
+
+inline void appendBe64(Packet::Payload& out, uint64_t v) {
+    for (int shift = 56; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(v >> shift));
+}
+
+} // namespace detail
+
+/// A line of text sent by the satellite (beacon, event or stored sample).
+template <uint8_t Id>
+struct TextLine {
+    static constexpr uint8_t id       = Id;
+    static constexpr size_t  min_size = 0;
+    static constexpr size_t  max_size = MAX_FRAME_PAYLOAD;
+
+    std::string_view text;
+
+    static std::optional<TextLine> parse(const Packet& pkt) {
+        return TextLine{detail::textOf(pkt)};
+    }
+
+    void serialize(Packet::Payload& out) const { detail::appendText(out, text); }
+};
+
+using KeepAlive  = TextLine<PROTO_PKT_KEEP_ALIVE>;
+using EventLine  = TextLine<PROTO_PKT_EVENT>;
+using SampleLine = TextLine<PROTO_PKT_SAMPLE>;
+
+/// Log request for the days first_day..last_day ("YYYYMMDDYYYYMMDD").
+template <uint8_t Id>
+struct RangeRequest {
+    static constexpr uint8_t id       = Id;
+    static constexpr size_t  min_size = 16;
+    static constexpr size_t  max_size = 16;
+
+    std::string_view first_day;   // YYYYMMDD
+    std::string_view last_day;    // YYYYMMDD
+
+    static std::optional<RangeRequest> parse(const Packet& pkt) {
+        std::string_view s = detail::textOf(pkt);
+        if (!detail::allDigits(s)) return std::nullopt;
+        return RangeRequest{s.substr(0, 8), s.substr(8, 8)};
+    }
+
+    void serialize(Packet::Payload& out) const {
+        detail::appendText(out, first_day);
+        detail::appendText(out, last_day);
+    }
+};
+
+using SampleRequest = RangeRequest<PROTO_PKT_SAMPLE>;
+using EventRequest  = RangeRequest<PROTO_PKT_EVENT>;
+
+/// Sets the satellite clock to local time "YYYYMMDDHHMMSS".
+struct TimeSync {
+    static constexpr uint8_t id       = PROTO_PKT_TIME_SYNC;
+    static constexpr size_t  min_size = 14;
+    static constexpr size_t  max_size = 14;
+
+    std::string_view timestamp;
+
+    static std::optional<TimeSync> parse(const Packet& pkt) {
+        std::string_view s = detail::textOf(pkt);
+        if (!detail::allDigits(s)) return std::nullopt;
+        return TimeSync{s};
+    }
+
+    void serialize(Packet::Payload& out) const { detail::appendText(out, timestamp); }
+};
+
+/// Gateway <-> client envelope: inner is addressed to / comes from sat.
+struct Routed {
+    static constexpr uint8_t id       = PROTO_PKT_ROUTED;
+    static constexpr size_t  min_size = 2;
+    static constexpr size_t  max_size = MAX_FRAME_PAYLOAD;
+
+    uint8_t sat;
+    Packet  inner;
+
+    static std::optional<Routed> parse(const Packet& pkt) {
+        // inner shares the envelope's memory resource and lifetime.
+        return Routed{pkt.payload[0],
+                      Packet{0, pkt.payload[1],
+                             Packet::Payload(pkt.payload.begin() + 2, pkt.payload.end(),
+                                             pkt.payload.get_allocator()),
+                             0}};
+    }
+
+    void serialize(Packet::Payload& out) const {
+        out.push_back(sat);
+        out.push_back(inner.packetId);
+        out.insert(out.end(), inner.payload.begin(), inner.payload.end());
+    }
+};
+
+/// Client asks for the journaled frames from offset from on, then live ones.
+struct Replay {
+    static constexpr uint8_t id       = PROTO_PKT_REPLAY;
+    static constexpr size_t  min_size = 8;
+    static constexpr size_t  max_size = 8;
+
+    uint64_t from;
+
+    static std::optional<Replay> parse(const Packet& pkt) {
+        return Replay{detail::loadBe64(pkt.payload.data())};
+    }
+
+    void serialize(Packet::Payload& out) const { detail::appendBe64(out, from); }
+};
+
+/// One journaled frame from satellite sat: its offset, id and payload.
+struct JournalEntry {
+    static constexpr uint8_t id       = PROTO_PKT_JOURNAL;
+    static constexpr size_t  min_size = 10;
+    static constexpr size_t  max_size = MAX_FRAME_PAYLOAD;
+
+    uint64_t         offset;
+    uint8_t          sat;
+    uint8_t          packet_id;
+    std::string_view payload;
+
+    static std::optional<JournalEntry> parse(const Packet& pkt) {
+        const uint8_t* p = pkt.payload.data();
+        return JournalEntry{detail::loadBe64(p), p[8], p[9],
+                            {reinterpret_cast<const char*>(p + 10), pkt.payload.size() - 10}};
+    }
+
+    void serialize(Packet::Payload& out) const {
+        detail::appendBe64(out, offset);
+        out.push_back(sat);
+        out.push_back(packet_id);
+        detail::appendText(out, payload);
+    }
+};
+
+/// Client asks for the live samples of sat (PROTO_SAT_ALL: of every
+/// satellite) thinned out as mode says (PROTO_RATE_*).
+struct RateRequest {
+    static constexpr uint8_t id       = PROTO_PKT_RATE;
+    static constexpr size_t  min_size = 6;
+    static constexpr size_t  max_size = 6;
+
+    uint8_t  sat;
+    uint8_t  mode;
+    uint32_t param;
+
+    static std::optional<RateRequest> parse(const Packet& pkt) {
+        const uint8_t* p = pkt.payload.data();
+        uint32_t param = (uint32_t(p[2]) << 24) | (uint32_t(p[3]) << 16)
+                       | (uint32_t(p[4]) << 8) | p[5];
+        if (p[1] > PROTO_RATE_AVG || (p[1] != PROTO_RATE_ALL && param == 0)) return std::nullopt;
+        return RateRequest{p[0], p[1], param};
+    }
+
+    void serialize(Packet::Payload& out) const {
+        out.push_back(sat);
+        out.push_back(mode);
+        for (int shift = 24; shift >= 0; shift -= 8) out.push_back(static_cast<uint8_t>(param >> shift));
+    }
+};
+
+/// The gateway refused a packet_id command for sat; the client may try
+/// again after retry_ms.
+struct Rejected {
+    static constexpr uint8_t id       = PROTO_PKT_REJECTED;
+    static constexpr size_t  min_size = 4;
+    static constexpr size_t  max_size = 4;
+
+    uint8_t  sat;
+    uint8_t  packet_id;
+    uint16_t retry_ms;
+
+    static std::optional<Rejected> parse(const Packet& pkt) {
+        const uint8_t* p = pkt.payload.data();
+        return Rejected{p[0], p[1], static_cast<uint16_t>((p[2] << 8) | p[3])};
+    }
+
+    void serialize(Packet::Payload& out) const {
+        out.push_back(sat);
+        out.push_back(packet_id);
+        out.push_back(static_cast<uint8_t>(retry_ms >> 8));
+        out.push_back(static_cast<uint8_t>(retry_ms));
+    }
+};
+
+/// Cached state of satellite sat: its last frame of packet_id, or its mode
+/// if packet_id is PROTO_STATE_MODE.
+struct StateEntry {
+    static constexpr uint8_t id       = PROTO_PKT_STATE;
+    static constexpr size_t  min_size = 2;
+    static constexpr size_t  max_size = MAX_FRAME_PAYLOAD;
+
+    uint8_t          sat;
+    uint8_t          packet_id;
+    std::string_view payload;
+
+    static std::optional<StateEntry> parse(const Packet& pkt) {
+        const uint8_t* p = pkt.payload.data();
+        return StateEntry{p[0], p[1],
+                          {reinterpret_cast<const char*>(p + 2), pkt.payload.size() - 2}};
+    }
+
+    void serialize(Packet::Payload& out) const {
+        out.push_back(sat);
+        out.push_back(packet_id);
+        detail::appendText(out, payload);
+    }
+};
+
+/// Handed to the handler for an id the registry does not know (known ==
+/// false) or a payload its type rejected (known == true).
+struct InvalidPacket {
+    const Packet& raw;
+    bool          known;
+};
+
+/// Builds the packet for a typed payload, or nullopt if it does not fit
+/// the type's size limits.
+template <class T>
+std::optional<Packet> encode(const T& value,
+                             std::pmr::memory_resource* mr = std::pmr::get_default_resource()) {
+    Packet pkt{0, T::id, Packet::Payload(mr), 0};
+    value.serialize(pkt.payload);
+    if (pkt.payload.size() < T::min_size || pkt.payload.size() > T::max_size) {
+        return std::nullopt;
+    }
+    return pkt;
+}
+
+/// Lambdas-as-handler helper: Overloaded{[](const Sample&){}, ...}.
+template <class... Fs>
+struct Overloaded : Fs... {
+    using Fs::operator()...;
+};
+template <class... Fs>
+Overloaded(Fs...) -> Overloaded<Fs...>;
+
+// ------------------------------------------------------------------------
+// Registry
+// ------------------------------------------------------------------------
+
+namespace detail {
+
+template <class... Types>
+constexpr bool uniqueIds() {
+    constexpr uint8_t ids[] = {Types::id...};
+    for (size_t i = 0; i < sizeof...(Types); ++i) {
+        for (size_t j = i + 1; j < sizeof...(Types); ++j) {
+            if (ids[i] == ids[j]) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/// The packet types one direction of a link may carry.
+///
+/// dispatch() indexes a 256-entry table built at compile time, checks the
+/// payload size against the type's limits, parses it, and calls the
+/// handler with the typed value. Anything else reaches the handler as an
+/// InvalidPacket. A handler that misses a registered type fails to compile.
+template <class... Types>
+class PacketRegistry {
+    static_assert(sizeof...(Types) > 0, "empty packet registry");
+    static_assert(detail::uniqueIds<Types...>(), "two packet types share an id");
+    static_assert(((Types::min_size <= Types::max_size) && ...),
+                  "packet type with min_size > max_size");
+    static_assert(((Types::max_size <= MAX_FRAME_PAYLOAD) && ...),
+                  "packet type larger than one frame");
+    static_assert(((Types::id != PROTO_PKT_NONE) && ...),
+                  "PROTO_PKT_NONE is reserved for empty envelopes");
+
+public:
+
+    template <class T>
+    static constexpr bool contains = (std::is_same_v<T, Types> || ...);
+
+    static constexpr bool knows(uint8_t id) { return ((Types::id == id) || ...); }
+
+    /// True if dispatch() would hand pkt to a typed handler.
+    static bool accepts(const Packet& pkt) {
+        bool ok = false;
+        dispatch(pkt, [&](const auto& value) {
+            ok = !std::is_same_v<std::decay_t<decltype(value)>, InvalidPacket>;
+        });
+        return ok;
+    }
+
+    template <class Handler>
+    static void dispatch(const Packet& pkt, Handler&& handler) {
+        using H = std::remove_reference_t<Handler>;
+        static_assert((std::is_invocable_v<H&, const Types&> && ...),
+                      "handler does not accept every packet type of the registry");
+        static_assert(std::is_invocable_v<H&, const InvalidPacket&>,
+                      "handler does not accept InvalidPacket");
+
+        table<H>[pkt.packetId](handler, pkt);
+    }
+
+private:
+
+    template <class H>
+    using Entry = void (*)(H&, const Packet&);
+
+    template <class H, class T>
+    static void invoke(H& handler, const Packet& pkt) {
+        size_t n = pkt.payload.size();
+        if (n >= T::min_size && n <= T::max_size) {
+            if (auto value = T::parse(pkt)) {
+                handler(static_cast<const T&>(*value));
+                return;
+            }
+        }
+        handler(InvalidPacket{pkt, true});
+    }
+
+    template <class H>
+    static void unknown(H& handler, const Packet& pkt) {
+        handler(InvalidPacket{pkt, false});
+    }
+
+    template <class H>
+    static constexpr std::array<Entry<H>, 256> makeTable() {
+        std::array<Entry<H>, 256> t{};
+        for (auto& e : t) e = &unknown<H>;
+        ((t[Types::id] = &invoke<H, Types>), ...);
+        return t;
+    }
+
+    template <class H>
+    static constexpr std::array<Entry<H>, 256> table = makeTable<H>();
+};
+
+/// Client -> gateway.
+using ClientRequests     = PacketRegistry<SampleRequest, EventRequest, Routed, Replay,
+                                          RateRequest>;
+/// Gateway -> satellite.
+using SatelliteCommands  = PacketRegistry<SampleRequest, EventRequest, TimeSync>;
+/// Satellite -> gateway.
+using SatelliteTelemetry = PacketRegistry<KeepAlive, EventLine, SampleLine>;
+/// Gateway -> client.
+using GatewayFeed        = PacketRegistry<SampleLine, Routed, JournalEntry, StateEntry,
+                                          Rejected>;
+
+} // namespace packets
+} // namespace altair
+
+#endif // PACKET_REGISTRY_HPP
@@ -2,8 +2,12 @@
 #define PROTOCOL_HPP
 
 #include "packet.hpp"
+#include <memory_resource>
 #include <optional>
+#include <string>
+#include <utility>
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
 namespace altair {
@@ -14,8 +18,78 @@ public:
     /// Computes the checksum for a given packet.
     static std::vector<uint8_t> pack(const Packet& pkt);
 
-    /// Unpacks a raw byte buffer into a Packet structure.
-    static std::optional<Packet> unpack(const uint8_t* buffer, uint16_t len);
+    /// As pack(), allocating the frame from mr.
+    static std::pmr::vector<uint8_t> pack(const Packet& pkt, std::pmr::memory_resource* mr);
+
+    /// Unpacks a raw byte buffer into a Packet structure whose payload is
+    /// allocated from mr.
+    static std::optional<Packet> unpack(const uint8_t* buffer, uint16_t len,
+                                        std::pmr::memory_resource* mr
+                                            = std::pmr::get_default_resource());
+
+    /// Builds a log range request ("YYYY-MM-DD" or "YYYYMMDD" dates).
+    /// Returns nullopt if the dates are malformed.
+    static std::optional<Packet> makeRangeRequest(uint8_t type,
+                                                  const std::string& start_date,
+                                                  const std::string& end_date);
+
+    /// Wraps inner in a PROTO_PKT_ROUTED envelope for satellite sat,
+    /// allocated from mr. Returns nullopt if the result would not fit in
+    /// one frame.
+    static std::optional<Packet> makeRouted(uint8_t sat, const Packet& inner,
+                                            std::pmr::memory_resource* mr
+                                                = std::pmr::get_default_resource());
+
+    /// Splits a PROTO_PKT_ROUTED packet into (satellite id, inner packet).
+    static std::optional<std::pair<uint8_t, Packet>> unwrapRouted(const Packet& routed);
+};
+
+/// Incremental decoder for a byte stream of framed packets.
+///
+/// Bytes may arrive in arbitrary chunks; frames spanning chunks are
+/// reassembled. A byte that cannot start a valid frame (zero length, bad
+/// checksum or missing end byte) is skipped so the stream resynchronises.
+class FrameDecoder {
+public:
+
+    /// Payloads of the packets returned by next() come from mr.
+    explicit FrameDecoder(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : resource_(mr) {}
+
+    /// Allocate the payloads of later packets from mr.
+    void setResource(std::pmr::memory_resource* mr) { resource_ = mr; }
+
+    /// Appends raw bytes to the pending buffer. Packets next() returns
+    /// from then on carry rx_ns, the time the bytes were read; drain
+    /// after every feed for each packet to get the read that completed it.
+    void feed(const uint8_t* data, size_t len, uint64_t rx_ns = 0);
+
+    /// Returns the next complete frame, or nullopt if more bytes are needed.
+    std::optional<Packet> next();
+
+    /// Bytes discarded while resynchronising.
+    uint64_t skippedBytes() const { return skipped_; }
+
+    /// Frames returned by next().
+    uint64_t frames() const { return frames_; }
+
+    /// Frames rejected (zero length, bad checksum or end byte) right after
+    /// a good one: one per corruption, however many bytes the resync skips.
+    uint64_t corruptFrames() const { return corrupt_; }
+
+    /// Bytes buffered but not yet decoded.
+    size_t pending() const { return buffer_.size() - pos_; }
+
+private:
+
+    std::vector<uint8_t> buffer_;
+    size_t               pos_{0};
+    uint64_t             skipped_{0};
+    uint64_t             frames_{0};
+    uint64_t             corrupt_{0};
+    bool                 in_step_{false};   ///< the last frame was good
+    uint64_t             rx_ns_{0};
+    std::pmr::memory_resource* resource_;
 };
 
 } //namespace altair
@@ -16,6 +16,40 @@ constexpr uint8_t PROTO_PKT_EVENT = 0x02;
 constexpr uint8_t PROTO_PKT_SAMPLE = 0x03;
 constexpr uint8_t PROTO_PKT_TIME_SYNC = 0x04;
 
+// Gateway <-> client only: [sat_id][packet_id][payload] for a given satellite.
+constexpr uint8_t PROTO_PKT_ROUTED = 0x10;
+// Inner packet id of a ROUTED packet that carries nothing (subscribe only).
+constexpr uint8_t PROTO_PKT_NONE = 0x00;
+// Satellite id addressing every satellite.
+constexpr uint8_t PROTO_SAT_ALL = 0xFF;
+
+// Client -> gateway: [u64 offset, big-endian]; every frame journaled from
+// that offset on, then live ones, as JOURNAL packets.
+constexpr uint8_t PROTO_PKT_REPLAY = 0x11;
+// Gateway -> client: [u64 offset, big-endian][sat_id][packet_id][payload].
+constexpr uint8_t PROTO_PKT_JOURNAL = 0x12;
+
+// Gateway -> client: [sat_id][packet_id][payload], the last frame of that id
+// the satellite sent, ahead of live ROUTED packets on subscribing.
+constexpr uint8_t PROTO_PKT_STATE = 0x13;
+// Inner packet id of a STATE packet whose payload is the satellite mode.
+constexpr uint8_t PROTO_STATE_MODE = 0x80;
+
+// Client -> gateway: [sat_id][mode][u32 param, big-endian]; thins out the
+// live samples of sat_id (PROTO_SAT_ALL: of every satellite) sent to it.
+constexpr uint8_t PROTO_PKT_RATE = 0x14;
+// RATE modes; param is in milliseconds except for EVERY_NTH.
+constexpr uint8_t PROTO_RATE_ALL = 0x00;        // every sample (param unused)
+constexpr uint8_t PROTO_RATE_INTERVAL = 0x01;   // at most one sample per param ms
+constexpr uint8_t PROTO_RATE_EVERY_NTH = 0x02;  // one sample in param
+constexpr uint8_t PROTO_RATE_MIN = 0x03;        // per param ms, each field's minimum
+constexpr uint8_t PROTO_RATE_MAX = 0x04;        // ... maximum
+constexpr uint8_t PROTO_RATE_AVG = 0x05;        // ... mean
+
+// Gateway -> client: [sat_id][packet_id][u16 retry after ms, big-endian];
+// a command was refused because too many of the client's were waiting.
+constexpr uint8_t PROTO_PKT_REJECTED = 0x15;
+
 } // namespace altair
 
 #endif // PROTOCOL_DEFS_HPP
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef RATE_LIMIT_HPP
+#define RATE_LIMIT_HPP
+
+#include "protocol_defs.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace altair {
+
+/// How a client wants live samples thinned out (a PROTO_PKT_RATE request).
+struct RateSpec {
+    uint8_t  mode{PROTO_RATE_ALL};  ///< PROTO_RATE_*
+    uint32_t param{0};              ///< milliseconds, or N for EVERY_NTH
+
+    bool passesAll() const { return mode == PROTO_RATE_ALL; }
+};
+
+/// Parses "all", "interval:MS", "nth:N", "min:MS", "max:MS" or "avg:MS".
+std::optional<RateSpec> parseRateSpec(std::string_view text);
+
+/// The text parseRateSpec() reads back as spec.
+std::string formatRateSpec(const RateSpec& spec);
+
+/// Output state of one client for one satellite's samples.
+///
+/// Decisions are made as samples arrive, with no timer: an interval, or a
+/// rollup window, closes with the first sample after its end. A rollup is
+/// one sample line in the usual format, "timestamp,field,field,...", with
+/// the last timestamp of the window and each numeric field's minimum,
+/// maximum or mean; fields that are not numbers keep their last value.
+class RateFilter {
+public:
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class Verdict {
+        Drop,       ///< send nothing
+        Pass,       ///< send the sample as it is
+        Rollup,     ///< send rollup() instead
+    };
+
+    explicit RateFilter(RateSpec spec) : spec_(spec) {}
+
+    /// Offers one live sample line received at now.
+    Verdict offer(std::string_view sample, Clock::time_point now);
+
+    /// The rollup of the window offer() just closed; valid until the next
+    /// offer().
+    std::string_view rollup() const { return rollup_; }
+
+private:
+
+    struct Field {
+        uint64_t    n{0};           ///< numeric values in the window
+        double      min{0}, max{0}, sum{0};
+        int         decimals{0};
+        std::string text;           ///< last value, for fields that are not numbers
+    };
+
+    /// Adds sample to the open window.
+    void accumulate(std::string_view sample);
+
+    /// Writes the open window's rollup into rollup_ and empties it.
+    void close();
+
+private:
+
+    RateSpec            spec_;
+    uint64_t            seen_{0};
+    bool                started_{false};
+    Clock::time_point   window_start_;
+
+    // Open rollup window; fields_ beyond width_ are spare.
+    size_t              width_{0};
+    std::string         stamp_;
+    std::string         ending_;
+    std::vector<Field>  fields_;
+    std::string         rollup_;
+};
+
+/// Everything a client asked for with RATE requests: a default for every
+/// satellite and overrides for some, each with its own filter state.
+class ClientRates {
+public:
+
+    /// Applies spec to sat, or to every satellite for PROTO_SAT_ALL
+    /// (dropping earlier overrides).
+    void set(uint8_t sat, RateSpec spec);
+
+    /// Filter for sat's samples, or nullptr if they all pass.
+    RateFilter* filterFor(uint8_t sat);
+
+    /// True if no satellite is thinned out.
+    bool passesAll() const { return all_.passesAll() && by_sat_.empty(); }
+
+private:
+
+    RateSpec                                all_;
+    std::unordered_map<uint8_t, RateSpec>   by_sat_;
+    std::unordered_map<uint8_t, RateFilter> filters_;
+};
+
+} // namespace altair
+
+#endif // RATE_LIMIT_HPP
@@ -0,0 +1,140 @@
+#ifndef SAT_STATE_HPP
+#define SAT_STATE_HPP
+
+#include "packet.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace altair {
+
+/// One cached text frame of a satellite.
+struct StateText {
+    uint64_t    t_ns{0};        ///< CLOCK_REALTIME at the gateway; 0 = none yet
+    uint8_t     size{0};
+    char        text[255]{};
+
+    std::string_view view() const { return {text, size}; }
+};
+
+/// Last known state of one satellite: the newest keep-alive, sample and
+/// event it sent, and the mode they report ("NORMAL", "SAFE", ...).
+/// Trivially copyable, so it can live in shared memory.
+struct SatState {
+    uint64_t    updated_ns{0};  ///< CLOCK_REALTIME of the last change
+    char        mode[16]{};     ///< NUL-terminated; empty until reported
+    StateText   keep_alive;
+    StateText   sample;
+    StateText   event;
+};
+
+/// A SatState behind a sequence lock: seq is odd while the writer is
+/// changing state, and 0 if the satellite has never been heard from.
+struct SatStateSlot {
+    std::atomic<uint32_t>   seq{0};
+    SatState                state;
+};
+
+/// Shared header at the start of a state table mapping; the slots, one
+/// per satellite id, follow at kSatStateDataOffset.
+struct SatStateHeader {
+    char                    magic[8];
+    uint32_t                slots;
+    uint32_t                slot_size;
+    std::atomic<uint32_t>   closed;
+};
+
+constexpr char   kSatStateMagic[8]     = {'A', 'L', 'T', 'S', 'T', 'A', '0', '1'};
+constexpr size_t kSatStateDataOffset   = 64;
+constexpr size_t kSatStateSlots        = 256;
+
+static_assert(std::is_trivially_copyable_v<SatState>, "SatState must be copyable as bytes");
+
+/// Copies the state out of slot; false if it was never written. Retries
+/// while the writer is busy, so it never blocks it and makes no syscall.
+inline bool readSatState(const SatStateSlot& slot, SatState& out) {
+    while (true) {
+        uint32_t before = slot.seq.load(std::memory_order_acquire);
+        if (before == 0) return false;
+        if (before & 1) continue;
+
+        std::memcpy(&out, &slot.state, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == before) return true;
+    }
+}
+
+/// The gateway's cache of every satellite's last known state.
+///
+/// Frames are offered to update() on the UART thread. Samples and events
+/// carry a timestamp, so the ones answering a log request, which are
+/// older, do not replace the latest. Any thread may read() at any time;
+/// the table is a sequence lock per satellite, with no mutex on either
+/// side.
+///
+/// With a name, the table lives in POSIX shared memory (/dev/shm/<name>)
+/// and other processes read it with SatStateReader.
+class SatStateTable {
+public:
+
+    /// Private table, or shared as /dev/shm/<name> (replacing any old
+    /// one) if name is not empty. Throws std::runtime_error on failure.
+    explicit SatStateTable(const std::string& name = {});
+
+    /// Marks a shared table closed and removes its name.
+    ~SatStateTable();
+
+    SatStateTable(const SatStateTable&) = delete;
+    SatStateTable& operator=(const SatStateTable&) = delete;
+
+    /// Records pkt from satellite sat if it is a newer keep-alive, sample
+    /// or event; returns true if the state changed. Single writer.
+    bool update(uint8_t sat, const Packet& pkt);
+
+    /// Copies out the state of sat; false if it has sent nothing yet.
+    bool read(uint8_t sat, SatState& out) const { return readSatState(slots_[sat], out); }
+
+    const std::string& name() const { return name_; }
+
+private:
+
+    std::string     name_;
+    SatStateHeader* header_{nullptr};
+    SatStateSlot*   slots_{nullptr};
+    size_t          mapped_{0};
+};
+
+/// Reads a state table another process shares; every read is a copy out
+/// of the mapping.
+class SatStateReader {
+public:
+
+    /// Opens /dev/shm/<name>. Throws std::runtime_error if it does not
+    /// exist or is not a state table.
+    explicit SatStateReader(const std::string& name);
+    ~SatStateReader();
+
+    SatStateReader(const SatStateReader&) = delete;
+    SatStateReader& operator=(const SatStateReader&) = delete;
+
+    /// Copies out the state of sat; false if it has sent nothing yet.
+    bool read(uint8_t sat, SatState& out) const { return readSatState(slots_[sat], out); }
+
+    /// True once the gateway has shut down.
+    bool writerClosed() const { return header_->closed.load(std::memory_order_acquire) != 0; }
+
+private:
+
+    const SatStateHeader*   header_{nullptr};
+    const SatStateSlot*     slots_{nullptr};
+    size_t                  mapped_{0};
+};
+
+} // namespace altair
+
+#endif // SAT_STATE_HPP
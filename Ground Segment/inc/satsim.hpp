@@ -0,0 +1,163 @@
+#ifndef SATSIM_HPP
+#define SATSIM_HPP
+
+#include "eventloop.hpp"
+#include "packet.hpp"
+#include "protocol.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace altair {
+
+/// Behaviour of the simulated NanoSat.
+struct SatSimOptions {
+    /// Optional symlink created to the pty slave (e.g. /tmp/ttyALTAIR).
+    std::string                 link_path;
+    /// Keep-alive beacon period (BEACON_MS in the firmware config).
+    std::chrono::milliseconds   beacon_interval{6000};
+    /// Synthetic samples generated per second (the board takes ~1).
+    double                      sample_rate{1.0};
+    /// Also transmit every generated sample as PROTO_PKT_SAMPLE. The
+    /// firmware only stores them; this is the high-rate benchmark source.
+    bool                        stream_samples{false};
+    /// Synthetic events (mode changes) generated per second; 0 = none.
+    double                      event_rate{0.0};
+    /// Emulate the wire time of every byte at this baud rate (10 bits per
+    /// byte, 8N1); 0 writes as fast as the pty accepts.
+    unsigned                    baud_rate{0};
+    /// Hold beacons and samples until a PROTO_PKT_TIME_SYNC arrives, as
+    /// Init_Task does on the board.
+    bool                        wait_for_time_sync{true};
+    /// Days of history on the synthetic SD card (LOGGER_MAX_RECENT_FILES).
+    unsigned                    history_days{7};
+    /// Samples stored per history day.
+    unsigned                    history_samples_per_day{1440};
+    /// Samples kept per day on top of the history; older ones are not stored.
+    size_t                      max_samples_per_day{200000};
+    /// Bytes that may wait for the pty before new output is dropped.
+    size_t                      max_tx_backlog{4 * 1024 * 1024};
+    uint32_t                    seed{1};
+};
+
+/// Counters reported by NanoSatSimulator::stats().
+struct SatSimStats {
+    uint64_t frames_out{0};
+    uint64_t bytes_out{0};
+    uint64_t frames_in{0};
+    uint64_t range_requests{0};
+    uint64_t samples_generated{0};
+    uint64_t frames_dropped{0};
+};
+
+/// Host-side stand-in for the NanoSat board.
+///
+/// Opens a pseudo-terminal whose slave side the gateway uses as its UART
+/// device and speaks the firmware protocol on the master side: framed
+/// keep-alive beacons, synthetic samples and events kept on an in-memory
+/// "SD card", range requests answered line by line, and TIME_SYNC setting
+/// the simulated clock. Everything runs on one EventLoop thread.
+class NanoSatSimulator {
+public:
+
+    /// Called for every frame just before its last byte is written to the pty.
+    using FrameObserver = std::function<void(const Packet&, EventLoop::Clock::time_point)>;
+
+    explicit NanoSatSimulator(SatSimOptions options);
+    ~NanoSatSimulator();
+
+    NanoSatSimulator(const NanoSatSimulator&) = delete;
+    NanoSatSimulator& operator=(const NanoSatSimulator&) = delete;
+
+    /// Path of the pty slave to pass to the gateway.
+    const std::string& devicePath() const { return slave_path_; }
+
+    /// Installs an observer; must be called before run().
+    void onFrameWritten(FrameObserver observer) { observer_ = std::move(observer); }
+
+    /// Serves the pty until stop() is called.
+    void run();
+
+    /// Makes run() return. Thread-safe.
+    void stop();
+
+    /// Snapshot of the counters. Thread-safe.
+    SatSimStats stats();
+
+private:
+
+    struct DayLog {
+        std::vector<std::string> samples;
+        std::vector<std::string> events;
+    };
+
+    void openPty();
+    void onReadable();
+    void handlePacket(const Packet& pkt);
+    void handleTimeSync(std::string_view stamp);
+    void handleRangeRequest(uint8_t type, std::string_view first_day,
+                            std::string_view last_day);
+
+    void startActivity();
+    void beacon();
+    void generateSample();
+    void generateEvent();
+    void fillHistory();
+
+    /// Frames the packet and queues it for the pty (drops it if the
+    /// backlog is full).
+    void transmit(const Packet& pkt);
+    void transmitText(uint8_t id, const std::string& text);
+    void pumpTx();
+
+    std::time_t now() const;
+    static std::string formatTimestamp(std::time_t t);
+    static std::string formatDate(std::time_t t);
+    std::string makeSampleLine(std::time_t t);
+
+private:
+
+    SatSimOptions                   options_;
+    EventLoop                       loop_;
+    int                             master_fd_{-1};
+    int                             slave_fd_{-1};
+    std::string                     slave_path_;
+    FrameDecoder                    decoder_;
+    FrameObserver                   observer_;
+
+    bool                            active_{false};
+    std::time_t                     clock_offset_{0};
+    std::mt19937                    rng_;
+    std::map<std::string, DayLog>   store_;
+    std::string                     mode_{"NORMAL"};
+    std::string                     last_sample_;
+    EventLoop::Clock::time_point    next_sample_;
+    EventLoop::Clock::time_point    next_event_;
+
+    std::deque<uint8_t>             tx_;
+    /// Cumulative end offset of each queued frame (packet kept for the observer).
+    std::deque<std::pair<uint64_t, Packet>> tx_frames_;
+    uint64_t                        tx_written_{0};
+    uint64_t                        tx_announced_{0};
+    bool                            tx_blocked_{false};
+    bool                            tx_timer_armed_{false};
+    EventLoop::Clock::time_point    tx_epoch_;
+    uint64_t                        tx_paced_bytes_{0};
+
+    std::mutex                      stats_mutex_;
+    SatSimStats                     stats_;
+};
+
+} // namespace altair
+
+#endif // SATSIM_HPP
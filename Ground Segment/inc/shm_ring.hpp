@@ -0,0 +1,165 @@
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include "packet.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace altair {
+
+/// Shared header at the start of a broadcast ring mapping.
+///
+/// The data area that follows holds 8-byte aligned records
+///
+///   u32 record size (0 = skip to the start) | u8 sat | u8 0 | u16 frame
+///   length | u64 sequence | framed packet bytes
+///
+/// head is the byte position after the last published record; reserve is
+/// the position the writer may be writing up to. Positions only grow and
+/// are reduced modulo capacity to index the data.
+struct ShmRingHeader {
+    char                    magic[8];
+    uint64_t                capacity;
+    std::atomic<uint32_t>   closed;
+
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint64_t>   reserve;
+
+    alignas(64) std::atomic<uint32_t> notify;   // futex word
+    std::atomic<uint32_t>   waiters;
+};
+
+constexpr char   kShmRingMagic[8]     = {'A', 'L', 'T', 'S', 'H', 'M', '0', '1'};
+constexpr size_t kShmRingDataOffset   = 256;
+constexpr size_t kShmRingRecordHead   = 16;
+/// Largest framed packet: length byte, id, 254 payload bytes, xor, end.
+constexpr size_t kShmRingMaxFrame     = 258;
+
+/// Single producer of a broadcast ring in POSIX shared memory
+/// (/dev/shm/<name>).
+///
+/// Every frame is written once, whatever the number of readers; the
+/// writer never waits for them, so a reader that falls a full ring behind
+/// loses the oldest frames. Readers that block are woken through a futex,
+/// only when some are actually waiting.
+class ShmRingWriter {
+public:
+
+    /// Creates (replacing) the ring; capacity is rounded up to a power of
+    /// two. Throws std::runtime_error on failure.
+    ShmRingWriter(const std::string& name, size_t capacity = 8 << 20);
+
+    /// Marks the ring closed and removes its name.
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    /// Publishes one framed packet from satellite sat. Frames longer than
+    /// kShmRingMaxFrame are refused (returns false). Not thread-safe.
+    bool publish(uint8_t sat, const uint8_t* frame, size_t len);
+
+    const std::string& name() const { return name_; }
+
+    uint64_t published() const { return seq_; }
+
+private:
+
+    std::string     name_;
+    ShmRingHeader*  header_{nullptr};
+    uint8_t*        data_{nullptr};
+    size_t          mapped_{0};
+    uint64_t        mask_{0};
+    uint64_t        head_{0};
+    uint64_t        seq_{0};
+};
+
+/// One reader of a broadcast ring. Its cursor is private, so readers
+/// never write to the shared mapping except to announce they are about to
+/// sleep in wait().
+///
+/// Each frame is copied to a small reader-local buffer and validated
+/// against the writer's reserve position before it is handed out, so a
+/// frame overwritten mid-read is never delivered; the reader skips to the
+/// newest data instead and counts what it lost.
+class ShmRingReader {
+public:
+
+    /// A frame as handed to the visitor; valid until the next call.
+    struct Frame {
+        uint8_t         sat;
+        uint64_t        seq;
+        const uint8_t*  data;
+        size_t          size;
+    };
+
+    /// Opens an existing ring and starts at its newest data. Throws
+    /// std::runtime_error if it does not exist or is not a ring.
+    explicit ShmRingReader(const std::string& name);
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    /// Hands every available frame to visit(const Frame&); returns how many.
+    /// No syscall.
+    template <class Visitor>
+    size_t poll(Visitor&& visit, size_t max_frames = SIZE_MAX);
+
+    /// Next frame decoded as (satellite, Packet), or nullopt if none is
+    /// available yet.
+    std::optional<std::pair<uint8_t, Packet>> next();
+
+    /// Spins briefly, then sleeps until new data is published or timeout
+    /// expires. Returns true if data is available.
+    bool wait(std::chrono::microseconds timeout);
+
+    /// True once the writer has shut down.
+    bool writerClosed() const { return header_->closed.load(std::memory_order_acquire) != 0; }
+
+    /// Frames skipped because the writer lapped this reader.
+    uint64_t lost() const { return lost_; }
+
+private:
+
+    /// Copies the record at cursor_ into frame_; false if none is ready.
+    bool fetch(Frame& out);
+
+    bool available() const {
+        return header_->head.load(std::memory_order_acquire) != cursor_;
+    }
+
+private:
+
+    ShmRingHeader*  header_{nullptr};
+    const uint8_t*  data_{nullptr};
+    size_t          mapped_{0};
+    uint64_t        capacity_{0};
+    uint64_t        mask_{0};
+    uint64_t        cursor_{0};
+    uint64_t        next_seq_{0};
+    bool            synced_{false};
+    uint64_t        lost_{0};
+    uint8_t         frame_[kShmRingMaxFrame];
+};
+
+template <class Visitor>
+size_t ShmRingReader::poll(Visitor&& visit, size_t max_frames) {
+    size_t n = 0;
+    Frame frame;
+    while (n < max_frames && fetch(frame)) {
+        visit(static_cast<const Frame&>(frame));
+        ++n;
+    }
+    return n;
+}
+
+} // namespace altair
+
+#endif // SHM_RING_HPP
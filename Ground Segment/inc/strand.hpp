@@ -0,0 +1,100 @@
+#pragma once
+
+#include "threadpool.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace altair {
+
+namespace ThreadPool {
+
+/// Serialises work posted from one source onto a shared ThreadPool.
+///
+/// Jobs posted to a Strand run one at a time, in post order, on whichever
+/// worker picks the strand up; different strands run in parallel. A drain
+/// pass runs at most m_batch jobs before re-queueing itself so one busy
+/// source cannot pin a worker.
+class Strand : public std::enable_shared_from_this<Strand>
+{
+public:
+    using job = std::function<void()>;
+
+    static std::shared_ptr<Strand> create(ThreadPool& pool,
+                                          Priority lane = Priority::Normal,
+                                          std::size_t batch = 32)
+    {
+        return std::shared_ptr<Strand>(new Strand(pool, lane, batch));
+    }
+
+    void post(job fn)
+    {
+        bool schedule = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.push_back(std::move(fn));
+            if (!m_scheduled) {
+                m_scheduled = true;
+                schedule = true;
+            }
+        }
+        if (schedule)
+            m_pool.submit_with_priority(m_lane, [self = shared_from_this()]() { self->drain(); });
+    }
+
+    std::size_t pending()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+private:
+    Strand(ThreadPool& pool, Priority lane, std::size_t batch)
+        : m_pool(pool), m_lane(lane), m_batch(batch ? batch : 1)
+    {}
+
+    void drain()
+    {
+        for (std::size_t n = 0; n < m_batch; ++n) {
+            job fn;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_queue.empty()) {
+                    m_scheduled = false;
+                    return;
+                }
+                fn = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            try {
+                fn();
+            } catch(const std::exception& e) {
+                std::cerr << "Caught exception from Strand job:\n"
+                    << "exc.what() = " << e.what() << '\n';
+            }
+        }
+
+        bool more;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            more = !m_queue.empty();
+            m_scheduled = more;
+        }
+        if (more)
+            m_pool.submit_with_priority(m_lane, [self = shared_from_this()]() { self->drain(); });
+    }
+
+    ThreadPool& m_pool;
+    Priority m_lane;
+    std::size_t m_batch;
+    std::mutex m_mutex;
+    std::deque<job> m_queue;
+    bool m_scheduled = false;
+};
+
+} /* namespace ThreadPool */
+
+} // namespace altair
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "threadpool.hpp"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace altair {
+
+namespace ThreadPool {
+
+/// A static DAG of stages run over a ThreadPool without blocking workers.
+///
+/// Nodes are added once, then run() is called per work item with a fresh
+/// Context. Each node is scheduled as a continuation of its predecessors,
+/// so a worker is only occupied while a stage is actually executing.
+///
+/// With ordered runs (the default) node N of a run also waits for node N
+/// of the previous run, which turns the graph into a pipeline: different
+/// items occupy different stages concurrently, yet every stage sees the
+/// items in submission order. Stateful stages (e.g. a stream decoder)
+/// therefore need no locking of their own.
+///
+/// The graph must not be modified while runs are in flight.
+template <class Context>
+class TaskGraph
+{
+public:
+    using node_id = std::size_t;
+    using node_fn = std::function<void(Context&)>;
+
+    explicit TaskGraph(bool ordered_runs = true) : m_ordered(ordered_runs)
+    {}
+
+    node_id add(node_fn fn, Priority lane = Priority::Normal)
+    {
+        m_nodes.push_back(node{std::move(fn), lane, {}});
+        m_tails.emplace_back();
+        return m_nodes.size() - 1;
+    }
+
+    /// Declare that `after` consumes the output of `before`. Nodes must be
+    /// linked in insertion order, which keeps the graph acyclic by
+    /// construction.
+    void precede(node_id before, node_id after)
+    {
+        if (before >= after || after >= m_nodes.size())
+            throw ThreadPoolException(bad_edge);
+        m_nodes[after].preds.push_back(before);
+    }
+
+    std::size_t size() const
+    {
+        return m_nodes.size();
+    }
+
+    /// Schedule every node for ctx. The returned future is ready once all
+    /// nodes have finished; a throwing node fails it and skips dependants.
+    Future<void> run(ThreadPool& pool, std::shared_ptr<Context> ctx)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Future<void>> done(m_nodes.size());
+
+        for (node_id i = 0; i < m_nodes.size(); ++i) {
+            const node& n = m_nodes[i];
+
+            std::vector<Future<void>> deps;
+            deps.reserve(n.preds.size() + 1);
+            for (node_id p : n.preds)
+                deps.push_back(done[p]);
+            if (m_ordered && m_tails[i].valid())
+                deps.push_back(m_tails[i]);
+
+            Future<void> gate = deps.empty()
+                ? make_ready_future(pool, n.lane)
+                : when_all(deps);
+
+            const node_fn* fn = &n.fn;
+            done[i] = gate.then(n.lane, [fn, ctx]() { (*fn)(*ctx); });
+
+            // A failed item must not wedge the stage for later ones.
+            if (m_ordered)
+                m_tails[i] = done[i].completion();
+        }
+        return when_all(done);
+    }
+
+private:
+    struct node
+    {
+        node_fn fn;
+        Priority lane;
+        std::vector<node_id> preds;
+    };
+
+    std::vector<node> m_nodes;
+    std::vector<Future<void>> m_tails;
+    bool m_ordered;
+    std::mutex m_mutex;
+
+    constexpr static const char* const bad_edge =
+    "TaskGraph::precede requires an earlier node to precede a later one";
+};
+
+} /* namespace ThreadPool */
+
+} // namespace altair
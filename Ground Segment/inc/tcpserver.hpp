@@ -11,57 +11,127 @@
 #include <set>
 
 #include "clientconnection.hpp"
+#include "eventloop.hpp"
+#include "metrics.hpp"
 #include "packet.hpp"
 
 namespace altair {
 
 /// Accepts TCP clients on a port and forwards their Packets via a callback.
+///
+/// The port is served by one or more acceptor shards. Each shard owns a
+/// listening socket bound with SO_REUSEPORT, so the kernel spreads new
+/// connections across them, and an EventLoop thread that accepts with
+/// accept4() and then serves the reads of every client it accepted.
+/// Client sockets are non-blocking, so a slow reader queues output on its
+/// connection instead of stalling the shard (see ClientConnection).
+/// Callbacks for a client always run on its shard's thread.
+///
+/// Packets go to a sink (see ClientConnection) installed with setSink();
+/// setMessageCallback() installs MessageCallbackSink, the std::function
+/// adapter, instead.
 class TCPServer {
 public:
     /// Called for every Packet from any client: (clientPtr, packet)
     using MessageCallback =
       std::function<void(std::shared_ptr<ClientConnection>, const Packet&)>;
 
+    /// Sink that forwards to a MessageCallback.
+    struct MessageCallbackSink {
+        MessageCallback cb;
+        void onPacket(ClientConnection& client, const Packet& pkt) {
+            if (cb) cb(client.shared_from_this(), pkt);
+        }
+    };
+
     /// Called when a client connects or disconnects: (clientPtr)
     using ClientCallback = std::function<void(std::shared_ptr<ClientConnection>)>;
 
-    explicit TCPServer(uint16_t port);
+    /// shards = 0 starts one per core.
+    explicit TCPServer(uint16_t port, unsigned shards = 0);
     ~TCPServer();
 
     /// Begin listening + accepting in background.
     void start();
     
-    /// Stop accepting clients and close the server socket.
+    /// Stop accepting clients, shut down the connected ones and close the
+    /// server sockets.
     void stop();
 
     /// Set the global handler for incoming Packets :contentReference[oaicite:0]{index=0}.
     void setMessageCallback(MessageCallback cb);
 
+    /// Deliver the Packets of every client accepted from now on to
+    /// sink.onPacket(ClientConnection&, const Packet&), on the client's
+    /// shard thread. The sink must outlive the server.
+    template <class Sink>
+    void setSink(Sink& sink);
+
     /// Set the handler for when a client connects.
     void setClientConnectedCallback(ClientCallback cb);
 
     /// Set the handler for when a client disconnects.
     void setClientDisconnectedCallback(ClientCallback cb);
 
+    /// Counts the traffic of every client accepted from now on, as source
+    /// "clients", and the clients connected. Call before start().
+    void instrument(MetricsRegistry& registry);
+
+    /// Clients accepted from now on are disconnected once more than bytes
+    /// of their output are queued (see ClientConnection::setOutputLimit()).
+    void setOutputLimit(size_t bytes);
+
+    /// Port being listened on (resolved after start() when 0 was given).
+    uint16_t port() const { return port_; }
+
+    /// Number of acceptor shards.
+    unsigned shardCount() const { return shard_count_; }
+
 private:
 
-    /// Accept clients in a loop until stopped.
-    void acceptLoop();
+    struct Shard {
+        int         listen_fd{-1};
+        EventLoop   loop;
+        std::thread thread;
+    };
+
+    /// Opens one SO_REUSEPORT listener on port_.
+    int openListener();
+
+    /// Accept every pending connection on the shard without blocking.
+    void acceptPending(Shard& shard);
+
+    /// Wire up a freshly accepted socket and serve it on the shard's loop.
+    void serve(Shard& shard, int client_fd);
 
 private:
 
-    int                                             server_fd_{-1};
     uint16_t                                        port_;
+    unsigned                                        shard_count_;
+    std::vector<std::unique_ptr<Shard>>             shards_;
     std::atomic<bool>                               running_{false};
-    std::thread                                     accept_thread_;
-    MessageCallback                                 messageCb_;
+    MessageCallbackSink                             messageSink_;
+    void*                                           sink_{nullptr};
+    void                                          (*attachSink_)(ClientConnection&, void*){nullptr};
     std::mutex                                      clients_mutex_;
     ClientCallback                                  clientConnectedCb_;
     ClientCallback                                  clientDisconnectedCb_;
     std::set<std::shared_ptr<ClientConnection>>     clients_;
+    LinkMetrics                                     metrics_;
+    Gauge*                                          connected_{nullptr};
+    Counter*                                        slow_{nullptr};
+    size_t                                          output_limit_{ClientConnection::kDefaultOutputLimit};
 
 };
 
+template <class Sink>
+void TCPServer::setSink(Sink& sink) {
+    sink_       = &sink;
+    attachSink_ = [](ClientConnection& client, void* s) {
+        client.setSink(*static_cast<Sink*>(s));
+    };
+}
+
 } // namespace altair
 
 #endif // TCPSERVER_HPP
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <functional>
 #include <iostream>
 #include <future>
 #include <list>
@@ -9,15 +16,99 @@
 #include <mutex>
 #include <optional>
 #include <queue>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace altair {
 
 namespace ThreadPool {
-    
+
+using clock = std::chrono::steady_clock;
+
+/// Scheduling lanes; a worker always drains a higher lane before a lower one.
+enum class Priority : unsigned
+{
+    High = 0,   // live keep-alive / event frames
+    Normal,     // default for submit()
+    Low,        // bulk work such as history parsing
+    Count
+};
+
+constexpr std::size_t lane_count = static_cast<std::size_t>(Priority::Count);
+
+/// Log2-bucketed histogram of queue-wait times (nanoseconds).
+/// Recording is a single relaxed atomic increment.
+class WaitHistogram
+{
+public:
+    static constexpr std::size_t bucket_count = 64;
+
+    void record(std::chrono::nanoseconds wait)
+    {
+        uint64_t ns = wait.count() > 0 ? static_cast<uint64_t>(wait.count()) : 0;
+        m_buckets[bucket_for(ns)].fetch_add(1, std::memory_order_relaxed);
+        m_total.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const
+    {
+        return m_total.load(std::memory_order_relaxed);
+    }
+
+    /// Upper bound (ns) of the bucket holding the given percentile (0..100).
+    uint64_t percentile(double pct) const
+    {
+        uint64_t total = count();
+        if (total == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(pct / 100.0 * total);
+        if (rank >= total)
+            rank = total - 1;
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen > rank)
+                return bucket_upper(i);
+        }
+        return bucket_upper(bucket_count - 1);
+    }
+
+    uint64_t bucket(std::size_t i) const
+    {
+        return m_buckets[i].load(std::memory_order_relaxed);
+    }
+
+    static uint64_t bucket_upper(std::size_t i)
+    {
+        return i >= 63 ? UINT64_MAX : (uint64_t(1) << i) - 1;
+    }
+
+    void reset()
+    {
+        for (auto& b : m_buckets)
+            b.store(0, std::memory_order_relaxed);
+        m_total.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    static std::size_t bucket_for(uint64_t ns)
+    {
+        std::size_t i = 0;
+        while (ns) {
+            ns >>= 1;
+            ++i;
+        }
+        return i < bucket_count ? i : bucket_count - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, bucket_count> m_buckets{};
+    std::atomic<uint64_t> m_total{0};
+};
+
 namespace details {    
 
     class TaskBase
@@ -25,6 +116,9 @@ namespace details {
     public:
         virtual ~TaskBase() {}
         virtual void run_me() = 0;
+
+        clock::time_point enqueued_at{};
+        clock::time_point deadline = clock::time_point::max();
     };
 
     template <class Result>
@@ -68,8 +162,115 @@ namespace details {
                                               std::forward<Args>(args)...);
     }
 
+    template <class T>
+    using stored_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    /// State shared between a Future and whoever fulfils it. Continuations
+    /// registered before completion run on the completing thread.
+    template <class T>
+    class SharedState
+    {
+    public:
+        void set_value(stored_t<T> value)
+        {
+            complete([&] { m_value.emplace(std::move(value)); });
+        }
+
+        void set_exception(std::exception_ptr error)
+        {
+            complete([&] { m_error = std::move(error); });
+        }
+
+        void on_ready(std::function<void()> cb)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_ready) {
+                    m_continuations.push_back(std::move(cb));
+                    return;
+                }
+            }
+            cb();
+        }
+
+        bool is_ready() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_ready;
+        }
+
+        void wait() const
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&] { return m_ready; });
+        }
+
+        /// Only meaningful once ready.
+        std::exception_ptr error() const
+        {
+            return m_error;
+        }
+
+        const stored_t<T>& value() const
+        {
+            wait();
+            if (m_error)
+                std::rethrow_exception(m_error);
+            return *m_value;
+        }
+
+    private:
+        template <class Setter>
+        void complete(Setter&& setter)
+        {
+            std::vector<std::function<void()>> continuations;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                setter();
+                m_ready = true;
+                continuations.swap(m_continuations);
+            }
+            m_cv.notify_all();
+            for (auto& cb : continuations)
+                cb();
+        }
+
+        mutable std::mutex m_mutex;
+        mutable std::condition_variable m_cv;
+        bool m_ready = false;
+        std::optional<stored_t<T>> m_value;
+        std::exception_ptr m_error;
+        std::vector<std::function<void()>> m_continuations;
+    };
+
 } /* namespace details */
 
+template <class T>
+class Future;
+
+/// Bounds and triggers for an elastic pool.
+struct ElasticConfig
+{
+    unsigned min_threads = 1;
+    unsigned max_threads = 1;
+    /// Grow when a task waited longer than this and no worker is idle.
+    std::chrono::nanoseconds target_wait = std::chrono::milliseconds(5);
+    /// Retire workers (down to min_threads) that were spare, idle the
+    /// whole time, for this long.
+    std::chrono::milliseconds idle_timeout = std::chrono::seconds(30);
+};
+
+/// Point-in-time view of pool sizing, for metrics export.
+struct PoolStats
+{
+    unsigned threads = 0;
+    unsigned idle_threads = 0;
+    unsigned peak_threads = 0;
+    uint64_t threads_started = 0;
+    uint64_t threads_retired = 0;
+    std::chrono::nanoseconds smoothed_wait{0};
+};
+
 class ThreadPoolException : public std::exception
 {
 public:
@@ -97,41 +298,272 @@ public:
         } catch(...) {
             throw ThreadPoolException(constructor_failed);
         }
+        m_peak_threads = num_threads;
+        m_threads_started = num_threads;
+    }
+
+    /// Elastic mode: starts with min_threads and resizes itself between
+    /// the configured bounds based on measured queue wait.
+    explicit ThreadPool(const ElasticConfig& config)
+        : m_done(false), m_elastic(true), m_config(config)
+    {
+        if (config.max_threads == 0 || config.min_threads > config.max_threads)
+            throw ThreadPoolException(bad_elastic_config);
+        try {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_threads.reserve(config.max_threads);
+            for (unsigned i = 0; i < config.min_threads; ++i)
+                spawn_worker();
+        } catch(...) {
+            throw ThreadPoolException(constructor_failed);
+        }
     }
     
     template <class Func, class... Args>
     auto submit(Func&& func, Args&&... args)
+    {
+        return submit_to(Priority::Normal, clock::time_point::max(),
+                         std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    /// Enqueue on a specific lane; FIFO within the lane.
+    template <class Func, class... Args>
+    auto submit_with_priority(Priority lane, Func&& func, Args&&... args)
+    {
+        return submit_to(lane, clock::time_point::max(),
+                         std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    /// Enqueue on a lane ordered earliest-deadline-first. Tasks without a
+    /// deadline on the same lane run after every task that has one.
+    template <class Func, class... Args>
+    auto submit_with_deadline(Priority lane, clock::time_point deadline,
+                              Func&& func, Args&&... args)
+    {
+        return submit_to(lane, deadline,
+                         std::forward<Func>(func), std::forward<Args>(args)...);
+    }
+
+    /// Like submit_with_priority(), but returns a Future that supports
+    /// non-blocking continuations (then / when_all).
+    template <class Func, class... Args>
+    auto submit_async(Priority lane, Func&& func, Args&&... args)
+    {
+        using Result = std::invoke_result_t<Func, Args...>;
+        auto state = std::make_shared<details::SharedState<Result>>();
+        submit_with_priority(lane,
+            [state, f = std::forward<Func>(func),
+             args = std::tuple(std::forward<Args>(args)...)]()
+            {
+                try {
+                    if constexpr (std::is_void_v<Result>) {
+                        std::apply(f, args);
+                        state->set_value({});
+                    } else {
+                        state->set_value(std::apply(f, args));
+                    }
+                } catch(...) {
+                    state->set_exception(std::current_exception());
+                }
+            });
+        return Future<Result>(std::move(state), this, lane);
+    }
+
+    /// Queue-wait distribution observed by tasks of the given lane.
+    const WaitHistogram& queue_wait_histogram(Priority lane) const
+    {
+        return m_wait_histograms[index_of(lane)];
+    }
+
+    /// Current sizing and smoothed queue wait across all lanes.
+    PoolStats stats()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PoolStats st;
+        st.threads = static_cast<unsigned>(m_threads.size());
+        st.idle_threads = m_idle;
+        st.peak_threads = m_peak_threads;
+        st.threads_started = m_threads_started;
+        st.threads_retired = m_threads_retired;
+        st.smoothed_wait = std::chrono::nanoseconds(m_smoothed_wait_ns);
+        return st;
+    }
+
+    /// Number of tasks currently waiting on the given lane.
+    std::size_t queue_depth(Priority lane)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lanes[index_of(lane)].size();
+    }
+    
+    ~ThreadPool()
+    {
+        destroy();
+    }
+    
+private:
+    using task_ptr = std::unique_ptr<details::TaskBase>;
+
+    struct deadline_later
+    {
+        bool operator()(const task_ptr& a, const task_ptr& b) const
+        {
+            if (a->deadline != b->deadline)
+                return a->deadline > b->deadline;
+            return a->enqueued_at > b->enqueued_at;
+        }
+    };
+
+    /// One lane: plain FIFO for undated tasks, a min-heap for dated ones.
+    struct lane
+    {
+        std::queue<task_ptr, std::list<task_ptr>> fifo;
+        std::priority_queue<task_ptr, std::vector<task_ptr>, deadline_later> edf;
+
+        bool empty() const { return fifo.empty() && edf.empty(); }
+        std::size_t size() const { return fifo.size() + edf.size(); }
+
+        task_ptr pop()
+        {
+            task_ptr ret;
+            if (!edf.empty()) {
+                // priority_queue::top() is const; the pop right after makes
+                // moving out of it safe.
+                ret = std::move(const_cast<task_ptr&>(edf.top()));
+                edf.pop();
+            } else {
+                ret = std::move(fifo.front());
+                fifo.pop();
+            }
+            return ret;
+        }
+    };
+
+    static constexpr std::size_t index_of(Priority lane)
+    {
+        return static_cast<std::size_t>(lane) < lane_count
+            ? static_cast<std::size_t>(lane)
+            : static_cast<std::size_t>(Priority::Normal);
+    }
+
+    template <class Func, class... Args>
+    auto submit_to(Priority lane, clock::time_point deadline,
+                   Func&& func, Args&&... args)
     {
         try {
             auto task = details::make_task(
                 std::forward<Func>(func), std::forward<Args>(args)...
             );
             auto task_future = task->get_future();
-            add_task(std::move(task));
+            task->deadline = deadline;
+            add_task(index_of(lane), std::move(task));
             return task_future;
         } catch(...) {
             throw ThreadPoolException(adding_task_failed);
         }
     }
-    
-    ~ThreadPool()
+
+    bool all_lanes_empty() const
     {
-        destroy();
+        for (const auto& l : m_lanes)
+            if (!l.empty())
+                return false;
+        return true;
     }
-    
-private:
-    using task_ptr = std::unique_ptr<details::TaskBase>;
-    
+
     std::atomic_bool m_done;
-    std::queue<task_ptr, std::list<task_ptr>> m_queue;
+    std::array<lane, lane_count> m_lanes;
+    std::array<WaitHistogram, lane_count> m_wait_histograms;
     std::vector<std::thread> m_threads;
     std::condition_variable m_condition;
     std::mutex m_mutex;
-    
+
+    // Elastic sizing; everything below is guarded by m_mutex.
+    bool m_elastic = false;
+    ElasticConfig m_config;
+    std::vector<std::thread> m_retired;
+    unsigned m_idle = 0;
+    unsigned m_peak_threads = 0;
+    uint64_t m_threads_started = 0;
+    uint64_t m_threads_retired = 0;
+    int64_t m_smoothed_wait_ns = 0;
+    // Fewest idle workers seen when one took a task, this window.
+    unsigned m_idle_low = 0;
+    unsigned m_retire_quota = 0;
+    clock::time_point m_window_start = clock::now();
+
+    void spawn_worker()
+    {
+        m_threads.push_back(std::thread(&ThreadPool::wait_for_work, this));
+        ++m_threads_started;
+        if (m_threads.size() > m_peak_threads)
+            m_peak_threads = static_cast<unsigned>(m_threads.size());
+    }
+
+    /// Called by a worker on itself; the handle is joined later by
+    /// reap_retired() or destroy(), after the thread has left the pool.
+    void retire_self()
+    {
+        auto self = std::this_thread::get_id();
+        for (auto it = m_threads.begin(); it != m_threads.end(); ++it) {
+            if (it->get_id() == self) {
+                m_retired.push_back(std::move(*it));
+                m_threads.erase(it);
+                ++m_threads_retired;
+                return;
+            }
+        }
+    }
+
+    /// Whether the calling idle worker should retire. Each idle_timeout
+    /// the workers that stayed idle throughout become a retirement
+    /// quota. Any worker can retire, so ones that keep getting woken for
+    /// a trickle of tasks still make way.
+    bool surplus_worker()
+    {
+        if (m_retire_quota == 0) {
+            auto now = clock::now();
+            if (now - m_window_start < m_config.idle_timeout)
+                return false;
+            unsigned spare = m_threads.size() > m_config.min_threads
+                ? static_cast<unsigned>(m_threads.size()) - m_config.min_threads : 0;
+            m_retire_quota = std::min(m_idle_low, spare);
+            m_idle_low = m_idle;
+            m_window_start = now;
+            if (m_retire_quota > 1)
+                m_condition.notify_all();
+        }
+        if (m_retire_quota == 0)
+            return false;
+        --m_retire_quota;
+        return true;
+    }
+
+    void reap_retired()
+    {
+        for (auto& thread : m_retired)
+            if (thread.joinable())
+                thread.join();
+        m_retired.clear();
+    }
+
+    void maybe_grow(std::chrono::nanoseconds wait)
+    {
+        if (wait <= m_config.target_wait || m_idle > 0 || all_lanes_empty())
+            return;
+        if (m_threads.size() >= m_config.max_threads)
+            return;
+        reap_retired();
+        spawn_worker();
+    }
+
     void wait_for_work()
     {
         while (!m_done) {
-            auto task = try_pop();
+            bool retired = false;
+            auto task = try_pop(retired);
+            if (retired)
+                return;
             if (task) {
                 try {
                     task.value()->run_me();
@@ -144,35 +576,78 @@ private:
         }
     }
     
-    std::optional<task_ptr> try_pop()
+    std::optional<task_ptr> try_pop(bool& retired)
     {
         std::unique_lock<std::mutex> lock(m_mutex);
-        m_condition.wait(lock, [&]() 
+        auto ready = [&]() 
             { 
-                return m_done || !m_queue.empty(); 
-            });
+                return m_done || !all_lanes_empty(); 
+            };
+
+        ++m_idle;
+        if (!m_elastic) {
+            m_condition.wait(lock, ready);
+        } else {
+            while (!ready()) {
+                if (surplus_worker()) {
+                    --m_idle;
+                    retire_self();
+                    retired = true;
+                    return std::nullopt;
+                }
+                m_condition.wait_for(lock, m_config.idle_timeout);
+            }
+        }
+        --m_idle;
+        if (m_elastic)
+            m_idle_low = std::min(m_idle_low, m_idle);
         
         if (m_done)
             return std::nullopt;
         
-        auto ret = std::optional(std::move(m_queue.front()));
-        m_queue.pop();
-        return ret;
+        for (std::size_t i = 0; i < lane_count; ++i) {
+            if (m_lanes[i].empty())
+                continue;
+            auto ret = std::optional(m_lanes[i].pop());
+            auto wait = clock::now() - (*ret)->enqueued_at;
+            m_wait_histograms[i].record(wait);
+            m_smoothed_wait_ns += (std::chrono::nanoseconds(wait).count() - m_smoothed_wait_ns) / 8;
+            if (m_elastic)
+                maybe_grow(wait);
+            return ret;
+        }
+        return std::nullopt;
     }
     
     template <class Task>
-    void add_task(std::unique_ptr<Task>&& task)
+    void add_task(std::size_t lane_index, std::unique_ptr<Task>&& task)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_queue.push(std::move(task));
+        task->enqueued_at = clock::now();
+        auto& l = m_lanes[lane_index];
+        if (task->deadline == clock::time_point::max())
+            l.fifo.push(std::move(task));
+        else
+            l.edf.push(std::move(task));
+        // An elastic pool may have shrunk to zero workers.
+        if (m_elastic && m_threads.empty())
+            spawn_worker();
         m_condition.notify_one();
     }
     
     void destroy()
     {
-        m_done = true;
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+            threads.swap(m_threads);
+            for (auto& thread : m_retired)
+                threads.push_back(std::move(thread));
+            m_retired.clear();
+        }
         m_condition.notify_all();
-        for (auto& thread: m_threads)
+        for (auto& thread: threads)
             if (thread.joinable())
                 thread.join();
     }
@@ -182,8 +657,209 @@ private:
     
     constexpr static const char* const adding_task_failed = 
     "ThreadPool::submit caught exception while enqueueing task";
+
+    constexpr static const char* const bad_elastic_config =
+    "ElasticConfig requires 0 < max_threads and min_threads <= max_threads";
+};
+
+
+/// Result of ThreadPool::submit_async(). Copyable; get() may be called from
+/// any number of holders and returns a reference to the shared value.
+template <class T>
+class Future
+{
+public:
+    Future() = default;
+
+    bool valid() const { return static_cast<bool>(m_state); }
+    bool is_ready() const { return m_state->is_ready(); }
+    void wait() const { m_state->wait(); }
+
+    decltype(auto) get() const
+    {
+        if constexpr (std::is_void_v<T>)
+            m_state->value();
+        else
+            return m_state->value();
+    }
+
+    /// Schedule func on the pool once this future is ready, on the same lane.
+    /// func receives the value (nothing for Future<void>); an exception in
+    /// this future skips func and propagates to the returned one.
+    template <class Func>
+    auto then(Func&& func) const
+    {
+        return then(m_lane, std::forward<Func>(func));
+    }
+
+    template <class Func>
+    auto then(Priority lane, Func&& func) const
+    {
+        using Result = typename continuation_result<Func>::type;
+        auto next = std::make_shared<details::SharedState<Result>>();
+        auto fn = std::make_shared<std::decay_t<Func>>(std::forward<Func>(func));
+        auto state = m_state;
+        ThreadPool* pool = m_pool;
+
+        m_state->on_ready([state, next, fn, pool, lane]() {
+            if (auto error = state->error()) {
+                next->set_exception(error);
+                return;
+            }
+            auto body = [state, next, fn]() {
+                try {
+                    if constexpr (std::is_void_v<Result>) {
+                        invoke_with(*fn, *state);
+                        next->set_value({});
+                    } else {
+                        next->set_value(invoke_with(*fn, *state));
+                    }
+                } catch(...) {
+                    next->set_exception(std::current_exception());
+                }
+            };
+            if (pool)
+                pool->submit_with_priority(lane, std::move(body));
+            else
+                body();
+        });
+        return Future<Result>(std::move(next), pool, lane);
+    }
+
+    /// A Future<void> that becomes ready when this one does, success or not.
+    Future<void> completion() const
+    {
+        auto next = std::make_shared<details::SharedState<void>>();
+        m_state->on_ready([next]() { next->set_value({}); });
+        return Future<void>(std::move(next), m_pool, m_lane);
+    }
+
+private:
+    template <class Func, bool = std::is_void_v<T>>
+    struct continuation_result
+    {
+        using type = std::invoke_result_t<Func&>;
+    };
+
+    template <class Func>
+    struct continuation_result<Func, false>
+    {
+        using type = std::invoke_result_t<Func&, const T&>;
+    };
+
+    template <class Func>
+    static decltype(auto) invoke_with(Func& fn, const details::SharedState<T>& state)
+    {
+        if constexpr (std::is_void_v<T>)
+            return fn();
+        else
+            return fn(state.value());
+    }
+
+    Future(std::shared_ptr<details::SharedState<T>> state,
+           ThreadPool* pool, Priority lane)
+        : m_state(std::move(state)), m_pool(pool), m_lane(lane)
+    {}
+
+    friend class ThreadPool;
+    template <class U> friend class Future;
+    friend Future<void> make_ready_future(ThreadPool&, Priority);
+    template <class U>
+    friend auto when_all(const std::vector<Future<U>>& futures);
+    template <class... Ts>
+    friend auto when_all(const Future<Ts>&... futures);
+
+    std::shared_ptr<details::SharedState<T>> m_state;
+    ThreadPool* m_pool = nullptr;
+    Priority m_lane = Priority::Normal;
 };
 
+/// An already-completed Future<void> whose continuations run on pool.
+inline Future<void> make_ready_future(ThreadPool& pool,
+                                      Priority lane = Priority::Normal)
+{
+    auto state = std::make_shared<details::SharedState<void>>();
+    state->set_value({});
+    return Future<void>(std::move(state), &pool, lane);
+}
+
+/// Ready when every future is; yields their values in order (or void).
+/// The first failure found is propagated. Continuations use the pool and
+/// lane of the first future.
+template <class T>
+auto when_all(const std::vector<Future<T>>& futures)
+{
+    using Result = std::conditional_t<std::is_void_v<T>, void,
+                                      std::vector<details::stored_t<T>>>;
+    auto next = std::make_shared<details::SharedState<Result>>();
+    ThreadPool* pool = futures.empty() ? nullptr : futures.front().m_pool;
+    Priority lane = futures.empty() ? Priority::Normal : futures.front().m_lane;
+
+    if (futures.empty()) {
+        next->set_value({});
+        return Future<Result>(std::move(next), pool, lane);
+    }
+
+    auto states = std::make_shared<std::vector<std::shared_ptr<details::SharedState<T>>>>();
+    states->reserve(futures.size());
+    for (const auto& f : futures)
+        states->push_back(f.m_state);
+    auto remaining = std::make_shared<std::atomic<std::size_t>>(futures.size());
+
+    for (const auto& state : *states) {
+        state->on_ready([states, remaining, next]() {
+            if (remaining->fetch_sub(1, std::memory_order_acq_rel) != 1)
+                return;
+            for (const auto& s : *states) {
+                if (auto error = s->error()) {
+                    next->set_exception(error);
+                    return;
+                }
+            }
+            if constexpr (std::is_void_v<T>) {
+                next->set_value({});
+            } else {
+                std::vector<T> values;
+                values.reserve(states->size());
+                for (const auto& s : *states)
+                    values.push_back(s->value());
+                next->set_value(std::move(values));
+            }
+        });
+    }
+    return Future<Result>(std::move(next), pool, lane);
+}
+
+/// Heterogeneous form: yields a tuple (void results become std::monostate).
+template <class... Ts>
+auto when_all(const Future<Ts>&... futures)
+{
+    static_assert(sizeof...(Ts) > 0, "when_all needs at least one future");
+    using Result = std::tuple<details::stored_t<Ts>...>;
+    auto next = std::make_shared<details::SharedState<Result>>();
+    auto states = std::make_shared<std::tuple<std::shared_ptr<details::SharedState<Ts>>...>>(
+        futures.m_state...);
+    auto remaining = std::make_shared<std::atomic<std::size_t>>(sizeof...(Ts));
+    const auto& first = std::get<0>(std::forward_as_tuple(futures...));
+
+    auto on_one_ready = [states, remaining, next]() {
+        if (remaining->fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        std::exception_ptr error;
+        std::apply([&](const auto&... s) {
+            ((error = error ? error : s->error()), ...);
+        }, *states);
+        if (error) {
+            next->set_exception(error);
+            return;
+        }
+        next->set_value(std::apply([](const auto&... s) {
+            return Result(s->value()...);
+        }, *states));
+    };
+    (futures.m_state->on_ready(on_one_ready), ...);
+    return Future<Result>(std::move(next), first.m_pool, first.m_lane);
+}
 
 } /* namespace ThreadPool */
 
@@ -0,0 +1,102 @@
+#ifndef UART_CAPTURE_HPP
+#define UART_CAPTURE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace altair {
+
+/// Which way a captured chunk travelled, seen from the gateway.
+enum class CaptureDirection : uint8_t {
+    Rx = 0,     ///< read from the satellite
+    Tx = 1      ///< written to the satellite
+};
+
+/// One chunk of UART traffic as it was read or written.
+struct CaptureRecord {
+    uint64_t            t_ns{0};    ///< CLOCK_MONOTONIC nanoseconds
+    uint8_t             sat{0};
+    CaptureDirection    dir{CaptureDirection::Rx};
+    const uint8_t*      data{nullptr};
+    uint16_t            size{0};
+};
+
+/// Capture file layout (host byte order):
+///
+///   header  "ALTCAP01" | u64 end offset of the last complete record
+///   record  u64 t_ns | u8 sat | u8 dir | u16 size | size bytes
+///
+/// The end offset is updated after every record, so a capture stays
+/// readable up to its last record even if the gateway is killed.
+constexpr char   kCaptureMagic[8]   = {'A', 'L', 'T', 'C', 'A', 'P', '0', '1'};
+constexpr size_t kCaptureHeaderSize = 16;
+constexpr size_t kCaptureRecordHead = 12;
+
+/// Appends UART chunks to a capture file through a growing shared mapping:
+/// a record is a memcpy, with no syscall except when the mapping grows.
+/// Not thread-safe; meant to be fed from the one reactor thread.
+class UartCaptureWriter {
+public:
+
+    /// Creates (truncating) path. Throws std::runtime_error on failure.
+    explicit UartCaptureWriter(const std::string& path, size_t grow_bytes = 16 << 20);
+    ~UartCaptureWriter();
+
+    UartCaptureWriter(const UartCaptureWriter&) = delete;
+    UartCaptureWriter& operator=(const UartCaptureWriter&) = delete;
+
+    /// Records a chunk stamped with the current monotonic time; chunks
+    /// over 64 KiB are split. Throws std::runtime_error if the file cannot
+    /// grow (e.g. the disk is full); the records before stay readable.
+    void append(uint8_t sat, CaptureDirection dir, const uint8_t* data, size_t size);
+
+    const std::string& path() const { return path_; }
+
+    /// Bytes of the file in use, header included.
+    uint64_t size() const { return used_; }
+
+private:
+
+    /// Grows the file and the mapping to hold at least need more bytes.
+    void reserve(size_t need);
+
+private:
+
+    std::string path_;
+    size_t      grow_bytes_;
+    int         fd_{-1};
+    uint8_t*    map_{nullptr};
+    size_t      mapped_{0};
+    uint64_t    used_{kCaptureHeaderSize};
+};
+
+/// Reads a capture file through a read-only mapping.
+class UartCaptureReader {
+public:
+
+    /// Opens and validates path. Throws std::runtime_error on failure.
+    explicit UartCaptureReader(const std::string& path);
+    ~UartCaptureReader();
+
+    UartCaptureReader(const UartCaptureReader&) = delete;
+    UartCaptureReader& operator=(const UartCaptureReader&) = delete;
+
+    /// Fills rec with the next record; false at the end. rec.data points
+    /// into the mapping and stays valid for the reader's lifetime.
+    bool next(CaptureRecord& rec);
+
+    /// Starts over from the first record.
+    void rewind() { pos_ = kCaptureHeaderSize; }
+
+private:
+
+    const uint8_t*  map_{nullptr};
+    size_t          mapped_{0};
+    uint64_t        end_{kCaptureHeaderSize};
+    uint64_t        pos_{kCaptureHeaderSize};
+};
+
+} // namespace altair
+
+#endif // UART_CAPTURE_HPP
@@ -9,6 +9,22 @@
 
 namespace altair {
 
+/// Opens a serial device in raw 8N1 mode at baud_rate and drops any input
+/// already pending. Throws std::runtime_error on failure.
+int openSerialPort(std::string const& device, unsigned baud_rate, bool non_blocking = false);
+
+/// A pseudo-terminal standing in for a serial device: the slave is what a
+/// UART client opens, the master is the "satellite" end.
+struct PseudoTerminal {
+    int         master_fd{-1};  ///< non-blocking
+    int         slave_fd{-1};   ///< held open so the master never hangs up
+    std::string slave_path;
+};
+
+/// Creates a pseudo-terminal with its line in raw mode and, if link_path
+/// is set, a symlink to the slave. Throws std::runtime_error on failure.
+PseudoTerminal openPseudoTerminal(const std::string& link_path = {});
+
 /// UartCommunicator class that handles UART communication with a device.
 class UartCommunicator : public Communicator {
 public:
@@ -0,0 +1,62 @@
+#ifndef UART_PIPELINE_HPP
+#define UART_PIPELINE_HPP
+
+#include "packet.hpp"
+#include "protocol.hpp"
+#include "taskgraph.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace altair {
+
+/// One chunk of raw UART bytes as it moves through the pipeline.
+struct UartFrameBatch {
+    std::vector<uint8_t>              raw;
+    std::vector<Packet>               packets;
+    std::vector<std::vector<uint8_t>> framed;
+};
+
+/// Reference ingest pipeline: decode -> frame -> { store, fan out }.
+///
+/// Each stage is a node of an ordered TaskGraph, so consecutive chunks
+/// overlap across stages while every stage still sees them in arrival
+/// order. No worker ever blocks on a future.
+class UartPipeline {
+public:
+    using StoreCallback  = std::function<void(const Packet&)>;
+    using FanoutCallback = std::function<void(const std::vector<uint8_t>&)>;
+
+    UartPipeline(ThreadPool::ThreadPool& pool,
+                 StoreCallback store,
+                 FanoutCallback fanout);
+
+    /// Feed a chunk exactly as read from the device.
+    ThreadPool::Future<void> push(std::vector<uint8_t> chunk);
+
+private:
+
+    /// Reassemble frames across chunk boundaries, skipping garbage bytes.
+    void decode(UartFrameBatch& batch);
+
+    /// Re-frame decoded packets for client delivery.
+    void frame(UartFrameBatch& batch);
+
+    void store(UartFrameBatch& batch);
+
+    void fanout(UartFrameBatch& batch);
+
+private:
+
+    ThreadPool::ThreadPool&                 pool_;
+    StoreCallback                           store_;
+    FanoutCallback                          fanout_;
+    FrameDecoder                            decoder_;   // decode stage only
+    ThreadPool::TaskGraph<UartFrameBatch>   graph_;
+};
+
+} // namespace altair
+
+#endif // UART_PIPELINE_HPP
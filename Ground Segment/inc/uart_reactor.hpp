@@ -0,0 +1,154 @@
+#ifndef UART_REACTOR_HPP
+#define UART_REACTOR_HPP
+
+#include "eventloop.hpp"
+#include "metrics.hpp"
+#include "packet.hpp"
+#include "protocol.hpp"
+#include "uart_capture.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace altair {
+
+/// One satellite link: its id and the serial device it is attached to.
+struct SatelliteConfig {
+    uint8_t     id{0};
+    std::string device;
+    unsigned    baud_rate{115200};
+};
+
+/// Reads a satellite list: one "<id> <device> [baud]" per line, '#' starts
+/// a comment. Throws std::runtime_error on a malformed or duplicate entry.
+std::vector<SatelliteConfig> loadSatelliteConfig(const std::string& path);
+
+/// Multiplexes many UART devices on a single EventLoop thread.
+///
+/// Every device is opened non-blocking and decoded with its own
+/// FrameDecoder; received packets are reported with the satellite id.
+/// Writes are queued per device and flushed as the fd becomes writable.
+/// A device that fails or hangs up is reopened periodically.
+///
+/// Packets from one read live in an arena released once the sink has seen
+/// them; a sink that keeps one must copy it.
+class UartReactor {
+public:
+    using ReceiveCallback = std::function<void(uint8_t sat, const Packet&)>;
+    using OpenCallback    = std::function<void(uint8_t sat)>;
+
+    explicit UartReactor(std::vector<SatelliteConfig> satellites);
+    ~UartReactor();
+
+    UartReactor(const UartReactor&) = delete;
+    UartReactor& operator=(const UartReactor&) = delete;
+
+    /// Called on the reactor thread for every packet received. Replaces
+    /// any sink.
+    void onReceive(ReceiveCallback cb) {
+        receive_cb_ = std::move(cb);
+        setSink(*this);
+    }
+
+    /// Delivers every packet received to sink.onPacket(uint8_t sat,
+    /// const Packet&) on the reactor thread, called directly from the
+    /// frame loop (see ClientConnection::setSink). Call before start().
+    template <class Sink>
+    void setSink(Sink& sink) {
+        sink_  = &sink;
+        drain_ = &drainInto<Sink>;
+    }
+
+    /// Called on the reactor thread whenever a device has been (re)opened.
+    void onOpen(OpenCallback cb) { open_cb_ = std::move(cb); }
+
+    /// Opens the devices and starts the reactor thread. Devices that cannot
+    /// be opened are retried; throws only if none could be opened.
+    void start();
+
+    /// Stops the reactor thread and closes every device.
+    void stop();
+
+    /// Queues a packet for satellite sat (PROTO_SAT_ALL for every one).
+    /// Thread-safe; returns false if sat is unknown.
+    bool send(uint8_t sat, const Packet& pkt);
+
+    /// Records every chunk read from or written to any device in a capture
+    /// file (see UartCaptureWriter). Call before start(); throws if the
+    /// file cannot be created. If it later cannot grow, recording stops
+    /// and the links carry on.
+    void record(const std::string& capture_path);
+
+    /// Counts each link's traffic as source "sat<id>", and its bytes
+    /// waiting to be written. Call before start().
+    void instrument(MetricsRegistry& registry);
+
+    /// Satellite ids in configuration order.
+    const std::vector<uint8_t>& satellites() const { return order_; }
+
+private:
+
+    struct Device {
+        SatelliteConfig         config;
+        int                     fd{-1};
+        FrameDecoder            decoder;
+        std::vector<uint8_t>    tx;
+        size_t                  tx_pos{0};
+        bool                    want_write{false};
+        LinkMetrics             metrics;                // all set, or none
+        Gauge*                  tx_backlog{nullptr};
+        DecoderTally            tally;
+    };
+
+    bool open(Device& dev);
+    void close(Device& dev);
+    void scheduleReopen(Device& dev);
+    void onEvents(Device& dev, uint32_t events);
+
+    /// Appends a chunk to the capture, if recording; a capture that cannot
+    /// grow is closed and recording stops.
+    void capture(Device& dev, CaptureDirection dir, const uint8_t* data, size_t size);
+    void queue(Device& dev, const std::vector<uint8_t>& frame);
+    void flush(Device& dev);
+    void rearm(Device& dev);
+
+    template <class Sink>
+    static void drainInto(FrameDecoder& decoder, uint8_t sat, void* sink) {
+        Sink& target = *static_cast<Sink*>(sink);
+        while (auto pkt = decoder.next()) {
+            target.onPacket(sat, *pkt);
+        }
+    }
+
+    /// Default sink: the onReceive() callback.
+    void onPacket(uint8_t sat, const Packet& pkt) {
+        if (receive_cb_) receive_cb_(sat, pkt);
+    }
+
+private:
+
+    EventLoop                                   loop_;
+    std::thread                                 thread_;
+    std::atomic<bool>                           running_{false};
+    std::map<uint8_t, std::unique_ptr<Device>>  devices_;
+    std::vector<uint8_t>                        order_;
+    ReceiveCallback                             receive_cb_;
+    void*                                       sink_{this};
+    void                                      (*drain_)(FrameDecoder&, uint8_t, void*){&drainInto<UartReactor>};
+    OpenCallback                                open_cb_;
+    std::unique_ptr<UartCaptureWriter>          capture_;
+    // Reactor thread only (see ClientConnection for the sizes).
+    std::pmr::unsynchronized_pool_resource      pool_{std::pmr::pool_options{2, 16 * 1024}};
+    std::pmr::monotonic_buffer_resource         batch_{4096, &pool_};
+};
+
+} // namespace altair
+
+#endif // UART_REACTOR_HPP
@@ -0,0 +1,211 @@
+#include "admission.hpp"
+#include "packet_registry.hpp"
+
+#include <cmath>
+#include <vector>
+
+namespace altair {
+
+namespace {
+
+/// Days since 1970-01-01 of a "YYYYMMDD" date (proleptic Gregorian).
+long dayNumber(std::string_view yyyymmdd) {
+    auto num = [&](size_t at, size_t len) {
+        long v = 0;
+        for (size_t i = at; i < at + len; ++i) v = v * 10 + (yyyymmdd[i] - '0');
+        return v;
+    };
+    long y = num(0, 4), m = num(4, 2), d = num(6, 2);
+    y -= m <= 2;
+    const long era = (y >= 0 ? y : y - 399) / 400;
+    const long yoe = y - era * 400;
+    const long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+} // namespace
+
+CommandAdmission::CommandAdmission(AdmissionOptions options,
+                                   std::map<uint8_t, double> link_bytes_per_s, Send send)
+    : options_(options)
+    , send_(std::move(send))
+{
+    const auto now = Clock::now();
+    for (const auto& [sat, capacity] : link_bytes_per_s) {
+        double rate = capacity * options_.uplink_share;
+        link_rate_[sat] = rate;
+        // Deep enough for the largest frame, however small the budget.
+        double depth = std::max(rate * options_.burst.count() / 1000.0,
+                                double(PROTO_MAX_PACKET_LEN));
+        global_.emplace(sat, TokenBucket(rate, depth, now));
+
+        double down = capacity * options_.downlink_share;
+        downlink_.emplace(sat, TokenBucket(down, std::max(down * options_.burst.count() / 1000.0,
+                                                          double(PROTO_MAX_PACKET_LEN)), now));
+    }
+    pacer_ = std::thread([this]() { paceLoop(); });
+}
+
+CommandAdmission::~CommandAdmission() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (const auto& [id, c] : clients_) stats_.dropped += c.waiting.size();
+        clients_.clear();
+    }
+    cv_.notify_all();
+    if (pacer_.joinable()) pacer_.join();
+}
+
+TokenBucket& CommandAdmission::clientBucket(Client& c, uint8_t sat, Clock::time_point now) {
+    auto it = c.buckets.find(sat);
+    if (it == c.buckets.end()) {
+        double rate  = link_rate_.at(sat) * options_.client_share;
+        double depth = std::max(rate * options_.burst.count() / 1000.0,
+                                double(PROTO_MAX_PACKET_LEN));
+        it = c.buckets.emplace(sat, TokenBucket(rate, depth, now)).first;
+    }
+    return it->second;
+}
+
+double CommandAdmission::replyCost(const Packet& pkt) const {
+    auto days = [this](const auto& range) {
+        long n = dayNumber(range.last_day) - dayNumber(range.first_day) + 1;
+        return options_.range_day_bytes * std::clamp(n, 1L, 366L);
+    };
+    if (pkt.packetId == PROTO_PKT_SAMPLE) {
+        if (auto range = packets::SampleRequest::parse(pkt)) return days(*range);
+    } else if (pkt.packetId == PROTO_PKT_EVENT) {
+        if (auto range = packets::EventRequest::parse(pkt)) return days(*range);
+    }
+    return 0;
+}
+
+bool CommandAdmission::tryTake(Client& c, uint8_t sat, double cost, double reply_cost,
+                               Clock::time_point now, Clock::duration& wait) {
+    TokenBucket& link = global_.at(sat);
+    TokenBucket& own  = clientBucket(c, sat, now);
+    TokenBucket& down = downlink_.at(sat);
+    link.refill(now);
+    own.refill(now);
+    down.refill(now);
+
+    if (link.tokens >= cost && own.tokens >= cost && down.tokens >= reply_cost) {
+        link.tokens -= cost;
+        own.tokens  -= cost;
+        down.tokens -= reply_cost;
+        return true;
+    }
+    wait = std::max({link.wait(cost), own.wait(cost), down.wait(reply_cost)});
+    return false;
+}
+
+CommandAdmission::Verdict CommandAdmission::submit(int client, uint8_t sat, const Packet& pkt,
+                                                   std::chrono::milliseconds* retry_after) {
+    // Bytes on the wire: length, id, payload, checksum, end byte.
+    const double cost       = pkt.payload.size() + 4;
+    // At most a full bucket, so a request never waits longer than a burst
+    // for the replies before it (clients time out on a quiet link).
+    const double reply_cost = std::min(replyCost(pkt), downlink_.at(sat).depth);
+    const auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Client& c = clients_[client];
+
+    // Behind waiting commands a new one waits too, to keep the order.
+    Clock::duration wait;
+    if (c.waiting.empty() && tryTake(c, sat, cost, reply_cost, now, wait)) {
+        // Sent under the lock, so the pacing thread cannot overtake it.
+        send_(sat, pkt);
+        stats_.admitted.fetch_add(1, std::memory_order_relaxed);
+        return Verdict::Sent;
+    }
+
+    if (c.waiting.size() >= options_.max_queued) {
+        stats_.rejected.fetch_add(1, std::memory_order_relaxed);
+        if (retry_after) {
+            const TokenBucket& own  = clientBucket(c, sat, now);
+            const TokenBucket& down = downlink_.at(sat);
+            auto wait = std::max(own.wait(c.waiting_cost + cost),
+                                 down.wait(c.waiting_reply_cost + reply_cost));
+            *retry_after = std::chrono::milliseconds(static_cast<int64_t>(std::ceil(
+                std::chrono::duration<double, std::milli>(wait).count())));
+        }
+        return Verdict::Rejected;
+    }
+
+    c.waiting.push_back(Command{sat, pkt, cost, reply_cost});
+    c.waiting_cost       += cost;
+    c.waiting_reply_cost += reply_cost;
+    stats_.queued.fetch_add(1, std::memory_order_relaxed);
+    cv_.notify_one();
+    return Verdict::Queued;
+}
+
+void CommandAdmission::forget(int client) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(client);
+    if (it == clients_.end()) return;
+    stats_.dropped.fetch_add(it->second.waiting.size(), std::memory_order_relaxed);
+    clients_.erase(it);
+}
+
+size_t CommandAdmission::waiting() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = 0;
+    for (const auto& [id, c] : clients_) n += c.waiting.size();
+    return n;
+}
+
+void CommandAdmission::paceLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<int> turns;
+
+    while (!stopping_) {
+        auto next = Clock::duration::max();
+        bool progress = true;
+
+        // One command per client per pass, starting after the client
+        // served last, until no head can go.
+        while (progress) {
+            progress = false;
+            next     = Clock::duration::max();
+
+            turns.clear();
+            for (const auto& [id, c] : clients_) {
+                if (!c.waiting.empty()) turns.push_back(id);
+            }
+            std::sort(turns.begin(), turns.end());
+            std::rotate(turns.begin(),
+                        std::upper_bound(turns.begin(), turns.end(), last_served_),
+                        turns.end());
+
+            const auto now = Clock::now();
+            for (int id : turns) {
+                Client& c = clients_.at(id);
+                Command& cmd = c.waiting.front();
+                Clock::duration wait;
+                if (!tryTake(c, cmd.sat, cmd.cost, cmd.reply_cost, now, wait)) {
+                    next = std::min(next, wait);
+                    continue;
+                }
+                send_(cmd.sat, cmd.pkt);
+                stats_.admitted.fetch_add(1, std::memory_order_relaxed);
+                c.waiting_cost       -= cmd.cost;
+                c.waiting_reply_cost -= cmd.reply_cost;
+                c.waiting.pop_front();
+                last_served_ = id;
+                progress     = true;
+            }
+        }
+
+        if (next == Clock::duration::max()) {
+            cv_.wait(lock);
+        } else {
+            cv_.wait_for(lock, std::max<Clock::duration>(next, std::chrono::milliseconds(1)));
+        }
+    }
+}
+
+} // namespace altair
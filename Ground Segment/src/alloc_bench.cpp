@@ -0,0 +1,227 @@
+// Allocator cost on the client receive path with many busy connections.
+//
+// Every thread plays one busy client connection: it feeds 4 KiB reads of
+// SAMPLE frames to its own FrameDecoder and, for every packet, frames a
+// reply with Protocol::pack, the allocations a gateway makes per frame.
+//
+//   heap   payloads and frames from the global heap, as before pmr
+//   arena  a per-connection pool with a monotonic arena per read, as
+//          ClientConnection does now
+//
+// All threads start together. Runs are repeated, interleaving the modes,
+// and the table shows the median aggregate rate and CPU time per frame.
+
+#include "protocol.hpp"
+#include "protocol_defs.hpp"
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    std::vector<unsigned> threads{1, 64};
+    uint64_t              frames{1000000};     // per thread
+    unsigned              repeat{5};
+    size_t                payload{40};
+    std::string           json_path;
+};
+
+struct Result {
+    std::string mode;
+    unsigned    threads{0};
+    uint64_t    frames{0};
+    double      seconds{0};
+    double      cpu_ns_per_frame{0};
+};
+
+double threadCpuNs() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/// One connection's worth of work; returns its CPU time in ns.
+double serveConnection(const BenchConfig& cfg, bool arena, const std::vector<uint8_t>& read,
+                       size_t frames_per_read, uint64_t& checksum) {
+    std::pmr::unsynchronized_pool_resource pool{std::pmr::pool_options{2, 16 * 1024}};
+    std::pmr::monotonic_buffer_resource    batch{1024, &pool};
+    FrameDecoder decoder(arena ? static_cast<std::pmr::memory_resource*>(&batch)
+                               : std::pmr::get_default_resource());
+
+    double start = threadCpuNs();
+    for (uint64_t done = 0; done < cfg.frames; done += frames_per_read) {
+        decoder.feed(read.data(), read.size());
+        while (auto pkt = decoder.next()) {
+            if (arena) {
+                checksum += Protocol::pack(*pkt, &batch).back();
+            } else {
+                checksum += Protocol::pack(*pkt).back();
+            }
+        }
+        batch.release();
+    }
+    return threadCpuNs() - start;
+}
+
+Result run(const BenchConfig& cfg, bool arena, unsigned threads) {
+    Packet pkt{};
+    pkt.packetId = PROTO_PKT_SAMPLE;
+    pkt.payload.assign(cfg.payload, '0');
+    auto frame = Protocol::pack(pkt);
+
+    std::vector<uint8_t> read;
+    size_t frames_per_read = std::max<size_t>(1, 4096 / frame.size());
+    for (size_t i = 0; i < frames_per_read; ++i) read.insert(read.end(), frame.begin(), frame.end());
+
+    std::mutex              mutex;
+    std::condition_variable go_cv;
+    bool                    go = false;
+    std::atomic<uint64_t>   checksum{0};
+    std::vector<double>     cpu_ns(threads);
+    std::vector<std::thread> workers;
+
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                go_cv.wait(lock, [&]() { return go; });
+            }
+            uint64_t sum = 0;
+            cpu_ns[t] = serveConnection(cfg, arena, read, frames_per_read, sum);
+            checksum += sum;
+        });
+    }
+
+    auto start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        go = true;
+    }
+    go_cv.notify_all();
+    for (auto& w : workers) w.join();
+
+    Result r;
+    r.mode    = arena ? "arena" : "heap";
+    r.threads = threads;
+    r.frames  = (cfg.frames + frames_per_read - 1) / frames_per_read * frames_per_read * threads;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double total_cpu = 0;
+    for (double ns : cpu_ns) total_cpu += ns;
+    r.cpu_ns_per_frame = total_cpu / r.frames;
+    if (checksum == 0) std::cerr << "unexpected checksum\n";
+    return r;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(8) << "mode" << std::right
+              << std::setw(10) << "threads" << std::setw(14) << "frames"
+              << std::setw(12) << "Mfr/s" << std::setw(14) << "cpu ns/fr" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(8) << r.mode << std::right << std::fixed
+                  << std::setw(10) << r.threads << std::setw(14) << r.frames
+                  << std::setprecision(2) << std::setw(12) << r.frames / r.seconds / 1e6
+                  << std::setprecision(1) << std::setw(14) << r.cpu_ns_per_frame << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"mode\":\"" << r.mode << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"threads\":" << r.threads
+       << ",\"payload\":" << cfg.payload
+       << ",\"frames\":" << r.frames
+       << ",\"seconds\":" << r.seconds
+       << ",\"frames_per_s\":" << r.frames / r.seconds
+       << ",\"cpu_ns_per_frame\":" << r.cpu_ns_per_frame << "}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --threads LIST        comma-separated thread counts (default 1,64)\n"
+              << "  --frames N            frames per thread (default 1000000)\n"
+              << "  --repeat N            runs per mode and thread count (default 5)\n"
+              << "  --payload N           payload bytes per frame (default 40)\n"
+              << "  --json FILE           append one JSON object per run ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--threads") {
+                cfg.threads.clear();
+                std::istringstream list(value());
+                std::string item;
+                while (std::getline(list, item, ',')) cfg.threads.push_back(std::stoul(item));
+            }
+            else if (arg == "--frames")  cfg.frames = std::stoull(value());
+            else if (arg == "--repeat")  cfg.repeat = std::max(1ul, std::stoul(value()));
+            else if (arg == "--payload") cfg.payload = std::min<size_t>(std::stoul(value()), 254);
+            else if (arg == "--json")    cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        // runs[i] holds the repeats of heap (even i) and arena (odd i).
+        std::vector<std::vector<Result>> runs(2 * cfg.threads.size());
+        for (unsigned rep = 0; rep < cfg.repeat; ++rep) {
+            for (size_t t = 0; t < cfg.threads.size(); ++t) {
+                runs[2 * t].push_back(run(cfg, false, cfg.threads[t]));
+                runs[2 * t + 1].push_back(run(cfg, true, cfg.threads[t]));
+            }
+        }
+
+        std::vector<Result> results;
+        for (auto& samples : runs) {
+            std::sort(samples.begin(), samples.end(), [](const Result& a, const Result& b) {
+                return a.cpu_ns_per_frame < b.cpu_ns_per_frame;
+            });
+            results.push_back(samples[samples.size() / 2]);
+        }
+
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
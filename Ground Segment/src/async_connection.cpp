@@ -0,0 +1,165 @@
+#include "async_connection.hpp"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace altair {
+
+AsyncConnection::AsyncConnection(EventLoop& loop, int socket_fd)
+    : loop_(loop)
+    , socket_(socket_fd)
+{
+    // Edge-triggered: callers always try the syscall first and only
+    // suspend after EAGAIN, so no edge can be missed.
+    loop_.watch(socket_, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET,
+                [this](uint32_t events) { onEvents(events); });
+}
+
+AsyncConnection::~AsyncConnection() {
+    if (socket_ >= 0) {
+        loop_.unwatch(socket_);
+        ::close(socket_);
+    }
+}
+
+Task<std::unique_ptr<AsyncConnection>> AsyncConnection::connect(EventLoop& loop,
+                                                                std::string host,
+                                                                uint16_t port) {
+    addrinfo hints{};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_NUMERICSERV;
+
+    addrinfo* res = nullptr;
+    std::string service = std::to_string(port);
+    if (::getaddrinfo(host.c_str(), service.c_str(), &hints, &res) != 0 || !res) {
+        throw std::runtime_error("Invalid address");
+    }
+    sockaddr_storage addr{};
+    socklen_t        addrLen = res->ai_addrlen;
+    std::memcpy(&addr, res->ai_addr, addrLen);
+    ::freeaddrinfo(res);
+
+    int sock = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        throw std::runtime_error("Failed to create socket");
+    }
+
+    if (::connect(sock, reinterpret_cast<sockaddr*>(&addr), addrLen) < 0
+        && errno != EINPROGRESS) {
+        ::close(sock);
+        throw std::runtime_error("Connection failed");
+    }
+
+    auto conn = std::make_unique<AsyncConnection>(loop, sock);
+
+    co_await IoAwaiter{*conn, conn->writer_, std::nullopt};
+
+    int       err = 0;
+    socklen_t len = sizeof(err);
+    if (::getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err != 0) {
+        throw std::runtime_error("Connection failed");
+    }
+    co_return conn;
+}
+
+Task<std::optional<Packet>> AsyncConnection::readFrame(
+    std::optional<std::chrono::milliseconds> timeout) {
+
+    std::optional<Clock::time_point> deadline;
+    if (timeout) deadline = Clock::now() + *timeout;
+
+    for (;;) {
+        if (auto pkt = decoder_.next()) co_return pkt;
+        if (socket_ < 0) co_return std::nullopt;
+
+        uint8_t buf[4096];
+        ssize_t n = ::read(socket_, buf, sizeof(buf));
+        if (n > 0) {
+            decoder_.feed(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n == 0) {
+            close();
+            co_return std::nullopt;
+        }
+        if (errno == EINTR) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            close();
+            co_return std::nullopt;
+        }
+
+        if (!co_await IoAwaiter{*this, reader_, deadline}) {
+            co_return std::nullopt;
+        }
+    }
+}
+
+Task<bool> AsyncConnection::write(std::vector<uint8_t> frame) {
+    size_t off = 0;
+    while (off < frame.size()) {
+        if (socket_ < 0) co_return false;
+
+        ssize_t n = ::send(socket_, frame.data() + off, frame.size() - off, MSG_NOSIGNAL);
+        if (n > 0) {
+            off += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            co_await IoAwaiter{*this, writer_, std::nullopt};
+            continue;
+        }
+        close();
+        co_return false;
+    }
+    co_return true;
+}
+
+void AsyncConnection::close() {
+    if (socket_ < 0) return;
+    loop_.unwatch(socket_);
+    ::close(socket_);
+    socket_ = -1;
+    wake(std::exchange(reader_, {}), std::exchange(writer_, {}));
+}
+
+void AsyncConnection::onEvents(uint32_t events) {
+    std::coroutine_handle<> r, w;
+    if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) r = std::exchange(reader_, {});
+    if (events & (EPOLLOUT | EPOLLHUP | EPOLLERR))              w = std::exchange(writer_, {});
+    wake(r, w);
+}
+
+void AsyncConnection::wake(std::coroutine_handle<> reader, std::coroutine_handle<> writer) {
+    // Resuming either side may destroy this connection; use locals only.
+    if (reader) reader.resume();
+    if (writer) writer.resume();
+}
+
+void AsyncConnection::resume(std::coroutine_handle<>& slot) {
+    if (auto h = std::exchange(slot, {})) h.resume();
+}
+
+void AsyncConnection::IoAwaiter::await_suspend(std::coroutine_handle<> h) {
+    slot = h;
+    if (deadline) {
+        timer = conn.loop_.addTimer(*deadline, [this]() {
+            timedOut = true;
+            resume(slot);
+        });
+    }
+}
+
+bool AsyncConnection::IoAwaiter::await_resume() {
+    if (timer && !timedOut) conn.loop_.cancelTimer(timer);
+    return !timedOut;
+}
+
+} // namespace altair
@@ -0,0 +1,81 @@
+#include "async_logclient.hpp"
+
+#include <ctime>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace altair {
+
+namespace {
+
+/// "YYYY-MM-DD" from the first eight digits of text.
+std::string dashedDate(const std::string& text) {
+    return text.substr(0, 4) + "-" + text.substr(4, 2) + "-" + text.substr(6, 2);
+}
+
+std::string todayDate() {
+    std::time_t now = std::time(nullptr);
+    char buf[11];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", std::localtime(&now));
+    return buf;
+}
+
+} // namespace
+
+AsyncLogClient::AsyncLogClient(std::unique_ptr<AsyncConnection> connection)
+    : connection_(std::move(connection))
+{}
+
+Task<std::unique_ptr<AsyncLogClient>> AsyncLogClient::connect(EventLoop& loop,
+                                                              std::string host,
+                                                              uint16_t port) {
+    auto conn = co_await AsyncConnection::connect(loop, std::move(host), port);
+    co_return std::make_unique<AsyncLogClient>(std::move(conn));
+}
+
+Task<std::vector<std::string>> AsyncLogClient::fetchRange(uint8_t type,
+                                                          std::string from,
+                                                          std::string to,
+                                                          std::chrono::milliseconds idle_timeout) {
+    auto request = Protocol::makeRangeRequest(type, from, to);
+    if (!request) {
+        throw std::invalid_argument("Invalid date format");
+    }
+
+    if (!co_await connection_->write(Protocol::pack(*request))) {
+        throw std::runtime_error("Failed to send request");
+    }
+
+    // Lines start with "YYYY-MM-DD". The gateway sends every client live
+    // samples and the replies to other clients' requests too, so a line
+    // only counts if it is dated in the range; live samples are dated
+    // today and never do. A client asking for the same range gets the
+    // same lines; every line is timestamped, so a repeat is one of those.
+    const std::string digits(request->payload.begin(), request->payload.end());
+    const std::string first = dashedDate(digits);
+    const std::string last  = dashedDate(digits.substr(8));
+    const std::string today = todayDate();
+
+    std::vector<std::string>        lines;
+    std::unordered_set<std::string> seen;
+    auto deadline = AsyncConnection::Clock::now() + idle_timeout;
+    for (;;) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - AsyncConnection::Clock::now());
+        if (left.count() <= 0) break;
+
+        auto pkt = co_await connection_->readFrame(left);
+        if (!pkt) break;
+        if (pkt->packetId != type || pkt->payload.size() < 10) continue;
+        std::string date(pkt->payload.begin(), pkt->payload.begin() + 10);
+        if (date < first || date > last || date == today) continue;
+
+        std::string line(pkt->payload.begin(), pkt->payload.end());
+        if (!seen.insert(line).second) continue;
+        lines.push_back(std::move(line));
+        deadline = AsyncConnection::Clock::now() + idle_timeout;
+    }
+    co_return lines;
+}
+
+} // namespace altair
@@ -0,0 +1,208 @@
+#include "asynclogger.hpp"
+
+#include <iostream>
+
+namespace altair {
+
+namespace {
+
+constexpr auto kWriterInterval = std::chrono::milliseconds(2);
+
+size_t roundUpPow2(size_t n) {
+    size_t p = 64;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+} // namespace
+
+LogLevel parseLogLevel(std::string_view name) {
+    if (name == "trace") return LogLevel::Trace;
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "warn")  return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    if (name == "off")   return LogLevel::Off;
+    return LogLevel::Info;
+}
+
+// ---------------------------------------------------------------- LogRing
+
+LogRing::LogRing(size_t capacity)
+    : capacity_(roundUpPow2(capacity))
+    , mask_(capacity_ - 1)
+{
+    buf_ = std::make_unique<uint8_t[]>(capacity_);
+}
+
+uint8_t* LogRing::reserve(size_t n) {
+    uint64_t w          = head_.load(std::memory_order_relaxed);
+    size_t   idx        = w & mask_;
+    size_t   contiguous = capacity_ - idx;
+    size_t   need       = contiguous < n ? contiguous + n : n;
+
+    if (capacity_ - (w - tail_cache_) < need) {
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        if (capacity_ - (w - tail_cache_) < need) return nullptr;
+    }
+
+    if (contiguous < n) {
+        // Records never straddle the end; leave a wrap marker instead.
+        uint32_t marker = 0;
+        std::memcpy(buf_.get() + idx, &marker, sizeof(marker));
+        w += contiguous;
+    }
+    reserved_ = w;
+    return buf_.get() + (w & mask_);
+}
+
+void LogRing::commit(size_t n) {
+    head_.store(reserved_ + n, std::memory_order_release);
+}
+
+// ------------------------------------------------------------ AsyncLogger
+
+AsyncLogger& AsyncLogger::instance() {
+    static AsyncLogger inst;
+    return inst;
+}
+
+AsyncLogger::AsyncLogger()
+    : writer_(&AsyncLogger::writerLoop, this)
+{}
+
+AsyncLogger::~AsyncLogger() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+}
+
+AsyncLogger::ThreadHandle::~ThreadHandle() {
+    if (buffer) buffer->retired.store(true, std::memory_order_release);
+}
+
+AsyncLogger::ThreadBuffer& AsyncLogger::localBuffer() {
+    thread_local ThreadHandle handle;
+    if (!handle.buffer) {
+        handle.buffer = std::make_shared<ThreadBuffer>(buffer_capacity_);
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.push_back(handle.buffer);
+    }
+    return *handle.buffer;
+}
+
+void AsyncLogger::flush() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    uint64_t ticket = ++flush_requests_;
+    wake_cv_.notify_all();
+    flushed_cv_.wait(lock, [&] { return flushes_done_ >= ticket || stopping_; });
+}
+
+void AsyncLogger::writerLoop() {
+    for (;;) {
+        uint64_t ticket;
+        bool     stop;
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait_for(lock, kWriterInterval, [&] {
+                return stopping_ || flush_requests_ > flushes_done_;
+            });
+            ticket = flush_requests_;
+            stop   = stopping_;
+        }
+
+        drainOnce();
+
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            flushes_done_ = ticket;
+        }
+        flushed_cv_.notify_all();
+
+        if (stop) {
+            drainOnce();
+            return;
+        }
+    }
+}
+
+bool AsyncLogger::drainOnce() {
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers = buffers_;
+    }
+
+    std::string out;
+    std::string err;
+    for (const auto& b : buffers) {
+        b->ring.consume([&](const uint8_t* rec) {
+            RecordHeader hdr;
+            std::memcpy(&hdr, rec, sizeof(hdr));
+            std::string& dst = hdr.level >= LogLevel::Warn ? err : out;
+            hdr.decode(hdr.fmt, rec + sizeof(hdr), dst);
+            dst += '\n';
+        });
+    }
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_dropped_) {
+        err += "[AsyncLogger] dropped " + std::to_string(dropped - reported_dropped_)
+             + " records (ring full)\n";
+        reported_dropped_ = dropped;
+    }
+
+    if (!out.empty()) {
+        std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+        std::cout.flush();
+    }
+    if (!err.empty()) {
+        std::cerr.write(err.data(), static_cast<std::streamsize>(err.size()));
+        std::cerr.flush();
+    }
+
+    // Forget rings whose thread has exited and that are now empty.
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+            [](const std::shared_ptr<ThreadBuffer>& b) {
+                return b->retired.load(std::memory_order_acquire) && b->ring.empty();
+            }), buffers_.end());
+    }
+
+    return !out.empty() || !err.empty();
+}
+
+void AsyncLogger::appendLiteral(const char*& fmt, std::string& out, bool toEnd) {
+    const char* start = fmt;
+    while (*fmt) {
+        if (!toEnd && fmt[0] == '{' && fmt[1] == '}') {
+            out.append(start, fmt);
+            fmt += 2;
+            return;
+        }
+        ++fmt;
+    }
+    out.append(start, fmt);
+}
+
+void AsyncLogger::encodeBytes(uint8_t*& p, const void* data, size_t n) {
+    uint16_t len = static_cast<uint16_t>(std::min<size_t>(n, UINT16_MAX));
+    std::memcpy(p, &len, sizeof(len));
+    p += sizeof(len);
+    if (len) std::memcpy(p, data, len);
+    p += len;
+}
+
+std::string_view AsyncLogger::decodeBytes(const uint8_t*& p) {
+    uint16_t len;
+    std::memcpy(&len, p, sizeof(len));
+    p += sizeof(len);
+    std::string_view sv(reinterpret_cast<const char*>(p), len);
+    p += len;
+    return sv;
+}
+
+} // namespace altair
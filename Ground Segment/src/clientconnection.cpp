@@ -1,4 +1,9 @@
 #include "clientconnection.hpp"
+#include "eventloop.hpp"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <iostream>
 #include <cstring>
@@ -9,11 +14,16 @@ namespace altair {
 
 ClientConnection::ClientConnection(int socket_fd)
   : socket_(socket_fd)
+  , nonblocking_((::fcntl(socket_fd, F_GETFL) & O_NONBLOCK) != 0)
 {}
 
 ClientConnection::~ClientConnection() {
     running_ = false;
-    if (reader_.joinable()) reader_.join();
+    if (reader_.joinable()) {
+        // The reader holds a reference, so it may be the one destroying us.
+        if (reader_.get_id() == std::this_thread::get_id()) reader_.detach();
+        else reader_.join();
+    }
     if (socket_ >= 0) ::close(socket_);
 }
 
@@ -24,19 +34,175 @@ void ClientConnection::start() {
     });
 }
 
+void ClientConnection::start(EventLoop& loop) {
+    running_ = true;
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    loop_ = &loop;
+    watchSocket();      // output queued before now is flushed as well
+}
+
+void ClientConnection::watchSocket() {
+    if (!running_) return;      // closed; the socket is no longer watched
+    uint32_t events = EPOLLIN | EPOLLRDHUP;
+    if (output_sent_ < output_.size()) events |= EPOLLOUT;
+    loop_->watch(socket_, events, [self = shared_from_this()](uint32_t ready) {
+        if (ready & EPOLLOUT) self->onWritable();
+        if (ready & ~uint32_t(EPOLLOUT)) self->onReadable();
+    });
+}
+
+void ClientConnection::setOutputLimit(size_t bytes, Counter* slow) {
+    output_limit_ = bytes;
+    slow_         = slow;
+}
+
 void ClientConnection::stop() {
     running_ = false;
+    if (loop_) {
+        ::shutdown(socket_, SHUT_RDWR);
+        return;
+    }
+    if (reader_.joinable() && reader_.get_id() != std::this_thread::get_id()) {
+        ::shutdown(socket_, SHUT_RDWR);
+        reader_.join();
+    }
 }
 
 void ClientConnection::onMessage(PacketCallback cb) {
     callback_ = std::move(cb);
+    setSink(*this);
 }
 
-void ClientConnection::send(const std::vector<uint8_t>& raw) {
-    ssize_t n = ::write(socket_, raw.data(), raw.size());
-    if (n != ssize_t(raw.size())) {
-        std::cerr << "ClientConnection[" << id_ << "] write error: "
-                  << strerror(errno) << "\n";
+void ClientConnection::onPacket(ClientConnection&, const Packet& pkt) {
+    if (callback_) callback_(pkt);
+}
+
+void ClientConnection::send(const uint8_t* data, size_t size, const SendTrace* trace) {
+    auto written = [&]() {
+        if (!trace) return;
+        const uint64_t done = monotonicNs();
+        trace->tracer->record(LatencyStage::Write, trace->start_ns, done);
+        trace->tracer->record(LatencyStage::Total, trace->rx_ns, done);
+    };
+    auto count = [&](uint64_t bytes) {
+        if (!metrics_ || bytes == 0) return;
+        // Writes may batch frames; each starts with its length byte.
+        uint64_t frames = 0;
+        for (size_t at = 0; at < size; at += size_t(data[at]) + 3) ++frames;
+        metrics_->frames_out->add(frames);
+        metrics_->bytes_out->add(bytes);
+    };
+
+    if (!nonblocking_) {
+        // MSG_NOSIGNAL: a peer that has gone away must not SIGPIPE the process.
+        ssize_t n = ::send(socket_, data, size, MSG_NOSIGNAL);
+        if (n > 0) count(static_cast<uint64_t>(n));
+        if (n != ssize_t(size)) {
+            std::cerr << "ClientConnection[" << id_ << "] write error: "
+                      << strerror(errno) << "\n";
+            return;
+        }
+        written();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    if (shut_) return;
+    size_t sent = 0;
+    if (output_sent_ == output_.size()) {
+        // Nothing queued, so the bytes may go straight out, in order.
+        ssize_t n;
+        do n = ::send(socket_, data, size, MSG_NOSIGNAL);
+        while (n < 0 && errno == EINTR);
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            // The peer is gone; the read side reports the disconnect.
+            if (errno != EPIPE && errno != ECONNRESET) {
+                std::cerr << "ClientConnection[" << id_ << "] write error: "
+                          << strerror(errno) << "\n";
+            }
+            return;
+        }
+        sent = n > 0 ? static_cast<size_t>(n) : 0;
+    }
+    if (sent == size) {
+        count(size);
+        written();
+    } else if (queueOutput(data + sent, size - sent)) {
+        count(size);
+        if (trace) output_traces_.emplace_back(output_queued_total_, *trace);
+    }
+}
+
+bool ClientConnection::queueOutput(const uint8_t* data, size_t size) {
+    const bool idle = output_sent_ == output_.size();
+    if (output_.size() - output_sent_ + size > output_limit_) {
+        // A frame may already be half written; dropping the rest would
+        // corrupt the stream, so the reader goes instead.
+        shut_ = true;
+        output_.clear();
+        output_.shrink_to_fit();
+        output_sent_ = 0;
+        output_traces_.clear();
+        if (slow_) slow_->add(1);
+        std::cerr << "[Client " << id_ << "] More than " << output_limit_
+                  << " bytes unread; disconnecting slow reader\n";
+        ::shutdown(socket_, SHUT_RDWR);
+        return false;
+    }
+    if (idle) {
+        output_.clear();
+        output_sent_ = 0;
+    }
+    output_.insert(output_.end(), data, data + size);
+    output_queued_total_ += size;
+    // The loop learns of the queue on its own thread; before start() the
+    // first watch covers it.
+    if (idle && loop_) {
+        loop_->post([self = shared_from_this()]() {
+            std::lock_guard<std::mutex> lock(self->output_mutex_);
+            self->watchSocket();
+        });
+    }
+    return true;
+}
+
+void ClientConnection::onWritable() {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    while (output_sent_ < output_.size()) {
+        ssize_t n = ::send(socket_, output_.data() + output_sent_,
+                           output_.size() - output_sent_, MSG_NOSIGNAL);
+        if (n > 0) {
+            output_sent_ += static_cast<size_t>(n);
+            output_sent_total_ += static_cast<uint64_t>(n);
+            recordWritten(monotonicNs());
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Still armed for EPOLLOUT; keep the unsent tail at the front
+            // once most of the buffer has gone.
+            if (output_sent_ > output_.size() / 2) {
+                output_.erase(output_.begin(), output_.begin() + output_sent_);
+                output_sent_ = 0;
+            }
+            return;
+        }
+        // The peer is gone; the read side reports the disconnect.
+        break;
+    }
+    output_.clear();
+    output_sent_ = 0;
+    output_sent_total_ = output_queued_total_;
+    output_traces_.clear();     // written, or lost with the peer
+    watchSocket();
+}
+
+void ClientConnection::recordWritten(uint64_t now_ns) {
+    while (!output_traces_.empty() && output_traces_.front().first <= output_sent_total_) {
+        const SendTrace& trace = output_traces_.front().second;
+        trace.tracer->record(LatencyStage::Write, trace.start_ns, now_ns);
+        trace.tracer->record(LatencyStage::Total, trace.rx_ns, now_ns);
+        output_traces_.pop_front();
     }
 }
 
@@ -54,38 +220,53 @@ void ClientConnection::readLoop() {
         uint8_t byte;
         ssize_t n = ::read(socket_, &byte, 1);
         if (n <= 0) {
+            if (!running_) break;   // stop()
             if (n < 0) {
                 std::cerr << "[Client " << id_ << "] Read error: " << strerror(errno) << std::endl;
             } 
 
-            running_ = false;
-
-            if (disconnectCallback_) {
-                disconnectCallback_(shared_from_this());
-            }
+            closed();
             break;
         }
 
-        buffer_.push_back(byte);
-
-        // Attempt to parse one or more complete frames
-        while (true) {
-            auto opt = Protocol::unpack(buffer_.data(),
-                                        static_cast<uint16_t>(buffer_.size()));
-            if (!opt) break;
-
-            Packet pkt = *opt;
+        decoder_.feed(&byte, 1);
+        drain_(*this, sink_);
+        if (metrics_) {
+            metrics_->bytes_in->add(1);
+            tally_.report(decoder_, *metrics_);
+        }
+    }
+}
 
-            if (callback_) {
-                callback_(pkt);
+void ClientConnection::onReadable() {
+    uint8_t chunk[4096];
+    while (true) {
+        ssize_t n = ::recv(socket_, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (n > 0) {
+            decoder_.feed(chunk, static_cast<size_t>(n));
+            drain_(*this, sink_);
+            if (metrics_) {
+                metrics_->bytes_in->add(static_cast<uint64_t>(n));
+                tally_.report(decoder_, *metrics_);
             }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n < 0 && errno == EINTR) continue;
 
-            size_t frameLen = 1  /*L*/ + 1 /*ID*/ 
-                            + pkt.payload.size() 
-                            + 1 /*CRC*/ + 1 /*END*/;
-            buffer_.erase(buffer_.begin(),
-                          buffer_.begin() + frameLen);
+        if (n < 0 && errno != ECONNRESET) {
+            std::cerr << "[Client " << id_ << "] Read error: " << strerror(errno) << std::endl;
         }
+        loop_->unwatch(socket_);
+        closed();
+        return;
+    }
+}
+
+void ClientConnection::closed() {
+    running_ = false;
+    if (disconnectCallback_) {
+        disconnectCallback_(shared_from_this());
     }
 }
 
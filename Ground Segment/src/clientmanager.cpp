@@ -1,12 +1,36 @@
 #include "clientmanager.hpp"
 #include "idgenerator.hpp"
 #include "clientconnection.hpp"
+#include "packet_registry.hpp"
+#include "protocol.hpp"
 
 #include <iostream>
+#include <memory_resource>
 #include <vector>
 
 namespace altair {
 
+namespace {
+
+/// Sends a rollup sample line to the client the way it gets samples.
+void sendRollup(ClientConnection& client, bool routed, uint8_t sat, std::string_view line,
+                const SendTrace* trace) {
+    std::byte buf[3 * PROTO_MAX_PACKET_LEN + 256];
+    std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf));
+
+    // Room for the ROUTED envelope's two bytes.
+    auto pkt = packets::encode(packets::SampleLine{line.substr(0, packets::MAX_FRAME_PAYLOAD - 2)},
+                               &arena);
+    if (!pkt) return;
+    if (!routed) {
+        client.send(Protocol::pack(*pkt, &arena), trace);
+    } else if (auto envelope = Protocol::makeRouted(sat, *pkt, &arena)) {
+        client.send(Protocol::pack(*envelope, &arena), trace);
+    }
+}
+
+} // namespace
+
 int ClientManager::registerClient(std::shared_ptr<ClientConnection> client) {
     if (!client) {
         throw std::invalid_argument("Client cannot be null");
@@ -25,6 +49,9 @@ void ClientManager::unregisterClient(int clientId) {
     if (it != clients_.end()) {
         clients_.erase(it);
     }
+    routed_.erase(clientId);
+    rates_.erase(clientId);
+    journal_.erase(clientId);
 }
 
 std::shared_ptr<ClientConnection> ClientManager::getClient(int clientId) {
@@ -40,4 +67,87 @@ void ClientManager::broadcastToAll(const std::vector<uint8_t>& data) {
     }
 }
 
+void ClientManager::setRouted(int clientId,
+                              const std::function<void(ClientConnection&)>& greet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = clients_.find(clientId);
+    if (it != clients_.end() && routed_.insert(clientId).second && greet) {
+        greet(*it->second);
+    }
+}
+
+void ClientManager::broadcastRouted(uint8_t sat, const Packet& sample,
+                                    const std::pmr::vector<uint8_t>& routed,
+                                    const std::pmr::vector<uint8_t>* legacy,
+                                    const FrameTrace& trace) {
+    const auto now = RateFilter::Clock::now();
+    const std::string_view text(reinterpret_cast<const char*>(sample.payload.data()),
+                                sample.payload.size());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [id, client] : clients_) {
+        if (journal_.count(id)) continue;
+        const bool is_routed = routed_.count(id) != 0;
+        const auto* frame = is_routed ? (routed.empty() ? nullptr : &routed) : legacy;
+        if (!frame) continue;
+
+        auto rate = rates_.find(id);
+        RateFilter* filter = rate == rates_.end() ? nullptr : rate->second.filterFor(sat);
+        if (!filter) {
+            traced(trace, [&](const SendTrace* t) { client->send(*frame, t); });
+            continue;
+        }
+        switch (filter->offer(text, now)) {
+            case RateFilter::Verdict::Drop:
+                break;
+            case RateFilter::Verdict::Pass:
+                traced(trace, [&](const SendTrace* t) { client->send(*frame, t); });
+                break;
+            case RateFilter::Verdict::Rollup:
+                traced(trace, [&](const SendTrace* t) {
+                    sendRollup(*client, is_routed, sat, filter->rollup(), t);
+                });
+                break;
+        }
+    }
+}
+
+bool ClientManager::setRate(int clientId, uint8_t sat, RateSpec spec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!clients_.count(clientId)) return false;
+
+    ClientRates& rates = rates_[clientId];
+    rates.set(sat, spec);
+    if (rates.passesAll()) rates_.erase(clientId);
+    return true;
+}
+
+bool ClientManager::startJournal(int clientId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!clients_.count(clientId)) return false;
+    return journal_.emplace(clientId, UINT64_MAX).second;
+}
+
+bool ClientManager::followJournal(int clientId, const std::function<uint64_t()>& catch_up) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = journal_.find(clientId);
+    if (it == journal_.end()) return false;
+    // No broadcast can slip in between the last replayed frame and this.
+    it->second = catch_up();
+    return true;
+}
+
+void ClientManager::broadcastJournal(uint64_t offset, const std::pmr::vector<uint8_t>& entry,
+                                     const FrameTrace& trace) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [id, next] : journal_) {
+        // Below next: already sent by the replay.
+        if (offset < next) continue;
+        next = offset + 1;
+        if (entry.empty()) continue;
+        auto& client = clients_.at(id);
+        traced(trace, [&](const SendTrace* t) { client->send(entry, t); });
+    }
+}
+
 } // namespace altair
\ No newline at end of file
@@ -0,0 +1,261 @@
+// Cost per frame of the path from a client socket to the packet handler.
+//
+// Frames are written into one end of a socketpair and read by a
+// ClientConnection on an EventLoop driven from this thread, so the only
+// difference between runs is how the connection is wired to the handler:
+//
+//   callbacks  ClientConnection::onMessage -> weak_ptr lock -> std::function
+//              taking a shared_ptr, as TCPServer wired every client before
+//              sinks existed
+//   adapter    TCPServer::MessageCallbackSink, what setMessageCallback()
+//              installs now
+//   sink       a typed sink called directly from the frame loop
+//
+// Reading and frame decoding are the same in every run.
+
+#include "clientconnection.hpp"
+#include "eventloop.hpp"
+#include "protocol.hpp"
+#include "protocol_defs.hpp"
+#include "tcpserver.hpp"
+
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace altair;
+
+namespace {
+
+struct BenchConfig {
+    std::vector<std::string> wirings{"callbacks", "adapter", "sink"};
+    uint64_t                 frames{2000000};
+    unsigned                 repeat{9};
+    size_t                   payload{40};
+    std::string              json_path;
+};
+
+struct Result {
+    std::string wiring;
+    uint64_t    frames{0};
+    double      best_ns{0};
+    double      median_ns{0};
+};
+
+/// CPU time of the calling thread; the VM scheduler does not count.
+double threadCpuNs() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/// Stands in for the gateway's inline handler: touches every packet.
+struct Handler {
+    uint64_t count{0};
+    uint64_t bytes{0};
+
+    void handle(const Packet& pkt) {
+        ++count;
+        bytes += pkt.payload.size() + pkt.packetId;
+    }
+};
+
+struct HandlerSink {
+    Handler& handler;
+    void onPacket(ClientConnection&, const Packet& pkt) { handler.handle(pkt); }
+};
+
+/// Runs frames through one wiring; returns CPU ns per frame, writes included.
+double runOnce(const BenchConfig& cfg, const std::string& wiring,
+               const std::vector<uint8_t>& stream, size_t frames_per_stream) {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        throw std::runtime_error("socketpair failed: " + std::string(strerror(errno)));
+    }
+    ::fcntl(sv[1], F_SETFL, ::fcntl(sv[1], F_GETFL) | O_NONBLOCK);
+
+    Handler handler;
+    HandlerSink sink{handler};
+    TCPServer::MessageCallbackSink adapter{
+        [&handler](std::shared_ptr<ClientConnection>, const Packet& pkt) {
+            handler.handle(pkt);
+        }};
+    TCPServer::MessageCallback callback =
+        [&handler](std::shared_ptr<ClientConnection>, const Packet& pkt) {
+            handler.handle(pkt);
+        };
+
+    EventLoop loop;
+    auto conn = std::make_shared<ClientConnection>(sv[0]);
+    if (wiring == "callbacks") {
+        conn->onMessage([&callback, weak = std::weak_ptr<ClientConnection>(conn)](const Packet& p) {
+            if (auto self = weak.lock(); self && callback) callback(self, p);
+        });
+    } else if (wiring == "adapter") {
+        conn->setSink(adapter);
+    } else if (wiring == "sink") {
+        conn->setSink(sink);
+    } else {
+        ::close(sv[1]);
+        throw std::invalid_argument("Unknown wiring: " + wiring);
+    }
+    conn->start(loop);
+
+    size_t   off = 0;
+    uint64_t written_frames = 0;
+    double start = threadCpuNs();
+    while (handler.count < cfg.frames) {
+        // Keep the socket full; the stream repeats until enough frames went in.
+        if (written_frames < cfg.frames) {
+            ssize_t n = ::write(sv[1], stream.data() + off, stream.size() - off);
+            if (n > 0) {
+                off += static_cast<size_t>(n);
+                if (off == stream.size()) {
+                    off = 0;
+                    written_frames += frames_per_stream;
+                }
+            } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                ::close(sv[1]);
+                throw std::runtime_error("write failed: " + std::string(strerror(errno)));
+            }
+        }
+        loop.runOnce(std::chrono::milliseconds(0));
+    }
+    double elapsed = threadCpuNs() - start;
+
+    ::close(sv[1]);
+    loop.unwatch(sv[0]);
+    return elapsed / handler.count;
+}
+
+/// Runs every wiring cfg.repeat times, interleaved so drift in the
+/// machine's speed hits them alike.
+std::vector<Result> run(const BenchConfig& cfg) {
+    // 64 KiB of back-to-back SAMPLE frames, written over and over.
+    Packet pkt{};
+    pkt.packetId = PROTO_PKT_SAMPLE;
+    pkt.payload.assign(cfg.payload, '0');
+    auto frame = Protocol::pack(pkt);
+
+    std::vector<uint8_t> stream;
+    size_t frames_per_stream = std::max<size_t>(1, (64 * 1024) / frame.size());
+    for (size_t i = 0; i < frames_per_stream; ++i) {
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    std::vector<std::vector<double>> samples(cfg.wirings.size());
+    for (unsigned i = 0; i < cfg.repeat; ++i) {
+        for (size_t w = 0; w < cfg.wirings.size(); ++w) {
+            samples[w].push_back(runOnce(cfg, cfg.wirings[w], stream, frames_per_stream));
+        }
+    }
+
+    std::vector<Result> results;
+    for (size_t w = 0; w < cfg.wirings.size(); ++w) {
+        auto& s = samples[w];
+        std::sort(s.begin(), s.end());
+
+        Result r;
+        r.wiring    = cfg.wirings[w];
+        r.frames    = cfg.frames;
+        r.best_ns   = s.front();
+        r.median_ns = s[s.size() / 2];
+        results.push_back(r);
+    }
+    return results;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(12) << "wiring" << std::right
+              << std::setw(12) << "frames" << std::setw(14) << "best ns/fr"
+              << std::setw(14) << "median ns/fr" << std::setw(14) << "Mfr/s" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(12) << r.wiring << std::right << std::fixed
+                  << std::setw(12) << r.frames
+                  << std::setprecision(1)
+                  << std::setw(14) << r.best_ns << std::setw(14) << r.median_ns
+                  << std::setprecision(2) << std::setw(14) << 1e3 / r.median_ns << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"wiring\":\"" << r.wiring << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"frames\":" << r.frames
+       << ",\"payload\":" << cfg.payload
+       << ",\"repeat\":" << cfg.repeat
+       << ",\"ns_per_frame\":{\"best\":" << r.best_ns
+       << ",\"median\":" << r.median_ns << "}}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --wirings LIST        comma-separated: callbacks, adapter, sink (default all)\n"
+              << "  --frames N            frames per run (default 2000000)\n"
+              << "  --repeat N            runs per wiring (default 9)\n"
+              << "  --payload N           payload bytes per frame (default 40)\n"
+              << "  --json FILE           append one JSON object per wiring ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--wirings") {
+                cfg.wirings.clear();
+                std::istringstream list(value());
+                std::string item;
+                while (std::getline(list, item, ',')) cfg.wirings.push_back(item);
+            }
+            else if (arg == "--frames")  cfg.frames = std::stoull(value());
+            else if (arg == "--repeat")  cfg.repeat = std::max(1ul, std::stoul(value()));
+            else if (arg == "--payload") cfg.payload = std::min<size_t>(std::stoul(value()), 254);
+            else if (arg == "--json")    cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        auto results = run(cfg);
+
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
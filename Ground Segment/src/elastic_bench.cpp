@@ -0,0 +1,244 @@
+// Elastic ThreadPool sizing under a bursty load profile.
+//
+// A feeder replays --profile, phases of NAME:SECONDS@TASKS_PER_S, queueing
+// tasks that each block for --task-us (a handler waiting on disk or a
+// socket). Each task's wait is the time from when it was due to when a
+// worker started it. The profile is run on:
+//
+//   elastic  ThreadPool(ElasticConfig) between --min and --max threads
+//   fixed    ThreadPool(--min), the size an idle pass would pick
+//
+// The table shows, per phase, the wait quantiles and the thread counts
+// seen. The exit status is 2 if the elastic pool did not grow past --min
+// during the busiest phase, or was not back at --min by the end of the
+// last one.
+
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Phase {
+    std::string name;
+    double      seconds{0};
+    double      rate{0};            // tasks per second
+};
+
+struct BenchConfig {
+    std::vector<Phase> profile;
+    unsigned           task_us{1000};
+    unsigned           min_threads{1};
+    unsigned           max_threads{32};
+    unsigned           target_ms{2};
+    unsigned           idle_ms{500};
+    std::string        json_path;
+};
+
+struct PhaseResult {
+    std::string pool;
+    std::string phase;
+    uint64_t    tasks{0};
+    double      p50_ms{0};
+    double      p99_ms{0};
+    unsigned    min_threads{0};
+    unsigned    max_threads{0};
+    unsigned    end_threads{0};
+};
+
+Phase parsePhase(const std::string& text) {
+    auto colon = text.find(':');
+    auto at    = text.find('@');
+    if (colon == std::string::npos || at == std::string::npos || at < colon) {
+        throw std::invalid_argument("Bad phase " + text + " (want NAME:SECONDS@RATE)");
+    }
+    return {text.substr(0, colon), std::stod(text.substr(colon + 1, at - colon - 1)),
+            std::stod(text.substr(at + 1))};
+}
+
+double quantile(std::vector<double>& values, double q) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+}
+
+std::vector<PhaseResult> replay(const BenchConfig& cfg, bool elastic) {
+    ThreadPool::ElasticConfig config;
+    config.min_threads  = cfg.min_threads;
+    config.max_threads  = cfg.max_threads;
+    config.target_wait  = std::chrono::milliseconds(cfg.target_ms);
+    config.idle_timeout = std::chrono::milliseconds(cfg.idle_ms);
+    auto pool = elastic ? std::make_unique<ThreadPool::ThreadPool>(config)
+                        : std::make_unique<ThreadPool::ThreadPool>(cfg.min_threads);
+
+    std::vector<PhaseResult> results;
+    for (const auto& phase : cfg.profile) {
+        std::mutex          waits_mutex;
+        std::vector<double> waits_ms;
+        std::atomic<bool>   sampling{true};
+        unsigned            lo = pool->stats().threads, hi = lo;
+
+        // Thread counts as the phase goes; the pool only reports snapshots.
+        std::thread sampler([&]() {
+            while (sampling) {
+                unsigned n = pool->stats().threads;
+                lo = std::min(lo, n);
+                hi = std::max(hi, n);
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        });
+
+        const auto start = Clock::now();
+        const auto end   = start + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double>(phase.seconds));
+        const auto gap   = std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double>(1.0 / std::max(phase.rate, 1e-3)));
+        std::vector<std::future<void>> pending;
+        for (auto due = start; due < end; due += gap) {
+            std::this_thread::sleep_until(due);
+            pending.push_back(pool->submit([&, due]() {
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - due).count();
+                std::this_thread::sleep_for(std::chrono::microseconds(cfg.task_us));
+                std::lock_guard<std::mutex> lock(waits_mutex);
+                waits_ms.push_back(ms);
+            }));
+        }
+        for (auto& f : pending) f.get();
+        std::this_thread::sleep_until(end);
+        sampling = false;
+        sampler.join();
+
+        PhaseResult r;
+        r.pool        = elastic ? "elastic" : "fixed";
+        r.phase       = phase.name;
+        r.tasks       = waits_ms.size();
+        r.p50_ms      = quantile(waits_ms, 0.50);
+        r.p99_ms      = quantile(waits_ms, 0.99);
+        r.min_threads = lo;
+        r.max_threads = hi;
+        r.end_threads = pool->stats().threads;
+        results.push_back(r);
+    }
+    return results;
+}
+
+void printTable(const std::vector<PhaseResult>& results) {
+    std::cout << std::left << std::setw(9) << "pool" << std::setw(10) << "phase" << std::right
+              << std::setw(9) << "tasks" << std::setw(11) << "p50 ms" << std::setw(11) << "p99 ms"
+              << std::setw(9) << "threads" << std::setw(7) << "end" << "\n";
+    for (const auto& r : results) {
+        std::ostringstream threads;
+        threads << r.min_threads << "-" << r.max_threads;
+        std::cout << std::left << std::setw(9) << r.pool << std::setw(10) << r.phase
+                  << std::right << std::fixed << std::setw(9) << r.tasks << std::setprecision(2)
+                  << std::setw(11) << r.p50_ms << std::setw(11) << r.p99_ms
+                  << std::setw(9) << threads.str() << std::setw(7) << r.end_threads << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const PhaseResult& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"pool\":\"" << r.pool << "\""
+       << ",\"phase\":\"" << r.phase << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"task_us\":" << cfg.task_us
+       << ",\"tasks\":" << r.tasks
+       << ",\"p50_ms\":" << r.p50_ms
+       << ",\"p99_ms\":" << r.p99_ms
+       << ",\"min_threads\":" << r.min_threads
+       << ",\"max_threads\":" << r.max_threads
+       << ",\"end_threads\":" << r.end_threads << "}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --profile LIST        NAME:SECONDS@TASKS_PER_S,... (default\n"
+              << "                        quiet:1@50,pass:2@2000,quiet:2@50)\n"
+              << "  --task-us N           time each task blocks (default 1000)\n"
+              << "  --min N               fewest threads, and the fixed pool's size (default 1)\n"
+              << "  --max N               most threads (default 32)\n"
+              << "  --target-ms N         queue wait that grows the pool (default 2)\n"
+              << "  --idle-ms N           idle time that retires a thread (default 500)\n"
+              << "  --json FILE           append one JSON object per phase ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        std::string profile = "quiet:1@50,pass:2@2000,quiet:2@50";
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--profile")        profile = value();
+            else if (arg == "--task-us")   cfg.task_us = std::stoul(value());
+            else if (arg == "--min")       cfg.min_threads = std::max(1ul, std::stoul(value()));
+            else if (arg == "--max")       cfg.max_threads = std::stoul(value());
+            else if (arg == "--target-ms") cfg.target_ms = std::stoul(value());
+            else if (arg == "--idle-ms")   cfg.idle_ms = std::stoul(value());
+            else if (arg == "--json")      cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        std::istringstream list(profile);
+        std::string item;
+        while (std::getline(list, item, ',')) cfg.profile.push_back(parsePhase(item));
+        if (cfg.profile.empty()) throw std::invalid_argument("Empty --profile");
+        cfg.max_threads = std::max(cfg.max_threads, cfg.min_threads);
+
+        auto results = replay(cfg, true);
+        auto fixed   = replay(cfg, false);
+        results.insert(results.end(), fixed.begin(), fixed.end());
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+
+        // The elastic results come first, one per phase.
+        size_t busiest = 0;
+        for (size_t p = 1; p < cfg.profile.size(); ++p) {
+            if (cfg.profile[p].rate > cfg.profile[busiest].rate) busiest = p;
+        }
+        if (results[busiest].max_threads <= cfg.min_threads && cfg.max_threads > cfg.min_threads) {
+            std::cout << "Elastic pool did not grow during " << cfg.profile[busiest].name << "\n";
+            return 2;
+        }
+        if (results[cfg.profile.size() - 1].end_threads != cfg.min_threads) {
+            std::cout << "Elastic pool ended with " << results[cfg.profile.size() - 1].end_threads
+                      << " threads, not " << cfg.min_threads << "\n";
+            return 2;
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,161 @@
+#include "eventloop.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace altair {
+
+EventLoop::EventLoop() {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0)
+        throw std::runtime_error("EventLoop: epoll_create1 failed: "
+                                 + std::string(strerror(errno)));
+
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        ::close(epoll_fd_);
+        throw std::runtime_error("EventLoop: eventfd failed: "
+                                 + std::string(strerror(errno)));
+    }
+
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+}
+
+EventLoop::~EventLoop() {
+    if (wake_fd_ >= 0)  ::close(wake_fd_);
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+}
+
+void EventLoop::watch(int fd, uint32_t events, IoCallback cb) {
+    epoll_event ev{};
+    ev.events  = events;
+    ev.data.fd = fd;
+
+    auto it = watchers_.find(fd);
+    int  op = (it == watchers_.end()) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (::epoll_ctl(epoll_fd_, op, fd, &ev) < 0)
+        throw std::runtime_error("EventLoop: epoll_ctl failed: "
+                                 + std::string(strerror(errno)));
+
+    watchers_[fd] = std::make_shared<IoCallback>(std::move(cb));
+}
+
+void EventLoop::unwatch(int fd) {
+    if (watchers_.erase(fd)) {
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+EventLoop::TimerId EventLoop::addTimer(Clock::time_point when, Callback cb) {
+    TimerId id = next_timer_++;
+    timers_.emplace(when, id);
+    timer_callbacks_.emplace(id, std::move(cb));
+    return id;
+}
+
+void EventLoop::cancelTimer(TimerId id) {
+    // The heap entry stays behind and is skipped when it comes due.
+    timer_callbacks_.erase(id);
+}
+
+void EventLoop::post(Callback cb) {
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        posted_.push_back(std::move(cb));
+    }
+    wake();
+}
+
+void EventLoop::stop() {
+    stopping_ = true;
+    wake();
+}
+
+void EventLoop::run() {
+    // A stop() that came before run() still counts, or an owner stopping
+    // a thread that has not reached run() yet would wait on it forever.
+    while (!stopping_) {
+        runOnce(std::chrono::milliseconds(1000));
+    }
+    stopping_ = false;      // ready to run again
+}
+
+void EventLoop::runOnce(std::chrono::milliseconds timeout) {
+    constexpr int kMaxEvents = 128;
+    epoll_event events[kMaxEvents];
+
+    int n = ::epoll_wait(epoll_fd_, events, kMaxEvents, nextTimeoutMs(timeout));
+    if (n < 0 && errno != EINTR)
+        throw std::runtime_error("EventLoop: epoll_wait failed: "
+                                 + std::string(strerror(errno)));
+
+    for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == wake_fd_) {
+            uint64_t drained;
+            while (::read(wake_fd_, &drained, sizeof(drained)) > 0) {}
+            continue;
+        }
+        auto it = watchers_.find(fd);
+        if (it == watchers_.end()) continue;
+        auto cb = it->second;   // keep alive if the callback unwatches
+        (*cb)(events[i].events);
+    }
+
+    runTimers();
+    runPosted();
+}
+
+void EventLoop::wake() {
+    uint64_t one = 1;
+    ssize_t  n   = ::write(wake_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void EventLoop::runPosted() {
+    std::vector<Callback> batch;
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        batch.swap(posted_);
+    }
+    for (auto& cb : batch) cb();
+}
+
+void EventLoop::runTimers() {
+    auto now = Clock::now();
+    while (!timers_.empty() && timers_.begin()->first <= now) {
+        TimerId id = timers_.begin()->second;
+        timers_.erase(timers_.begin());
+        auto it = timer_callbacks_.find(id);
+        if (it == timer_callbacks_.end()) continue;
+        Callback cb = std::move(it->second);
+        timer_callbacks_.erase(it);
+        cb();
+    }
+}
+
+int EventLoop::nextTimeoutMs(std::chrono::milliseconds cap) const {
+    {
+        std::lock_guard<std::mutex> lock(posted_mutex_);
+        if (!posted_.empty()) return 0;
+    }
+    if (timers_.empty()) return static_cast<int>(cap.count());
+
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        timers_.begin()->first - Clock::now());
+    if (wait.count() < 0) return 0;
+    // Round up so a timer is never polled a millisecond early.
+    return static_cast<int>(std::min(cap, wait + std::chrono::milliseconds(1)).count());
+}
+
+} // namespace altair
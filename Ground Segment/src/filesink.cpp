@@ -0,0 +1,139 @@
+#include "filesink.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace altair {
+
+FileSink::FileSink(const std::string& path, FileSinkOptions options)
+    : path_(path)
+    , options_(options)
+{
+    if (options_.buffer_size == 0) options_.buffer_size = 1;
+
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("FileSink: failed to open " + path_ + ": "
+                                 + strerror(errno));
+    }
+
+    active_.reserve(options_.buffer_size);
+    standby_.reserve(options_.buffer_size);
+    writer_ = std::thread(&FileSink::writerLoop, this);
+}
+
+FileSink::~FileSink() {
+    close();
+}
+
+void FileSink::write(const uint8_t* data, size_t len) {
+    if (len == 0) return;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closing_) return;
+
+    // Back-pressure only when the writer is still busy with the other buffer.
+    if (!active_.empty() && active_.size() + len > options_.buffer_size) {
+        flush_requested_ = true;
+        writer_cv_.notify_one();
+    }
+    producer_cv_.wait(lock, [&] {
+        return closing_ || active_.empty()
+            || active_.size() + len <= options_.buffer_size;
+    });
+    if (closing_) return;
+
+    active_.insert(active_.end(), data, data + len);
+    appended_ += len;
+
+    if (active_.size() >= options_.buffer_size) {
+        writer_cv_.notify_one();
+    }
+}
+
+void FileSink::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = appended_;
+    if (written_.load() >= target) return;
+
+    flush_requested_ = true;
+    writer_cv_.notify_one();
+    producer_cv_.wait(lock, [&] { return written_.load() >= target; });
+}
+
+void FileSink::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closing_) return;
+        closing_ = true;
+    }
+    writer_cv_.notify_one();
+    producer_cv_.notify_all();
+    if (writer_.joinable()) writer_.join();
+
+    if (fd_ >= 0) {
+        ::fdatasync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void FileSink::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        writer_cv_.wait_for(lock, options_.flush_interval, [&] {
+            return closing_ || flush_requested_
+                || active_.size() >= options_.buffer_size;
+        });
+
+        if (active_.empty()) {
+            flush_requested_ = false;
+            if (closing_) return;
+            continue;
+        }
+
+        // Swap under the lock, write without it.
+        active_.swap(standby_);
+        flush_requested_ = false;
+        producer_cv_.notify_all();
+        lock.unlock();
+
+        bool ok = writeAll(standby_);
+        size_t n = standby_.size();
+        if (ok) {
+            unsynced_ += n;
+            if (options_.fsync_every_bytes && unsynced_ >= options_.fsync_every_bytes) {
+                ::fdatasync(fd_);
+                unsynced_ = 0;
+            }
+        }
+
+        lock.lock();
+        standby_.clear();
+        // Count failed bytes as done so flush() cannot hang on a dead disk.
+        written_.fetch_add(n);
+        producer_cv_.notify_all();
+    }
+}
+
+bool FileSink::writeAll(const std::vector<uint8_t>& buf) {
+    size_t off = 0;
+    while (off < buf.size()) {
+        ssize_t n = ::write(fd_, buf.data() + off, buf.size() - off);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "FileSink[" << path_ << "] write error: "
+                      << strerror(errno) << "\n";
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace altair
@@ -0,0 +1,199 @@
+// Saving a downloaded history, FileSink against an ofstream per line.
+//
+// --lines sample lines, as the simulator's SD-card history holds them, are
+// saved the way LogClient's socket reader thread saves each received line:
+//
+//   sink      one FileSink kept open; each line is copied into its buffer
+//             and a background thread writes the buffers out
+//   ofstream  the file opened in append mode, written and closed for every
+//             line, as LogClient::saveLogData used to
+//
+// Each mode writes a fresh file in --dir and the time runs until every
+// byte has reached the kernel (FileSink::flush()). The table shows lines
+// per second, MiB per second and the per-line cost seen by the caller.
+
+#include "filesink.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    uint64_t    lines{100000};
+    std::string dir{"/tmp"};
+    bool        keep{false};
+    std::string json_path;
+};
+
+struct Result {
+    std::string mode;
+    uint64_t    lines{0};
+    uint64_t    bytes{0};
+    double      seconds{0};
+    double      p50_us{0};
+    double      p99_us{0};
+    double      max_us{0};
+};
+
+double quantile(std::vector<double>& values, double q) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+}
+
+/// One line per minute going back from 2025-04-20, in the simulator's format.
+std::vector<std::vector<uint8_t>> makeHistory(uint64_t lines) {
+    std::vector<std::vector<uint8_t>> history;
+    history.reserve(lines);
+    std::tm tm{};
+    tm.tm_year = 125;
+    tm.tm_mon  = 3;
+    tm.tm_mday = 20;
+    std::time_t t = timegm(&tm);
+    for (uint64_t i = 0; i < lines; ++i, t -= 60) {
+        std::tm* cur = std::gmtime(&t);
+        char buf[96];
+        int n = std::snprintf(buf, sizeof(buf),
+                              "%04d-%02d-%02d %02d:%02d:%02d T=%.1f H=%.1f L=%u V=%.2f\n",
+                              cur->tm_year + 1900, cur->tm_mon + 1, cur->tm_mday,
+                              cur->tm_hour, cur->tm_min, cur->tm_sec,
+                              20.0 + (i % 50) / 10.0, 40.0 + (i % 30) / 10.0,
+                              static_cast<unsigned>(400 + i % 200), 3.30 - (i % 20) / 100.0);
+        history.emplace_back(buf, buf + n);
+    }
+    return history;
+}
+
+Result run(const BenchConfig& cfg, const std::vector<std::vector<uint8_t>>& history, bool sink) {
+    Result r;
+    r.mode = sink ? "sink" : "ofstream";
+    const std::string path = cfg.dir + "/filesink_bench_" + r.mode + "_"
+                           + std::to_string(::getpid()) + ".txt";
+    std::remove(path.c_str());
+
+    std::vector<double> lat_us;
+    lat_us.reserve(history.size());
+    auto start = Clock::now();
+
+    if (sink) {
+        FileSink file(path);
+        for (const auto& line : history) {
+            auto t0 = Clock::now();
+            file.write(line);
+            lat_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        }
+        file.flush();
+        r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        r.bytes   = file.bytesWritten();
+    } else {
+        for (const auto& line : history) {
+            auto t0 = Clock::now();
+            std::ofstream file(path, std::ios::app);
+            if (!file) throw std::runtime_error("Failed to open " + path);
+            file.write(reinterpret_cast<const char*>(line.data()), line.size());
+            file.close();
+            lat_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+            r.bytes += line.size();
+        }
+        r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    if (!cfg.keep) std::remove(path.c_str());
+    r.lines  = lat_us.size();
+    r.p50_us = quantile(lat_us, 0.50);
+    r.p99_us = quantile(lat_us, 0.99);
+    r.max_us = lat_us.empty() ? 0 : lat_us.back();
+    return r;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(10) << "mode" << std::right
+              << std::setw(10) << "lines" << std::setw(12) << "lines/s" << std::setw(9) << "MiB/s"
+              << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(11) << "max us"
+              << std::setw(10) << "seconds" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(10) << r.mode << std::right << std::fixed
+                  << std::setw(10) << r.lines << std::setprecision(0)
+                  << std::setw(12) << r.lines / r.seconds << std::setprecision(1)
+                  << std::setw(9) << r.bytes / r.seconds / (1 << 20) << std::setprecision(2)
+                  << std::setw(10) << r.p50_us << std::setw(10) << r.p99_us
+                  << std::setw(11) << r.max_us << std::setprecision(3)
+                  << std::setw(10) << r.seconds << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"mode\":\"" << r.mode << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"lines\":" << r.lines
+       << ",\"bytes\":" << r.bytes
+       << ",\"seconds\":" << r.seconds
+       << ",\"lines_per_s\":" << r.lines / r.seconds
+       << ",\"p50_us\":" << r.p50_us
+       << ",\"p99_us\":" << r.p99_us
+       << ",\"max_us\":" << r.max_us << "}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --lines N             history lines to save (default 100000)\n"
+              << "  --dir DIR             where the output files go (default /tmp)\n"
+              << "  --keep                leave the output files behind\n"
+              << "  --json FILE           append one JSON object per mode ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--lines")       cfg.lines = std::max(1ull, std::stoull(value()));
+            else if (arg == "--dir")    cfg.dir = value();
+            else if (arg == "--keep")   cfg.keep = true;
+            else if (arg == "--json")   cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        const auto history = makeHistory(cfg.lines);
+        std::vector<Result> results{run(cfg, history, true), run(cfg, history, false)};
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, r);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
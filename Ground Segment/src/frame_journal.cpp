@@ -0,0 +1,439 @@
+#include "frame_journal.hpp"
+#include "protocol_defs.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace altair {
+
+namespace {
+
+std::string errnoText() {
+    return std::strerror(errno);
+}
+
+uint64_t realtimeNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+std::string segmentPath(const std::string& dir, uint64_t base) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020" PRIu64 ".seg", base);
+    return dir + "/" + name;
+}
+
+/// Size of the record at p if it is a complete frame with the expected
+/// offset, else 0. A crash leaves zeroes or a torn record after the last
+/// flushed one; both fail here.
+size_t validRecord(const uint8_t* p, size_t avail, uint64_t expected) {
+    if (avail < kJournalRecordHead) return 0;
+
+    uint64_t offset;
+    uint16_t size;
+    std::memcpy(&offset, p, sizeof(offset));
+    std::memcpy(&size, p + 18, sizeof(size));
+    if (offset != expected || size < 4 || size > kJournalMaxFrame
+        || avail < kJournalRecordHead + size) {
+        return 0;
+    }
+
+    const uint8_t* frame = p + kJournalRecordHead;
+    if (frame[0] != size - 3 || frame[size - 1] != PROTO_END_BYTE) return 0;
+    uint8_t cs = 0;
+    for (size_t i = 0; i < size - 2u; ++i) cs ^= frame[i];
+    return cs == frame[size - 2] ? kJournalRecordHead + size : 0;
+}
+
+} // namespace
+
+JournalSegment::~JournalSegment() {
+    if (map) ::munmap(map, mapped);
+    if (fd >= 0) ::close(fd);
+}
+
+void JournalSegment::allocateIndex() {
+    size_t records = mapped / (kJournalRecordHead + 4);
+    index = std::make_unique<uint64_t[]>(records / kJournalIndexStride + 1);
+}
+
+FrameJournal::FrameJournal(const std::string& dir, JournalOptions options)
+    : dir_(dir)
+    , options_(options)
+{
+    options_.segment_bytes = std::max<size_t>(options_.segment_bytes,
+                                              kJournalHeaderSize + kJournalRecordHead
+                                              + kJournalMaxFrame);
+
+    if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Cannot create journal " + dir + ": " + errnoText());
+    }
+    dir_fd_ = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd_ < 0) {
+        throw std::runtime_error("Cannot open journal " + dir + ": " + errnoText());
+    }
+
+    std::vector<std::string> names;
+    if (DIR* d = ::fdopendir(::dup(dir_fd_))) {
+        while (dirent* e = ::readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() == 24 && name.compare(20, 4, ".seg") == 0) names.push_back(name);
+        }
+        ::closedir(d);
+    }
+    // Zero-padded bases: name order is offset order.
+    std::sort(names.begin(), names.end());
+
+    try {
+        for (size_t i = 0; i < names.size(); ++i) {
+            bool last = i + 1 == names.size();
+            std::string path = dir + "/" + names[i];
+            auto seg = openSegment(path, last);
+            if (!seg) {
+                // Only a segment created just before a crash can lack its header.
+                if (!last) throw std::runtime_error(path + " is not a journal segment");
+                ::unlink(path.c_str());
+                continue;
+            }
+            if (last) active_ = seg;
+            segments_.push_back(std::move(seg));
+        }
+
+        for (auto& seg : segments_) {
+            if (seg != active_) seg->sealed = true;
+        }
+        if (!active_) roll(segments_.empty() ? 0 : segments_.back()->next.load());
+    }
+    catch (...) {
+        segments_.clear();
+        active_.reset();
+        ::close(dir_fd_);
+        throw;
+    }
+
+    begin_   = segments_.front()->base;
+    end_     = active_->next.load();
+    durable_ = end_.load();
+
+    flusher_ = std::thread([this]() { flushLoop(); });
+}
+
+FrameJournal::~FrameJournal() {
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        stopping_ = true;
+    }
+    flush_cv_.notify_all();
+    synced_cv_.notify_all();
+    if (flusher_.joinable()) flusher_.join();
+
+    flushPending();
+    if (active_) {
+        // Hand the unused tail back; it is allocated again on reopening.
+        if (::ftruncate(active_->fd, static_cast<off_t>(active_->used.load())) == 0) {
+            ::fsync(active_->fd);
+        }
+    }
+    if (dir_fd_ >= 0) ::close(dir_fd_);
+}
+
+std::shared_ptr<JournalSegment> FrameJournal::openSegment(const std::string& path,
+                                                          bool writable) {
+    auto seg = std::make_shared<JournalSegment>();
+    seg->path = path;
+    seg->fd   = ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if (seg->fd < 0) {
+        throw std::runtime_error("Cannot open segment " + path + ": " + errnoText());
+    }
+
+    struct stat st{};
+    if (::fstat(seg->fd, &st) != 0) {
+        throw std::runtime_error("Cannot stat segment " + path + ": " + errnoText());
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    if (size < kJournalHeaderSize) return nullptr;
+
+    // The active segment gets its room back for further appends.
+    if (writable && size < options_.segment_bytes) {
+        int rc = ::posix_fallocate(seg->fd, 0, static_cast<off_t>(options_.segment_bytes));
+        if (rc != 0) {
+            throw std::runtime_error("Cannot grow segment " + path + ": " + std::strerror(rc));
+        }
+        size = options_.segment_bytes;
+    }
+
+    void* p = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                     MAP_SHARED, seg->fd, 0);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Cannot map segment " + path + ": " + errnoText());
+    }
+    seg->map    = static_cast<uint8_t*>(p);
+    seg->mapped = size;
+
+    if (std::memcmp(seg->map, kJournalMagic, sizeof(kJournalMagic)) != 0) return nullptr;
+    std::memcpy(&seg->base, seg->map + 8, sizeof(seg->base));
+
+    seg->allocateIndex();
+    uint64_t pos  = kJournalHeaderSize;
+    uint64_t next = seg->base;
+    while (size_t n = validRecord(seg->map + pos, size - pos, next)) {
+        if ((next - seg->base) % kJournalIndexStride == 0) {
+            seg->index[(next - seg->base) / kJournalIndexStride] = pos;
+        }
+        uint64_t t;
+        std::memcpy(&t, seg->map + pos + 8, sizeof(t));
+        seg->last_ns.store(t, std::memory_order_relaxed);
+        pos += n;
+        ++next;
+    }
+    seg->used   = pos;
+    seg->next   = next;
+    seg->synced = next;
+    return seg;
+}
+
+void FrameJournal::roll(uint64_t base) {
+    auto seg = std::make_shared<JournalSegment>();
+    seg->path = segmentPath(dir_, base);
+    seg->fd   = ::open(seg->path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (seg->fd < 0) {
+        throw std::runtime_error("Cannot create segment " + seg->path + ": " + errnoText());
+    }
+
+    // Allocated blocks: a full disk fails here, not as SIGBUS in append(),
+    // and fdatasync() has no file size to write back.
+    int rc = ::posix_fallocate(seg->fd, 0, static_cast<off_t>(options_.segment_bytes));
+    if (rc != 0) {
+        ::unlink(seg->path.c_str());
+        throw std::runtime_error("Cannot allocate segment " + seg->path + ": "
+                                 + std::strerror(rc));
+    }
+
+    void* p = ::mmap(nullptr, options_.segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     seg->fd, 0);
+    if (p == MAP_FAILED) {
+        ::unlink(seg->path.c_str());
+        throw std::runtime_error("Cannot map segment " + seg->path + ": " + errnoText());
+    }
+    seg->map    = static_cast<uint8_t*>(p);
+    seg->mapped = options_.segment_bytes;
+    seg->base   = base;
+    seg->next   = base;
+    seg->synced = base;
+    seg->allocateIndex();
+    std::memcpy(seg->map, kJournalMagic, sizeof(kJournalMagic));
+    std::memcpy(seg->map + 8, &base, sizeof(base));
+
+    {
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        segments_.push_back(seg);
+    }
+    // Readers look for the next segment once this flag is up, so it is
+    // listed first.
+    if (active_) active_->sealed.store(true, std::memory_order_release);
+    active_ = std::move(seg);
+    dir_dirty_ = true;
+}
+
+uint64_t FrameJournal::append(uint8_t sat, const uint8_t* frame, size_t len) {
+    if (len > kJournalMaxFrame) {
+        throw std::invalid_argument("Frame of " + std::to_string(len)
+                                    + " bytes is too long for the journal");
+    }
+
+    const size_t need   = kJournalRecordHead + len;
+    const uint64_t offset = end_.load(std::memory_order_relaxed);
+    if (active_->used.load(std::memory_order_relaxed) + need > active_->mapped) {
+        roll(offset);
+    }
+
+    JournalSegment& seg = *active_;
+    uint64_t pos = seg.used.load(std::memory_order_relaxed);
+    uint64_t t   = realtimeNs();
+    uint16_t n   = static_cast<uint16_t>(len);
+
+    uint8_t* p = seg.map + pos;
+    std::memcpy(p, &offset, sizeof(offset));
+    std::memcpy(p + 8, &t, sizeof(t));
+    p[16] = sat;
+    p[17] = 0;
+    std::memcpy(p + 18, &n, sizeof(n));
+    std::memcpy(p + kJournalRecordHead, frame, len);
+    if ((offset - seg.base) % kJournalIndexStride == 0) {
+        seg.index[(offset - seg.base) / kJournalIndexStride] = pos;
+    }
+
+    // Publish the record only once it is complete.
+    seg.last_ns.store(t, std::memory_order_relaxed);
+    seg.next.store(offset + 1, std::memory_order_release);
+    seg.used.store(pos + need, std::memory_order_release);
+    end_.store(offset + 1, std::memory_order_release);
+
+    unsynced_bytes_ += need;
+    if (unsynced_bytes_ >= options_.sync_bytes) {
+        unsynced_bytes_ = 0;
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex_);
+            flush_requested_ = true;
+        }
+        flush_cv_.notify_one();
+    }
+    return offset;
+}
+
+void FrameJournal::sync() {
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    const uint64_t target = end();
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    synced_cv_.wait(lock, [&]() { return durable() >= target || stopping_; });
+}
+
+void FrameJournal::flushLoop() {
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    while (!stopping_) {
+        flush_cv_.wait_for(lock, options_.sync_interval,
+                           [&]() { return flush_requested_ || stopping_; });
+        flush_requested_ = false;
+
+        lock.unlock();
+        flushPending();
+        applyRetention();
+        lock.lock();
+
+        synced_cv_.notify_all();
+    }
+}
+
+void FrameJournal::flushPending() {
+    // Taken first: every record below it is in one of the segments below.
+    const uint64_t target = end();
+    if (durable() >= target) return;
+
+    std::vector<std::shared_ptr<JournalSegment>> dirty;
+    {
+        std::lock_guard<std::mutex> lock(segments_mutex_);
+        for (const auto& seg : segments_) {
+            if (seg->synced < seg->next.load(std::memory_order_acquire)) dirty.push_back(seg);
+        }
+    }
+
+    bool ok = true;
+    if (dir_dirty_.exchange(false) && ::fsync(dir_fd_) != 0) {
+        dir_dirty_ = true;
+        ok = false;
+    }
+    // One flush covers every frame appended since the previous one.
+    for (const auto& seg : dirty) {
+        uint64_t next = seg->next.load(std::memory_order_acquire);
+        if (::fdatasync(seg->fd) == 0) {
+            seg->synced = next;
+        } else {
+            std::cerr << "[Journal] fdatasync " << seg->path << ": " << errnoText() << "\n";
+            ok = false;
+        }
+    }
+    if (ok) durable_.store(target, std::memory_order_release);
+}
+
+void FrameJournal::applyRetention() {
+    if (options_.max_bytes == 0 && options_.max_age.count() == 0) return;
+
+    const uint64_t now_ns = realtimeNs();
+    const uint64_t max_age_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(options_.max_age).count());
+
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    uint64_t total = 0;
+    for (const auto& seg : segments_) total += seg->mapped;
+
+    // The active segment is always kept.
+    while (segments_.size() > 1) {
+        const auto& oldest = segments_.front();
+        bool too_big = options_.max_bytes && total > options_.max_bytes;
+        bool too_old = max_age_ns && oldest->last_ns.load(std::memory_order_relaxed) + max_age_ns
+                                     < now_ns;
+        if (!too_big && !too_old) break;
+
+        // Readers still on it keep the mapping; the file goes now.
+        ::unlink(oldest->path.c_str());
+        total -= oldest->mapped;
+        segments_.pop_front();
+        begin_.store(segments_.front()->base, std::memory_order_release);
+    }
+}
+
+std::shared_ptr<JournalSegment> FrameJournal::segmentFor(uint64_t offset) const {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), offset,
+                               [](uint64_t o, const std::shared_ptr<JournalSegment>& seg) {
+                                   return o < seg->base;
+                               });
+    return it == segments_.begin() ? segments_.front() : *std::prev(it);
+}
+
+std::shared_ptr<JournalSegment> FrameJournal::segmentAfter(uint64_t base) const {
+    std::lock_guard<std::mutex> lock(segments_mutex_);
+    for (const auto& seg : segments_) {
+        if (seg->base > base) return seg;
+    }
+    return nullptr;
+}
+
+JournalReader::JournalReader(const FrameJournal& journal, uint64_t from)
+    : journal_(journal)
+    , next_(std::min(from, journal.end()))
+{}
+
+void JournalReader::seek() {
+    segment_ = journal_.segmentFor(next_);
+    if (next_ < segment_->base) {
+        lost_ += segment_->base - next_;
+        next_  = segment_->base;
+    }
+
+    // Published records only: their index entries are written.
+    uint64_t used = segment_->used.load(std::memory_order_acquire);
+    uint64_t last = segment_->next.load(std::memory_order_acquire);
+    pos_ = kJournalHeaderSize;
+    if (next_ < last) {
+        pos_ = segment_->index[(next_ - segment_->base) / kJournalIndexStride];
+    }
+    while (pos_ < used) {
+        uint64_t offset;
+        uint16_t size;
+        std::memcpy(&offset, segment_->map + pos_, sizeof(offset));
+        if (offset >= next_) break;
+        std::memcpy(&size, segment_->map + pos_ + 18, sizeof(size));
+        pos_ += kJournalRecordHead + size;
+    }
+}
+
+bool JournalReader::advance() {
+    if (!segment_->sealed.load(std::memory_order_acquire)) return false;
+    // Records published before the seal may not have been seen yet.
+    if (pos_ < segment_->used.load(std::memory_order_acquire)) return true;
+
+    auto following = journal_.segmentAfter(segment_->base);
+    if (!following) return false;
+    if (next_ < following->base) {
+        lost_ += following->base - next_;
+        next_  = following->base;
+    }
+    segment_ = std::move(following);
+    pos_     = kJournalHeaderSize;
+    return pos_ < segment_->used.load(std::memory_order_acquire);
+}
+
+} // namespace altair
@@ -1,29 +1,81 @@
 #include "gateway.hpp"
+#include "packet_registry.hpp"
 #include "protocol.hpp"
 #include "protocol_defs.hpp"
+#include "asynclogger.hpp"
 
 #include <iostream>
 #include <stdexcept>
 #include <string>
-#include <iomanip>
 #include <cstring>
-
-#define PROTO_PKT_TIME_SYNC 0x04   
-
+#include <memory_resource>
+#include <algorithm>
+#include <thread>
 
 namespace altair {
 
 using namespace std::string_literals; 
 
-Gateway::Gateway(uint16_t tcp_port, const std::string& uart_device)
-    : tcp_server_(std::make_unique<TCPServer>(tcp_port))
-    , uart_comm_(std::make_unique<UartCommunicator>(uart_device))
+namespace {
+
+/// Journal frames sent to a replaying client per socket write.
+constexpr size_t kReplayBatchFrames = 256;
+
+/// Handler time buckets, in ns: inline handlers take microseconds, a
+/// handler stuck on a slow client socket milliseconds.
+const std::vector<uint64_t> kHandlerBounds{
+    250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+    500000, 1000000, 2500000, 10000000, 100000000};
+
+/// The JOURNAL frame for a journaled satellite frame; empty if the frame
+/// is too long to fit in the envelope.
+std::pmr::vector<uint8_t> journalEntry(uint64_t offset, uint8_t sat,
+                                       const uint8_t* frame, size_t len,
+                                       std::pmr::memory_resource* mr) {
+    packets::JournalEntry entry{offset, sat, frame[1],
+                                {reinterpret_cast<const char*>(frame + 2), len - 4}};
+    auto pkt = packets::encode(entry, mr);
+    if (!pkt) return std::pmr::vector<uint8_t>(mr);
+    return Protocol::pack(*pkt, mr);
+}
+
+} // namespace
+
+Gateway::Gateway(uint16_t tcp_port, const std::string& uart_device,
+                 DispatchMode mode, unsigned worker_threads)
+    : Gateway(tcp_port, std::vector<SatelliteConfig>{{0, uart_device, 115200}},
+              mode, worker_threads)
+{}
+
+Gateway::Gateway(uint16_t tcp_port, std::vector<SatelliteConfig> satellites,
+                 DispatchMode mode, unsigned worker_threads, unsigned tcp_shards)
+    : tcp_server_(std::make_unique<TCPServer>(tcp_port, tcp_shards))
+    , state_(std::make_unique<SatStateTable>())
+    , dispatch_mode_(mode)
 {
+    if (satellites.empty()) {
+        throw std::invalid_argument("Gateway needs at least one satellite");
+    }
+    default_sat_ = satellites.front().id;
+    for (const auto& sat : satellites) {
+        // 8N1: ten bits on the wire per byte.
+        link_capacity_[sat.id] = sat.baud_rate / 10.0;
+    }
+    uart_ = std::make_unique<UartReactor>(std::move(satellites));
+    limitCommands(AdmissionOptions{});
+
+    if (dispatch_mode_ == DispatchMode::Pool) {
+        if (worker_threads == 0) {
+            worker_threads = std::max(2u, std::thread::hardware_concurrency());
+        }
+        pool_ = std::make_unique<ThreadPool::ThreadPool>(worker_threads);
+        for (uint8_t sat : uart_->satellites()) {
+            sat_strands_[sat] = ThreadPool::Strand::create(*pool_, ThreadPool::Priority::High);
+        }
+    }
+
     // Set up callbacks
-    tcp_server_->setMessageCallback(
-        [this](std::shared_ptr<ClientConnection> client, const Packet& pkt) {
-            handleTcpPacket(client, pkt);
-        });
+    tcp_server_->setSink(tcp_sink_);
     
     tcp_server_->setClientConnectedCallback(
         [this](std::shared_ptr<ClientConnection> client) {
@@ -35,14 +87,24 @@ Gateway::Gateway(uint16_t tcp_port, const std::string& uart_device)
             handleClientDisconnect(client);
         });
 
-    uart_comm_->onReceive([this](const Packet& pkt) {
-        handleUartPacket(pkt);
+    uart_->setSink(uart_sink_);
+
+    tcp_server_->instrument(metrics_);
+    uart_->instrument(metrics_);
+    client_manager_.traceSends(&latency_);
+    registerMetrics();
+
+    // Every link, including one that comes back after a drop, gets the time.
+    uart_->onOpen([this](uint8_t sat) {
+        sendTimeSync(sat);
     });
 
 }
 
 Gateway::~Gateway() {
     stop();
+    // Workers reference the members below; let them finish first.
+    pool_.reset();
 }
 
 
@@ -52,10 +114,9 @@ void Gateway::start() {
     running_ = true;
 
     try {
-        uart_comm_->start();
+        uart_->start();
         tcp_server_->start();
-
-        sendTimeSync();
+        if (metrics_server_) metrics_server_->start();
     }
     catch (const std::exception& e) {
         stop();
@@ -63,7 +124,26 @@ void Gateway::start() {
     }
 }
 
-void Gateway::sendTimeSync() {
+void Gateway::submitCommand(ClientConnection& client, uint8_t sat, const Packet& pkt) {
+    if (sat == PROTO_SAT_ALL) {
+        for (uint8_t each : uart_->satellites()) submitCommand(client, each, pkt);
+        return;
+    }
+
+    std::chrono::milliseconds retry{0};
+    auto verdict = admission_->submit(client.getId(), sat, pkt, &retry);
+    if (verdict != CommandAdmission::Verdict::Rejected) return;
+
+    // Debug only: a flooding client must not flood the log as well.
+    AsyncLogger::instance().log(LogLevel::Debug,
+        "[Gateway] Client {} has too many commands waiting; rejected one for satellite {}",
+        client.getId(), static_cast<int>(sat));
+    auto rejected = packets::encode(packets::Rejected{
+        sat, pkt.packetId, static_cast<uint16_t>(std::min<int64_t>(retry.count(), UINT16_MAX))});
+    client.send(Protocol::pack(*rejected));
+}
+
+void Gateway::sendTimeSync(uint8_t sat) {
     auto now = std::chrono::system_clock::now();
     std::time_t time = std::chrono::system_clock::to_time_t(now);
     struct tm* ltm = std::localtime(&time);
@@ -86,17 +166,137 @@ void Gateway::sendTimeSync() {
     }
 
     // Create and send time sync packet
-    Packet timePkt;
-    timePkt.packetId = PROTO_PKT_TIME_SYNC;
-    timePkt.payload.assign(timestr, timestr + 14);
+    auto timePkt = packets::encode(packets::TimeSync{std::string_view(timestr, 14)});
+    uart_->send(sat, *timePkt);
+}
+
+void Gateway::recordUart(const std::string& capture_path) {
+    uart_->record(capture_path);
+}
+
+void Gateway::shareFrames(const std::string& name, size_t capacity) {
+    shm_ring_ = std::make_unique<ShmRingWriter>(name, capacity);
+}
 
-    uart_comm_->send(timePkt);
+void Gateway::multicastFrames(const MulticastOptions& options) {
+    multicast_ = std::make_unique<MulticastPublisher>(options);
+}
+
+void Gateway::journalFrames(const std::string& dir, const JournalOptions& options) {
+    journal_ = std::make_unique<FrameJournal>(dir, options);
+}
+
+void Gateway::shareState(const std::string& name) {
+    state_ = std::make_unique<SatStateTable>(name);
+}
+
+void Gateway::limitCommands(const AdmissionOptions& options) {
+    admission_ = std::make_unique<CommandAdmission>(options, link_capacity_,
+        [this](uint8_t sat, const Packet& pkt) { uart_->send(sat, pkt); });
+}
+
+void Gateway::limitClientQueues(size_t bytes) {
+    tcp_server_->setOutputLimit(bytes);
+}
+
+void Gateway::elasticWorkers(const ThreadPool::ElasticConfig& config) {
+    if (dispatch_mode_ != DispatchMode::Pool) {
+        throw std::logic_error("Gateway: elastic workers need pool dispatch");
+    }
+    // The strands hold the pool they post to.
+    sat_strands_.clear();
+    pool_ = std::make_unique<ThreadPool::ThreadPool>(config);
+    for (uint8_t sat : uart_->satellites()) {
+        sat_strands_[sat] = ThreadPool::Strand::create(*pool_, ThreadPool::Priority::High);
+    }
 }
 
 void Gateway::stop() {
-    running_ = false;
-    uart_comm_->stop();
+    bool was_running = running_.exchange(false);
+    if (metrics_server_) metrics_server_->stop();
+    latency_.stop();
+    uart_->stop();
     tcp_server_->stop();
+
+    if (was_running) {
+        const auto& s = admission_->stats();
+        AsyncLogger::instance().log(LogLevel::Info,
+            "[Gateway] Client commands: {} sent, {} waited, {} rejected, {} dropped",
+            s.admitted.load(), s.queued.load(), s.rejected.load(), s.dropped.load());
+    }
+
+    // Clients are shut down, so no replay is left blocked in a send.
+    std::lock_guard<std::mutex> lock(replays_mutex_);
+    for (auto& replay : replays_) {
+        if (replay.thread.joinable()) replay.thread.join();
+    }
+    replays_.clear();
+}
+
+void Gateway::serveMetrics(const std::string& address, uint16_t port) {
+    metrics_server_ = std::make_unique<MetricsServer>(metrics_, address, port);
+}
+
+void Gateway::reportLatency(std::chrono::seconds interval) {
+    latency_.report(interval);
+}
+
+void Gateway::registerMetrics() {
+    const std::string commands = "Client commands to the satellites, by what admission did.";
+    metrics_.counterFn("altair_commands_total", commands, {{"verdict", "sent"}},
+                       [this]() { return double(admission_->stats().admitted.load()); });
+    metrics_.counterFn("altair_commands_total", commands, {{"verdict", "rejected"}},
+                       [this]() { return double(admission_->stats().rejected.load()); });
+    metrics_.counterFn("altair_commands_total", commands, {{"verdict", "dropped"}},
+                       [this]() { return double(admission_->stats().dropped.load()); });
+    metrics_.counterFn("altair_commands_waited_total",
+                       "Client commands sent only after waiting for tokens.", {},
+                       [this]() { return double(admission_->stats().queued.load()); });
+
+    const std::string depth = "Items waiting in a gateway queue.";
+    metrics_.gaugeFn("altair_queue_depth", depth, {{"queue", "commands"}},
+                     [this]() { return double(admission_->waiting()); });
+    if (pool_) {
+        metrics_.gaugeFn("altair_queue_depth", depth, {{"queue", "workers_high"}}, [this]() {
+            return double(pool_->queue_depth(ThreadPool::Priority::High));
+        });
+        metrics_.gaugeFn("altair_queue_depth", depth, {{"queue", "workers_normal"}}, [this]() {
+            return double(pool_->queue_depth(ThreadPool::Priority::Normal));
+        });
+
+        // Read through pool_, which elasticWorkers() may replace.
+        metrics_.gaugeFn("altair_worker_threads", "Worker threads in the pool.", {},
+                         [this]() { return double(pool_->stats().threads); });
+        metrics_.gaugeFn("altair_worker_threads_idle", "Worker threads waiting for a task.", {},
+                         [this]() { return double(pool_->stats().idle_threads); });
+        metrics_.counterFn("altair_worker_threads_started_total", "Worker threads started.", {},
+                           [this]() { return double(pool_->stats().threads_started); });
+        metrics_.counterFn("altair_worker_threads_retired_total",
+                           "Worker threads retired by an elastic pool.", {},
+                           [this]() { return double(pool_->stats().threads_retired); });
+        metrics_.gaugeFn("altair_worker_queue_wait_smoothed_seconds",
+                         "Moving average of the time tasks waited for a worker; what an "
+                         "elastic pool grows on.", {},
+                         [this]() { return pool_->stats().smoothed_wait.count() * 1e-9; });
+        const std::string wait = "Time tasks waited for a worker since start, in seconds "
+                                 "(log2 bucket bounds).";
+        for (auto [lane, name] : {std::pair{ThreadPool::Priority::High, "high"},
+                                  std::pair{ThreadPool::Priority::Normal, "normal"}}) {
+            metrics_.gaugeFn("altair_worker_queue_wait_seconds", wait,
+                             {{"lane", name}, {"quantile", "0.99"}}, [this, lane = lane]() {
+                                 return pool_->queue_wait_histogram(lane).percentile(99) * 1e-9;
+                             });
+        }
+    }
+    metrics_.counterFn("altair_log_dropped_total", "Log records dropped on a full ring.", {},
+                       []() { return double(AsyncLogger::instance().dropped()); });
+
+    const std::string handler = "Time spent handling one frame, in seconds.";
+    uart_handler_time_ = &metrics_.histogram("altair_handler_seconds", handler, kHandlerBounds,
+                                             1e-9, {{"source", "satellites"}});
+    tcp_handler_time_  = &metrics_.histogram("altair_handler_seconds", handler, kHandlerBounds,
+                                             1e-9, {{"source", "clients"}});
+    latency_.exportTo(metrics_);
 }
 
 void Gateway::handleNewClient(std::shared_ptr<ClientConnection> client) {
@@ -113,75 +313,292 @@ void Gateway::handleClientDisconnect(std::shared_ptr<ClientConnection> client) {
     
     int clientId = client->getId();
     client_manager_.unregisterClient(clientId);
+    admission_->forget(clientId);
+
+    // Jobs already posted keep the strand alive until they have run.
+    std::lock_guard<std::mutex> lock(strands_mutex_);
+    client_strands_.erase(clientId);
+}
+
+std::shared_ptr<ThreadPool::Strand> Gateway::clientStrand(int clientId) {
+    std::lock_guard<std::mutex> lock(strands_mutex_);
+    auto& strand = client_strands_[clientId];
+    if (!strand) {
+        strand = ThreadPool::Strand::create(*pool_, ThreadPool::Priority::Normal);
+    }
+    return strand;
+}
+
+void Gateway::dispatchTcpPacket(ClientConnection& client, const Packet& pkt) {
+    if (!running_) return;
+
+    if (dispatch_mode_ == DispatchMode::Inline) {
+        handleTcpPacket(client, pkt);
+        return;
+    }
+
+    // The strand may run after the client is gone; keep it alive until then.
+    clientStrand(client.getId())->post([this, client = client.shared_from_this(), pkt]() {
+        handleTcpPacket(*client, pkt);
+    });
 }
 
-void Gateway::handleTcpPacket(std::shared_ptr<ClientConnection> client, 
-                             const Packet& pkt) {
-    if (!client || !running_) return;
+void Gateway::dispatchUartPacket(uint8_t sat, const Packet& pkt) {
+    if (!running_) return;
+
+    // Still on the reactor thread, whatever the dispatch mode, so the
+    // ring, the journal and the state table keep a single producer and
+    // multicast sequence numbers follow arrival order. The state is
+    // updated before the frame is broadcast: a client subscribing now
+    // gets it in its snapshot, live, or both, but never misses it.
+    const uint64_t decoded = monotonicNs();
+    latency_.record(LatencyStage::Decode, pkt.rx_ns, decoded);
+    state_->update(sat, pkt);
+
+    if (shm_ring_ || multicast_ || journal_) {
+        std::byte buf[PROTO_MAX_PACKET_LEN + 64];
+        std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf));
+        auto frame = Protocol::pack(pkt, &arena);
+        if (shm_ring_) shm_ring_->publish(sat, frame.data(), frame.size());
+        if (multicast_) multicast_->publish(sat, frame.data(), frame.size());
+        if (journal_) journalFrame(sat, frame.data(), frame.size(), {pkt.rx_ns, decoded});
+    }
+
+    if (dispatch_mode_ == DispatchMode::Inline) {
+        handleUartPacket(sat, pkt, decoded);
+        return;
+    }
 
+    sat_strands_.at(sat)->post([this, sat, pkt, decoded]() {
+        handleUartPacket(sat, pkt, decoded);
+    });
+}
+
+void Gateway::sendSnapshot(ClientConnection& client) {
+    std::vector<uint8_t> out;
+    auto add = [&](uint8_t sat, uint8_t id, std::string_view text) {
+        text = text.substr(0, packets::StateEntry::max_size - 2);
+        if (auto pkt = packets::encode(packets::StateEntry{sat, id, text})) {
+            auto frame = Protocol::pack(*pkt);
+            out.insert(out.end(), frame.begin(), frame.end());
+        }
+    };
+
+    SatState state;
+    for (uint8_t sat : uart_->satellites()) {
+        if (!state_->read(sat, state)) continue;
+        if (state.keep_alive.t_ns) add(sat, PROTO_PKT_KEEP_ALIVE, state.keep_alive.view());
+        if (state.event.t_ns)      add(sat, PROTO_PKT_EVENT, state.event.view());
+        if (state.sample.t_ns)     add(sat, PROTO_PKT_SAMPLE, state.sample.view());
+        if (state.mode[0])         add(sat, PROTO_STATE_MODE, state.mode);
+    }
+    if (!out.empty()) client.send(out);
+}
+
+void Gateway::journalFrame(uint8_t sat, const uint8_t* frame, size_t len,
+                           const FrameTrace& trace) {
     try {
-        std::cout << "[Gateway] Received TCP packet:" << std::endl;
-        std::cout << "  ID: 0x" << std::hex << static_cast<int>(pkt.packetId) 
-                  << std::dec << std::endl;
-        std::cout << "  Payload size: " << pkt.payload.size() << std::endl;
-        std::cout << "  Payload hex: ";
-        for (uint8_t b : pkt.payload) {
-            std::cout << std::hex << std::setw(2) << std::setfill('0') 
-                     << static_cast<int>(b) << " ";
+        uint64_t offset = journal_->append(sat, frame, len);
+
+        std::byte buf[PROTO_MAX_PACKET_LEN + 64];
+        std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf));
+        client_manager_.broadcastJournal(offset, journalEntry(offset, sat, frame, len, &arena),
+                                         trace);
+    }
+    catch (const std::exception& e) {
+        AsyncLogger::instance().log(LogLevel::Error,
+            "[Gateway] Failed to journal frame: {}", std::string(e.what()));
+    }
+}
+
+void Gateway::startReplay(ClientConnection& client, uint64_t from) {
+    auto& log = AsyncLogger::instance();
+    if (!journal_) {
+        log.log(LogLevel::Warn, "[Gateway] Client {} asked for a replay, but no journal is kept",
+                client.getId());
+        return;
+    }
+    if (!client_manager_.startJournal(client.getId())) {
+        log.log(LogLevel::Warn, "[Gateway] Client {} is already replaying", client.getId());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(replays_mutex_);
+    replays_.remove_if([](Replay& replay) {
+        if (!replay.done) return false;
+        replay.thread.join();
+        return true;
+    });
+
+    Replay& replay = replays_.emplace_back();
+    replay.thread = std::thread([this, &replay, client = client.shared_from_this(), from]() {
+        serveReplay(*client, from);
+        replay.done = true;
+    });
+}
+
+void Gateway::serveReplay(ClientConnection& client, uint64_t from) {
+    auto& log = AsyncLogger::instance();
+    const int id = client.getId();
+
+    JournalReader reader(*journal_, from);
+    std::pmr::monotonic_buffer_resource arena(16 * 1024);
+    std::vector<uint8_t> batch;
+    uint64_t sent = 0;
+
+    // Frames come straight out of the mapped segments; a batch of them
+    // goes out in one write.
+    auto add = [&](const JournalReader::Frame& frame) {
+        auto entry = journalEntry(frame.offset, frame.sat, frame.data, frame.size, &arena);
+        batch.insert(batch.end(), entry.begin(), entry.end());
+        ++sent;
+    };
+    auto flush = [&]() {
+        if (!batch.empty()) client.send(batch);
+        batch.clear();
+        arena.release();
+    };
+
+    while (running_ && client_manager_.getClient(id)) {
+        if (reader.poll(add, kReplayBatchFrames) > 0) {
+            flush();
+            continue;
         }
 
-        std::cout << std::dec << std::endl;
-        std::cout << "  Payload ASCII: ";
-        for (uint8_t b : pkt.payload) {
-            std::cout << (std::isprint(b) ? static_cast<char>(b) : '.');
+        // Caught up: whatever was appended since is sent under the
+        // broadcast lock, and live broadcasts carry on from there.
+        if (client_manager_.followJournal(id, [&]() {
+                reader.poll(add);
+                flush();
+                return reader.position();
+            })) {
+            log.log(LogLevel::Info,
+                    "[Gateway] Client {} replayed {} frames ({} no longer kept), live from {}",
+                    id, sent, reader.lost(), reader.position());
         }
-        std::cout << std::endl;
-
-        switch (pkt.packetId) {
-            case PROTO_PKT_SAMPLE:
-            case PROTO_PKT_EVENT:
-                std::cout << "[Gateway] Forwarding log request to UART" << std::endl;
-                uart_comm_->send(pkt);
-                break;
-
-            default:
-                std::cerr << "[Gateway] Unknown packet type from client: " 
-                         << static_cast<int>(pkt.packetId) << std::endl;
-                break;
+        return;
+    }
+}
+
+void Gateway::handleTcpPacket(ClientConnection& client, const Packet& pkt) {
+    if (!running_) return;
+    ScopedTimer timer(*tcp_handler_time_);
+
+    try {
+        auto& log = AsyncLogger::instance();
+        if (log.enabled(LogLevel::Debug)) {
+            log.log(LogLevel::Debug, "[Gateway] Received TCP packet:\n"
+                                     "  ID: 0x{}\n"
+                                     "  Payload size: {}\n"
+                                     "  Payload hex: {}\n"
+                                     "  Payload ASCII: {}",
+                    logHex(pkt.packetId), pkt.payload.size(),
+                    logHex(pkt.payload), logAscii(pkt.payload));
         }
+
+        auto forward = [&](const Packet& request) {
+            log.log(LogLevel::Info, "[Gateway] Forwarding log request to UART");
+            submitCommand(client, default_sat_, request);
+        };
+
+        packets::ClientRequests::dispatch(pkt, packets::Overloaded{
+            [&](const packets::SampleRequest&) { forward(pkt); },
+            [&](const packets::EventRequest&)  { forward(pkt); },
+
+            [&](const packets::Routed& routed) {
+                // Subscribing: the cached state first, then live frames.
+                client_manager_.setRouted(client.getId(), [this](ClientConnection& c) {
+                    sendSnapshot(c);
+                });
+                if (routed.inner.packetId == PROTO_PKT_NONE) return;
+
+                log.log(LogLevel::Info, "[Gateway] Forwarding request to satellite {}",
+                        static_cast<int>(routed.sat));
+                if (!packets::SatelliteCommands::accepts(routed.inner)) {
+                    log.log(LogLevel::Warn, "[Gateway] Invalid packet type {} for satellite {}",
+                            static_cast<int>(routed.inner.packetId),
+                            static_cast<int>(routed.sat));
+                } else if (routed.sat != PROTO_SAT_ALL
+                           && std::find(uart_->satellites().begin(), uart_->satellites().end(),
+                                        routed.sat) == uart_->satellites().end()) {
+                    log.log(LogLevel::Warn, "[Gateway] Unknown satellite {} from client {}",
+                            static_cast<int>(routed.sat), client.getId());
+                } else {
+                    submitCommand(client, routed.sat, routed.inner);
+                }
+            },
+
+            [&](const packets::RateRequest& rate) {
+                log.log(LogLevel::Info, "[Gateway] Client {} sets sample rate mode {} ({}) "
+                                        "for satellite {}",
+                        client.getId(), static_cast<int>(rate.mode), rate.param,
+                        static_cast<int>(rate.sat));
+                client_manager_.setRate(client.getId(), rate.sat, RateSpec{rate.mode, rate.param});
+            },
+
+            [&](const packets::Replay& replay) {
+                log.log(LogLevel::Info, "[Gateway] Client {} replays the journal from {}",
+                        client.getId(), replay.from);
+                startReplay(client, replay.from);
+            },
+
+            [&](const packets::InvalidPacket& bad) {
+                log.log(LogLevel::Warn, bad.known
+                            ? "[Gateway] Malformed packet of type {} from client"
+                            : "[Gateway] Unknown packet type from client: {}",
+                        static_cast<int>(bad.raw.packetId));
+            },
+        });
     }
     catch (const std::exception& e) {
-        std::cerr << "Failed to forward TCP packet to UART: " 
-                  << e.what() << std::endl;
+        AsyncLogger::instance().log(LogLevel::Error,
+            "Failed to forward TCP packet to UART: {}", std::string(e.what()));
     }
 }
 
-void Gateway::handleUartPacket(const Packet& uart_pkt) {
+void Gateway::handleUartPacket(uint8_t sat, const Packet& uart_pkt, uint64_t decoded_ns) {
     if (!running_) {
         return;
     }
+    ScopedTimer timer(*uart_handler_time_);
+    const FrameTrace trace{uart_pkt.rx_ns, monotonicNs()};
+    latency_.record(LatencyStage::Dispatch, decoded_ns, trace.handled_ns);
 
     try {
-        switch (uart_pkt.packetId) {
-            case PROTO_PKT_SAMPLE:
-            {
-                auto framed_packet = Protocol::pack(uart_pkt);
-                client_manager_.broadcastToAll(framed_packet);
-                break;
-            }
-            default:
-            {
-                std::cout << std::dec << std::endl;
-                for (uint8_t b : uart_pkt.payload) {
-                    std::cout << (std::isprint(b) ? static_cast<char>(b) : '.');
+        auto print = [&]() {
+            AsyncLogger::instance().log(LogLevel::Info, "\n[Sat {}] {}",
+                                        static_cast<int>(sat),
+                                        logAscii(uart_pkt.payload));
+        };
+
+        packets::SatelliteTelemetry::dispatch(uart_pkt, packets::Overloaded{
+            [&](const packets::SampleLine&) {
+                // Both frames and the envelope fit on the stack.
+                std::byte buf[3 * PROTO_MAX_PACKET_LEN + 256];
+                std::pmr::monotonic_buffer_resource arena(buf, sizeof(buf));
+
+                std::pmr::vector<uint8_t> legacy(&arena);
+                if (sat == default_sat_) legacy = Protocol::pack(uart_pkt, &arena);
+
+                std::pmr::vector<uint8_t> tagged(&arena);
+                if (auto routed = Protocol::makeRouted(sat, uart_pkt, &arena)) {
+                    tagged = Protocol::pack(*routed, &arena);
+                } else {
+                    AsyncLogger::instance().log(LogLevel::Warn,
+                        "[Gateway] Sample from satellite {} too long to tag",
+                        static_cast<int>(sat));
                 }
-                std::cout << std::endl;
-                break;
-            }
-        }
+                client_manager_.broadcastRouted(sat, uart_pkt, tagged,
+                                                sat == default_sat_ ? &legacy : nullptr, trace);
+            },
+            [&](const packets::KeepAlive&)     { print(); },
+            [&](const packets::EventLine&)     { print(); },
+            [&](const packets::InvalidPacket&) { print(); },
+        });
     }
     catch (const std::exception& e) {
-        std::cerr << "Failed to broadcast UART packet: " << e.what() << std::endl;
+        AsyncLogger::instance().log(LogLevel::Error,
+            "Failed to broadcast UART packet: {}", std::string(e.what()));
     }
 }
 
@@ -0,0 +1,1114 @@
+// End-to-end gateway benchmark.
+//
+// For each workload: starts a NanoSatSimulator on a pty, launches the
+// gateway binary against it, drives subscriber and history clients with
+// LoadGenerator, and measures what reaches the clients. A sample frame's
+// latency runs from the simulator handing it to the pty (UART ingress) to
+// a client decoding it. Gateway CPU and RSS are read from /proc.
+//
+// The storm workload instead opens thousands of connections at once, drops
+// them all as a network blip would, and reconnects them, timing how long
+// the gateway takes to accept and start serving every one.
+//
+// The rates workload gives subscribers different PROTO_PKT_RATE requests
+// and checks that each gets no more than it asked for.
+//
+// The fetch workload downloads --fetch-days of history with LogClient,
+// as pipelined per-day requests and as one request for the whole range.
+//
+// With --dispatch, every workload runs once per dispatch mode (inline, a
+// fixed pool, an elastic pool) so the modes can be compared side by side.
+//
+// Results are printed as a table and, with --json, written one JSON
+// object per workload so runs can be compared release to release.
+
+#include "loadgen.hpp"
+#include "logclient.hpp"
+#include "packet_registry.hpp"
+#include "rate_limit.hpp"
+#include "satsim.hpp"
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+using namespace altair;
+using namespace std::string_literals;
+using Clock = EventLoop::Clock;
+
+namespace {
+
+struct BenchConfig {
+    std::string gateway{"./gateway"};
+    std::string gateway_log{"/dev/null"};
+    std::string json_path;
+    uint16_t    port{18064};
+    /// The gateway's worker_threads argument; empty = inline dispatch.
+    std::string workers;
+    /// Modes to run every workload in, as workers arguments.
+    std::vector<std::string> dispatch{""};
+    unsigned    busy_clients{32};
+    unsigned    subscribers{8};
+    unsigned    history_clients{4};
+    double      sample_rate{2000};
+    unsigned    satellites{64};
+    unsigned    baud{0};
+    unsigned    storm_clients{10000};
+    unsigned    fetch_days{7};
+    unsigned    fetch_window{4};
+    unsigned    fetch_repeat{3};
+    unsigned    shards{0};              // 0 = gateway default
+    std::chrono::seconds duration{10};
+    std::vector<RateSpec> rates{        // for the rates workload
+        {PROTO_RATE_ALL, 0}, {PROTO_RATE_INTERVAL, 100}, {PROTO_RATE_EVERY_NTH, 10},
+        {PROTO_RATE_AVG, 250}, {PROTO_RATE_MAX, 1000},
+    };
+};
+
+struct Workload {
+    std::string   name;
+    SatSimOptions sim;
+    LoadProfile   load;
+    /// More than one runs that many simulators behind a gateway config file.
+    unsigned      satellites{1};
+    /// Subscriber i asks for rates[i % size]; latency is measured for the
+    /// ones taking every sample only.
+    std::vector<RateSpec> rates{};
+    /// Extra environment for the gateway.
+    std::vector<std::pair<std::string, std::string>> env{};
+};
+
+/// What the subscribers asking for one rate got, per client.
+struct RateResult {
+    RateSpec spec;
+    unsigned clients{0};
+    double   frames_per_s{0};
+    double   bytes_per_s{0};
+    double   expected_per_s{0};     ///< at most, given the ingress rate
+};
+
+struct ProcSample {
+    double   cpu_seconds{0};
+    uint64_t rss_kb{0};
+    uint64_t rss_peak_kb{0};
+};
+
+struct BenchResult {
+    std::string name;
+    std::string workers;            ///< the gateway's workers argument
+    unsigned    satellites{1};
+    double      seconds{0};
+    uint64_t    ingress_frames{0};
+    uint64_t    ingress_bytes{0};
+    uint64_t    delivered_frames{0};
+    uint64_t    delivered_bytes{0};
+    uint64_t    matched{0};
+    uint64_t    unmatched{0};
+    double      p50_us{0}, p99_us{0}, p999_us{0}, max_us{0};
+    double      cpu_seconds{0};
+    double      cpu_us_per_frame{0};
+    uint64_t    rss_kb{0};
+    uint64_t    rss_peak_kb{0};
+    uint64_t    connects{0};
+    uint64_t    requests{0};
+    uint64_t    errors{0};
+    bool        gateway_died{false};
+    std::vector<RateResult> rates;
+};
+
+/// One wave of the storm: every client connecting at the same moment.
+struct StormWave {
+    double   connected_ms{0};   ///< until the last handshake completed
+    double   served_ms{0};      ///< until the last client got its first frame
+    uint64_t retries{0};        ///< refused or reset connects tried again
+    bool     complete{false};
+};
+
+/// One way of downloading the history, the median of its runs.
+struct FetchResult {
+    std::string mode;
+    uint64_t    requests{0};
+    uint64_t    lines{0};
+    uint64_t    bytes{0};
+    double      seconds{0};
+    bool        gateway_died{false};
+};
+
+struct StormResult {
+    unsigned  clients{0};
+    StormWave initial;
+    StormWave reconnect;
+    double    cpu_seconds{0};
+    uint64_t  rss_peak_kb{0};
+    bool      gateway_died{false};
+};
+
+/// Sample frames as the simulator wrote them, for matching deliveries.
+class IngressLog {
+public:
+    static constexpr size_t kWindow = 1 << 16;
+
+    void record(const Packet& pkt, Clock::time_point t) {
+        if (pkt.packetId != PROTO_PKT_SAMPLE) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.push_back({hashOf(pkt), t});
+    }
+
+    /// Finds the ingress time of a delivered frame. cursor is the session's
+    /// position in the log (npos until its first match). Frames reach a
+    /// client in ingress order, so later matches only search forward.
+    bool match(const Packet& pkt, size_t& cursor, Clock::time_point& ingress) {
+        size_t h = hashOf(pkt);
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        size_t n = entries_.size();
+        if (cursor == npos) {
+            // First frame on a (re)connected session: look back from the end.
+            size_t stop = n > kWindow ? n - kWindow : 0;
+            for (size_t i = n; i > stop; --i) {
+                if (entries_[i - 1].first == h) return found(i - 1, cursor, ingress);
+            }
+            return false;
+        }
+
+        size_t stop = std::min(n, cursor + kWindow);
+        for (size_t i = cursor; i < stop; ++i) {
+            if (entries_[i].first == h) return found(i, cursor, ingress);
+        }
+        return false;
+    }
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+private:
+    bool found(size_t i, size_t& cursor, Clock::time_point& ingress) {
+        cursor  = i + 1;
+        ingress = entries_[i].second;
+        return true;
+    }
+
+    static size_t hashOf(const Packet& pkt) {
+        return std::hash<std::string_view>{}(std::string_view(
+            reinterpret_cast<const char*>(pkt.payload.data()), pkt.payload.size()));
+    }
+
+    std::mutex                                       mutex_;
+    std::vector<std::pair<size_t, Clock::time_point>> entries_;
+};
+
+/// "inline", "pool:N" or "pool:MIN:MAX" for a workers argument.
+std::string dispatchName(const std::string& workers) {
+    return workers.empty() ? "inline" : "pool:" + workers;
+}
+
+/// The workers count for JSON: -1 inline, the most threads otherwise.
+long workersCount(const std::string& workers) {
+    if (workers.empty()) return -1;
+    auto colon = workers.find(':');
+    return std::stol(colon == std::string::npos ? workers : workers.substr(colon + 1));
+}
+
+std::string dateOffset(int days) {
+    std::time_t t = std::time(nullptr) + static_cast<std::time_t>(days) * 24 * 60 * 60;
+    std::tm tm{};
+    ::localtime_r(&t, &tm);
+    char buf[11];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+    return buf;
+}
+
+/// Forks the gateway on a single device, or on a config file if
+/// config is set.
+pid_t spawnGateway(const BenchConfig& cfg, const std::string& device, bool config,
+                   const std::vector<std::pair<std::string, std::string>>& env = {}) {
+    pid_t pid = ::fork();
+    if (pid < 0) throw std::runtime_error("fork failed");
+    if (pid > 0) return pid;
+
+    int fd = ::open(cfg.gateway_log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd >= 0) {
+        ::dup2(fd, STDOUT_FILENO);
+        ::dup2(fd, STDERR_FILENO);
+        ::close(fd);
+    }
+    ::setenv("ALTAIR_LOG_LEVEL", "warn", 0);
+    if (cfg.shards) ::setenv("ALTAIR_TCP_SHARDS", std::to_string(cfg.shards).c_str(), 1);
+    for (const auto& [name, value] : env) ::setenv(name.c_str(), value.c_str(), 1);
+
+    std::string port = std::to_string(cfg.port);
+    std::string workers = cfg.workers;
+    std::vector<char*> args{const_cast<char*>(cfg.gateway.c_str()), port.data()};
+    if (config) args.push_back(const_cast<char*>("-c"));
+    args.push_back(const_cast<char*>(device.c_str()));
+    if (!workers.empty()) args.push_back(workers.data());
+    args.push_back(nullptr);
+
+    ::execv(cfg.gateway.c_str(), args.data());
+    std::perror("exec gateway");
+    ::_exit(127);
+}
+
+bool waitForPort(uint16_t port, std::chrono::milliseconds timeout) {
+    auto deadline = Clock::now() + timeout;
+    while (Clock::now() < deadline) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port   = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bool ok = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+        ::close(fd);
+        if (ok) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return false;
+}
+
+ProcSample readProc(pid_t pid) {
+    ProcSample s;
+
+    std::ifstream stat("/proc/" + std::to_string(pid) + "/stat");
+    std::string line;
+    std::getline(stat, line);
+    auto paren = line.rfind(')');
+    if (paren != std::string::npos) {
+        std::istringstream fields(line.substr(paren + 2));
+        std::string f;
+        unsigned long utime = 0, stime = 0;
+        // Fields from "state" (3) on; utime and stime are 14 and 15.
+        for (int i = 3; i <= 15 && fields >> f; ++i) {
+            if (i == 14) utime = std::stoul(f);
+            if (i == 15) stime = std::stoul(f);
+        }
+        s.cpu_seconds = double(utime + stime) / ::sysconf(_SC_CLK_TCK);
+    }
+
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) s.rss_kb = std::stoull(line.substr(6));
+        if (line.rfind("VmHWM:", 0) == 0) s.rss_peak_kb = std::stoull(line.substr(6));
+    }
+    return s;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()));
+    return sorted[idx];
+}
+
+std::vector<Workload> makeWorkloads(const BenchConfig& cfg) {
+    SatSimOptions sim;
+    sim.baud_rate   = cfg.baud;
+    sim.sample_rate = 0;
+
+    LoadProfile load;
+    load.port        = cfg.port;
+    load.subscribers = cfg.subscribers;
+    load.clients     = 0;
+    load.from        = dateOffset(-7);
+    load.to          = dateOffset(-1);
+    load.duration    = cfg.duration;
+
+    std::vector<Workload> w;
+
+    // Keep-alives only: the gateway's idle cost per ingress frame.
+    Workload beacons{"beacons", sim, load};
+    beacons.sim.beacon_interval = std::chrono::milliseconds(10);
+    w.push_back(beacons);
+
+    // Streamed samples fanned out to every subscriber.
+    Workload samples{"samples", sim, load};
+    samples.sim.sample_rate    = cfg.sample_rate;
+    samples.sim.stream_samples = true;
+    w.push_back(samples);
+
+    // Clients pulling the full SD-card history back to back.
+    Workload history{"history", sim, load};
+    history.sim.sample_rate   = 1;
+    history.load.clients      = cfg.history_clients;
+    history.load.idle_timeout = std::chrono::milliseconds(200);
+    // The simulator's link is unpaced; the gateway budgets a real one.
+    history.env = {{"ALTAIR_DOWNLINK_SHARE", "100000"}};
+    w.push_back(history);
+
+    // Many clients asking for one short day back to back, so packet
+    // handling and fanout rather than the link set the pace: command
+    // admission is opened up to let every request through. Replies go to
+    // every client, as they do from the gateway.
+    Workload busy{"busy", sim, load};
+    busy.sim.history_days            = 1;
+    busy.sim.history_samples_per_day = 48;
+    busy.load.clients                = cfg.busy_clients;
+    busy.load.from                   = dateOffset(-1);
+    busy.load.idle_timeout           = std::chrono::milliseconds(20);
+    busy.env = {{"ALTAIR_UPLINK_SHARE", "100000"}, {"ALTAIR_CLIENT_SHARE", "100"},
+                {"ALTAIR_DOWNLINK_SHARE", "100000"}};
+    w.push_back(busy);
+
+    // Subscribers reconnecting while samples stream.
+    Workload churn{"churn", sim, load};
+    churn.sim.sample_rate      = cfg.sample_rate / 4;
+    churn.sim.stream_samples   = true;
+    churn.load.churn_interval  = std::chrono::milliseconds(250);
+    w.push_back(churn);
+
+    // Many satellites on one reactor, tagged frames to every subscriber.
+    Workload constellation{"constellation", sim, load};
+    constellation.satellites              = std::max(1u, cfg.satellites);
+    constellation.sim.beacon_interval     = std::chrono::milliseconds(1000);
+    constellation.sim.sample_rate         = cfg.sample_rate / constellation.satellites;
+    constellation.sim.stream_samples      = true;
+    constellation.sim.history_days        = 1;
+    constellation.load.routed_subscribers = true;
+    w.push_back(constellation);
+
+    // Streamed samples, subscribers each asking for their own rate.
+    Workload rates{"rates", sim, load};
+    rates.sim.sample_rate          = cfg.sample_rate / 4;
+    rates.sim.stream_samples       = true;
+    rates.load.routed_subscribers  = true;
+    rates.rates                    = cfg.rates;
+    for (const auto& spec : rates.rates) {
+        rates.load.subscriber_requests.push_back(
+            *packets::encode(packets::RateRequest{PROTO_SAT_ALL, spec.mode, spec.param}));
+    }
+    w.push_back(rates);
+
+    return w;
+}
+
+BenchResult runWorkload(const BenchConfig& cfg, Workload w) {
+    BenchResult r;
+    r.name       = w.name;
+    r.workers    = cfg.workers;
+    r.satellites = w.satellites;
+
+    // One simulator and ingress log per satellite; satellite i has id i.
+    std::vector<std::unique_ptr<IngressLog>>       ingress;
+    std::vector<std::unique_ptr<NanoSatSimulator>> sims;
+    std::vector<std::thread>                       sim_threads;
+    for (unsigned i = 0; i < w.satellites; ++i) {
+        SatSimOptions opts = w.sim;
+        opts.seed = i + 1;
+        ingress.push_back(std::make_unique<IngressLog>());
+        sims.push_back(std::make_unique<NanoSatSimulator>(opts));
+        sims.back()->onFrameWritten([log = ingress.back().get()](const Packet& pkt,
+                                                                 Clock::time_point t) {
+            log->record(pkt, t);
+        });
+    }
+    for (auto& sim : sims) sim_threads.emplace_back([&sim]() { sim->run(); });
+
+    std::string device = sims.front()->devicePath();
+    std::string config_path;
+    if (w.satellites > 1) {
+        config_path = "/tmp/altair_bench_" + std::to_string(::getpid()) + ".conf";
+        std::ofstream conf(config_path);
+        for (unsigned i = 0; i < w.satellites; ++i) {
+            conf << i << " " << sims[i]->devicePath() << "\n";
+        }
+        device = config_path;
+    }
+
+    pid_t gw = spawnGateway(cfg, device, w.satellites > 1, w.env);
+    auto cleanup = [&]() {
+        if (gw > 0) {
+            ::kill(gw, SIGTERM);
+            ::waitpid(gw, nullptr, 0);
+        }
+        for (auto& sim : sims) sim->stop();
+        for (auto& t : sim_threads) t.join();
+        if (!config_path.empty()) ::unlink(config_path.c_str());
+    };
+
+    if (!waitForPort(cfg.port, std::chrono::seconds(5))) {
+        cleanup();
+        throw std::runtime_error("gateway did not start listening on port "
+                                 + std::to_string(cfg.port));
+    }
+    // Let TIME_SYNC reach the simulators and the first beacons settle.
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // cursors[session][satellite]
+    std::vector<std::vector<size_t>> cursors(w.load.clients + w.load.subscribers,
+                                             std::vector<size_t>(w.satellites, IngressLog::npos));
+    std::vector<double> latencies;
+    uint64_t delivered = 0, delivered_bytes = 0, unmatched = 0;
+    std::vector<uint64_t> session_frames(cursors.size()), session_bytes(cursors.size());
+    // Rate a session asked for, if not every sample.
+    auto rateOf = [&w](size_t session) -> const RateSpec* {
+        if (w.rates.empty() || session < w.load.clients) return nullptr;
+        const RateSpec& spec = w.rates[(session - w.load.clients) % w.rates.size()];
+        return spec.passesAll() ? nullptr : &spec;
+    };
+
+    LoadGenerator generator(w.load);
+    generator.onFrame([&](size_t session, const Packet& pkt, Clock::time_point t) {
+        // The state snapshot a subscriber gets first is not a delivery.
+        if (pkt.packetId == PROTO_PKT_STATE) return;
+        ++delivered;
+        delivered_bytes += pkt.payload.size() + 4;
+        ++session_frames[session];
+        session_bytes[session] += pkt.payload.size() + 4;
+        // Decimated streams skip ingress frames and rollups match none.
+        if (rateOf(session)) return;
+
+        uint8_t sat = 0;
+        const Packet* frame = &pkt;
+        std::optional<std::pair<uint8_t, Packet>> routed;
+        if (pkt.packetId == PROTO_PKT_ROUTED) {
+            routed = Protocol::unwrapRouted(pkt);
+            if (!routed || routed->first >= w.satellites) {
+                ++unmatched;
+                return;
+            }
+            sat   = routed->first;
+            frame = &routed->second;
+        }
+
+        Clock::time_point in;
+        if (ingress[sat]->match(*frame, cursors[session][sat], in)) {
+            latencies.push_back(std::chrono::duration<double, std::micro>(t - in).count());
+        } else {
+            ++unmatched;
+        }
+    });
+
+    auto simTotals = [&sims]() {
+        SatSimStats total;
+        for (auto& sim : sims) {
+            auto s = sim->stats();
+            total.frames_out     += s.frames_out;
+            total.bytes_out      += s.bytes_out;
+            total.frames_dropped += s.frames_dropped;
+        }
+        return total;
+    };
+
+    auto proc_before = readProc(gw);
+    auto sim_before  = simTotals();
+    auto report      = generator.run();
+    auto sim_after   = simTotals();
+    auto proc_after  = readProc(gw);
+
+    int status = 0;
+    if (::waitpid(gw, &status, WNOHANG) == gw) {
+        r.gateway_died = true;
+        std::cerr << "Gateway exited during " << w.name << " ("
+                  << (WIFSIGNALED(status) ? "signal " + std::to_string(WTERMSIG(status))
+                                          : "status " + std::to_string(WEXITSTATUS(status)))
+                  << ")\n";
+        gw = -1;
+    }
+
+    cleanup();
+
+    std::sort(latencies.begin(), latencies.end());
+    r.seconds          = report.seconds;
+    r.ingress_frames   = sim_after.frames_out - sim_before.frames_out;
+    r.ingress_bytes    = sim_after.bytes_out - sim_before.bytes_out;
+    r.delivered_frames = delivered;
+    r.delivered_bytes  = delivered_bytes;
+    r.matched          = latencies.size();
+    r.unmatched        = unmatched;
+    r.p50_us           = percentile(latencies, 50);
+    r.p99_us           = percentile(latencies, 99);
+    r.p999_us          = percentile(latencies, 99.9);
+    r.max_us           = latencies.empty() ? 0 : latencies.back();
+    r.cpu_seconds      = proc_after.cpu_seconds - proc_before.cpu_seconds;
+    r.cpu_us_per_frame = r.ingress_frames ? r.cpu_seconds * 1e6 / r.ingress_frames : 0;
+    r.rss_kb           = proc_after.rss_kb;
+    r.rss_peak_kb      = proc_after.rss_peak_kb;
+    r.connects         = report.connects;
+    r.requests         = report.requests;
+    r.errors           = report.connect_errors + report.disconnects + report.timeouts
+                       + (sim_after.frames_dropped - sim_before.frames_dropped);
+
+    const double secs    = r.seconds > 0 ? r.seconds : 1;
+    const double in_rate = r.ingress_frames / secs;
+    for (size_t k = 0; k < w.rates.size() && k < w.load.subscribers; ++k) {
+        RateResult rate;
+        rate.spec = w.rates[k];
+        for (size_t sub = k; sub < w.load.subscribers; sub += w.rates.size()) {
+            ++rate.clients;
+            rate.frames_per_s += session_frames[w.load.clients + sub] / secs;
+            rate.bytes_per_s  += session_bytes[w.load.clients + sub] / secs;
+        }
+        rate.frames_per_s /= rate.clients;
+        rate.bytes_per_s  /= rate.clients;
+        rate.expected_per_s = rate.spec.mode == PROTO_RATE_ALL       ? in_rate
+                            : rate.spec.mode == PROTO_RATE_EVERY_NTH ? in_rate / rate.spec.param
+                            : std::min(in_rate, 1000.0 / rate.spec.param);
+        r.rates.push_back(rate);
+    }
+    return r;
+}
+
+/// Opens clients connections to the gateway at once and waits until each
+/// has completed its handshake and received a first frame. Connections
+/// are left open in fds for the caller to drop.
+StormWave stormWave(const BenchConfig& cfg, unsigned clients, std::vector<int>& fds,
+                    std::chrono::seconds timeout) {
+    struct Conn {
+        bool connected{false};
+        bool served{false};
+    };
+
+    StormWave wave;
+    EventLoop loop;
+    std::vector<Conn> conns(clients);
+    unsigned connected = 0, served = 0;
+    fds.assign(clients, -1);
+
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_port        = htons(cfg.port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    auto start = Clock::now();
+    auto elapsedMs = [&start]() {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    std::function<void(unsigned)> open = [&](unsigned i) {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::runtime_error("socket failed: "s + std::strerror(errno));
+        fds[i] = fd;
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+        loop.watch(fd, EPOLLIN | EPOLLOUT, [&, i, fd](uint32_t events) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err || (events & (EPOLLERR | EPOLLHUP))) {
+                // Refused or reset before being served: try again shortly.
+                loop.unwatch(fd);
+                ::close(fd);
+                fds[i] = -1;
+                if (conns[i].connected) --connected;
+                conns[i] = Conn{};
+                ++wave.retries;
+                loop.addTimer(Clock::now() + std::chrono::milliseconds(10),
+                              [&open, i]() { open(i); });
+                return;
+            }
+
+            Conn& c = conns[i];
+            if (!c.connected && (events & EPOLLOUT)) {
+                c.connected = true;
+                if (++connected == clients) wave.connected_ms = elapsedMs();
+                loop.watch(fd, EPOLLIN, [&, i, fd](uint32_t ev) {
+                    char buf[4096];
+                    ssize_t n;
+                    while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0) {
+                        if (!conns[i].served) {
+                            conns[i].served = true;
+                            if (++served == clients) {
+                                wave.served_ms = elapsedMs();
+                                loop.stop();
+                            }
+                        }
+                    }
+                    if (n == 0 || (ev & (EPOLLERR | EPOLLHUP))) loop.unwatch(fd);
+                });
+            }
+        });
+    };
+
+    for (unsigned i = 0; i < clients; ++i) open(i);
+
+    auto deadline = start + timeout;
+    loop.addTimer(deadline, [&loop]() { loop.stop(); });
+    loop.run();
+
+    wave.complete = served == clients;
+    if (!wave.complete) {
+        if (connected < clients) wave.connected_ms = elapsedMs();
+        wave.served_ms = elapsedMs();
+    }
+    return wave;
+}
+
+StormResult runStorm(const BenchConfig& cfg) {
+    StormResult r;
+    r.clients = cfg.storm_clients;
+
+    // A slow sample stream: the first frame shows a client is registered.
+    SatSimOptions opts;
+    opts.sample_rate    = 20;
+    opts.stream_samples = true;
+    opts.baud_rate      = cfg.baud;
+    opts.history_days   = 1;
+    NanoSatSimulator sim(opts);
+    std::thread sim_thread([&sim]() { sim.run(); });
+
+    pid_t gw = spawnGateway(cfg, sim.devicePath(), false);
+    auto cleanup = [&]() {
+        if (gw > 0) {
+            ::kill(gw, SIGTERM);
+            ::waitpid(gw, nullptr, 0);
+        }
+        sim.stop();
+        sim_thread.join();
+    };
+
+    if (!waitForPort(cfg.port, std::chrono::seconds(5))) {
+        cleanup();
+        throw std::runtime_error("gateway did not start listening on port "
+                                 + std::to_string(cfg.port));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    auto proc_before = readProc(gw);
+    std::vector<int> fds;
+    auto dropAll = [&fds]() {
+        for (int fd : fds) if (fd >= 0) ::close(fd);
+        fds.clear();
+    };
+
+    r.initial = stormWave(cfg, r.clients, fds, std::chrono::seconds(30));
+    // The blip: every client drops at once and comes straight back.
+    dropAll();
+    r.reconnect = stormWave(cfg, r.clients, fds, std::chrono::seconds(30));
+    auto proc_after = readProc(gw);
+    dropAll();
+
+    int status = 0;
+    if (::waitpid(gw, &status, WNOHANG) == gw) {
+        r.gateway_died = true;
+        std::cerr << "Gateway exited during storm\n";
+        gw = -1;
+    }
+    cleanup();
+
+    r.cpu_seconds = proc_after.cpu_seconds - proc_before.cpu_seconds;
+    r.rss_peak_kb = proc_after.rss_peak_kb;
+    return r;
+}
+
+void printStorm(const StormResult& r) {
+    auto row = [&r](const char* name, const StormWave& w) {
+        double secs = w.served_ms > 0 ? w.served_ms / 1000 : 1;
+        std::cout << std::left << std::setw(14) << name << std::right << std::fixed
+                  << std::setprecision(1)
+                  << std::setw(9) << r.clients
+                  << std::setw(14) << w.connected_ms
+                  << std::setw(12) << w.served_ms
+                  << std::setprecision(0) << std::setw(11) << r.clients / secs
+                  << std::setw(9) << w.retries
+                  << (w.complete ? "" : "  incomplete")
+                  << (r.gateway_died ? "  gateway died" : "") << "\n";
+    };
+    std::cout << std::left << std::setw(14) << "storm" << std::right
+              << std::setw(9) << "clients" << std::setw(14) << "connected ms"
+              << std::setw(12) << "served ms" << std::setw(11) << "conn/s"
+              << std::setw(9) << "retries" << "\n";
+    row("initial", r.initial);
+    row("reconnect", r.reconnect);
+    std::cout << "gateway cpu " << std::setprecision(2) << r.cpu_seconds << " s, peak rss "
+              << r.rss_peak_kb << " KiB\n";
+}
+
+void printStormJson(std::ostream& os, const BenchConfig& cfg, const StormResult& r) {
+    auto wave = [&os](const StormWave& w) {
+        os << "{\"connected_ms\":" << w.connected_ms << ",\"served_ms\":" << w.served_ms
+           << ",\"retries\":" << w.retries
+           << ",\"complete\":" << (w.complete ? "true" : "false") << "}";
+    };
+    os << std::fixed << std::setprecision(3)
+       << "{\"workload\":\"storm\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"config\":{\"workers\":" << workersCount(cfg.workers)
+       << ",\"dispatch\":\"" << dispatchName(cfg.workers) << "\""
+       << ",\"shards\":" << cfg.shards
+       << ",\"clients\":" << r.clients << "}"
+       << ",\"initial\":";
+    wave(r.initial);
+    os << ",\"reconnect\":";
+    wave(r.reconnect);
+    os << ",\"cpu_seconds\":" << r.cpu_seconds
+       << ",\"rss_peak_kb\":" << r.rss_peak_kb
+       << ",\"gateway_died\":" << (r.gateway_died ? "true" : "false") << "}\n";
+}
+
+std::vector<FetchResult> runFetch(const BenchConfig& cfg) {
+    SatSimOptions opts;
+    opts.sample_rate  = 1;
+    opts.baud_rate    = cfg.baud;
+    opts.history_days = std::max(1u, cfg.fetch_days);
+    NanoSatSimulator sim(opts);
+    std::thread sim_thread([&sim]() { sim.run(); });
+
+    // Compares ways of fetching, not the gateway's reply budget.
+    pid_t gw = spawnGateway(cfg, sim.devicePath(), false, {{"ALTAIR_DOWNLINK_SHARE", "100000"}});
+    auto cleanup = [&]() {
+        if (gw > 0) {
+            ::kill(gw, SIGTERM);
+            ::waitpid(gw, nullptr, 0);
+        }
+        sim.stop();
+        sim_thread.join();
+    };
+
+    if (!waitForPort(cfg.port, std::chrono::seconds(5))) {
+        cleanup();
+        throw std::runtime_error("gateway did not start listening on port "
+                                 + std::to_string(cfg.port));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    struct Mode {
+        std::string       name;
+        RangeFetchOptions options;
+    };
+    std::vector<Mode> modes(3);
+    modes[0].name = "per-day:" + std::to_string(cfg.fetch_window);
+    modes[0].options.window = std::max(1u, cfg.fetch_window);
+    modes[1].name = "per-day:1";
+    modes[1].options.window = 1;
+    modes[2].name = "single";
+    modes[2].options.split_by_day = false;
+
+    const std::string from = dateOffset(-static_cast<int>(opts.history_days));
+    const std::string to   = dateOffset(-1);
+    const std::string path = "/tmp/gateway_bench_fetch_" + std::to_string(::getpid()) + ".txt";
+
+    std::vector<FetchResult> results;
+    for (auto& mode : modes) {
+        mode.options.idle_timeout = std::chrono::milliseconds(200);
+        std::vector<FetchResult> runs;
+        for (unsigned rep = 0; rep < std::max(1u, cfg.fetch_repeat); ++rep) {
+            std::remove(path.c_str());
+            FetchResult r;
+            r.mode     = mode.name;
+            r.requests = mode.options.split_by_day ? opts.history_days : 1;
+
+            // LogClient reports every day on stdout.
+            auto* out = std::cout.rdbuf(nullptr);
+            auto start = Clock::now();
+            {
+                LogClient client("127.0.0.1", cfg.port);
+                client.setRangeFetchOptions(mode.options);
+                client.setOutputPath(PROTO_PKT_SAMPLE, path);
+                client.requestLogs(PROTO_PKT_SAMPLE, from, to);
+            }
+            r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+            std::cout.rdbuf(out);
+            std::cout.clear();
+
+            std::ifstream file(path);
+            std::string line;
+            while (std::getline(file, line)) {
+                ++r.lines;
+                r.bytes += line.size() + 1;
+            }
+            runs.push_back(r);
+        }
+        std::sort(runs.begin(), runs.end(), [](const FetchResult& a, const FetchResult& b) {
+            return a.seconds < b.seconds;
+        });
+        results.push_back(runs[runs.size() / 2]);
+    }
+    std::remove(path.c_str());
+
+    int status = 0;
+    if (::waitpid(gw, &status, WNOHANG) == gw) {
+        for (auto& r : results) r.gateway_died = true;
+        std::cerr << "Gateway exited during fetch\n";
+        gw = -1;
+    }
+    cleanup();
+    return results;
+}
+
+void printFetch(const std::vector<FetchResult>& results) {
+    std::cout << std::left << std::setw(14) << "fetch" << std::right
+              << std::setw(10) << "requests" << std::setw(9) << "lines" << std::setw(11) << "seconds"
+              << std::setw(11) << "lines/s" << std::setw(10) << "KiB/s" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(14) << r.mode << std::right << std::fixed
+                  << std::setw(10) << r.requests << std::setw(9) << r.lines
+                  << std::setprecision(2) << std::setw(11) << r.seconds << std::setprecision(0)
+                  << std::setw(11) << r.lines / r.seconds
+                  << std::setw(10) << r.bytes / r.seconds / 1024
+                  << (r.gateway_died ? "  gateway died" : "") << "\n";
+    }
+}
+
+void printFetchJson(std::ostream& os, const BenchConfig& cfg, const FetchResult& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"workload\":\"fetch\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"config\":{\"workers\":" << workersCount(cfg.workers)
+       << ",\"dispatch\":\"" << dispatchName(cfg.workers) << "\""
+       << ",\"baud\":" << cfg.baud
+       << ",\"days\":" << cfg.fetch_days << "}"
+       << ",\"mode\":\"" << r.mode << "\""
+       << ",\"requests\":" << r.requests
+       << ",\"lines\":" << r.lines
+       << ",\"bytes\":" << r.bytes
+       << ",\"seconds\":" << r.seconds
+       << ",\"gateway_died\":" << (r.gateway_died ? "true" : "false") << "}\n";
+}
+
+void printTable(const std::vector<BenchResult>& results) {
+    std::cout << std::left << std::setw(14) << "workload" << std::setw(12) << "dispatch"
+              << std::right << std::setw(9) << "req/s"
+              << std::setw(11) << "in fr/s" << std::setw(11) << "out fr/s"
+              << std::setw(12) << "out KiB/s"
+              << std::setw(10) << "p50 us" << std::setw(10) << "p99 us"
+              << std::setw(10) << "p999 us"
+              << std::setw(11) << "cpu us/fr" << std::setw(10) << "rss KiB"
+              << std::setw(8) << "errors" << "\n";
+
+    for (const auto& r : results) {
+        double secs = r.seconds > 0 ? r.seconds : 1;
+        std::cout << std::left << std::setw(14) << r.name
+                  << std::setw(12) << dispatchName(r.workers) << std::right << std::fixed
+                  << std::setprecision(0)
+                  << std::setw(9) << r.requests / secs
+                  << std::setw(11) << r.ingress_frames / secs
+                  << std::setw(11) << r.delivered_frames / secs
+                  << std::setw(12) << r.delivered_bytes / secs / 1024
+                  << std::setprecision(1)
+                  << std::setw(10) << r.p50_us << std::setw(10) << r.p99_us
+                  << std::setw(10) << r.p999_us
+                  << std::setprecision(2) << std::setw(11) << r.cpu_us_per_frame
+                  << std::setw(10) << r.rss_peak_kb
+                  << std::setw(8) << r.errors
+                  << (r.gateway_died ? "  gateway died" : "") << "\n";
+    }
+}
+
+/// Per-client delivery of each rate; "over" marks one that got more than
+/// it asked for (with 10% and one frame per second of slack).
+void printRates(const BenchResult& r) {
+    std::cout << std::left << std::setw(16) << "rate" << std::right
+              << std::setw(9) << "clients" << std::setw(14) << "fr/s/client"
+              << std::setw(15) << "KiB/s/client" << std::setw(14) << "expected fr/s" << "\n";
+    for (const auto& rate : r.rates) {
+        bool over = rate.frames_per_s > rate.expected_per_s * 1.1 + 1;
+        std::cout << std::left << std::setw(16) << formatRateSpec(rate.spec) << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(9) << rate.clients
+                  << std::setw(14) << rate.frames_per_s
+                  << std::setw(15) << rate.bytes_per_s / 1024
+                  << std::setw(14) << rate.expected_per_s
+                  << (over ? "  over" : "") << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const BenchResult& r) {
+    double secs = r.seconds > 0 ? r.seconds : 1;
+    os << std::fixed << std::setprecision(3)
+       << "{\"workload\":\"" << r.name << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"config\":{\"workers\":" << workersCount(r.workers)
+       << ",\"dispatch\":\"" << dispatchName(r.workers) << "\""
+       << ",\"subscribers\":" << cfg.subscribers
+       << ",\"history_clients\":" << cfg.history_clients
+       << ",\"sample_rate\":" << cfg.sample_rate
+       << ",\"satellites\":" << r.satellites
+       << ",\"baud\":" << cfg.baud
+       << ",\"duration_s\":" << cfg.duration.count() << "}"
+       << ",\"seconds\":" << r.seconds
+       << ",\"ingress_frames\":" << r.ingress_frames
+       << ",\"ingress_bytes\":" << r.ingress_bytes
+       << ",\"delivered_frames\":" << r.delivered_frames
+       << ",\"delivered_bytes\":" << r.delivered_bytes
+       << ",\"frames_per_sec\":" << r.delivered_frames / secs
+       << ",\"bytes_per_sec\":" << r.delivered_bytes / secs
+       << ",\"latency_us\":{\"p50\":" << r.p50_us << ",\"p99\":" << r.p99_us
+       << ",\"p999\":" << r.p999_us << ",\"max\":" << r.max_us
+       << ",\"matched\":" << r.matched << ",\"unmatched\":" << r.unmatched << "}"
+       << ",\"cpu_seconds\":" << r.cpu_seconds
+       << ",\"cpu_us_per_frame\":" << r.cpu_us_per_frame
+       << ",\"rss_kb\":" << r.rss_kb
+       << ",\"rss_peak_kb\":" << r.rss_peak_kb
+       << ",\"connects\":" << r.connects
+       << ",\"requests\":" << r.requests;
+    if (!r.rates.empty()) {
+        os << ",\"rates\":[";
+        for (size_t i = 0; i < r.rates.size(); ++i) {
+            const auto& rate = r.rates[i];
+            os << (i ? "," : "") << "{\"rate\":\"" << formatRateSpec(rate.spec) << "\""
+               << ",\"clients\":" << rate.clients
+               << ",\"frames_per_sec\":" << rate.frames_per_s
+               << ",\"bytes_per_sec\":" << rate.bytes_per_s
+               << ",\"expected_frames_per_sec\":" << rate.expected_per_s << "}";
+        }
+        os << "]";
+    }
+    os << ",\"errors\":" << r.errors
+       << ",\"gateway_died\":" << (r.gateway_died ? "true" : "false") << "}\n";
+}
+
+/// Parses a comma-separated list of parseRateSpec() specs.
+std::vector<RateSpec> parseRates(const std::string& list) {
+    std::vector<RateSpec> rates;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        auto spec = parseRateSpec(item);
+        if (!spec) throw std::invalid_argument("Invalid rate: " + item);
+        rates.push_back(*spec);
+    }
+    return rates;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options] [workload...]\n"
+              << "Workloads: beacons samples history busy churn constellation rates fetch storm\n"
+              << "           (default: all)\n"
+              << "  --gateway PATH        gateway binary (default ./gateway)\n"
+              << "  --gateway-log FILE    gateway output (default /dev/null)\n"
+              << "  --port N              TCP port for the gateway (default 18064)\n"
+              << "  --workers N           run the gateway with a pool of N (0 = per core)\n"
+              << "  --dispatch LIST       run every workload per mode: inline, N or MIN:MAX\n"
+              << "                        workers (e.g. inline,4,1:16)\n"
+              << "  --busy-clients N      request clients in the busy workload (default 32)\n"
+              << "  --subscribers N       live subscribers (default 8)\n"
+              << "  --history-clients N   clients pulling history (default 4)\n"
+              << "  --rate N              streamed samples per second (default 2000)\n"
+              << "  --satellites N        simulators in the constellation workload (default 64)\n"
+              << "  --baud N              emulate UART wire time (default off)\n"
+              << "  --storm-clients N     connections in the storm workload (default 10000)\n"
+              << "  --fetch-days N        history days downloaded by fetch (default 7)\n"
+              << "  --fetch-window N      per-day requests in flight in fetch (default 4)\n"
+              << "  --fetch-repeat N      downloads per fetch mode, median kept (default 3)\n"
+              << "  --shards N            gateway accept loops (ALTAIR_TCP_SHARDS)\n"
+              << "  --rates SPEC,...      subscriber rates in the rates workload (default\n"
+              << "                        all,interval:100,nth:10,avg:250,max:1000)\n"
+              << "  --duration S          seconds per workload (default 10)\n"
+              << "  --json FILE           append one JSON object per workload ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+    std::vector<std::string> selected;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if      (arg == "--gateway")         cfg.gateway = value();
+            else if (arg == "--gateway-log")     cfg.gateway_log = value();
+            else if (arg == "--port")            cfg.port = static_cast<uint16_t>(std::stoul(value()));
+            else if (arg == "--workers")         cfg.dispatch = {value()};
+            else if (arg == "--dispatch") {
+                cfg.dispatch.clear();
+                std::istringstream list(value());
+                std::string item;
+                while (std::getline(list, item, ',')) {
+                    cfg.dispatch.push_back(item == "inline" ? "" : item);
+                }
+            }
+            else if (arg == "--busy-clients")    cfg.busy_clients = std::stoul(value());
+            else if (arg == "--subscribers")     cfg.subscribers = std::stoul(value());
+            else if (arg == "--history-clients") cfg.history_clients = std::stoul(value());
+            else if (arg == "--rate")            cfg.sample_rate = std::stod(value());
+            else if (arg == "--satellites")      cfg.satellites = std::stoul(value());
+            else if (arg == "--baud")            cfg.baud = std::stoul(value());
+            else if (arg == "--storm-clients")   cfg.storm_clients = std::stoul(value());
+            else if (arg == "--fetch-days")      cfg.fetch_days = std::stoul(value());
+            else if (arg == "--fetch-window")    cfg.fetch_window = std::stoul(value());
+            else if (arg == "--fetch-repeat")    cfg.fetch_repeat = std::stoul(value());
+            else if (arg == "--shards")          cfg.shards = std::stoul(value());
+            else if (arg == "--duration")        cfg.duration = std::chrono::seconds(std::stoul(value()));
+            else if (arg == "--rates")           cfg.rates = parseRates(value());
+            else if (arg == "--json")            cfg.json_path = value();
+            else if (arg.rfind("--", 0) == 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            else selected.push_back(arg);
+        }
+
+        // The storm holds a descriptor per client, as does the gateway.
+        rlimit files{};
+        if (::getrlimit(RLIMIT_NOFILE, &files) == 0) {
+            files.rlim_cur = files.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &files);
+        }
+
+        std::vector<BenchResult> results;
+        for (auto& w : makeWorkloads(cfg)) {
+            if (!selected.empty()
+                && std::find(selected.begin(), selected.end(), w.name) == selected.end()) {
+                continue;
+            }
+            for (const auto& workers : cfg.dispatch) {
+                BenchConfig mode = cfg;
+                mode.workers = workers;
+                std::cerr << "Running " << w.name << " (" << dispatchName(workers) << ") for "
+                          << cfg.duration.count() << " s...\n";
+                results.push_back(runWorkload(mode, w));
+            }
+        }
+        // The storm measures accepting, which dispatch does not touch, and
+        // fetch is bound by the link.
+        cfg.workers = cfg.dispatch.front();
+
+        std::vector<FetchResult> fetch;
+        if (selected.empty()
+            || std::find(selected.begin(), selected.end(), "fetch") != selected.end()) {
+            std::cerr << "Running fetch of " << cfg.fetch_days << " days...\n";
+            fetch = runFetch(cfg);
+        }
+
+        std::optional<StormResult> storm;
+        if (selected.empty()
+            || std::find(selected.begin(), selected.end(), "storm") != selected.end()) {
+            std::cerr << "Running storm with " << cfg.storm_clients << " clients...\n";
+            storm = runStorm(cfg);
+        }
+
+        if (!results.empty()) printTable(results);
+        for (const auto& r : results) {
+            if (!r.rates.empty()) printRates(r);
+        }
+        if (!fetch.empty()) printFetch(fetch);
+        if (storm) printStorm(*storm);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+            for (const auto& r : fetch) printFetchJson(os, cfg, r);
+            if (storm) printStormJson(os, cfg, *storm);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,229 @@
+// Append throughput and catch-up read speed of the frame journal.
+//
+// Each run starts from an empty journal directory and measures
+//
+//   append    frames appended by one writer, group commit running, up to
+//             the final sync() that makes them all durable
+//   catch-up  a JournalReader reading every frame from offset 0 straight
+//             out of the mapped segments
+//   seek      opening a reader at a random offset until its first frame
+//   reopen    closing and opening the journal, which validates every record
+//
+// Runs are repeated and the table shows the median of each phase.
+
+#include "frame_journal.hpp"
+#include "protocol.hpp"
+#include "protocol_defs.hpp"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    std::string dir{"journal_bench.d"};
+    uint64_t    frames{2000000};
+    size_t      payload{40};
+    size_t      segment_mb{64};
+    unsigned    sync_ms{50};
+    size_t      sync_kb{1024};
+    unsigned    seeks{100};
+    unsigned    repeat{3};
+    std::string json_path;
+};
+
+struct Result {
+    std::string phase;
+    uint64_t    frames{0};
+    uint64_t    bytes{0};
+    double      seconds{0};
+};
+
+double since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/// Removes the segments a previous run left behind.
+void clearDir(const std::string& dir) {
+    if (DIR* d = ::opendir(dir.c_str())) {
+        while (dirent* e = ::readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".seg") == 0) {
+                ::unlink((dir + "/" + name).c_str());
+            }
+        }
+        ::closedir(d);
+    }
+}
+
+std::vector<Result> runOnce(const BenchConfig& cfg, const std::vector<uint8_t>& frame) {
+    JournalOptions options;
+    options.segment_bytes = cfg.segment_mb << 20;
+    options.max_bytes     = 0;
+    options.max_age       = std::chrono::seconds(0);
+    options.sync_interval = std::chrono::milliseconds(cfg.sync_ms);
+    options.sync_bytes    = cfg.sync_kb << 10;
+
+    clearDir(cfg.dir);
+    auto journal = std::make_unique<FrameJournal>(cfg.dir, options);
+    const uint64_t record_bytes = kJournalRecordHead + frame.size();
+
+    std::vector<Result> results;
+
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < cfg.frames; ++i) {
+        journal->append(static_cast<uint8_t>(i & 3), frame.data(), frame.size());
+    }
+    journal->sync();
+    results.push_back({"append", cfg.frames, cfg.frames * record_bytes, since(start)});
+
+    uint64_t checksum = 0;
+    start = Clock::now();
+    JournalReader reader(*journal, 0);
+    uint64_t read = reader.poll([&](const JournalReader::Frame& f) {
+        checksum += f.data[f.size - 2];
+    });
+    results.push_back({"catch-up", read, read * record_bytes, since(start)});
+    if (read != cfg.frames) {
+        throw std::runtime_error("catch-up read " + std::to_string(read) + " of "
+                                 + std::to_string(cfg.frames) + " frames");
+    }
+
+    std::mt19937_64 rng(42);
+    start = Clock::now();
+    for (unsigned i = 0; i < cfg.seeks; ++i) {
+        JournalReader at(*journal, rng() % cfg.frames);
+        at.poll([&](const JournalReader::Frame& f) { checksum += f.offset; }, 1);
+    }
+    results.push_back({"seek", cfg.seeks, 0, since(start)});
+
+    start = Clock::now();
+    journal.reset();
+    journal = std::make_unique<FrameJournal>(cfg.dir, options);
+    results.push_back({"reopen", journal->end(), journal->end() * record_bytes, since(start)});
+    if (journal->end() != cfg.frames) throw std::runtime_error("reopen lost frames");
+
+    if (checksum == 0) std::cerr << "unexpected checksum\n";
+    return results;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(10) << "phase" << std::right
+              << std::setw(12) << "frames" << std::setw(12) << "Mfr/s"
+              << std::setw(12) << "MB/s" << std::setw(14) << "ns/frame" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(10) << r.phase << std::right << std::fixed
+                  << std::setw(12) << r.frames
+                  << std::setprecision(2) << std::setw(12) << r.frames / r.seconds / 1e6
+                  << std::setprecision(0) << std::setw(12) << r.bytes / r.seconds / 1e6
+                  << std::setprecision(1) << std::setw(14) << r.seconds * 1e9 / r.frames
+                  << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"phase\":\"" << r.phase << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"payload\":" << cfg.payload
+       << ",\"segment_mb\":" << cfg.segment_mb
+       << ",\"sync_ms\":" << cfg.sync_ms
+       << ",\"frames\":" << r.frames
+       << ",\"seconds\":" << r.seconds
+       << ",\"frames_per_s\":" << r.frames / r.seconds
+       << ",\"bytes_per_s\":" << r.bytes / r.seconds << "}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --dir DIR             journal directory, emptied first (default journal_bench.d)\n"
+              << "  --frames N            frames per run (default 2000000)\n"
+              << "  --payload N           payload bytes per frame (default 40)\n"
+              << "  --segment-mb N        segment size (default 64)\n"
+              << "  --sync-ms N           group commit interval (default 50)\n"
+              << "  --sync-kb N           flush early after this much data (default 1024)\n"
+              << "  --seeks N             random reader openings per run (default 100)\n"
+              << "  --repeat N            runs (default 3)\n"
+              << "  --json FILE           append one JSON object per phase ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if      (arg == "--dir")        cfg.dir = value();
+            else if (arg == "--frames")     cfg.frames = std::max(1ull, std::stoull(value()));
+            else if (arg == "--payload")    cfg.payload = std::min<size_t>(std::stoul(value()), 254);
+            else if (arg == "--segment-mb") cfg.segment_mb = std::max(1ul, std::stoul(value()));
+            else if (arg == "--sync-ms")    cfg.sync_ms = std::stoul(value());
+            else if (arg == "--sync-kb")    cfg.sync_kb = std::stoul(value());
+            else if (arg == "--seeks")      cfg.seeks = std::max(1ul, std::stoul(value()));
+            else if (arg == "--repeat")     cfg.repeat = std::max(1ul, std::stoul(value()));
+            else if (arg == "--json")       cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        Packet pkt{};
+        pkt.packetId = PROTO_PKT_SAMPLE;
+        pkt.payload.assign(cfg.payload, '0');
+        auto frame = Protocol::pack(pkt);
+
+        // runs[p] holds the repeats of phase p.
+        std::vector<std::vector<Result>> runs;
+        for (unsigned rep = 0; rep < cfg.repeat; ++rep) {
+            auto results = runOnce(cfg, frame);
+            runs.resize(results.size());
+            for (size_t p = 0; p < results.size(); ++p) runs[p].push_back(results[p]);
+        }
+        clearDir(cfg.dir);
+
+        std::vector<Result> results;
+        for (auto& samples : runs) {
+            std::sort(samples.begin(), samples.end(), [](const Result& a, const Result& b) {
+                return a.seconds < b.seconds;
+            });
+            results.push_back(samples[samples.size() / 2]);
+        }
+
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
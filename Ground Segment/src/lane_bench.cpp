@@ -0,0 +1,197 @@
+// High-lane latency while the low lane is flooded with bulk work.
+//
+// The pool's workers are handed --bulk tasks of --bulk-us busy work each,
+// all queued at once, as a history download would. While they drain, a
+// submitter thread queues a short task every --interval-us and times how
+// long it waited before starting:
+//
+//   lanes  short tasks on Priority::High, bulk on Priority::Low, as the
+//          gateway queues live frames ahead of bulk work
+//   fifo   both on Priority::Low, what a single queue gives
+//
+// The table shows the short tasks' wait quantiles per mode, next to the
+// p99 the pool's own High-lane histogram recorded. The exit status is 2
+// if the lanes p99 is over --budget-us.
+
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    unsigned    workers{4};
+    uint64_t    bulk{100000};
+    unsigned    bulk_us{10};
+    unsigned    interval_us{200};
+    double      budget_us{1000};
+    std::string json_path;
+};
+
+struct Result {
+    std::string mode;
+    uint64_t    high{0};
+    double      p50_us{0};
+    double      p99_us{0};
+    double      max_us{0};
+    double      pool_p99_us{0};     // from the pool's lane histogram
+    double      seconds{0};
+};
+
+void spin(std::chrono::microseconds d) {
+    auto until = Clock::now() + d;
+    while (Clock::now() < until) {}
+}
+
+double quantile(std::vector<double>& values, double q) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+}
+
+Result run(const BenchConfig& cfg, bool lanes) {
+    ThreadPool::ThreadPool pool(cfg.workers);
+    const auto high_lane = lanes ? ThreadPool::Priority::High : ThreadPool::Priority::Low;
+
+    std::atomic<uint64_t> bulk_done{0};
+    std::mutex            waits_mutex;
+    std::vector<double>   waits_us;
+
+    auto start = Clock::now();
+    for (uint64_t i = 0; i < cfg.bulk; ++i) {
+        pool.submit_with_priority(ThreadPool::Priority::Low, [&]() {
+            spin(std::chrono::microseconds(cfg.bulk_us));
+            bulk_done.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+
+    // Short tasks for as long as the flood lasts; each records its wait.
+    std::vector<std::future<void>> pending;
+    while (bulk_done.load(std::memory_order_relaxed) < cfg.bulk) {
+        auto queued = Clock::now();
+        pending.push_back(pool.submit_with_priority(high_lane, [&, queued]() {
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - queued).count();
+            std::lock_guard<std::mutex> lock(waits_mutex);
+            waits_us.push_back(us);
+        }));
+        std::this_thread::sleep_for(std::chrono::microseconds(cfg.interval_us));
+    }
+    for (auto& f : pending) f.get();
+
+    Result r;
+    r.mode        = lanes ? "lanes" : "fifo";
+    r.seconds     = std::chrono::duration<double>(Clock::now() - start).count();
+    r.high        = waits_us.size();
+    r.p50_us      = quantile(waits_us, 0.50);
+    r.p99_us      = quantile(waits_us, 0.99);
+    r.max_us      = waits_us.empty() ? 0 : waits_us.back();
+    r.pool_p99_us = lanes ? pool.queue_wait_histogram(ThreadPool::Priority::High).percentile(99) / 1e3
+                          : 0;
+    return r;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(8) << "mode" << std::right
+              << std::setw(9) << "short" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+              << std::setw(12) << "max us" << std::setw(14) << "pool p99 us"
+              << std::setw(10) << "seconds" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(8) << r.mode << std::right << std::fixed
+                  << std::setw(9) << r.high << std::setprecision(1)
+                  << std::setw(12) << r.p50_us << std::setw(12) << r.p99_us
+                  << std::setw(12) << r.max_us << std::setw(14) << r.pool_p99_us
+                  << std::setprecision(2) << std::setw(10) << r.seconds << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"mode\":\"" << r.mode << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"workers\":" << cfg.workers
+       << ",\"bulk\":" << cfg.bulk
+       << ",\"bulk_us\":" << cfg.bulk_us
+       << ",\"short\":" << r.high
+       << ",\"p50_us\":" << r.p50_us
+       << ",\"p99_us\":" << r.p99_us
+       << ",\"max_us\":" << r.max_us
+       << ",\"pool_p99_us\":" << r.pool_p99_us
+       << ",\"seconds\":" << r.seconds << "}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --workers N           pool threads (default 4)\n"
+              << "  --bulk N              bulk tasks queued on the low lane (default 100000)\n"
+              << "  --bulk-us N           busy work per bulk task (default 10)\n"
+              << "  --interval-us N       pause between short tasks (default 200)\n"
+              << "  --budget-us N         fail if the lanes p99 is over it (default 1000)\n"
+              << "  --json FILE           append one JSON object per mode ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--workers")          cfg.workers = std::max(1ul, std::stoul(value()));
+            else if (arg == "--bulk")        cfg.bulk = std::stoull(value());
+            else if (arg == "--bulk-us")     cfg.bulk_us = std::stoul(value());
+            else if (arg == "--interval-us") cfg.interval_us = std::stoul(value());
+            else if (arg == "--budget-us")   cfg.budget_us = std::stod(value());
+            else if (arg == "--json")        cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        std::vector<Result> results{run(cfg, true), run(cfg, false)};
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+
+        const Result& lanes = results.front();
+        if (lanes.high == 0) {
+            std::cout << "No short task ran during the flood; raise --bulk\n";
+            return 2;
+        }
+        if (lanes.p99_us > cfg.budget_us) {
+            std::cout << "Over budget: high-lane p99 " << lanes.p99_us << " us (budget "
+                      << cfg.budget_us << " us)\n";
+            return 2;
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
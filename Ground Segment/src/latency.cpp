@@ -0,0 +1,169 @@
+#include "latency.hpp"
+#include "asynclogger.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace altair {
+
+namespace {
+
+constexpr double kQuantiles[] = {0.5, 0.99, 0.999};
+
+/// "850 ns", "12.3 us", "4.56 ms", "1.2 s".
+std::string formatNs(uint64_t ns) {
+    char buf[32];
+    if (ns < 1000)            std::snprintf(buf, sizeof(buf), "%llu ns", static_cast<unsigned long long>(ns));
+    else if (ns < 1000000)    std::snprintf(buf, sizeof(buf), "%.3g us", ns / 1e3);
+    else if (ns < 1000000000) std::snprintf(buf, sizeof(buf), "%.3g ms", ns / 1e6);
+    else                      std::snprintf(buf, sizeof(buf), "%.3g s", ns / 1e9);
+    return buf;
+}
+
+} // namespace
+
+// ------------------------------------------------------------------------
+// HdrHistogram
+// ------------------------------------------------------------------------
+
+HdrHistogram::HdrHistogram(uint64_t max_value, int significant_digits)
+    : max_value_(max_value)
+{
+    // Enough sub-buckets to tell apart values differing in the last of
+    // significant_digits digits.
+    const double largest_single_unit = 2 * std::pow(10.0, significant_digits);
+    const int sub_magnitude = static_cast<int>(std::ceil(std::log2(largest_single_unit)));
+    half_magnitude_  = std::max(sub_magnitude, 1) - 1;
+    half_count_      = uint64_t(1) << half_magnitude_;
+    sub_bucket_mask_ = (half_count_ << 1) - 1;
+
+    size_t buckets = 1;
+    for (uint64_t untrackable = half_count_ << 1; untrackable <= max_value_; untrackable <<= 1) {
+        ++buckets;
+        if (untrackable > (UINT64_MAX >> 1)) break;
+    }
+    size_   = (buckets + 1) * half_count_;
+    counts_ = std::make_unique<std::atomic<uint64_t>[]>(size_);
+}
+
+std::vector<uint64_t> HdrHistogram::snapshot() const {
+    std::vector<uint64_t> counts(size_);
+    for (size_t i = 0; i < size_; ++i) counts[i] = counts_[i].load(std::memory_order_relaxed);
+    return counts;
+}
+
+uint64_t HdrHistogram::highestAt(size_t i) const {
+    int bucket   = static_cast<int>(i >> half_magnitude_) - 1;
+    uint64_t sub = (i & (half_count_ - 1)) + half_count_;
+    if (bucket < 0) {
+        sub   -= half_count_;
+        bucket = 0;
+    }
+    return (sub << bucket) + (uint64_t(1) << bucket) - 1;
+}
+
+uint64_t HdrHistogram::valueAt(const std::vector<uint64_t>& counts, double q) const {
+    uint64_t total = 0;
+    for (uint64_t c : counts) total += c;
+    if (total == 0) return 0;
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * double(total))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) return std::min(highestAt(i), max_value_);
+    }
+    return max_value_;
+}
+
+// ------------------------------------------------------------------------
+// LatencyTracer
+// ------------------------------------------------------------------------
+
+LatencyTracer::LatencyTracer() = default;
+
+LatencyTracer::~LatencyTracer() {
+    stop();
+}
+
+const char* LatencyTracer::stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Decode:   return "decode";
+        case LatencyStage::Dispatch: return "dispatch";
+        case LatencyStage::Fanout:   return "fanout";
+        case LatencyStage::Write:    return "write";
+        case LatencyStage::Total:    return "total";
+        default:                     return "?";
+    }
+}
+
+void LatencyTracer::report(std::chrono::seconds interval) {
+    stop();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = false;
+    reporter_ = std::thread([this, interval]() { reportLoop(interval); });
+}
+
+void LatencyTracer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (reporter_.joinable()) reporter_.join();
+}
+
+void LatencyTracer::reportLoop(std::chrono::seconds interval) {
+    constexpr size_t n = static_cast<size_t>(LatencyStage::Count);
+    std::vector<uint64_t> last[n];
+    for (size_t s = 0; s < n; ++s) last[s] = stages_[s].snapshot();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cv_.wait_for(lock, interval, [this]() { return stopping_; })) {
+        for (size_t s = 0; s < n; ++s) {
+            // Quantiles over the interval: what was recorded since last time.
+            std::vector<uint64_t> now = stages_[s].snapshot();
+            std::vector<uint64_t> window(now.size());
+            uint64_t frames = 0;
+            for (size_t i = 0; i < now.size(); ++i) {
+                window[i] = now[i] - last[s][i];
+                frames   += window[i];
+            }
+            last[s] = std::move(now);
+            if (frames == 0) continue;
+
+            const HdrHistogram& h = stages_[s];
+            AsyncLogger::instance().log(LogLevel::Info,
+                "[Latency] {}: p50 {}, p99 {}, p999 {} ({} frames)",
+                stageName(static_cast<LatencyStage>(s)), formatNs(h.valueAt(window, 0.5)),
+                formatNs(h.valueAt(window, 0.99)), formatNs(h.valueAt(window, 0.999)), frames);
+        }
+    }
+}
+
+void LatencyTracer::exportTo(MetricsRegistry& registry) {
+    for (size_t s = 0; s < static_cast<size_t>(LatencyStage::Count); ++s) {
+        const std::string stage = stageName(static_cast<LatencyStage>(s));
+        const HdrHistogram& h = stages_[s];
+
+        for (double q : kQuantiles) {
+            char label[16];
+            std::snprintf(label, sizeof(label), "%g", q);
+            registry.gaugeFn("altair_latency_seconds",
+                             "Frame latency per stage from UART ingress to client egress, "
+                             "quantiles since start.",
+                             {{"stage", stage}, {"quantile", label}},
+                             [&h, q]() { return h.valueAt(h.snapshot(), q) * 1e-9; });
+        }
+        registry.counterFn("altair_latency_frames_total",
+                           "Frames timed per latency stage.", {{"stage", stage}},
+                           [&h]() {
+                               uint64_t total = 0;
+                               for (uint64_t c : h.snapshot()) total += c;
+                               return double(total);
+                           });
+    }
+}
+
+} // namespace altair
@@ -0,0 +1,347 @@
+#include "loadgen.hpp"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <stdexcept>
+
+namespace altair {
+
+using Clock = EventLoop::Clock;
+
+namespace {
+
+double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = std::min(v.size() - 1, static_cast<size_t>(p / 100.0 * v.size()));
+    return v[idx];
+}
+
+double micros(Clock::duration d) {
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+/// "YYYY-MM-DD" from the first eight digits of text.
+std::string dashedDate(const std::string& text) {
+    return text.substr(0, 4) + "-" + text.substr(4, 2) + "-" + text.substr(6, 2);
+}
+
+std::string todayDate() {
+    std::time_t now = std::time(nullptr);
+    char buf[11];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", std::localtime(&now));
+    return buf;
+}
+
+} // namespace
+
+struct LoadGenerator::Session {
+    size_t                  index{0};
+    bool                    subscriber{false};
+    int                     fd{-1};
+    bool                    connected{false};
+    FrameDecoder            decoder;
+
+    bool                    waiting{false};     // a request is outstanding
+    bool                    got_first{false};
+    uint8_t                 type{0};
+    std::string             today;              // when the request went out
+    Clock::time_point       sent_at;
+    Clock::time_point       last_frame_at;
+    EventLoop::TimerId      timer{0};
+};
+
+LoadGenerator::LoadGenerator(LoadProfile profile)
+    : profile_(std::move(profile))
+{
+    for (const auto& [type, weight] : profile_.mix) mix_total_ += weight;
+    if (mix_total_ == 0) {
+        profile_.mix = {{PROTO_PKT_SAMPLE, 1}};
+        mix_total_ = 1;
+    }
+    if (profile_.clients > 0) {
+        auto range = Protocol::makeRangeRequest(PROTO_PKT_SAMPLE, profile_.from, profile_.to);
+        if (!range) throw std::invalid_argument("Invalid date format");
+        const std::string digits(range->payload.begin(), range->payload.end());
+        first_day_ = dashedDate(digits);
+        last_day_  = dashedDate(digits.substr(8));
+    }
+}
+
+LoadGenerator::~LoadGenerator() {
+    for (auto& s : sessions_) closeSession(*s);
+}
+
+LoadReport LoadGenerator::run() {
+    report_  = LoadReport{};
+    running_ = true;
+
+    for (unsigned i = 0; i < profile_.clients + profile_.subscribers; ++i) {
+        auto s = std::make_unique<Session>();
+        s->index      = i;
+        s->subscriber = i >= profile_.clients;
+        sessions_.push_back(std::move(s));
+    }
+    for (auto& s : sessions_) connect(*s);
+
+    auto start = Clock::now();
+    loop_.addTimer(start + profile_.duration, [this]() {
+        running_ = false;
+        loop_.stop();
+    });
+    loop_.run();
+
+    report_.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto& s : sessions_) closeSession(*s);
+    sessions_.clear();
+    return std::move(report_);
+}
+
+void LoadGenerator::connect(Session& s) {
+    addrinfo hints{};
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_NUMERICSERV;
+
+    addrinfo*   res = nullptr;
+    std::string service = std::to_string(profile_.port);
+    if (::getaddrinfo(profile_.host.c_str(), service.c_str(), &hints, &res) != 0 || !res) {
+        throw std::runtime_error("Invalid address");
+    }
+
+    s.fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int rc = s.fd < 0 ? -1 : ::connect(s.fd, res->ai_addr, res->ai_addrlen);
+    ::freeaddrinfo(res);
+
+    if (s.fd < 0 || (rc < 0 && errno != EINPROGRESS)) {
+        ++report_.connect_errors;
+        scheduleReconnect(s);
+        return;
+    }
+
+    s.connected = false;
+    s.decoder   = FrameDecoder{};
+    loop_.watch(s.fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP,
+                [this, &s](uint32_t events) { onEvents(s, events); });
+}
+
+void LoadGenerator::onEvents(Session& s, uint32_t events) {
+    if (!s.connected) {
+        int       err = 0;
+        socklen_t len = sizeof(err);
+        ::getsockopt(s.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err != 0 || (events & (EPOLLERR | EPOLLHUP))) {
+            ++report_.connect_errors;
+            scheduleReconnect(s);
+            return;
+        }
+        s.connected = true;
+        ++report_.connects;
+        loop_.watch(s.fd, EPOLLIN | EPOLLRDHUP,
+                    [this, &s](uint32_t ev) { onEvents(s, ev); });
+        if (!s.subscriber) {
+            sendRequest(s);
+            return;
+        }
+        if (profile_.routed_subscribers) {
+            Packet none{};
+            none.packetId = PROTO_PKT_NONE;
+            auto frame = Protocol::pack(*Protocol::makeRouted(PROTO_SAT_ALL, none));
+            ::send(s.fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+        }
+        if (!profile_.subscriber_requests.empty()) {
+            size_t k = (s.index - profile_.clients) % profile_.subscriber_requests.size();
+            auto frame = Protocol::pack(profile_.subscriber_requests[k]);
+            ::send(s.fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+        }
+        if (profile_.churn_interval.count() > 0) {
+            s.timer = loop_.addTimer(Clock::now() + profile_.churn_interval, [this, &s]() {
+                s.timer = 0;
+                closeSession(s);
+                if (running_) connect(s);
+            });
+        }
+        return;
+    }
+
+    uint8_t buf[16 * 1024];
+    for (;;) {
+        ssize_t n = ::read(s.fd, buf, sizeof(buf));
+        if (n > 0) {
+            s.decoder.feed(buf, static_cast<size_t>(n));
+            while (auto pkt = s.decoder.next()) onFrame(s, *pkt);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+
+        ++report_.disconnects;
+        scheduleReconnect(s);
+        return;
+    }
+}
+
+void LoadGenerator::onFrame(Session& s, const Packet& pkt) {
+    if (frame_hook_) frame_hook_(s.index, pkt, Clock::now());
+
+    if (s.subscriber) {
+        ++report_.subscriber_frames;
+        return;
+    }
+
+    ++report_.frames_in;
+    report_.bytes_in += pkt.payload.size() + 4;
+
+    // Refused by admission control: ask again when the gateway says.
+    if (pkt.packetId == PROTO_PKT_REJECTED && s.waiting && pkt.payload.size() == 4) {
+        ++report_.rejected;
+        loop_.cancelTimer(s.timer);
+        s.waiting = false;
+        auto retry = std::chrono::milliseconds((pkt.payload[2] << 8) | pkt.payload[3]);
+        s.timer = loop_.addTimer(Clock::now() + retry, [this, &s]() { s.timer = 0; sendRequest(s); });
+        return;
+    }
+    if (!s.waiting || pkt.packetId != s.type || !inRange(s, pkt)) return;
+
+    auto now = Clock::now();
+    if (!s.got_first) {
+        s.got_first = true;
+        report_.first_frame_us.push_back(micros(now - s.sent_at));
+    }
+    s.last_frame_at = now;
+
+    loop_.cancelTimer(s.timer);
+    s.timer = loop_.addTimer(now + profile_.idle_timeout, [this, &s]() { finishRequest(s); });
+}
+
+bool LoadGenerator::inRange(const Session& s, const Packet& pkt) const {
+    // Lines start with "YYYY-MM-DD". The gateway sends every client live
+    // samples and the replies to other clients' requests too, so a line
+    // only answers this session if it is dated in the requested range.
+    // Live samples are dated today and never do.
+    if (pkt.payload.size() < 10) return false;
+    std::string date(pkt.payload.begin(), pkt.payload.begin() + 10);
+    return date >= first_day_ && date <= last_day_ && date != s.today;
+}
+
+void LoadGenerator::sendRequest(Session& s) {
+    if (!running_ || s.fd < 0) return;
+
+    s.type = pickType();
+    auto frame = Protocol::pack(*Protocol::makeRangeRequest(s.type, profile_.from, profile_.to));
+    ssize_t n = ::send(s.fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+    if (n != static_cast<ssize_t>(frame.size())) {
+        ++report_.disconnects;
+        scheduleReconnect(s);
+        return;
+    }
+
+    s.waiting   = true;
+    s.got_first = false;
+    s.today     = todayDate();
+    s.sent_at   = Clock::now();
+    s.timer     = loop_.addTimer(s.sent_at + profile_.response_timeout,
+                                 [this, &s]() { finishRequest(s); });
+}
+
+void LoadGenerator::finishRequest(Session& s) {
+    s.timer   = 0;
+    s.waiting = false;
+    if (s.got_first) {
+        ++report_.requests;
+        report_.complete_us.push_back(micros(s.last_frame_at - s.sent_at));
+    } else {
+        ++report_.timeouts;
+    }
+
+    if (profile_.think_time.count() > 0) {
+        s.timer = loop_.addTimer(Clock::now() + profile_.think_time,
+                                 [this, &s]() { s.timer = 0; sendRequest(s); });
+    } else {
+        sendRequest(s);
+    }
+}
+
+void LoadGenerator::scheduleReconnect(Session& s) {
+    closeSession(s);
+    if (!running_) return;
+    s.timer = loop_.addTimer(Clock::now() + std::chrono::milliseconds(100),
+                             [this, &s]() { s.timer = 0; connect(s); });
+}
+
+void LoadGenerator::closeSession(Session& s) {
+    if (s.timer) {
+        loop_.cancelTimer(s.timer);
+        s.timer = 0;
+    }
+    if (s.fd >= 0) {
+        loop_.unwatch(s.fd);
+        ::close(s.fd);
+        s.fd = -1;
+    }
+    s.connected = false;
+    s.waiting   = false;
+}
+
+uint8_t LoadGenerator::pickType() {
+    // xorshift64: cheap and good enough to honour the weights.
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 7;
+    rng_ ^= rng_ << 17;
+    unsigned r = static_cast<unsigned>(rng_ % mix_total_);
+    for (const auto& [type, weight] : profile_.mix) {
+        if (r < weight) return type;
+        r -= weight;
+    }
+    return profile_.mix.front().first;
+}
+
+void LoadReport::print(std::ostream& os) {
+    double secs = seconds > 0 ? seconds : 1;
+    os << std::fixed << std::setprecision(1)
+       << "Duration:          " << seconds << " s\n"
+       << "Requests:          " << requests << " (" << requests / secs << "/s)\n"
+       << "Frames in:         " << frames_in << " (" << frames_in / secs << "/s)\n"
+       << "Bytes in:          " << bytes_in << " (" << bytes_in / secs / 1024 << " KiB/s)\n"
+       << "Subscriber frames: " << subscriber_frames << "\n"
+       << "Connects:          " << connects << "\n"
+       << "First frame (ms):  p50 " << percentile(first_frame_us, 50) / 1000
+       << "  p90 " << percentile(first_frame_us, 90) / 1000
+       << "  p99 " << percentile(first_frame_us, 99) / 1000 << "\n"
+       << "Complete (ms):     p50 " << percentile(complete_us, 50) / 1000
+       << "  p90 " << percentile(complete_us, 90) / 1000
+       << "  p99 " << percentile(complete_us, 99) / 1000 << "\n"
+       << "Errors:            connect " << connect_errors
+       << ", disconnect " << disconnects
+       << ", timeout " << timeouts << ", rejected " << rejected << "\n";
+}
+
+void LoadReport::printJson(std::ostream& os) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"seconds\":" << seconds
+       << ",\"requests\":" << requests
+       << ",\"frames_in\":" << frames_in
+       << ",\"bytes_in\":" << bytes_in
+       << ",\"subscriber_frames\":" << subscriber_frames
+       << ",\"connects\":" << connects
+       << ",\"first_frame_us\":{\"p50\":" << percentile(first_frame_us, 50)
+       << ",\"p90\":" << percentile(first_frame_us, 90)
+       << ",\"p99\":" << percentile(first_frame_us, 99) << "}"
+       << ",\"complete_us\":{\"p50\":" << percentile(complete_us, 50)
+       << ",\"p90\":" << percentile(complete_us, 90)
+       << ",\"p99\":" << percentile(complete_us, 99) << "}"
+       << ",\"errors\":{\"connect\":" << connect_errors
+       << ",\"disconnect\":" << disconnects
+       << ",\"timeout\":" << timeouts
+       << ",\"rejected\":" << rejected << "}}\n";
+}
+
+} // namespace altair
@@ -1,8 +1,12 @@
 #include "logclient.hpp"
+#include "packet_registry.hpp"
 #include "protocol_defs.hpp"
 
+#include <algorithm>
 #include <iostream>
-#include <fstream>
+#include <iomanip>
+#include <ctime>
+#include <cstdio>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -10,15 +14,63 @@
 
 namespace altair {
 
-LogClient::LogClient(const std::string& host, uint16_t port) 
-    : host_(host), port_(port) {
+namespace {
+
+/// Expands [start, end] into "YYYY-MM-DD" days; empty if malformed.
+std::vector<std::string> expandDays(const std::string& start_date,
+                                    const std::string& end_date) {
+    auto parse = [](std::string d, std::tm& tm) {
+        d.erase(std::remove(d.begin(), d.end(), '-'), d.end());
+        if (d.size() != 8) return false;
+        tm = {};
+        if (std::sscanf(d.c_str(), "%4d%2d%2d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) != 3)
+            return false;
+        tm.tm_year -= 1900;
+        tm.tm_mon  -= 1;
+        tm.tm_hour  = 12;   // keep DST shifts from changing the date
+        tm.tm_isdst = -1;
+        return true;
+    };
+
+    std::vector<std::string> days;
+    std::tm from{}, to{};
+    if (!parse(start_date, from) || !parse(end_date, to)) return days;
+
+    std::time_t t_end = std::mktime(&to);
+    for (std::time_t t = std::mktime(&from); t <= t_end; ) {
+        std::tm* cur = std::localtime(&t);
+        char buf[11];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d", cur);
+        days.emplace_back(buf);
+        cur->tm_mday += 1;
+        t = std::mktime(cur);
+    }
+    return days;
+}
+
+/// Today's local date as "YYYY-MM-DD", the date live samples carry.
+std::string todayDate() {
+    std::time_t now = std::time(nullptr);
+    char buf[11];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", std::localtime(&now));
+    return buf;
+}
+
+} // namespace
+
+LogClient::LogClient(const std::string& host, uint16_t port,
+                     FileSinkOptions sink_options) 
+    : host_(host), port_(port), sink_options_(sink_options) {
     connectToServer();
 }
 
 LogClient::~LogClient() {
-    if (connection_) {
-        connection_->setDisconnectCallback(nullptr);
-    }
+    // Joins the reader thread: no packet reaches this object afterwards.
+    if (connection_) connection_->stop();
+
+    std::lock_guard<std::mutex> lock(sinks_mutex_);
+    if (samples_sink_) samples_sink_->close();
+    if (events_sink_) events_sink_->close();
 }
 
 void LogClient::connectToServer() {
@@ -46,61 +98,268 @@ void LogClient::connectToServer() {
     connection_->setDisconnectCallback([this](std::shared_ptr<ClientConnection>) {
         std::cout << "Disconnected from server\n";
         running_ = false;
+        connected_ = false;
+        std::lock_guard<std::mutex> lock(fetch_mutex_);
+        fetch_cv_.notify_all();
     });
 
+    connected_ = true;
     connection_->start();
 }
 
 void LogClient::handlePacket(const Packet& pkt) {
-    switch (pkt.packetId) {
-        case PROTO_PKT_SAMPLE:
+    packets::GatewayFeed::dispatch(pkt, packets::Overloaded{
+        [&](const packets::SampleLine&) {
             saveLogData(pkt.payload);
-            break;
-        default:
-            std::cout << "Received unknown packet type: " 
-                      << static_cast<int>(pkt.packetId) << std::endl;
-            break;
+        },
+        [&](const packets::Routed& routed) {
+            // Only sent to clients that subscribed with a ROUTED packet.
+            std::cout << "Ignoring packet routed from satellite "
+                      << static_cast<int>(routed.sat) << std::endl;
+        },
+        [&](const packets::JournalEntry& entry) {
+            // Only sent after follow(). Lines already end in a newline.
+            std::string_view text = entry.payload;
+            while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) {
+                text.remove_suffix(1);
+            }
+            std::cout << entry.offset << " [Sat " << static_cast<int>(entry.sat) << "] "
+                      << text << std::endl;
+        },
+        [&](const packets::StateEntry&) {
+            // Only sent to clients that subscribed with a ROUTED packet.
+        },
+        [&](const packets::Rejected& rejected) {
+            std::cout << "Gateway is busy, request 0x" << std::hex
+                      << static_cast<int>(rejected.packet_id) << std::dec
+                      << " refused; retry in " << rejected.retry_ms << " ms" << std::endl;
+        },
+        [&](const packets::InvalidPacket& bad) {
+            std::cout << "Received unknown packet type: "
+                      << static_cast<int>(bad.raw.packetId) << std::endl;
+        },
+    });
+}
+
+FileSink& LogClient::sinkFor(uint8_t type) {
+    std::lock_guard<std::mutex> lock(sinks_mutex_);
+    auto& sink = (type == PROTO_PKT_SAMPLE) ? samples_sink_ : events_sink_;
+    if (!sink) {
+        sink = std::make_unique<FileSink>(
+            type == PROTO_PKT_SAMPLE ? samples_path_ : events_path_, sink_options_);
     }
+    return *sink;
 }
 
-void LogClient::saveLogData(const std::vector<uint8_t>& data) {
-    std::string filename = current_type_ == PROTO_PKT_SAMPLE ? 
-                          "samples.txt" : "events.txt";
-    
-    std::ofstream file(filename, std::ios::app);
-    if (!file) {
-        std::cerr << "Failed to open " << filename << std::endl;
-        return;
+void LogClient::saveLogData(const Packet::Payload& data) {
+    {
+        std::lock_guard<std::mutex> lock(fetch_mutex_);
+        if (fetch_active_) {
+            routeLine(data);
+            return;
+        }
     }
 
-    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    // Runs on the socket reader thread: only copy into the sink's buffer,
+    // the disk write happens on the sink's own thread.
+    try {
+        sinkFor(current_type_).write(data.data(), data.size());
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
 }
 
 void LogClient::requestLogs(uint8_t type, const std::string& start_date, 
                           const std::string& end_date) {
     current_type_ = type;
-    
-    // Format dates as YYYYMMDDYYYYMMDD
-    std::string payload = start_date + end_date;
-    payload.erase(std::remove(payload.begin(), payload.end(), '-'), payload.end());
-    
-    if (payload.length() != 16) {
+
+    auto first = expandDays(start_date, start_date);
+    auto last  = expandDays(end_date, end_date);
+    if (first.empty() || last.empty()) {
         std::cerr << "Invalid date format\n";
         return;
     }
 
-    Packet request;
-    request.packetId = type;
-    request.payload.assign(payload.begin(), payload.end());
-    
-    auto framed = Protocol::pack(request);
-    connection_->send(framed);
+    std::vector<std::pair<std::string, std::string>> ranges;
+    if (fetch_options_.split_by_day) {
+        for (auto& day : expandDays(first.front(), last.front())) ranges.emplace_back(day, day);
+    }
+    if (ranges.empty()) ranges.emplace_back(first.front(), last.front());
+    fetchRanges(type, ranges);
+}
+
+void LogClient::setOutputPath(uint8_t type, const std::string& path) {
+    std::lock_guard<std::mutex> lock(sinks_mutex_);
+    if (type == PROTO_PKT_SAMPLE) {
+        samples_path_ = path;
+        samples_sink_.reset();
+    } else {
+        events_path_ = path;
+        events_sink_.reset();
+    }
+}
+
+void LogClient::setRangeFetchOptions(RangeFetchOptions options) {
+    if (options.window == 0) options.window = 1;
+    std::lock_guard<std::mutex> lock(fetch_mutex_);
+    fetch_options_ = options;
+}
+
+void LogClient::routeLine(const Packet::Payload& data) {
+    // Lines start with "YYYY-MM-DD". The gateway sends every client live
+    // samples and the replies to other clients' requests too, so a line
+    // only counts towards an outstanding day it is dated on.
+    if (data.size() < 10) return;
+    std::string date(data.begin(), data.begin() + 10);
+
+    for (size_t i = first_incomplete_; i < next_to_send_; ++i) {
+        DayFetch& day = days_[i];
+        if (day.complete || date < day.date || date > day.last) continue;
+
+        auto now = std::chrono::steady_clock::now();
+        day.data.insert(day.data.end(), data.begin(), data.end());
+        ++day.lines;
+        day.last_line = now;
+
+        // The satellite answers one request at a time, so a reply for a
+        // later day, whoever asked for it, means the earlier days that
+        // have started are done. Live samples are dated today and prove
+        // nothing; days with no lines yet wait for the idle timeout.
+        if (date < fetch_today_) {
+            for (size_t j = first_incomplete_; j < i; ++j) {
+                if (!days_[j].complete && days_[j].lines > 0) {
+                    days_[j].complete = true;
+                    days_[j].finished = days_[j].last_line;
+                }
+            }
+            while (first_incomplete_ < next_to_send_ && days_[first_incomplete_].complete) {
+                ++first_incomplete_;
+            }
+        }
+        fetch_cv_.notify_one();
+        return;
+    }
+}
+
+void LogClient::completeIdleDays() {
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = first_incomplete_; i < next_to_send_; ++i) {
+        DayFetch& day = days_[i];
+        if (day.complete) continue;
+
+        if (day.lines > 0) {
+            // The satellite sends a day in one go: it is over once its
+            // lines stop.
+            if (now - day.last_line < fetch_options_.idle_timeout) continue;
+            day.finished = day.last_line;
+        } else {
+            // Nothing yet. The satellite answers in order, so wait for the
+            // days before it, then give it the idle timeout to start.
+            if (i != first_incomplete_) continue;
+            auto since = i > 0 ? std::max(day.sent, days_[i - 1].finished) : day.sent;
+            if (now - since < fetch_options_.idle_timeout) continue;
+            day.finished = now;
+        }
+        day.complete = true;
+    }
+
+    while (first_incomplete_ < next_to_send_ && days_[first_incomplete_].complete) {
+        ++first_incomplete_;
+    }
+}
+
+void LogClient::fetchRanges(uint8_t type,
+                            const std::vector<std::pair<std::string, std::string>>& ranges) {
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lock(fetch_mutex_);
+    days_.clear();
+    for (const auto& [first, last] : ranges) {
+        DayFetch day;
+        day.date = first;
+        day.last = last;
+        days_.push_back(std::move(day));
+    }
+    first_incomplete_ = 0;
+    next_to_send_     = 0;
+    fetch_today_      = todayDate();
+    fetch_active_     = true;
+
+    FileSink& sink   = sinkFor(type);
+    const size_t total   = days_.size();
+    size_t next_to_write = 0;
+    size_t total_lines   = 0;
+    auto   started       = Clock::now();
+    auto   prev_finished = started;
+
+    while (next_to_write < total) {
+        // Keep the window full.
+        while (next_to_send_ < total
+               && next_to_send_ - first_incomplete_ < fetch_options_.window) {
+            DayFetch& day = days_[next_to_send_];
+            auto request = Protocol::makeRangeRequest(type, day.date, day.last);
+            day.sent = Clock::now();
+            ++next_to_send_;
+            if (request) connection_->send(Protocol::pack(*request));
+        }
+
+        // Take completed days in order. The reader thread keeps adding to
+        // the later ones while these are written with the lock released;
+        // only the timestamps of a taken day are read again.
+        std::vector<DayFetch> done;
+        while (next_to_write < total && days_[next_to_write].complete) {
+            done.push_back(std::move(days_[next_to_write]));
+            ++next_to_write;
+        }
+        if (!done.empty()) {
+            lock.unlock();
+            size_t index = next_to_write - done.size();
+            for (const DayFetch& day : done) {
+                sink.write(day.data);
+                total_lines += day.lines;
+
+                auto begin = std::max(day.sent, prev_finished);
+                auto ms    = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 day.finished - begin).count();
+                prev_finished = day.finished;
+
+                std::cout << "[" << ++index << "/" << total << "] " << day.date
+                          << (day.last != day.date ? " to " + day.last : std::string())
+                          << ": " << day.lines << " lines, "
+                          << day.data.size() << " bytes in " << ms << " ms" << std::endl;
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (!connected_) {
+            std::cerr << "Disconnected; range fetch aborted" << std::endl;
+            break;
+        }
+
+        fetch_cv_.wait_for(lock, fetch_options_.idle_timeout / 4);
+        completeIdleDays();
+    }
+
+    fetch_active_ = false;
+    days_.clear();
+    lock.unlock();
+
+    sink.flush();
+
+    double secs = std::chrono::duration<double>(Clock::now() - started).count();
+    std::cout << "\nRetrieved " << total_lines << " lines in " << std::fixed
+              << std::setprecision(2) << secs << " s." << std::endl;
+    std::cout << "Data saved to " << sink.path() << std::endl;
+}
 
-    std::cout << "\nRetrieved data." << std::endl;
+void LogClient::follow(uint64_t from) {
+    auto request = packets::encode(packets::Replay{from});
+    connection_->send(Protocol::pack(*request));
 
-    std::cout << "Data saved to " << (current_type_ == PROTO_PKT_SAMPLE ? 
-                "samples.txt" : "events.txt")
-     << std::endl;
+    std::unique_lock<std::mutex> lock(fetch_mutex_);
+    fetch_cv_.wait(lock, [&]() { return !connected_; });
 }
 
 void LogClient::run() {
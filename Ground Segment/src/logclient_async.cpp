@@ -0,0 +1,98 @@
+#include "async_logclient.hpp"
+#include "eventloop.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Stats {
+    int                 done{0};
+    int                 failed{0};
+    size_t              lines{0};
+    std::vector<double> latencies_ms;
+};
+
+altair::Task<void> fetchOne(altair::EventLoop& loop, const std::string& host,
+                            uint16_t port, uint8_t type,
+                            const std::string& from, const std::string& to,
+                            std::chrono::milliseconds idle, Stats& stats) {
+    auto start  = std::chrono::steady_clock::now();
+    auto client = co_await altair::AsyncLogClient::connect(loop, host, port);
+    auto lines  = co_await client->fetchRange(type, from, to, idle);
+
+    // Exclude the trailing idle wait that marks the end of the range.
+    auto elapsed = std::chrono::steady_clock::now() - start - idle;
+    stats.latencies_ms.push_back(
+        std::chrono::duration<double, std::milli>(elapsed).count());
+    stats.lines += lines.size();
+}
+
+double percentile(std::vector<double>& v, double p) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = std::min(v.size() - 1, static_cast<size_t>(p / 100.0 * v.size()));
+    return v[idx];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 6 || argc > 8) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <host> <port> <samples|events> <from> <to> [clients] [idle_ms]\n";
+        std::cerr << "Example: " << argv[0]
+                  << " 127.0.0.1 8064 samples 2025-04-20 2025-04-22 1000\n";
+        return 1;
+    }
+
+    try {
+        std::string host    = argv[1];
+        uint16_t    port    = static_cast<uint16_t>(std::stoi(argv[2]));
+        uint8_t     type    = std::string(argv[3]) == "events" ? altair::PROTO_PKT_EVENT
+                                                               : altair::PROTO_PKT_SAMPLE;
+        std::string from    = argv[4];
+        std::string to      = argv[5];
+        int         clients = argc > 6 ? std::stoi(argv[6]) : 1;
+        auto        idle    = std::chrono::milliseconds(argc > 7 ? std::stoi(argv[7]) : 2000);
+
+        altair::EventLoop loop;
+        Stats             stats;
+        auto              start = std::chrono::steady_clock::now();
+
+        // Every client is a coroutine on this one thread.
+        for (int i = 0; i < clients; ++i) {
+            altair::spawn(fetchOne(loop, host, port, type, from, to, idle, stats),
+                [&](std::exception_ptr error) {
+                    if (error) {
+                        ++stats.failed;
+                        try { std::rethrow_exception(error); }
+                        catch (const std::exception& e) {
+                            if (stats.failed == 1)
+                                std::cerr << "Client failed: " << e.what() << "\n";
+                        }
+                    }
+                    if (++stats.done == clients) loop.stop();
+                });
+        }
+        if (stats.done < clients) loop.run();
+
+        double wall = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "clients=" << clients
+                  << " failed=" << stats.failed
+                  << " lines=" << stats.lines
+                  << " wall_s=" << wall
+                  << " p50_ms=" << percentile(stats.latencies_ms, 50)
+                  << " p99_ms=" << percentile(stats.latencies_ms, 99)
+                  << "\n";
+        return stats.failed ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,20 +1,172 @@
 #include "logclient.hpp"
+#include "loadgen.hpp"
+#include "packet_registry.hpp"
+#include "rate_limit.hpp"
 #include <iostream>
+#include <sstream>
+
+namespace {
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <host> <port> [options]\n"
+              << "\n"
+              << "Without options the interactive menu is started.\n"
+              << "\n"
+              << "Batch download:\n"
+              << "  --type samples|events   log type to fetch\n"
+              << "  --from YYYY-MM-DD       first day (also needed for --load)\n"
+              << "  --to YYYY-MM-DD         last day (default: --from)\n"
+              << "  --out FILE              output file (default samples.txt / events.txt)\n"
+              << "  --window N              per-day requests in flight (default 4)\n"
+              << "  --idle-ms N             day completion timeout (default 2000)\n"
+              << "  --no-split              send the range as a single request\n"
+              << "                          (done after --idle-ms without a line)\n"
+              << "\n"
+              << "Journal:\n"
+              << "  --follow OFFSET         print every frame journaled from OFFSET on, then\n"
+              << "                          live ones (the gateway needs ALTAIR_JOURNAL)\n"
+              << "\n"
+              << "Load generation:\n"
+              << "  --load N                request clients\n"
+              << "  --mix samples:W,events:W  weighted request mix (default samples:1)\n"
+              << "  --subscribers M         live-only listeners (default 0)\n"
+              << "  --duration S            run time in seconds (default 10)\n"
+              << "  --think-ms N            pause between requests (default 0)\n"
+              << "  --churn-ms N            subscribers reconnect after N ms (default never)\n"
+              << "  --routed                subscribers take tagged frames from every satellite\n"
+              << "  --sub-rate SPEC         subscribers thin out samples: interval:MS, nth:N,\n"
+              << "                          min:MS, max:MS or avg:MS\n"
+              << "  --idle-ms N             response completion timeout (default 500)\n"
+              << "  --json                  print the report as JSON\n"
+              << "\n"
+              << "Example: " << prog << " localhost 8064 --type samples "
+              << "--from 2025-04-20 --to 2025-04-22 --out april.txt\n";
+}
+
+uint8_t parseType(const std::string& name) {
+    if (name == "samples") return altair::PROTO_PKT_SAMPLE;
+    if (name == "events")  return altair::PROTO_PKT_EVENT;
+    throw std::invalid_argument("Unknown log type: " + name);
+}
+
+std::vector<std::pair<uint8_t, unsigned>> parseMix(const std::string& spec) {
+    std::vector<std::pair<uint8_t, unsigned>> mix;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        auto colon = item.find(':');
+        unsigned weight = colon == std::string::npos ? 1 : std::stoul(item.substr(colon + 1));
+        mix.emplace_back(parseType(item.substr(0, colon)), weight);
+    }
+    return mix;
+}
+
+} // namespace
 
 int main(int argc, char* argv[]) {
     
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <host> <port>\n";
-        std::cerr << "Example: " << argv[0] << " localhost 8064\n";
+    if (argc < 3) {
+        usage(argv[0]);
         return 1;
     }
 
+    std::string host = argv[1];
+    uint16_t port = static_cast<uint16_t>(std::stoi(argv[2]));
+
     try {
-        altair::LogClient client(argv[1], std::stoi(argv[2]));
-        client.run();
+        if (argc == 3) {
+            altair::LogClient client(host, port);
+            client.run();
+            return 0;
+        }
+
+        std::string type_name, from, to, out, mix;
+        altair::RangeFetchOptions fetch;
+        altair::LoadProfile load;
+        unsigned clients = 0;
+        bool json = false;
+        std::string follow;
+
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if      (arg == "--type")        type_name = value();
+            else if (arg == "--from")        from = value();
+            else if (arg == "--to")          to = value();
+            else if (arg == "--out")         out = value();
+            else if (arg == "--window")      fetch.window = std::stoul(value());
+            else if (arg == "--no-split")    fetch.split_by_day = false;
+            else if (arg == "--load")        clients = std::stoul(value());
+            else if (arg == "--mix")         mix = value();
+            else if (arg == "--subscribers") load.subscribers = std::stoul(value());
+            else if (arg == "--duration")    load.duration = std::chrono::seconds(std::stoul(value()));
+            else if (arg == "--think-ms")    load.think_time = std::chrono::milliseconds(std::stoul(value()));
+            else if (arg == "--churn-ms")    load.churn_interval = std::chrono::milliseconds(std::stoul(value()));
+            else if (arg == "--routed")      load.routed_subscribers = true;
+            else if (arg == "--sub-rate") {
+                auto spec = altair::parseRateSpec(value());
+                if (!spec) throw std::invalid_argument("Invalid --sub-rate");
+                load.subscriber_requests = {*altair::packets::encode(altair::packets::RateRequest{
+                    altair::PROTO_SAT_ALL, spec->mode, spec->param})};
+            }
+            else if (arg == "--json")        json = true;
+            else if (arg == "--follow")      follow = value();
+            else if (arg == "--idle-ms") {
+                auto ms = std::chrono::milliseconds(std::stoul(value()));
+                fetch.idle_timeout = ms;
+                load.idle_timeout  = ms;
+            } else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (!follow.empty()) {
+            altair::LogClient client(host, port);
+            client.follow(std::stoull(follow));
+            return 0;
+        }
+
+        if (to.empty()) to = from;
+        // Subscribers only listen; only requests need a date range.
+        if (from.empty() && (clients > 0 || load.subscribers == 0)) {
+            std::cerr << "Error: --from is required\n";
+            return 1;
+        }
+
+        if (clients > 0 || load.subscribers > 0) {
+            load.host    = host;
+            load.port    = port;
+            load.clients = clients;
+            load.from    = from;
+            load.to      = to;
+            if (!mix.empty()) load.mix = parseMix(mix);
+            else if (!type_name.empty()) load.mix = {{parseType(type_name), 1}};
+
+            altair::LoadGenerator generator(load);
+            auto report = generator.run();
+            if (json) report.printJson(std::cout);
+            else      report.print(std::cout);
+            return (report.requests > 0 || clients == 0) ? 0 : 1;
+        }
+
+        if (type_name.empty()) {
+            std::cerr << "Error: --type is required\n";
+            return 1;
+        }
+
+        uint8_t type = parseType(type_name);
+        altair::LogClient client(host, port);
+        client.setRangeFetchOptions(fetch);
+        if (!out.empty()) client.setOutputPath(type, out);
+        client.requestLogs(type, from, to);
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,238 @@
+// Per-call cost of the gateway's packet dump, AsyncLogger against iostream.
+//
+// Each call logs what handleTcpPacket prints for a client packet of
+// --payload bytes (id, size, hex and ASCII dump), from --threads threads:
+//
+//   async     one Debug record through AsyncLogger; the writer thread
+//             formats it later
+//   iostream  the dump formatted on the calling thread straight into
+//             std::cout, one std::endl per line, as the gateway used to
+//
+// Standard output goes to --sink (/dev/null) while a mode runs. The table
+// shows the per-call latency quantiles seen by the callers, the calls per
+// second, and the records AsyncLogger dropped because a ring was full.
+
+#include "asynclogger.hpp"
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    unsigned    threads{1};
+    uint64_t    calls{20000};           // per thread
+    size_t      payload{32};
+    unsigned    interval_us{50};
+    std::string sink{"/dev/null"};
+    std::string json_path;
+};
+
+struct Result {
+    std::string mode;
+    uint64_t    calls{0};
+    double      p50_ns{0};
+    double      p99_ns{0};
+    double      p999_ns{0};
+    double      seconds{0};
+    uint64_t    dropped{0};
+};
+
+double quantile(std::vector<double>& values, double q) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+}
+
+/// The dump handleTcpPacket wrote before AsyncLogger.
+void dumpIostream(uint8_t id, const std::vector<uint8_t>& payload) {
+    std::cout << "[Gateway] Received TCP packet:" << std::endl;
+    std::cout << "  ID: 0x" << std::hex << static_cast<int>(id) << std::dec << std::endl;
+    std::cout << "  Payload size: " << payload.size() << std::endl;
+    std::cout << "  Payload hex: ";
+    for (uint8_t b : payload) {
+        std::cout << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(b) << " ";
+    }
+    std::cout << std::dec << std::endl;
+    std::cout << "  Payload ASCII: ";
+    for (uint8_t b : payload) {
+        std::cout << (std::isprint(b) ? static_cast<char>(b) : '.');
+    }
+    std::cout << std::endl;
+}
+
+/// The same dump as handleTcpPacket writes it now.
+void dumpAsync(uint8_t id, const std::vector<uint8_t>& payload) {
+    auto& log = AsyncLogger::instance();
+    if (log.enabled(LogLevel::Debug)) {
+        log.log(LogLevel::Debug, "[Gateway] Received TCP packet:\n"
+                                 "  ID: 0x{}\n"
+                                 "  Payload size: {}\n"
+                                 "  Payload hex: {}\n"
+                                 "  Payload ASCII: {}",
+                logHex(id), payload.size(), logHex(payload), logAscii(payload));
+    }
+}
+
+/// Points standard output at a file for as long as it lives.
+class StdoutRedirect {
+public:
+    explicit StdoutRedirect(const std::string& path) {
+        std::cout.flush();
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        saved_ = ::dup(STDOUT_FILENO);
+        ::dup2(fd, STDOUT_FILENO);
+        ::close(fd);
+    }
+
+    ~StdoutRedirect() {
+        std::cout.flush();
+        ::dup2(saved_, STDOUT_FILENO);
+        ::close(saved_);
+    }
+
+private:
+    int saved_{-1};
+};
+
+Result run(const BenchConfig& cfg, bool async) {
+    std::vector<uint8_t> payload(cfg.payload);
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<uint8_t>('0' + i % 75);
+
+    std::mutex          lat_mutex;
+    std::vector<double> lat_ns;
+    lat_ns.reserve(cfg.calls * cfg.threads);
+
+    auto& log = AsyncLogger::instance();
+    const uint64_t dropped_before = log.dropped();
+
+    StdoutRedirect redirect(cfg.sink);
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < cfg.threads; ++t) {
+        threads.emplace_back([&]() {
+            std::vector<double> mine;
+            mine.reserve(cfg.calls);
+            for (uint64_t i = 0; i < cfg.calls; ++i) {
+                auto t0 = Clock::now();
+                if (async) dumpAsync(0x01, payload);
+                else       dumpIostream(0x01, payload);
+                mine.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+                if (cfg.interval_us) std::this_thread::sleep_for(std::chrono::microseconds(cfg.interval_us));
+            }
+            std::lock_guard<std::mutex> lock(lat_mutex);
+            lat_ns.insert(lat_ns.end(), mine.begin(), mine.end());
+        });
+    }
+    for (auto& t : threads) t.join();
+    if (async) log.flush();
+    std::cout << std::setfill(' ');     // the old dump leaves '0' behind
+
+    Result r;
+    r.mode    = async ? "async" : "iostream";
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    r.calls   = lat_ns.size();
+    r.p50_ns  = quantile(lat_ns, 0.50);
+    r.p99_ns  = quantile(lat_ns, 0.99);
+    r.p999_ns = quantile(lat_ns, 0.999);
+    r.dropped = log.dropped() - dropped_before;
+    return r;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(10) << "mode" << std::right
+              << std::setw(10) << "calls" << std::setw(11) << "p50 ns" << std::setw(11) << "p99 ns"
+              << std::setw(11) << "p999 ns" << std::setw(13) << "calls/s" << std::setw(9) << "dropped"
+              << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(10) << r.mode << std::right << std::fixed
+                  << std::setw(10) << r.calls << std::setprecision(0)
+                  << std::setw(11) << r.p50_ns << std::setw(11) << r.p99_ns
+                  << std::setw(11) << r.p999_ns << std::setw(13) << r.calls / r.seconds
+                  << std::setw(9) << r.dropped << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"mode\":\"" << r.mode << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"threads\":" << cfg.threads
+       << ",\"payload\":" << cfg.payload
+       << ",\"calls\":" << r.calls
+       << ",\"p50_ns\":" << r.p50_ns
+       << ",\"p99_ns\":" << r.p99_ns
+       << ",\"p999_ns\":" << r.p999_ns
+       << ",\"seconds\":" << r.seconds
+       << ",\"dropped\":" << r.dropped << "}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --threads N           logging threads (default 1)\n"
+              << "  --calls N             dumps per thread (default 20000)\n"
+              << "  --payload N           packet payload bytes (default 32)\n"
+              << "  --interval-us N       pause between a thread's calls (default 50)\n"
+              << "  --sink FILE           where log output goes (default /dev/null)\n"
+              << "  --json FILE           append one JSON object per mode ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--threads")          cfg.threads = std::max(1ul, std::stoul(value()));
+            else if (arg == "--calls")       cfg.calls = std::max(1ull, std::stoull(value()));
+            else if (arg == "--payload")     cfg.payload = std::min(254ul, std::stoul(value()));
+            else if (arg == "--interval-us") cfg.interval_us = std::stoul(value());
+            else if (arg == "--sink")        cfg.sink = value();
+            else if (arg == "--json")        cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        AsyncLogger::instance().setLevel(LogLevel::Debug);
+        std::vector<Result> results{run(cfg, true), run(cfg, false)};
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
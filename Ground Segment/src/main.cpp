@@ -1,6 +1,11 @@
 #include "gateway.hpp"
+#include "asynclogger.hpp"
+#include <sys/resource.h>
+#include <algorithm>
 #include <iostream>
 #include <csignal>
+#include <cstdlib>
+#include <optional>
 #include <thread>
 
 static std::atomic<bool> running{true};
@@ -10,12 +15,51 @@ void signalHandler(int) {
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <tcp_port> <uart_device>\n";
+    // "-c <file>" takes the place of <uart_device>.
+    const bool use_config = argc >= 3 && std::string(argv[2]) == "-c";
+    const int  base_args  = use_config ? 4 : 3;
+
+    if (argc != base_args && argc != base_args + 1) {
+        std::cerr << "Usage: " << argv[0] << " <tcp_port> <uart_device> [worker_threads]\n";
+        std::cerr << "       " << argv[0] << " <tcp_port> -c <satellites.conf> [worker_threads]\n";
         std::cerr << "Example: " << argv[0] << " 8080 /dev/ttyUSB0\n";
+        std::cerr << "The config lists one '<id> <device> [baud]' per line.\n";
+        std::cerr << "With worker_threads, packets are handled on a pool "
+                     "(0 = one per core) instead of the socket and UART threads.\n";
+        std::cerr << "worker_threads MIN:MAX sizes the pool with its queue wait "
+                     "(ALTAIR_WORKER_WAIT_MS, default 5; idle ones retire after "
+                     "ALTAIR_WORKER_IDLE_S, default 30).\n";
+        std::cerr << "Set ALTAIR_LOG_LEVEL=debug to dump every client packet.\n";
+        std::cerr << "ALTAIR_UART_CAPTURE=FILE records all UART traffic "
+                     "for uart_replay.\n";
+        std::cerr << "ALTAIR_SHM=NAME also publishes every frame to /dev/shm/NAME "
+                     "for local readers.\n";
+        std::cerr << "ALTAIR_STATE_SHM=NAME publishes each satellite's last known "
+                     "state to /dev/shm/NAME (see sat_state).\n";
+        std::cerr << "ALTAIR_MULTICAST=GROUP[:PORT] also sends every frame to a "
+                     "multicast group (ALTAIR_MULTICAST_IF=ADDR picks the interface).\n";
+        std::cerr << "ALTAIR_JOURNAL=DIR journals every frame for client replays "
+                     "(ALTAIR_JOURNAL_MAX_MB and ALTAIR_JOURNAL_MAX_HOURS set retention).\n";
+        std::cerr << "ALTAIR_UPLINK_SHARE=PCT and ALTAIR_CLIENT_SHARE=PCT budget client "
+                     "commands: PCT of each link's capacity, PCT of that per client "
+                     "(default 10 and 25).\n";
+        std::cerr << "ALTAIR_DOWNLINK_SHARE=PCT budgets the replies to log requests, "
+                     "charged per requested day (default 100).\n";
+        std::cerr << "ALTAIR_CLIENT_QUEUE_KB=N disconnects a client with more than N KiB "
+                     "of output unread (default 4096).\n";
+        std::cerr << "ALTAIR_METRICS=[ADDR:]PORT serves Prometheus metrics at "
+                     "http://ADDR:PORT/metrics.\n";
+        std::cerr << "ALTAIR_LATENCY_REPORT=SECONDS logs UART-to-client latency per stage "
+                     "that often.\n";
+        std::cerr << "ALTAIR_TCP_SHARDS=N sets the number of accept loops "
+                     "(default one per core).\n";
         return 1;
     }
 
+    if (const char* level = std::getenv("ALTAIR_LOG_LEVEL")) {
+        altair::AsyncLogger::instance().setLevel(altair::parseLogLevel(level));
+    }
+
     try {
         // Set up signal handling for clean shutdown
         // signal(SIGINT, signalHandler);
@@ -23,13 +67,119 @@ int main(int argc, char* argv[]) {
 
         // Parse command line args
         uint16_t port = static_cast<uint16_t>(std::stoi(argv[1]));
-        std::string uart_device = argv[2];
 
-        std::cout << "Starting Gateway on port " << port 
-                  << " with UART device " << uart_device << "\n";
+        std::vector<altair::SatelliteConfig> satellites;
+        if (use_config) {
+            satellites = altair::loadSatelliteConfig(argv[3]);
+        } else {
+            satellites.push_back({0, argv[2], 115200});
+        }
+
+        unsigned shards = 0;
+        if (const char* env = std::getenv("ALTAIR_TCP_SHARDS")) {
+            shards = static_cast<unsigned>(std::stoul(env));
+        }
+
+        // Every client is a descriptor; allow as many as the hard limit does.
+        rlimit files{};
+        if (::getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+            files.rlim_cur = files.rlim_max;
+            ::setrlimit(RLIMIT_NOFILE, &files);
+        }
+
+        auto mode = altair::DispatchMode::Inline;
+        unsigned workers = 0;
+        std::optional<altair::ThreadPool::ElasticConfig> elastic;
+        if (argc == base_args + 1) {
+            mode = altair::DispatchMode::Pool;
+            std::string arg = argv[base_args];
+            auto colon = arg.find(':');
+            if (colon == std::string::npos) {
+                workers = static_cast<unsigned>(std::stoul(arg));
+            } else {
+                elastic.emplace();
+                elastic->min_threads = static_cast<unsigned>(std::stoul(arg.substr(0, colon)));
+                elastic->max_threads = static_cast<unsigned>(std::stoul(arg.substr(colon + 1)));
+                if (const char* ms = std::getenv("ALTAIR_WORKER_WAIT_MS")) {
+                    elastic->target_wait = std::chrono::milliseconds(std::stoul(ms));
+                }
+                if (const char* s = std::getenv("ALTAIR_WORKER_IDLE_S")) {
+                    elastic->idle_timeout = std::chrono::seconds(std::stoul(s));
+                }
+            }
+        }
+
+        std::cout << "Starting Gateway on port " << port << " with "
+                  << satellites.size() << " satellite(s), first on "
+                  << satellites.front().device << "\n";
 
         // Create and start the gateway
-        altair::Gateway gateway(port, uart_device);
+        altair::Gateway gateway(port, std::move(satellites), mode, workers, shards);
+        if (elastic) {
+            gateway.elasticWorkers(*elastic);
+            std::cout << "Workers: " << elastic->min_threads << " to "
+                      << elastic->max_threads << " threads\n";
+        }
+        if (const char* capture = std::getenv("ALTAIR_UART_CAPTURE")) {
+            gateway.recordUart(capture);
+            std::cout << "Recording UART traffic to " << capture << "\n";
+        }
+        if (const char* shm = std::getenv("ALTAIR_SHM")) {
+            gateway.shareFrames(shm);
+            std::cout << "Sharing frames on /dev/shm/" << shm << "\n";
+        }
+        if (const char* group = std::getenv("ALTAIR_MULTICAST")) {
+            altair::MulticastOptions mcast;
+            if (!altair::parseMulticastEndpoint(group, mcast)) {
+                throw std::invalid_argument("ALTAIR_MULTICAST: expected GROUP[:PORT], got "
+                                            + std::string(group));
+            }
+            if (const char* iface = std::getenv("ALTAIR_MULTICAST_IF")) mcast.interface = iface;
+            gateway.multicastFrames(mcast);
+            std::cout << "Multicasting frames to " << mcast.group << ":" << mcast.port << "\n";
+        }
+        if (const char* dir = std::getenv("ALTAIR_JOURNAL")) {
+            altair::JournalOptions journal;
+            if (const char* mb = std::getenv("ALTAIR_JOURNAL_MAX_MB")) {
+                journal.max_bytes = std::stoull(mb) << 20;
+            }
+            if (const char* hours = std::getenv("ALTAIR_JOURNAL_MAX_HOURS")) {
+                journal.max_age = std::chrono::hours(std::stoul(hours));
+            }
+            gateway.journalFrames(dir, journal);
+            std::cout << "Journaling frames to " << dir << "\n";
+        }
+        const char* uplink_share = std::getenv("ALTAIR_UPLINK_SHARE");
+        const char* client_share = std::getenv("ALTAIR_CLIENT_SHARE");
+        const char* downlink_share = std::getenv("ALTAIR_DOWNLINK_SHARE");
+        if (uplink_share || client_share || downlink_share) {
+            altair::AdmissionOptions admission;
+            if (uplink_share) admission.uplink_share = std::stod(uplink_share) / 100;
+            if (client_share) admission.client_share = std::stod(client_share) / 100;
+            if (downlink_share) admission.downlink_share = std::stod(downlink_share) / 100;
+            gateway.limitCommands(admission);
+        }
+        if (const char* kb = std::getenv("ALTAIR_CLIENT_QUEUE_KB")) {
+            gateway.limitClientQueues(std::stoul(kb) * 1024);
+        }
+        if (const char* state = std::getenv("ALTAIR_STATE_SHM")) {
+            gateway.shareState(state);
+            std::cout << "Sharing satellite state on /dev/shm/" << state << "\n";
+        }
+        if (const char* endpoint = std::getenv("ALTAIR_METRICS")) {
+            std::string address;
+            uint16_t metrics_port = 0;
+            if (!altair::parseMetricsEndpoint(endpoint, address, metrics_port)) {
+                throw std::invalid_argument("ALTAIR_METRICS: expected [ADDR:]PORT, got "
+                                            + std::string(endpoint));
+            }
+            gateway.serveMetrics(address, metrics_port);
+            std::cout << "Serving metrics on http://" << address << ":" << metrics_port
+                      << "/metrics\n";
+        }
+        if (const char* seconds = std::getenv("ALTAIR_LATENCY_REPORT")) {
+            gateway.reportLatency(std::chrono::seconds(std::max(1ul, std::stoul(seconds))));
+        }
         gateway.start();
 
         std::cout << "Gateway running. Press Ctrl+C to exit.\n";
@@ -42,6 +192,7 @@ int main(int argc, char* argv[]) {
         std::cout << "\nShutting down...\n";
 
         gateway.stop();
+        altair::AsyncLogger::instance().flush();
         return 0;
     }
     catch (const std::exception& e) {
@@ -0,0 +1,83 @@
+#include "multicast.hpp"
+#include "protocol_defs.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <string>
+
+static std::atomic<bool> running{true};
+
+void signalHandler(int) {
+    running = false;
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [GROUP[:PORT]] [options]\n"
+              << "Listens to the gateway's multicast telemetry (ALTAIR_MULTICAST).\n"
+              << "  --interface ADDR     join on this interface (e.g. 127.0.0.1)\n"
+              << "  --reorder-ms N       how long to wait for a missing frame (default 20)\n"
+              << "  --quiet              print only gaps and the final counters\n"
+              << "Example: " << prog << " 239.255.42.99:8065 --interface 127.0.0.1\n";
+}
+
+int main(int argc, char* argv[]) {
+    altair::MulticastOptions options;
+    std::chrono::milliseconds reorder{20};
+    bool quiet = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if      (arg == "--interface")  options.interface = value();
+            else if (arg == "--reorder-ms") reorder = std::chrono::milliseconds(std::stoul(value()));
+            else if (arg == "--quiet")      quiet = true;
+            else if (arg.rfind("--", 0) == 0 || !altair::parseMulticastEndpoint(arg, options)) {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+
+        altair::MulticastReceiver receiver(options, reorder);
+        receiver.onFrame([quiet](uint8_t sat, uint64_t seq, const altair::Packet& pkt) {
+            if (quiet) return;
+            std::cout << "#" << seq << " [Sat " << int(sat) << "] ";
+            if (pkt.packetId == altair::PROTO_PKT_SAMPLE || pkt.packetId == altair::PROTO_PKT_KEEP_ALIVE
+                || pkt.packetId == altair::PROTO_PKT_EVENT) {
+                std::string text(pkt.payload.begin(), pkt.payload.end());
+                while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+                std::cout << text << "\n";
+            } else {
+                std::cout << "packet 0x" << std::hex << int(pkt.packetId) << std::dec
+                          << ", " << pkt.payload.size() << " bytes\n";
+            }
+        });
+        receiver.onGap([](uint64_t first, uint64_t count) {
+            std::cout << "GAP: " << count << " frame(s) missing from #" << first << "\n";
+        });
+
+        std::cout << "Listening on " << options.group << ":" << options.port << "\n" << std::flush;
+        while (running) {
+            receiver.poll(std::chrono::milliseconds(200));
+        }
+
+        const auto& s = receiver.stats();
+        std::cout << "\nReceived " << s.received << ", delivered " << s.delivered
+                  << ", lost " << s.lost << ", reordered " << s.reordered
+                  << ", late " << s.late << ", malformed " << s.malformed
+                  << ", sessions " << s.sessions << "\n";
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,207 @@
+#include "metrics.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+
+namespace altair {
+
+namespace {
+
+const char* typeName(bool counter, bool histogram) {
+    return histogram ? "histogram" : counter ? "counter" : "gauge";
+}
+
+std::string number(double v) {
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.15g", v);
+    return std::string(buf, n > 0 ? size_t(n) : 0);
+}
+
+/// Escapes a HELP text (escape_quote false) or a label value.
+void appendEscaped(std::string& out, const std::string& text, bool escape_quote) {
+    for (char c : text) {
+        if (c == '\\')                       out += "\\\\";
+        else if (c == '\n')                  out += "\\n";
+        else if (c == '"' && escape_quote)   out += "\\\"";
+        else                                 out += c;
+    }
+}
+
+/// {a="1",b="2"}, with extra (le="...") last; nothing if both are empty.
+void appendLabels(std::string& out, const MetricLabels& labels,
+                  const std::pair<std::string, std::string>* extra = nullptr) {
+    if (labels.empty() && !extra) return;
+    out += '{';
+    bool first = true;
+    auto add = [&](const std::pair<std::string, std::string>& label) {
+        if (!first) out += ',';
+        first = false;
+        out += label.first;
+        out += "=\"";
+        appendEscaped(out, label.second, true);
+        out += '"';
+    };
+    for (const auto& label : labels) add(label);
+    if (extra) add(*extra);
+    out += '}';
+}
+
+} // namespace
+
+void Histogram::snapshot(std::vector<uint64_t>& buckets, uint64_t& sum) const {
+    buckets.assign(bounds_.size() + 1, 0);
+    sum = 0;
+    for (size_t shard = 0; shard < kMetricShards; ++shard) {
+        const size_t base = shard * lines_per_shard_ * kPerLine;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            buckets[i] += cell(base + i).load(std::memory_order_relaxed);
+        }
+        sum += cell(base + bounds_.size() + 1).load(std::memory_order_relaxed);
+    }
+}
+
+// ------------------------------------------------------------------------
+// MetricsRegistry
+// ------------------------------------------------------------------------
+
+MetricsRegistry::Series& MetricsRegistry::series(const std::string& name,
+                                                 const std::string& help, Type type,
+                                                 const MetricLabels& labels) {
+    Family* family = nullptr;
+    for (auto& f : families_) {
+        if (f->name == name) family = f.get();
+    }
+    if (!family) {
+        families_.push_back(std::make_unique<Family>(Family{name, help, type, {}}));
+        family = families_.back().get();
+    } else if (family->type != type) {
+        throw std::invalid_argument("Metric " + name + " is already registered as a "
+                                    + typeName(family->type == Type::Counter,
+                                               family->type == Type::Histogram));
+    }
+
+    for (auto& s : family->series) {
+        if (s->labels == labels) return *s;
+    }
+    family->series.push_back(std::make_unique<Series>());
+    family->series.back()->labels = labels;
+    return *family->series.back();
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help,
+                                  const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Counter, labels);
+    if (!s.counter && !s.fn) s.counter = std::make_unique<Counter>();
+    if (!s.counter) throw std::invalid_argument("Metric " + name + " is a callback");
+    return *s.counter;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help,
+                              const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Gauge, labels);
+    if (!s.gauge && !s.fn) s.gauge = std::make_unique<Gauge>();
+    if (!s.gauge) throw std::invalid_argument("Metric " + name + " is a callback");
+    return *s.gauge;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help,
+                                      std::vector<uint64_t> bounds, double scale,
+                                      const MetricLabels& labels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Histogram, labels);
+    if (!s.histogram) {
+        s.histogram = std::make_unique<Histogram>(std::move(bounds));
+        s.scale     = scale;
+    }
+    return *s.histogram;
+}
+
+void MetricsRegistry::counterFn(const std::string& name, const std::string& help,
+                                const MetricLabels& labels, ValueFn fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Counter, labels);
+    if (s.counter) throw std::invalid_argument("Metric " + name + " is not a callback");
+    s.fn = std::move(fn);
+}
+
+void MetricsRegistry::gaugeFn(const std::string& name, const std::string& help,
+                              const MetricLabels& labels, ValueFn fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series& s = series(name, help, Type::Gauge, labels);
+    if (s.gauge) throw std::invalid_argument("Metric " + name + " is not a callback");
+    s.fn = std::move(fn);
+}
+
+std::string MetricsRegistry::render() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out;
+    std::vector<uint64_t> buckets;
+
+    for (const auto& family : families_) {
+        out += "# HELP " + family->name + ' ';
+        appendEscaped(out, family->help, false);
+        out += "\n# TYPE " + family->name + ' '
+             + typeName(family->type == Type::Counter, family->type == Type::Histogram) + '\n';
+
+        for (const auto& s : family->series) {
+            if (family->type != Type::Histogram) {
+                out += family->name;
+                appendLabels(out, s->labels);
+                out += ' ';
+                out += s->fn      ? number(s->fn())
+                     : s->counter ? std::to_string(s->counter->value())
+                     :              std::to_string(s->gauge->value());
+                out += '\n';
+                continue;
+            }
+
+            uint64_t sum = 0;
+            s->histogram->snapshot(buckets, sum);
+            const auto& bounds = s->histogram->bounds();
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                cumulative += buckets[i];
+                std::pair<std::string, std::string> le{
+                    "le", i < bounds.size() ? number(double(bounds[i]) * s->scale) : "+Inf"};
+                out += family->name + "_bucket";
+                appendLabels(out, s->labels, &le);
+                out += ' ' + std::to_string(cumulative) + '\n';
+            }
+            out += family->name + "_sum";
+            appendLabels(out, s->labels);
+            out += ' ' + number(double(sum) * s->scale) + '\n';
+            out += family->name + "_count";
+            appendLabels(out, s->labels);
+            out += ' ' + std::to_string(cumulative) + '\n';
+        }
+    }
+    return out;
+}
+
+// ------------------------------------------------------------------------
+// LinkMetrics
+// ------------------------------------------------------------------------
+
+LinkMetrics LinkMetrics::registerIn(MetricsRegistry& registry, const std::string& source) {
+    const MetricLabels labels{{"source", source}};
+    LinkMetrics m;
+    m.frames_in       = &registry.counter("altair_frames_in_total",
+                                          "Frames decoded from the source.", labels);
+    m.bytes_in        = &registry.counter("altair_bytes_in_total",
+                                          "Bytes read from the source.", labels);
+    m.frames_out      = &registry.counter("altair_frames_out_total",
+                                          "Frames written to the source.", labels);
+    m.bytes_out       = &registry.counter("altair_bytes_out_total",
+                                          "Bytes written to the source.", labels);
+    m.checksum_errors = &registry.counter("altair_checksum_errors_total",
+                                          "Corrupt frames (bad checksum, end byte or length) "
+                                          "from the source.", labels);
+    m.resync_bytes    = &registry.counter("altair_resync_bytes_total",
+                                          "Bytes from the source skipped to find the next "
+                                          "frame.", labels);
+    return m;
+}
+
+} // namespace altair
@@ -0,0 +1,262 @@
+// Cost of recording a metric on the hot path.
+//
+// Every thread records into the same metric in a tight loop, as the
+// shard and UART threads do per frame:
+//
+//   counter    Counter::add, one relaxed add on the thread's own cell
+//   shared     one std::atomic fetch_add shared by all threads, what an
+//              unsharded counter costs
+//   gauge      Gauge::set
+//   histogram  Histogram::observe over the gateway's handler buckets
+//   timer      ScopedTimer: two clock reads and an observe
+//
+// All threads start together. Runs are repeated, interleaving the
+// operations, and the table shows the median CPU time per operation. The
+// exit status is 2 if any sharded operation is over --budget-ns.
+
+#include "metrics.hpp"
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    std::vector<std::string> ops{"counter", "shared", "gauge", "histogram", "timer"};
+    std::vector<unsigned>    threads{1, 4};
+    uint64_t                 count{10000000};  // per thread
+    unsigned                 repeat{5};
+    double                   budget_ns{100};
+    std::string              json_path;
+};
+
+struct Result {
+    std::string op;
+    unsigned    threads{0};
+    uint64_t    ops{0};
+    double      seconds{0};
+    double      cpu_ns_per_op{0};
+};
+
+double threadCpuNs() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/// Fresh metrics per run, so no run starts with warm cells.
+struct Targets {
+    Counter                 counter;
+    alignas(64) std::atomic<uint64_t> shared{0};
+    Gauge                   gauge;
+    Histogram               histogram{{250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+                                       250000, 500000, 1000000, 2500000, 10000000, 100000000}};
+};
+
+/// One thread's loop; returns its CPU time in ns.
+double record(const std::string& op, Targets& t, uint64_t count) {
+    double start = threadCpuNs();
+    if (op == "counter") {
+        for (uint64_t i = 0; i < count; ++i) t.counter.add();
+    } else if (op == "shared") {
+        for (uint64_t i = 0; i < count; ++i) t.shared.fetch_add(1, std::memory_order_relaxed);
+    } else if (op == "gauge") {
+        for (uint64_t i = 0; i < count; ++i) t.gauge.set(int64_t(i));
+    } else if (op == "histogram") {
+        // Spread over the buckets like handler times: mostly short.
+        for (uint64_t i = 0; i < count; ++i) t.histogram.observe((i * 2654435761u) % 40000);
+    } else if (op == "timer") {
+        for (uint64_t i = 0; i < count; ++i) ScopedTimer timer(t.histogram);
+    } else {
+        throw std::invalid_argument("Unknown operation " + op);
+    }
+    return threadCpuNs() - start;
+}
+
+/// True if every recorded operation is accounted for.
+bool complete(const std::string& op, const Targets& t, uint64_t total) {
+    if (op == "counter") return t.counter.value() == total;
+    if (op == "shared")  return t.shared.load() == total;
+    if (op == "histogram" || op == "timer") {
+        std::vector<uint64_t> buckets;
+        uint64_t sum = 0;
+        t.histogram.snapshot(buckets, sum);
+        uint64_t n = 0;
+        for (uint64_t b : buckets) n += b;
+        return n == total;
+    }
+    return true;
+}
+
+Result run(const BenchConfig& cfg, const std::string& op, unsigned threads) {
+    auto targets = std::make_unique<Targets>();
+
+    std::mutex              mutex;
+    std::condition_variable go_cv;
+    bool                    go = false;
+    std::vector<double>     cpu_ns(threads);
+    std::vector<std::thread> workers;
+
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                go_cv.wait(lock, [&]() { return go; });
+            }
+            cpu_ns[t] = record(op, *targets, cfg.count);
+        });
+    }
+
+    auto start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        go = true;
+    }
+    go_cv.notify_all();
+    for (auto& w : workers) w.join();
+
+    Result r;
+    r.op      = op;
+    r.threads = threads;
+    r.ops     = cfg.count * threads;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double total_cpu = 0;
+    for (double ns : cpu_ns) total_cpu += ns;
+    r.cpu_ns_per_op = total_cpu / r.ops;
+    if (!complete(op, *targets, r.ops)) std::cerr << op << ": operations lost\n";
+    return r;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(11) << "op" << std::right
+              << std::setw(9) << "threads" << std::setw(14) << "ops"
+              << std::setw(12) << "Mops/s" << std::setw(12) << "cpu ns/op" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(11) << r.op << std::right << std::fixed
+                  << std::setw(9) << r.threads << std::setw(14) << r.ops
+                  << std::setprecision(1) << std::setw(12) << r.ops / r.seconds / 1e6
+                  << std::setprecision(1) << std::setw(12) << r.cpu_ns_per_op << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"op\":\"" << r.op << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"threads\":" << r.threads
+       << ",\"ops\":" << r.ops
+       << ",\"seconds\":" << r.seconds
+       << ",\"ops_per_s\":" << r.ops / r.seconds
+       << ",\"cpu_ns_per_op\":" << r.cpu_ns_per_op << "}\n";
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::istringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) items.push_back(item);
+    return items;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --ops LIST            counter,shared,gauge,histogram,timer (default all)\n"
+              << "  --threads LIST        comma-separated thread counts (default 1,4)\n"
+              << "  --count N             operations per thread (default 10000000)\n"
+              << "  --repeat N            runs per operation and thread count (default 5)\n"
+              << "  --budget-ns NS        fail if a sharded operation costs more (default 100)\n"
+              << "  --json FILE           append one JSON object per run ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--ops") cfg.ops = splitList(value());
+            else if (arg == "--threads") {
+                cfg.threads.clear();
+                for (const auto& item : splitList(value())) cfg.threads.push_back(std::stoul(item));
+            }
+            else if (arg == "--count")     cfg.count = std::stoull(value());
+            else if (arg == "--repeat")    cfg.repeat = std::max(1ul, std::stoul(value()));
+            else if (arg == "--budget-ns") cfg.budget_ns = std::stod(value());
+            else if (arg == "--json")      cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        // runs[t * ops + o] holds the repeats of op o at thread count t.
+        const size_t n_ops = cfg.ops.size();
+        std::vector<std::vector<Result>> runs(cfg.threads.size() * n_ops);
+        for (unsigned rep = 0; rep < cfg.repeat; ++rep) {
+            for (size_t t = 0; t < cfg.threads.size(); ++t) {
+                for (size_t o = 0; o < n_ops; ++o) {
+                    runs[t * n_ops + o].push_back(run(cfg, cfg.ops[o], cfg.threads[t]));
+                }
+            }
+        }
+
+        std::vector<Result> results;
+        for (auto& samples : runs) {
+            std::sort(samples.begin(), samples.end(), [](const Result& a, const Result& b) {
+                return a.cpu_ns_per_op < b.cpu_ns_per_op;
+            });
+            results.push_back(samples[samples.size() / 2]);
+        }
+
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, r);
+        }
+
+        // The shared atomic is the reference, not a recording path.
+        const Result* worst = nullptr;
+        for (const auto& r : results) {
+            if (r.op == "shared") continue;
+            if (!worst || r.cpu_ns_per_op > worst->cpu_ns_per_op) worst = &r;
+        }
+        if (worst && worst->cpu_ns_per_op > cfg.budget_ns) {
+            std::cout << "Over budget: " << worst->op << " with " << worst->threads
+                      << " threads costs " << worst->cpu_ns_per_op << " ns (budget "
+                      << cfg.budget_ns << " ns)\n";
+            return 2;
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,163 @@
+#include "metrics_server.hpp"
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace altair {
+
+namespace {
+
+/// Longest request head read; scrapers send far less.
+constexpr size_t kMaxRequest = 4096;
+
+void sendAll(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        done += static_cast<size_t>(n);
+    }
+}
+
+std::string response(const char* status, const char* type, const std::string& body) {
+    return std::string("HTTP/1.0 ") + status + "\r\n"
+         + "Content-Type: " + type + "\r\n"
+         + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+         + "Connection: close\r\n\r\n" + body;
+}
+
+} // namespace
+
+bool parseMetricsEndpoint(const std::string& text, std::string& address, uint16_t& port) {
+    auto colon = text.rfind(':');
+    std::string host = colon == std::string::npos ? "0.0.0.0" : text.substr(0, colon);
+    std::string digits = colon == std::string::npos ? text : text.substr(colon + 1);
+
+    in_addr addr{};
+    if (::inet_pton(AF_INET, host.c_str(), &addr) != 1) return false;
+    if (digits.empty() || digits.size() > 5
+        || digits.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long value = std::stoul(digits);
+    if (value > 65535) return false;
+
+    address = host;
+    port    = static_cast<uint16_t>(value);
+    return true;
+}
+
+MetricsServer::MetricsServer(const MetricsRegistry& registry, std::string address,
+                             uint16_t port)
+    : registry_(registry), address_(std::move(address)), port_(port)
+{}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start() {
+    if (running_) return;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port_);
+    if (::inet_pton(AF_INET, address_.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error("MetricsServer: bad address " + address_);
+    }
+
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("MetricsServer: socket failed: ") + strerror(errno));
+    }
+    int opt = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, 16) < 0) {
+        std::string error = strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("MetricsServer: cannot listen on " + address_ + ":"
+                                 + std::to_string(port_) + ": " + error);
+    }
+
+    socklen_t len = sizeof(addr);
+    if (::getsockname(fd, (sockaddr*)&addr, &len) == 0) port_ = ntohs(addr.sin_port);
+
+    listen_fd_ = fd;
+    running_   = true;
+    loop_.watch(listen_fd_, EPOLLIN, [this](uint32_t) { acceptPending(); });
+    thread_ = std::thread([this]() { loop_.run(); });
+}
+
+void MetricsServer::stop() {
+    if (!running_.exchange(false)) return;
+
+    loop_.stop();
+    if (thread_.joinable()) thread_.join();
+    ::close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void MetricsServer::acceptPending() {
+    while (running_) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0) {
+            serve(fd);
+            continue;
+        }
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            std::cerr << "MetricsServer accept error: " << strerror(errno) << "\n";
+        }
+        return;
+    }
+}
+
+void MetricsServer::serve(int fd) {
+    // Blocking, with timeouts: a scrape is one short request, and a
+    // client that stalls only delays the next scrape.
+    timeval timeout{1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos
+           && request.find("\n\n") == std::string::npos && request.size() < kMaxRequest) {
+        ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        request.append(buf, static_cast<size_t>(n));
+    }
+
+    // "GET /metrics HTTP/1.1"; a query string is ignored.
+    std::string line = request.substr(0, request.find_first_of("\r\n"));
+    auto sp1 = line.find(' ');
+    auto sp2 = line.find(' ', sp1 == std::string::npos ? sp1 : sp1 + 1);
+    std::string method = line.substr(0, sp1);
+    std::string path   = sp1 == std::string::npos ? "" : line.substr(sp1 + 1, sp2 - sp1 - 1);
+    path = path.substr(0, path.find('?'));
+
+    if (method != "GET" && method != "HEAD") {
+        sendAll(fd, response("405 Method Not Allowed", "text/plain", "GET /metrics\n"));
+    } else if (path != "/metrics") {
+        sendAll(fd, response("404 Not Found", "text/plain", "GET /metrics\n"));
+    } else {
+        std::string reply = response("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                                     registry_.render());
+        if (method == "HEAD") reply.resize(reply.find("\r\n\r\n") + 4);
+        sendAll(fd, reply);
+    }
+    ::close(fd);
+}
+
+} // namespace altair
@@ -0,0 +1,373 @@
+#include "multicast.hpp"
+#include "protocol.hpp"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <endian.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+namespace altair {
+
+namespace {
+
+/// Datagrams per sendmmsg()/recvmmsg() call.
+constexpr size_t kMaxBatch = 64;
+
+in_addr toAddress(const std::string& text, const char* what) {
+    in_addr addr{};
+    if (::inet_pton(AF_INET, text.c_str(), &addr) != 1) {
+        throw std::runtime_error(std::string("Invalid ") + what + " address " + text);
+    }
+    return addr;
+}
+
+} // namespace
+
+bool parseMulticastEndpoint(const std::string& text, MulticastOptions& options) {
+    auto colon = text.rfind(':');
+    std::string group = text.substr(0, colon);
+    in_addr addr{};
+    if (::inet_pton(AF_INET, group.c_str(), &addr) != 1 || !IN_MULTICAST(ntohl(addr.s_addr))) {
+        return false;
+    }
+    if (colon != std::string::npos) {
+        try {
+            unsigned long port = std::stoul(text.substr(colon + 1));
+            if (port == 0 || port > 65535) return false;
+            options.port = static_cast<uint16_t>(port);
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+    options.group = group;
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Publisher
+// ------------------------------------------------------------------------
+
+MulticastPublisher::MulticastPublisher(MulticastOptions options)
+    : options_(std::move(options))
+    , session_(std::random_device{}())
+{
+    sockaddr_in group{};
+    group.sin_family = AF_INET;
+    group.sin_port   = htons(options_.port);
+    group.sin_addr   = toAddress(options_.group, "multicast group");
+
+    fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        throw std::runtime_error(std::string("Multicast socket failed: ") + strerror(errno));
+    }
+
+    unsigned char ttl  = options_.ttl;
+    unsigned char loop = 1;
+    ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    ::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    if (!options_.interface.empty()) {
+        in_addr iface = toAddress(options_.interface, "interface");
+        if (::setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Cannot send multicast on " + options_.interface + ": "
+                                     + strerror(errno));
+        }
+    }
+
+    // Connected, so every datagram in a batch needs no address of its own.
+    if (::connect(fd_, reinterpret_cast<sockaddr*>(&group), sizeof(group)) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot reach multicast group " + options_.group + ": "
+                                 + strerror(errno));
+    }
+
+    queue_.reserve(kMaxBatch);
+    sender_ = std::thread(&MulticastPublisher::senderLoop, this);
+}
+
+MulticastPublisher::~MulticastPublisher() {
+    close();
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool MulticastPublisher::publish(uint8_t sat, const uint8_t* frame, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_) return false;
+
+    uint64_t seq = next_seq_++;
+    if (len > kMulticastMaxFrame || queue_.size() >= options_.max_queue) {
+        ++dropped_;
+        return false;
+    }
+
+    Datagram& d = queue_.emplace_back();
+    const uint32_t session = htobe32(session_);
+    const uint64_t seq_be  = htobe64(seq);
+    d.bytes[0] = 'A';
+    d.bytes[1] = 'M';
+    d.bytes[2] = kMulticastVersion;
+    d.bytes[3] = sat;
+    std::memcpy(&d.bytes[4], &session, sizeof(session));
+    std::memcpy(&d.bytes[8], &seq_be, sizeof(seq_be));
+    std::memcpy(&d.bytes[kMulticastHeaderSize], frame, len);
+    d.size = static_cast<uint16_t>(kMulticastHeaderSize + len);
+
+    if (queue_.size() == 1) cv_.notify_one();
+    return true;
+}
+
+void MulticastPublisher::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closing_) return;
+        closing_ = true;
+    }
+    cv_.notify_one();
+    if (sender_.joinable()) sender_.join();
+}
+
+uint64_t MulticastPublisher::sent() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sent_;
+}
+
+uint64_t MulticastPublisher::dropped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+uint64_t MulticastPublisher::batches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+}
+
+void MulticastPublisher::senderLoop() {
+    std::vector<Datagram> batch;
+    batch.reserve(kMaxBatch);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cv_.wait(lock, [&] { return closing_ || !queue_.empty(); });
+        if (queue_.empty()) return;     // closing with nothing left
+
+        // Swap under the lock, send without it.
+        batch.swap(queue_);
+        lock.unlock();
+        sendBatch(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+void MulticastPublisher::sendBatch(const std::vector<Datagram>& batch) {
+    mmsghdr msgs[kMaxBatch];
+    iovec   iovs[kMaxBatch];
+    uint64_t sent = 0, calls = 0, failed = 0;
+
+    for (size_t start = 0; start < batch.size(); ) {
+        const size_t n = std::min(kMaxBatch, batch.size() - start);
+        for (size_t i = 0; i < n; ++i) {
+            const Datagram& d = batch[start + i];
+            iovs[i].iov_base = const_cast<uint8_t*>(d.bytes.data());
+            iovs[i].iov_len  = d.size;
+            msgs[i] = mmsghdr{};
+            msgs[i].msg_hdr.msg_iov    = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int r = ::sendmmsg(fd_, msgs, static_cast<unsigned>(n), 0);
+        ++calls;
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            // ENOBUFS and friends: this datagram is lost, receivers see a gap.
+            ++failed;
+            ++start;
+            continue;
+        }
+        sent  += static_cast<uint64_t>(r);
+        start += static_cast<size_t>(r);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    sent_    += sent;
+    batches_ += calls;
+    dropped_ += failed;
+}
+
+// ------------------------------------------------------------------------
+// Receiver
+// ------------------------------------------------------------------------
+
+MulticastReceiver::MulticastReceiver(const MulticastOptions& options,
+                                     std::chrono::milliseconds reorder_timeout,
+                                     size_t reorder_window)
+    : reorder_timeout_(reorder_timeout)
+    , reorder_window_(std::max<size_t>(reorder_window, 1))
+{
+    ip_mreq membership{};
+    membership.imr_multiaddr = toAddress(options.group, "multicast group");
+    membership.imr_interface.s_addr = options.interface.empty()
+        ? htonl(INADDR_ANY) : toAddress(options.interface, "interface").s_addr;
+
+    fd_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd_ < 0) {
+        throw std::runtime_error(std::string("Multicast socket failed: ") + strerror(errno));
+    }
+
+    // Several listeners may share the group on one host.
+    int one = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    int rcvbuf = 4 << 20;
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    // Bound to the group address, so other traffic to the port is not seen.
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(options.port);
+    addr.sin_addr   = membership.imr_multiaddr;
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || ::setsockopt(fd_, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+        std::string err = strerror(errno);
+        ::close(fd_);
+        throw std::runtime_error("Cannot join " + options.group + ":"
+                                 + std::to_string(options.port) + ": " + err);
+    }
+}
+
+MulticastReceiver::~MulticastReceiver() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+size_t MulticastReceiver::poll(std::chrono::milliseconds timeout) {
+    // Wake in time to release frames held for a missing one.
+    if (!held_.empty()) {
+        auto due = held_.begin()->second.arrived + reorder_timeout_;
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now())
+                  + std::chrono::milliseconds(1);
+        timeout = std::max(std::chrono::milliseconds(0), std::min(timeout, left));
+    }
+
+    pollfd pfd{fd_, POLLIN, 0};
+    ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+    return drain();
+}
+
+size_t MulticastReceiver::drain() {
+    delivered_now_ = 0;
+
+    uint8_t  buffers[kMaxBatch][kMulticastHeaderSize + kMulticastMaxFrame];
+    iovec    iovs[kMaxBatch];
+    mmsghdr  msgs[kMaxBatch];
+    for (;;) {
+        for (size_t i = 0; i < kMaxBatch; ++i) {
+            iovs[i] = {buffers[i], sizeof(buffers[i])};
+            msgs[i] = mmsghdr{};
+            msgs[i].msg_hdr.msg_iov    = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n = ::recvmmsg(fd_, msgs, kMaxBatch, MSG_DONTWAIT, nullptr);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+
+        auto now = Clock::now();
+        for (int i = 0; i < n; ++i) {
+            handleDatagram(buffers[i], msgs[i].msg_len, now);
+        }
+        if (n < static_cast<int>(kMaxBatch)) break;
+    }
+
+    size_t delivered = delivered_now_;
+    return delivered + expire();
+}
+
+size_t MulticastReceiver::expire() {
+    delivered_now_ = 0;
+    auto now = Clock::now();
+    while (!held_.empty()
+           && (held_.begin()->second.arrived + reorder_timeout_ <= now
+               || held_.size() >= reorder_window_)) {
+        // Give up on what is missing before the oldest held frame.
+        uint64_t next = held_.begin()->first;
+        stats_.lost += next - expected_;
+        if (gap_cb_) gap_cb_(expected_, next - expected_);
+        expected_ = next;
+        deliverInOrder();
+    }
+    return delivered_now_;
+}
+
+void MulticastReceiver::handleDatagram(const uint8_t* data, size_t len, Clock::time_point now) {
+    ++stats_.received;
+    if (len < kMulticastHeaderSize || data[0] != 'A' || data[1] != 'M'
+        || data[2] != kMulticastVersion) {
+        ++stats_.malformed;
+        return;
+    }
+
+    uint32_t session;
+    uint64_t seq;
+    std::memcpy(&session, data + 4, sizeof(session));
+    std::memcpy(&seq, data + 8, sizeof(seq));
+    session = be32toh(session);
+    seq     = be64toh(seq);
+
+    auto pkt = Protocol::unpack(data + kMulticastHeaderSize,
+                                static_cast<uint16_t>(len - kMulticastHeaderSize));
+    if (!pkt) {
+        ++stats_.malformed;
+        return;
+    }
+
+    if (!synced_ || session != session_) {
+        // First datagram, or the publisher restarted: start from here.
+        synced_   = true;
+        session_  = session;
+        expected_ = seq;
+        held_.clear();
+        ++stats_.sessions;
+    }
+
+    if (seq < expected_ || held_.count(seq)) {
+        ++stats_.late;
+        return;
+    }
+
+    if (seq == expected_) {
+        deliver(data[3], seq, *pkt);
+        ++expected_;
+        deliverInOrder();
+        return;
+    }
+
+    ++stats_.reordered;
+    held_.emplace(seq, Held{data[3], std::move(*pkt), now});
+}
+
+size_t MulticastReceiver::deliverInOrder() {
+    size_t n = 0;
+    for (auto it = held_.begin(); it != held_.end() && it->first == expected_;
+         it = held_.erase(it)) {
+        deliver(it->second.sat, it->first, it->second.packet);
+        ++expected_;
+        ++n;
+    }
+    return n;
+}
+
+void MulticastReceiver::deliver(uint8_t sat, uint64_t seq, const Packet& pkt) {
+    ++stats_.delivered;
+    ++delivered_now_;
+    if (frame_cb_) frame_cb_(sat, seq, pkt);
+}
+
+} // namespace altair
@@ -0,0 +1,84 @@
+#include "satsim.hpp"
+#include <atomic>
+#include <csignal>
+#include <iostream>
+#include <thread>
+
+static std::atomic<bool> running{true};
+
+void signalHandler(int) {
+    running = false;
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --link PATH          symlink the pty slave to PATH (e.g. /tmp/ttyALTAIR)\n"
+              << "  --beacon-ms N        keep-alive period (default 6000, BEACON_MS)\n"
+              << "  --rate N             synthetic samples per second (default 1)\n"
+              << "  --stream             also transmit every sample as it is generated\n"
+              << "  --event-rate N       synthetic mode-change events per second (default 0)\n"
+              << "  --baud N             emulate the wire time of N baud 8N1 (default off)\n"
+              << "  --no-wait-sync       start without waiting for TIME_SYNC\n"
+              << "  --history-days N     days on the synthetic SD card (default 7)\n"
+              << "  --history-samples N  samples per history day (default 1440)\n"
+              << "  --seed N             random seed (default 1)\n"
+              << "Example: " << prog << " --link /tmp/ttyALTAIR --rate 1000 --stream --baud 115200\n";
+}
+
+int main(int argc, char* argv[]) {
+    altair::SatSimOptions options;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if      (arg == "--link")            options.link_path = value();
+            else if (arg == "--beacon-ms")       options.beacon_interval = std::chrono::milliseconds(std::stoul(value()));
+            else if (arg == "--rate")            options.sample_rate = std::stod(value());
+            else if (arg == "--stream")          options.stream_samples = true;
+            else if (arg == "--event-rate")      options.event_rate = std::stod(value());
+            else if (arg == "--baud")            options.baud_rate = std::stoul(value());
+            else if (arg == "--no-wait-sync")    options.wait_for_time_sync = false;
+            else if (arg == "--history-days")    options.history_days = std::stoul(value());
+            else if (arg == "--history-samples") options.history_samples_per_day = std::stoul(value());
+            else if (arg == "--seed")            options.seed = std::stoul(value());
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+
+        altair::NanoSatSimulator sim(options);
+        std::cout << "NanoSat simulator on " << sim.devicePath();
+        if (!options.link_path.empty()) std::cout << " (" << options.link_path << ")";
+        std::cout << "\n" << (options.wait_for_time_sync ? "Waiting for TIME_SYNC.\n"
+                                                         : "Running.\n")
+                  << std::flush;
+
+        std::thread loop([&sim]() { sim.run(); });
+        while (running) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        sim.stop();
+        loop.join();
+
+        auto s = sim.stats();
+        std::cout << "\nFrames out: " << s.frames_out << " (" << s.bytes_out << " bytes)"
+                  << ", frames in: " << s.frames_in
+                  << ", range requests: " << s.range_requests
+                  << ", samples: " << s.samples_generated
+                  << ", dropped: " << s.frames_dropped << "\n";
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
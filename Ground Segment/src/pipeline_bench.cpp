@@ -0,0 +1,326 @@
+// UartPipeline against a thread-per-stage ingest pipeline.
+//
+// A stream of SAMPLE frames is cut into --chunk-bytes reads, as a UART
+// delivers them, and pushed through decode -> frame -> { store, fan out }.
+// Store and fan out each spend --work-ns of busy work per frame.
+//
+//   graph    UartPipeline: the stages as TaskGraph nodes on a ThreadPool
+//            of --threads workers
+//   threads  one thread per stage, handing batches on through blocking
+//            queues
+//
+// Both keep at most --window chunks in flight. Runs are repeated,
+// alternating the designs, and the table shows the median rate and CPU
+// time per frame.
+
+#include "protocol.hpp"
+#include "protocol_defs.hpp"
+#include "uart_pipeline.hpp"
+
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    unsigned    threads{4};
+    uint64_t    chunks{2000};
+    size_t      chunk_bytes{4000};
+    unsigned    work_ns{500};
+    size_t      window{64};
+    unsigned    repeat{3};
+    std::string json_path;
+};
+
+struct Result {
+    std::string design;
+    uint64_t    frames{0};
+    double      seconds{0};
+    double      cpu_ns_per_frame{0};
+};
+
+double processCpuNs() {
+    timespec ts{};
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void spin(unsigned ns) {
+    auto until = Clock::now() + std::chrono::nanoseconds(ns);
+    while (Clock::now() < until) {}
+}
+
+/// The UART reads: a stream of SAMPLE frames cut at fixed sizes, so
+/// frames straddle reads.
+std::vector<std::vector<uint8_t>> makeChunks(const BenchConfig& cfg) {
+    Packet pkt{};
+    pkt.packetId = PROTO_PKT_SAMPLE;
+    const std::string line = "2025-04-20 12:00:00 T=21.5 H=40.2 L=512 V=3.30";
+    pkt.payload.assign(line.begin(), line.end());
+    auto frame = Protocol::pack(pkt);
+
+    std::vector<std::vector<uint8_t>> chunks(cfg.chunks);
+    size_t at = 0;
+    for (auto& chunk : chunks) {
+        chunk.reserve(cfg.chunk_bytes);
+        while (chunk.size() < cfg.chunk_bytes) {
+            chunk.push_back(frame[at]);
+            at = (at + 1) % frame.size();
+        }
+    }
+    return chunks;
+}
+
+/// Blocking hand-off between two stage threads; nullptr ends the stream.
+class BatchQueue {
+public:
+    void push(std::shared_ptr<UartFrameBatch> batch) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            items_.push_back(std::move(batch));
+        }
+        cv_.notify_one();
+    }
+
+    std::shared_ptr<UartFrameBatch> pop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !items_.empty(); });
+        auto batch = std::move(items_.front());
+        items_.pop_front();
+        return batch;
+    }
+
+private:
+    std::mutex                                  mutex_;
+    std::condition_variable                     cv_;
+    std::deque<std::shared_ptr<UartFrameBatch>> items_;
+};
+
+/// Counts finished chunks, letting the feeder wait for room in the window.
+class Window {
+public:
+    void finished() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++done_;
+        }
+        cv_.notify_one();
+    }
+
+    void waitFor(uint64_t done) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&]() { return done_ >= done; });
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    uint64_t                done_{0};
+};
+
+uint64_t runGraph(const BenchConfig& cfg, const std::vector<std::vector<uint8_t>>& chunks) {
+    std::atomic<uint64_t> stored{0};
+    std::atomic<uint64_t> sent{0};
+    ThreadPool::ThreadPool pool(cfg.threads);
+    UartPipeline pipeline(pool,
+        [&](const Packet&) { spin(cfg.work_ns); stored.fetch_add(1, std::memory_order_relaxed); },
+        [&](const std::vector<uint8_t>&) { spin(cfg.work_ns); sent.fetch_add(1, std::memory_order_relaxed); });
+
+    std::deque<ThreadPool::Future<void>> in_flight;
+    for (const auto& chunk : chunks) {
+        if (in_flight.size() >= cfg.window) {
+            in_flight.front().wait();
+            in_flight.pop_front();
+        }
+        in_flight.push_back(pipeline.push(chunk));
+    }
+    for (auto& f : in_flight) f.get();
+    if (stored != sent) std::cerr << "graph: stored " << stored << ", sent " << sent << "\n";
+    return sent;
+}
+
+uint64_t runThreads(const BenchConfig& cfg, const std::vector<std::vector<uint8_t>>& chunks) {
+    BatchQueue to_decode, to_frame, to_store, to_fanout;
+    Window     window;
+    uint64_t   stored = 0;
+    uint64_t   sent   = 0;
+    // Store and fan out both finish a chunk; the second one counts it.
+    std::vector<std::atomic<int>> halves(chunks.size());
+
+    std::thread decoder([&]() {
+        FrameDecoder decoder;
+        while (auto batch = to_decode.pop()) {
+            decoder.feed(batch->raw.data(), batch->raw.size());
+            while (auto pkt = decoder.next()) batch->packets.push_back(std::move(*pkt));
+            to_frame.push(std::move(batch));
+        }
+        to_frame.push(nullptr);
+    });
+    std::thread framer([&]() {
+        while (auto batch = to_frame.pop()) {
+            batch->framed.reserve(batch->packets.size());
+            for (const auto& pkt : batch->packets) batch->framed.push_back(Protocol::pack(pkt));
+            to_store.push(batch);
+            to_fanout.push(std::move(batch));
+        }
+        to_store.push(nullptr);
+        to_fanout.push(nullptr);
+    });
+    auto done = [&](size_t index) {
+        if (halves[index].fetch_add(1, std::memory_order_acq_rel) == 1) window.finished();
+    };
+
+    std::thread storer([&]() {
+        size_t index = 0;
+        while (auto batch = to_store.pop()) {
+            for (size_t i = 0; i < batch->packets.size(); ++i) { spin(cfg.work_ns); ++stored; }
+            done(index++);
+        }
+    });
+    std::thread fanouter([&]() {
+        size_t index = 0;
+        while (auto batch = to_fanout.pop()) {
+            for (size_t i = 0; i < batch->framed.size(); ++i) { spin(cfg.work_ns); ++sent; }
+            done(index++);
+        }
+    });
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (i >= cfg.window) window.waitFor(i - cfg.window + 1);
+        auto batch = std::make_shared<UartFrameBatch>();
+        batch->raw = chunks[i];
+        to_decode.push(std::move(batch));
+    }
+    to_decode.push(nullptr);
+    decoder.join();
+    framer.join();
+    storer.join();
+    fanouter.join();
+    if (stored != sent) std::cerr << "threads: stored " << stored << ", sent " << sent << "\n";
+    return sent;
+}
+
+Result run(const BenchConfig& cfg, const std::vector<std::vector<uint8_t>>& chunks, bool graph) {
+    double cpu   = processCpuNs();
+    auto   start = Clock::now();
+    uint64_t frames = graph ? runGraph(cfg, chunks) : runThreads(cfg, chunks);
+
+    Result r;
+    r.design           = graph ? "graph" : "threads";
+    r.frames           = frames;
+    r.seconds          = std::chrono::duration<double>(Clock::now() - start).count();
+    r.cpu_ns_per_frame = (processCpuNs() - cpu) / std::max<uint64_t>(frames, 1);
+    return r;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(9) << "design" << std::right
+              << std::setw(12) << "frames" << std::setw(12) << "Mfr/s"
+              << std::setw(14) << "cpu ns/fr" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(9) << r.design << std::right << std::fixed
+                  << std::setw(12) << r.frames
+                  << std::setprecision(3) << std::setw(12) << r.frames / r.seconds / 1e6
+                  << std::setprecision(1) << std::setw(14) << r.cpu_ns_per_frame << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"design\":\"" << r.design << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"threads\":" << cfg.threads
+       << ",\"chunk_bytes\":" << cfg.chunk_bytes
+       << ",\"work_ns\":" << cfg.work_ns
+       << ",\"window\":" << cfg.window
+       << ",\"frames\":" << r.frames
+       << ",\"seconds\":" << r.seconds
+       << ",\"frames_per_s\":" << r.frames / r.seconds
+       << ",\"cpu_ns_per_frame\":" << r.cpu_ns_per_frame << "}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --threads N           pool workers for graph (default 4)\n"
+              << "  --chunks N            UART reads per run (default 2000)\n"
+              << "  --chunk-bytes N       bytes per read (default 4000)\n"
+              << "  --work-ns N           busy work per frame in store and fan out (default 500)\n"
+              << "  --window N            chunks in flight (default 64)\n"
+              << "  --repeat N            runs per design (default 3)\n"
+              << "  --json FILE           append one JSON object per design ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--threads")          cfg.threads = std::max(1ul, std::stoul(value()));
+            else if (arg == "--chunks")      cfg.chunks = std::stoull(value());
+            else if (arg == "--chunk-bytes") cfg.chunk_bytes = std::max(1ul, std::stoul(value()));
+            else if (arg == "--work-ns")     cfg.work_ns = std::stoul(value());
+            else if (arg == "--window")      cfg.window = std::max(1ul, std::stoul(value()));
+            else if (arg == "--repeat")      cfg.repeat = std::max(1ul, std::stoul(value()));
+            else if (arg == "--json")        cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        const auto chunks = makeChunks(cfg);
+        std::vector<Result> graph, threads;
+        for (unsigned rep = 0; rep < cfg.repeat; ++rep) {
+            graph.push_back(run(cfg, chunks, true));
+            threads.push_back(run(cfg, chunks, false));
+        }
+
+        std::vector<Result> results;
+        for (auto* samples : {&graph, &threads}) {
+            std::sort(samples->begin(), samples->end(), [](const Result& a, const Result& b) {
+                return a.seconds < b.seconds;
+            });
+            results.push_back((*samples)[samples->size() / 2]);
+        }
+
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
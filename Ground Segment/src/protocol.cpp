@@ -1,6 +1,7 @@
 #include "protocol.hpp"
 #include "protocol_defs.hpp"
 
+#include <algorithm>
 #include <iomanip>
 #include <cstring>
 #include <iostream>
@@ -19,31 +20,45 @@ static uint8_t computeChecksum(uint8_t length,
     return cs;
 }
 
-std::vector<uint8_t> Protocol::pack(const Packet& pkt)
+/// Frames pkt into out, which holds frameSize(pkt) bytes. Sizing the
+/// vector first and copying the payload in one go is several times
+/// cheaper than push_back/insert, most of all with a pmr allocator.
+static size_t frameSize(const Packet& pkt)
+{
+    return pkt.payload.size() + 4;  // 1(L) + 1(ID) + payload + 1(CRC) + 1(END)
+}
+
+static void packInto(const Packet& pkt, uint8_t* out)
 {
     const uint8_t payloadLen = static_cast<uint8_t>(pkt.payload.size());
     const uint8_t length     = payloadLen + 1;
 
-    std::vector<uint8_t> out;
-    out.reserve(length + 3);        // 1(L) + length + 1(CRC) + 1(END)
-
-    out.push_back(length);          // [0] Length
-    out.push_back(pkt.packetId);    // [1] Packet‑ID
-    out.insert(out.end(),
-               pkt.payload.begin(),
-               pkt.payload.end());  // [2..] Payload
+    out[0] = length;                // [0] Length
+    out[1] = pkt.packetId;          // [1] Packet‑ID
+    if (payloadLen) {               // [2..] Payload
+        std::memcpy(out + 2, pkt.payload.data(), payloadLen);
+    }
+    out[2 + payloadLen] = computeChecksum(length, pkt.packetId,
+                                          out + 2, payloadLen);    // CRC
+    out[3 + payloadLen] = Packet::END_BYTE;
+}
 
-    uint8_t crc = computeChecksum(length,
-                                  pkt.packetId,
-                                  out.data() + 2,
-                                  payloadLen);
-    out.push_back(crc);             // CRC
-    out.push_back(Packet::END_BYTE);
+std::vector<uint8_t> Protocol::pack(const Packet& pkt)
+{
+    std::vector<uint8_t> out(frameSize(pkt));
+    packInto(pkt, out.data());
+    return out;
+}
 
+std::pmr::vector<uint8_t> Protocol::pack(const Packet& pkt, std::pmr::memory_resource* mr)
+{
+    std::pmr::vector<uint8_t> out(frameSize(pkt), mr);
+    packInto(pkt, out.data());
     return out;
 }
 
-std::optional<Packet> Protocol::unpack(const uint8_t* buffer, uint16_t len) {
+std::optional<Packet> Protocol::unpack(const uint8_t* buffer, uint16_t len,
+                                       std::pmr::memory_resource* mr) {
     if (!buffer || len < 4) {
         return std::nullopt;
     }
@@ -69,12 +84,96 @@ std::optional<Packet> Protocol::unpack(const uint8_t* buffer, uint16_t len) {
         return std::nullopt;
     }
 
-    Packet pkt;
-    pkt.length = length;
-    pkt.packetId = buffer[1];
-    pkt.payload.assign(buffer + 2, buffer + 2 + payloadLen);
-    pkt.checksum = crc;
+    // Built in place: assigning a payload from another resource would copy.
+    // Sized then filled, as in pack().
+    Packet pkt{length, buffer[1], Packet::Payload(payloadLen, mr), crc};
+    if (payloadLen) std::memcpy(pkt.payload.data(), buffer + 2, payloadLen);
     return pkt;
 }
 
-} // namespace altair
\ No newline at end of file
+std::optional<Packet> Protocol::makeRangeRequest(uint8_t type,
+                                                 const std::string& start_date,
+                                                 const std::string& end_date) {
+    // Format dates as YYYYMMDDYYYYMMDD
+    std::string payload = start_date + end_date;
+    payload.erase(std::remove(payload.begin(), payload.end(), '-'), payload.end());
+
+    if (payload.length() != 16) {
+        return std::nullopt;
+    }
+
+    Packet request{};
+    request.packetId = type;
+    request.payload.assign(payload.begin(), payload.end());
+    return request;
+}
+
+std::optional<Packet> Protocol::makeRouted(uint8_t sat, const Packet& inner,
+                                           std::pmr::memory_resource* mr) {
+    // The length byte counts payload + id, so a payload tops out at 254.
+    if (inner.payload.size() + 2 > 254) {
+        return std::nullopt;
+    }
+
+    Packet routed{0, PROTO_PKT_ROUTED, Packet::Payload(inner.payload.size() + 2, mr), 0};
+    routed.payload[0] = sat;
+    routed.payload[1] = inner.packetId;
+    if (!inner.payload.empty()) {
+        std::memcpy(routed.payload.data() + 2, inner.payload.data(), inner.payload.size());
+    }
+    return routed;
+}
+
+std::optional<std::pair<uint8_t, Packet>> Protocol::unwrapRouted(const Packet& routed) {
+    if (routed.packetId != PROTO_PKT_ROUTED || routed.payload.size() < 2) {
+        return std::nullopt;
+    }
+
+    Packet inner{};
+    inner.packetId = routed.payload[1];
+    inner.payload.assign(routed.payload.begin() + 2, routed.payload.end());
+    return std::make_pair(routed.payload[0], std::move(inner));
+}
+
+void FrameDecoder::feed(const uint8_t* data, size_t len, uint64_t rx_ns) {
+    rx_ns_ = rx_ns;
+    // Compact lazily so a steady stream does not shift bytes on every frame.
+    if (pos_ > 0 && pos_ >= buffer_.size() / 2) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + pos_);
+        pos_ = 0;
+    }
+    buffer_.insert(buffer_.end(), data, data + len);
+}
+
+std::optional<Packet> FrameDecoder::next() {
+    while (buffer_.size() - pos_ >= 4) {
+        const uint8_t* frame     = buffer_.data() + pos_;
+        size_t         available = std::min<size_t>(buffer_.size() - pos_,
+                                                    PROTO_MAX_PACKET_LEN);
+        size_t         frameLen  = size_t(frame[0]) + 3;
+
+        auto opt = Protocol::unpack(frame, static_cast<uint16_t>(available), resource_);
+        if (opt) {
+            pos_ += frameLen;
+            opt->rx_ns = rx_ns_;
+            ++frames_;
+            in_step_ = true;
+            return opt;
+        }
+
+        // Incomplete frame: wait for more bytes.
+        if (frame[0] != 0 && available < frameLen) break;
+
+        if (in_step_) ++corrupt_;
+        in_step_ = false;
+        ++pos_;
+        ++skipped_;
+    }
+    if (pos_ == buffer_.size()) {
+        buffer_.clear();
+        pos_ = 0;
+    }
+    return std::nullopt;
+}
+
+} // namespace altair
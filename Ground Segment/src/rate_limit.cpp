@@ -0,0 +1,174 @@
+#include "rate_limit.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <utility>
+
+namespace altair {
+
+namespace {
+
+constexpr std::pair<std::string_view, uint8_t> kModes[] = {
+    {"interval", PROTO_RATE_INTERVAL}, {"nth", PROTO_RATE_EVERY_NTH},
+    {"min", PROTO_RATE_MIN}, {"max", PROTO_RATE_MAX}, {"avg", PROTO_RATE_AVG},
+};
+
+} // namespace
+
+std::optional<RateSpec> parseRateSpec(std::string_view text) {
+    if (text == "all") return RateSpec{};
+
+    size_t colon = text.find(':');
+    if (colon == std::string_view::npos) return std::nullopt;
+
+    std::string_view name  = text.substr(0, colon);
+    std::string_view value = text.substr(colon + 1);
+    uint32_t param = 0;
+    auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), param);
+    if (ec != std::errc() || end != value.data() + value.size() || param == 0) {
+        return std::nullopt;
+    }
+    for (const auto& [mode_name, mode] : kModes) {
+        if (name == mode_name) return RateSpec{mode, param};
+    }
+    return std::nullopt;
+}
+
+std::string formatRateSpec(const RateSpec& spec) {
+    for (const auto& [mode_name, mode] : kModes) {
+        if (spec.mode == mode) return std::string(mode_name) + ":" + std::to_string(spec.param);
+    }
+    return "all";
+}
+
+// ------------------------------------------------------------------------
+// RateFilter
+// ------------------------------------------------------------------------
+
+RateFilter::Verdict RateFilter::offer(std::string_view sample, Clock::time_point now) {
+    const auto interval = std::chrono::milliseconds(spec_.param);
+    ++seen_;
+
+    switch (spec_.mode) {
+        case PROTO_RATE_EVERY_NTH:
+            return (seen_ - 1) % spec_.param == 0 ? Verdict::Pass : Verdict::Drop;
+
+        case PROTO_RATE_INTERVAL:
+            if (started_ && now - window_start_ < interval) return Verdict::Drop;
+            started_      = true;
+            window_start_ = now;
+            return Verdict::Pass;
+
+        case PROTO_RATE_MIN:
+        case PROTO_RATE_MAX:
+        case PROTO_RATE_AVG: {
+            Verdict verdict = Verdict::Drop;
+            if (!started_) {
+                started_      = true;
+                window_start_ = now;
+            } else if (now - window_start_ >= interval) {
+                close();
+                verdict       = Verdict::Rollup;
+                window_start_ = now;
+            }
+            accumulate(sample);
+            return verdict;
+        }
+
+        default:
+            return Verdict::Pass;
+    }
+}
+
+void RateFilter::accumulate(std::string_view sample) {
+    size_t body_end = sample.find_last_not_of("\r\n") + 1;  // npos + 1 == 0
+    ending_.assign(sample.substr(body_end));
+    std::string_view body = sample.substr(0, body_end);
+
+    size_t comma = body.find(',');
+    stamp_.assign(body.substr(0, comma));
+    if (comma == std::string_view::npos) return;
+    body.remove_prefix(comma + 1);
+
+    for (size_t i = 0; ; ++i) {
+        comma = body.find(',');
+        std::string_view value = body.substr(0, comma);
+
+        if (i >= fields_.size()) fields_.emplace_back();
+        width_ = std::max(width_, i + 1);
+        Field& f = fields_[i];
+        f.text.assign(value);
+
+        double v = 0;
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), v);
+        if (!value.empty() && ec == std::errc() && end == value.data() + value.size()) {
+            size_t dot = value.find('.');
+            int decimals = dot == std::string_view::npos ? 0 : int(value.size() - dot - 1);
+            f.decimals = std::max(f.decimals, decimals);
+            f.min = f.n ? std::min(f.min, v) : v;
+            f.max = f.n ? std::max(f.max, v) : v;
+            f.sum += v;
+            ++f.n;
+        }
+
+        if (comma == std::string_view::npos) break;
+        body.remove_prefix(comma + 1);
+    }
+}
+
+void RateFilter::close() {
+    rollup_.assign(stamp_);
+    for (size_t i = 0; i < width_; ++i) {
+        Field& f = fields_[i];
+        rollup_ += ',';
+        if (f.n) {
+            double v = spec_.mode == PROTO_RATE_MIN ? f.min
+                     : spec_.mode == PROTO_RATE_MAX ? f.max
+                     : f.sum / double(f.n);
+            char buf[64];
+            int n = std::snprintf(buf, sizeof(buf), "%.*f", f.decimals, v);
+            rollup_.append(buf, size_t(std::clamp(n, 0, int(sizeof(buf) - 1))));
+        } else {
+            rollup_ += f.text;
+        }
+        f.n        = 0;
+        f.sum      = 0;
+        f.decimals = 0;
+        f.text.clear();
+    }
+    rollup_ += ending_;
+    width_ = 0;
+}
+
+// ------------------------------------------------------------------------
+// ClientRates
+// ------------------------------------------------------------------------
+
+void ClientRates::set(uint8_t sat, RateSpec spec) {
+    if (sat == PROTO_SAT_ALL) {
+        all_ = spec;
+        by_sat_.clear();
+        filters_.clear();
+        return;
+    }
+
+    filters_.erase(sat);
+    if (spec.mode == all_.mode && spec.param == all_.param) {
+        by_sat_.erase(sat);
+    } else {
+        by_sat_[sat] = spec;
+    }
+}
+
+RateFilter* ClientRates::filterFor(uint8_t sat) {
+    auto it = by_sat_.find(sat);
+    const RateSpec& spec = it != by_sat_.end() ? it->second : all_;
+    if (spec.passesAll()) return nullptr;
+
+    auto filter = filters_.find(sat);
+    if (filter == filters_.end()) filter = filters_.emplace(sat, RateFilter(spec)).first;
+    return &filter->second;
+}
+
+} // namespace altair
@@ -0,0 +1,209 @@
+#include "sat_state.hpp"
+#include "protocol_defs.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+
+namespace altair {
+
+namespace {
+
+std::string shmPath(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+uint64_t realtimeNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+/// The "YYYY-MM-DD HH:MM:SS" a line starts with, or empty if it has none.
+std::string_view stampOf(std::string_view text) {
+    static constexpr char pattern[] = "dddd-dd-dd dd:dd:dd";
+    if (text.size() < sizeof(pattern) - 1) return {};
+    for (size_t i = 0; i + 1 < sizeof(pattern); ++i) {
+        bool digit = text[i] >= '0' && text[i] <= '9';
+        if (pattern[i] == 'd' ? !digit : text[i] != pattern[i]) return {};
+    }
+    return text.substr(0, sizeof(pattern) - 1);
+}
+
+/// True unless text is timestamped before what old holds. Text without a
+/// timestamp is live; old text without one counts from its arrival.
+bool isNewer(std::string_view text, const StateText& old) {
+    std::string_view stamp = stampOf(text);
+    if (stamp.empty()) return true;
+
+    std::string_view prev = stampOf(old.view());
+    char arrival[20];
+    if (prev.empty()) {
+        std::time_t t = static_cast<std::time_t>(old.t_ns / 1000000000);
+        std::tm tm{};
+        ::localtime_r(&t, &tm);
+        prev = {arrival, std::strftime(arrival, sizeof(arrival), "%Y-%m-%d %H:%M:%S", &tm)};
+    }
+    return stamp >= prev;
+}
+
+/// The mode a keep-alive ("... MODE:SAFE, ...") or a mode change event
+/// ("System mode changed to SAFE") reports, or empty.
+std::string_view modeOf(uint8_t packet_id, std::string_view text) {
+    std::string_view key = packet_id == PROTO_PKT_KEEP_ALIVE ? "MODE:" : "changed to ";
+    size_t at = text.find(key);
+    if (at == std::string_view::npos) return {};
+
+    text.remove_prefix(at + key.size());
+    size_t end = text.find_first_of(", \r\n");
+    return text.substr(0, end);
+}
+
+static_assert(sizeof(SatStateHeader) <= kSatStateDataOffset, "state header too large");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "state atomics must be lock-free to be shared between processes");
+
+} // namespace
+
+// ------------------------------------------------------------------------
+// Writer
+// ------------------------------------------------------------------------
+
+SatStateTable::SatStateTable(const std::string& name)
+    : name_(name.empty() ? std::string() : shmPath(name))
+    , mapped_(kSatStateDataOffset + kSatStateSlots * sizeof(SatStateSlot))
+{
+    void* p;
+    if (name_.empty()) {
+        p = ::mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        ::shm_unlink(name_.c_str());
+        int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot create state table " + name_ + ": "
+                                     + strerror(errno));
+        }
+        if (::ftruncate(fd, static_cast<off_t>(mapped_)) != 0) {
+            ::close(fd);
+            ::shm_unlink(name_.c_str());
+            throw std::runtime_error("Cannot size state table " + name_ + ": "
+                                     + strerror(errno));
+        }
+        p = ::mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+    }
+    if (p == MAP_FAILED) {
+        if (!name_.empty()) ::shm_unlink(name_.c_str());
+        throw std::runtime_error("Cannot map state table " + name_ + ": " + strerror(errno));
+    }
+
+    // Magic last, so a reader never sees a half-initialised table.
+    header_ = new (p) SatStateHeader{};
+    header_->slots     = kSatStateSlots;
+    header_->slot_size = sizeof(SatStateSlot);
+    slots_ = new (static_cast<uint8_t*>(p) + kSatStateDataOffset) SatStateSlot[kSatStateSlots];
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, kSatStateMagic, sizeof(kSatStateMagic));
+}
+
+SatStateTable::~SatStateTable() {
+    if (!header_) return;
+    header_->closed.store(1, std::memory_order_release);
+    ::munmap(header_, mapped_);
+    if (!name_.empty()) ::shm_unlink(name_.c_str());
+}
+
+bool SatStateTable::update(uint8_t sat, const Packet& pkt) {
+    StateText SatState::* field;
+    switch (pkt.packetId) {
+        case PROTO_PKT_KEEP_ALIVE: field = &SatState::keep_alive; break;
+        case PROTO_PKT_SAMPLE:     field = &SatState::sample;     break;
+        case PROTO_PKT_EVENT:      field = &SatState::event;      break;
+        default:                   return false;
+    }
+
+    std::string_view text(reinterpret_cast<const char*>(pkt.payload.data()),
+                          std::min<size_t>(pkt.payload.size(), sizeof(StateText::text)));
+    SatStateSlot& slot = slots_[sat];
+    SatState& state = slot.state;   // only this thread writes it
+
+    // Keep-alives are always live; samples and events may be history.
+    if (pkt.packetId != PROTO_PKT_KEEP_ALIVE && (state.*field).t_ns
+        && !isNewer(text, state.*field)) {
+        return false;
+    }
+    std::string_view mode = pkt.packetId == PROTO_PKT_SAMPLE
+        ? std::string_view() : modeOf(pkt.packetId, text);
+    const uint64_t now = realtimeNs();
+
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    StateText& dst = state.*field;
+    dst.t_ns = now;
+    dst.size = static_cast<uint8_t>(text.size());
+    std::memcpy(dst.text, text.data(), text.size());
+    if (!mode.empty()) {
+        size_t n = std::min(mode.size(), sizeof(state.mode) - 1);
+        std::memcpy(state.mode, mode.data(), n);
+        state.mode[n] = '\0';
+    }
+    state.updated_ns = now;
+
+    slot.seq.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Reader
+// ------------------------------------------------------------------------
+
+SatStateReader::SatStateReader(const std::string& name) {
+    const std::string path = shmPath(name);
+    int fd = ::shm_open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open state table " + path + ": " + strerror(errno));
+    }
+
+    struct stat st{};
+    const size_t expected = kSatStateDataOffset + kSatStateSlots * sizeof(SatStateSlot);
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < expected) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a state table");
+    }
+
+    mapped_ = expected;
+    void* p = ::mmap(nullptr, mapped_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Cannot map state table " + path + ": " + strerror(errno));
+    }
+    header_ = static_cast<const SatStateHeader*>(p);
+
+    // The writer stores magic last, after a release fence: read it first,
+    // then fence, so the slot layout is seen as it was written.
+    char magic[sizeof(kSatStateMagic)];
+    std::memcpy(magic, header_->magic, sizeof(magic));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (std::memcmp(magic, kSatStateMagic, sizeof(kSatStateMagic)) != 0
+        || header_->slots != kSatStateSlots || header_->slot_size != sizeof(SatStateSlot)) {
+        ::munmap(const_cast<SatStateHeader*>(header_), mapped_);
+        throw std::runtime_error(path + " is not a state table");
+    }
+    slots_ = reinterpret_cast<const SatStateSlot*>(static_cast<const uint8_t*>(p)
+                                                   + kSatStateDataOffset);
+}
+
+SatStateReader::~SatStateReader() {
+    if (header_) ::munmap(const_cast<SatStateHeader*>(header_), mapped_);
+}
+
+} // namespace altair
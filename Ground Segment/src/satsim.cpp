@@ -0,0 +1,449 @@
+#include "satsim.hpp"
+#include "packet_registry.hpp"
+#include "protocol_defs.hpp"
+#include "uart_communicator.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace altair {
+
+using Clock = EventLoop::Clock;
+
+namespace {
+
+constexpr size_t kMaxTextPayload = 254;   // length byte = payload + 1
+
+const char* const kModes[] = {"NORMAL", "ERROR", "SAFE"};
+
+} // namespace
+
+NanoSatSimulator::NanoSatSimulator(SatSimOptions options)
+    : options_(std::move(options))
+    , rng_(options_.seed)
+{
+    openPty();
+}
+
+NanoSatSimulator::~NanoSatSimulator() {
+    if (!options_.link_path.empty()) ::unlink(options_.link_path.c_str());
+    if (slave_fd_ >= 0) ::close(slave_fd_);
+    if (master_fd_ >= 0) ::close(master_fd_);
+}
+
+void NanoSatSimulator::openPty() {
+    auto pty    = openPseudoTerminal(options_.link_path);
+    master_fd_  = pty.master_fd;
+    slave_fd_   = pty.slave_fd;
+    slave_path_ = pty.slave_path;
+}
+
+void NanoSatSimulator::run() {
+    loop_.watch(master_fd_, EPOLLIN, [this](uint32_t) { onReadable(); });
+
+    if (!options_.wait_for_time_sync) startActivity();
+
+    loop_.run();
+}
+
+void NanoSatSimulator::stop() {
+    loop_.stop();
+}
+
+SatSimStats NanoSatSimulator::stats() {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    return stats_;
+}
+
+// ------------------------------------------------------------------------
+// Reception
+// ------------------------------------------------------------------------
+
+void NanoSatSimulator::onReadable() {
+    uint8_t buf[1024];
+    for (;;) {
+        ssize_t n = ::read(master_fd_, buf, sizeof(buf));
+        if (n > 0) {
+            decoder_.feed(buf, static_cast<size_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        break;
+    }
+
+    while (auto pkt = decoder_.next()) {
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            ++stats_.frames_in;
+        }
+        handlePacket(*pkt);
+    }
+}
+
+void NanoSatSimulator::handlePacket(const Packet& pkt) {
+    packets::SatelliteCommands::dispatch(pkt, packets::Overloaded{
+        [&](const packets::TimeSync& sync) {
+            handleTimeSync(sync.timestamp);
+        },
+        [&](const packets::SampleRequest& req) {
+            handleRangeRequest(req.id, req.first_day, req.last_day);
+        },
+        [&](const packets::EventRequest& req) {
+            handleRangeRequest(req.id, req.first_day, req.last_day);
+        },
+        [&](const packets::InvalidPacket& bad) {
+            std::cerr << "[SatSim] Ignoring " << (bad.known ? "malformed " : "")
+                      << "packet id " << int(pkt.packetId) << std::endl;
+        },
+    });
+}
+
+void NanoSatSimulator::handleTimeSync(std::string_view stamp) {
+    // "YYYYMMDDHHMMSS", parsed like communicator.c does.
+    std::string s(stamp);
+    std::tm tm{};
+    tm.tm_year  = std::atoi(s.substr(0, 4).c_str()) - 1900;
+    tm.tm_mon   = std::atoi(s.substr(4, 2).c_str()) - 1;
+    tm.tm_mday  = std::atoi(s.substr(6, 2).c_str());
+    tm.tm_hour  = std::atoi(s.substr(8, 2).c_str());
+    tm.tm_min   = std::atoi(s.substr(10, 2).c_str());
+    tm.tm_sec   = std::atoi(s.substr(12, 2).c_str());
+    tm.tm_isdst = -1;
+
+    std::time_t synced = std::mktime(&tm);
+    if (synced == static_cast<std::time_t>(-1)) {
+        std::cerr << "[SatSim] Invalid TIME_SYNC payload: " << s << std::endl;
+        return;
+    }
+
+    clock_offset_ = synced - std::time(nullptr);
+    std::clog << "[SatSim] Time synced to " << formatTimestamp(now()) << std::endl;
+
+    if (!active_) startActivity();
+}
+
+void NanoSatSimulator::handleRangeRequest(uint8_t type, std::string_view first_day,
+                                          std::string_view last_day) {
+    // Walked one day at a time like Logger_HandleSampleRequest.
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.range_requests;
+    }
+
+    auto parse = [](std::string_view sv) {
+        std::string d(sv);
+        std::tm tm{};
+        tm.tm_year  = std::atoi(d.substr(0, 4).c_str()) - 1900;
+        tm.tm_mon   = std::atoi(d.substr(4, 2).c_str()) - 1;
+        tm.tm_mday  = std::atoi(d.substr(6, 2).c_str());
+        tm.tm_hour  = 12;   // midday keeps DST shifts from skipping a day
+        tm.tm_isdst = -1;
+        return std::mktime(&tm);
+    };
+
+    std::time_t day = parse(first_day);
+    std::time_t end = parse(last_day);
+    if (day == static_cast<std::time_t>(-1) || end == static_cast<std::time_t>(-1)) return;
+
+    const bool samples = type == PROTO_PKT_SAMPLE;
+    for (; day <= end; day += 24 * 60 * 60) {
+        auto it = store_.find(formatDate(day));
+        if (it == store_.end()) continue;
+
+        for (const auto& line : samples ? it->second.samples : it->second.events) {
+            transmitText(type, line);
+        }
+    }
+}
+
+// ------------------------------------------------------------------------
+// Synthetic activity
+// ------------------------------------------------------------------------
+
+void NanoSatSimulator::startActivity() {
+    active_ = true;
+    fillHistory();
+
+    auto start = Clock::now();
+    next_sample_ = start;
+    next_event_  = start;
+
+    // Beacons on a fixed period, like the keep-alive timer on the board.
+    struct Beacon {
+        NanoSatSimulator* sim;
+        Clock::time_point when;
+        void operator()() {
+            sim->beacon();
+            when += sim->options_.beacon_interval;
+            sim->loop_.addTimer(when, *this);
+        }
+    };
+    loop_.addTimer(start, Beacon{this, start});
+
+    // Samples and events are generated in batches on a 1 ms tick so high
+    // rates do not need one timer per item.
+    struct Tick {
+        NanoSatSimulator* sim;
+        void operator()() {
+            auto t = Clock::now();
+            auto& o = sim->options_;
+            if (o.sample_rate > 0) {
+                auto period = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / o.sample_rate));
+                // Catch up at most one second's worth after a stall.
+                if (t - sim->next_sample_ > std::chrono::seconds(1)) {
+                    sim->next_sample_ = t - std::chrono::seconds(1);
+                }
+                while (sim->next_sample_ <= t) {
+                    sim->generateSample();
+                    sim->next_sample_ += period;
+                }
+            }
+            if (o.event_rate > 0) {
+                auto period = std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / o.event_rate));
+                if (t - sim->next_event_ > std::chrono::seconds(1)) {
+                    sim->next_event_ = t - std::chrono::seconds(1);
+                }
+                while (sim->next_event_ <= t) {
+                    sim->generateEvent();
+                    sim->next_event_ += period;
+                }
+            }
+            sim->loop_.addTimer(t + std::chrono::milliseconds(1), *this);
+        }
+    };
+    if (options_.sample_rate > 0 || options_.event_rate > 0) {
+        loop_.addTimer(start, Tick{this});
+    }
+}
+
+void NanoSatSimulator::beacon() {
+    // Same text as Communicator_SendKeepAliveText.
+    std::string line = last_sample_.empty()
+        ? formatTimestamp(now()) + " MODE:" + mode_ + ", no sample\r\n"
+        : last_sample_;
+    transmitText(PROTO_PKT_KEEP_ALIVE, line);
+}
+
+std::string NanoSatSimulator::makeSampleLine(std::time_t t) {
+    std::uniform_int_distribution<int> temp(180, 320), hum(300, 700), ldr(0, 100),
+                                       vbat(3300, 4200);
+    int tv = temp(rng_), hv = hum(rng_);
+    char line[96];
+    // logger_feeder.c: "timestamp,T,H,VBAT,LDR\n"
+    std::snprintf(line, sizeof(line), "%s,%d.%d,%d.%d,%d,%d\n",
+                  formatTimestamp(t).c_str(), tv / 10, tv % 10, hv / 10, hv % 10,
+                  vbat(rng_), ldr(rng_));
+    return line;
+}
+
+void NanoSatSimulator::generateSample() {
+    std::time_t t = now();
+    std::string line = makeSampleLine(t);
+
+    auto& day = store_[formatDate(t)].samples;
+    if (day.size() < options_.max_samples_per_day) day.push_back(line);
+
+    // Keep-alive text carries the latest reading.
+    int t_int = 0, t_frac = 0, h_int = 0, h_frac = 0, vbat = 0, ldr = 0;
+    std::sscanf(line.c_str() + 20, "%d.%d,%d.%d,%d,%d",
+                &t_int, &t_frac, &h_int, &h_frac, &vbat, &ldr);
+    char text[160];
+    std::snprintf(text, sizeof(text), "%s MODE:%s, LDR:%d, VBAT:%d, T:%d.%dC, H:%d.%d%%\r\n",
+                  formatTimestamp(t).c_str(), mode_.c_str(), ldr, vbat,
+                  t_int, t_frac, h_int, h_frac);
+    last_sample_ = text;
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.samples_generated;
+    }
+
+    if (options_.stream_samples) transmitText(PROTO_PKT_SAMPLE, line);
+}
+
+void NanoSatSimulator::generateEvent() {
+    std::uniform_int_distribution<int> pick(0, 2);
+    mode_ = kModes[pick(rng_)];
+
+    std::string msg = "System mode changed to " + mode_;
+    std::time_t t = now();
+    store_[formatDate(t)].events.push_back(formatTimestamp(t) + ",EVENT," + msg + "\r\n");
+    transmitText(PROTO_PKT_EVENT, msg);
+}
+
+void NanoSatSimulator::fillHistory() {
+    if (options_.history_samples_per_day == 0) return;
+
+    const std::time_t today = now();
+    const long step = 24L * 60 * 60 / options_.history_samples_per_day;
+
+    for (unsigned d = options_.history_days; d > 0; --d) {
+        std::time_t day = today - static_cast<std::time_t>(d) * 24 * 60 * 60;
+        std::tm tm{};
+        ::localtime_r(&day, &tm);
+        tm.tm_hour = tm.tm_min = tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        std::time_t midnight = std::mktime(&tm);
+
+        auto& log = store_[formatDate(day)];
+        if (!log.samples.empty()) continue;
+
+        for (unsigned i = 0; i < options_.history_samples_per_day; ++i) {
+            log.samples.push_back(makeSampleLine(midnight + static_cast<std::time_t>(i) * step));
+        }
+        log.events.push_back(formatTimestamp(midnight + 8 * 3600)
+                             + ",EVENT,System mode changed to ERROR\r\n");
+        log.events.push_back(formatTimestamp(midnight + 9 * 3600)
+                             + ",EVENT,System mode changed to NORMAL\r\n");
+    }
+
+    // The board keeps only the most recent files (KeepOnlyRecent).
+    while (store_.size() > options_.history_days + 1) store_.erase(store_.begin());
+}
+
+// ------------------------------------------------------------------------
+// Transmission
+// ------------------------------------------------------------------------
+
+void NanoSatSimulator::transmitText(uint8_t id, const std::string& text) {
+    Packet pkt{};
+    pkt.packetId = id;
+    size_t n = std::min(text.size(), kMaxTextPayload);
+    pkt.payload.assign(text.begin(), text.begin() + n);
+    transmit(pkt);
+}
+
+void NanoSatSimulator::transmit(const Packet& pkt) {
+    auto frame = Protocol::pack(pkt);
+
+    if (tx_.size() + frame.size() > options_.max_tx_backlog) {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++stats_.frames_dropped;
+        return;
+    }
+
+    if (tx_.empty() && options_.baud_rate > 0) {
+        // Line idle: the pacing window starts now (never in the past, or a
+        // burst after a quiet period would go out faster than the baud rate).
+        auto busy_until = tx_epoch_ + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(tx_paced_bytes_ * 10.0 / options_.baud_rate));
+        auto t = Clock::now();
+        if (busy_until < t) {
+            tx_epoch_       = t;
+            tx_paced_bytes_ = 0;
+        }
+    }
+
+    tx_.insert(tx_.end(), frame.begin(), frame.end());
+    tx_frames_.emplace_back(tx_written_ + tx_.size(), observer_ ? pkt : Packet{});
+    pumpTx();
+}
+
+void NanoSatSimulator::pumpTx() {
+    if (tx_blocked_ || tx_timer_armed_) return;
+
+    while (!tx_.empty()) {
+        size_t allowed = tx_.size();
+        if (options_.baud_rate > 0) {
+            double elapsed = std::chrono::duration<double>(Clock::now() - tx_epoch_).count();
+            uint64_t budget = static_cast<uint64_t>(elapsed * options_.baud_rate / 10.0);
+            allowed = budget > tx_paced_bytes_
+                    ? std::min<uint64_t>(allowed, budget - tx_paced_bytes_) : 0;
+            if (allowed == 0) {
+                // Wake when the next 16 bytes' wire time has passed.
+                auto due = tx_epoch_ + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>((tx_paced_bytes_ + 16) * 10.0
+                                                  / options_.baud_rate));
+                tx_timer_armed_ = true;
+                loop_.addTimer(due, [this]() {
+                    tx_timer_armed_ = false;
+                    pumpTx();
+                });
+                return;
+            }
+        }
+
+        uint8_t chunk[4096];
+        size_t n = std::min({allowed, tx_.size(), sizeof(chunk)});
+        std::copy_n(tx_.begin(), n, chunk);
+
+        // Frames are announced before the write: once the bytes are in the
+        // pty the gateway may forward them before write() even returns.
+        auto t = Clock::now();
+        for (auto& [end, pkt] : tx_frames_) {
+            if (end > tx_written_ + n) break;
+            if (end > tx_announced_) {
+                if (observer_) observer_(pkt, t);
+                tx_announced_ = end;
+            }
+        }
+
+        ssize_t w = ::write(master_fd_, chunk, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) {
+                // The gateway is not keeping up; resume when the pty drains.
+                tx_blocked_ = true;
+                loop_.watch(master_fd_, EPOLLIN | EPOLLOUT, [this](uint32_t events) {
+                    if (events & EPOLLOUT) {
+                        tx_blocked_ = false;
+                        loop_.watch(master_fd_, EPOLLIN, [this](uint32_t) { onReadable(); });
+                        pumpTx();
+                    }
+                    if (events & EPOLLIN) onReadable();
+                });
+                return;
+            }
+            std::cerr << "[SatSim] pty write error: " << strerror(errno) << std::endl;
+            tx_.clear();
+            tx_frames_.clear();
+            tx_announced_ = tx_written_;
+            return;
+        }
+
+        tx_.erase(tx_.begin(), tx_.begin() + w);
+        tx_written_     += static_cast<uint64_t>(w);
+        tx_paced_bytes_ += static_cast<uint64_t>(w);
+
+        uint64_t frames = 0;
+        while (!tx_frames_.empty() && tx_frames_.front().first <= tx_written_) {
+            tx_frames_.pop_front();
+            ++frames;
+        }
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        stats_.bytes_out += static_cast<uint64_t>(w);
+        stats_.frames_out += frames;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Clock
+// ------------------------------------------------------------------------
+
+std::time_t NanoSatSimulator::now() const {
+    return std::time(nullptr) + clock_offset_;
+}
+
+std::string NanoSatSimulator::formatTimestamp(std::time_t t) {
+    std::tm tm{};
+    ::localtime_r(&t, &tm);
+    char buf[20];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+std::string NanoSatSimulator::formatDate(std::time_t t) {
+    return formatTimestamp(t).substr(0, 10);
+}
+
+} // namespace altair
@@ -0,0 +1,313 @@
+// Shared-memory ring versus loopback TCP for same-host subscribers.
+//
+// One producer thread publishes sample-sized frames at a fixed rate (or as
+// fast as it can) to N consumer threads, once through a ShmRingWriter and
+// once the way ClientManager fans out: a blocking send() per consumer
+// socket. Each frame carries its send time, so consumers measure latency;
+// the time spent publishing a frame is its cost on the gateway side.
+
+#include "protocol.hpp"
+#include "protocol_defs.hpp"
+#include "shm_ring.hpp"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace altair;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct BenchConfig {
+    std::vector<unsigned> consumers{1, 32};
+    uint64_t              frames{100000};
+    double                rate{10000};          // frames/s, 0 = unpaced
+    std::string           json_path;
+};
+
+struct Result {
+    std::string transport;
+    unsigned    consumers{0};
+    uint64_t    frames{0};
+    double      seconds{0};
+    double      producer_ns_per_frame{0};
+    uint64_t    delivered{0};
+    uint64_t    lost{0};
+    double      p50_us{0}, p99_us{0}, p999_us{0};
+};
+
+uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count());
+}
+
+/// A SAMPLE frame the size of a real one, stamped with the send time.
+std::vector<uint8_t> makeFrame(uint64_t t) {
+    Packet pkt;
+    pkt.packetId = PROTO_PKT_SAMPLE;
+    pkt.payload.assign(40, '0');
+    std::memcpy(pkt.payload.data(), &t, sizeof(t));
+    return Protocol::pack(pkt);
+}
+
+uint64_t stampOf(const Packet& pkt) {
+    uint64_t t = 0;
+    if (pkt.payload.size() >= sizeof(t)) std::memcpy(&t, pkt.payload.data(), sizeof(t));
+    return t;
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t idx = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()));
+    return sorted[idx];
+}
+
+/// Runs the paced producer loop; publish(frame) does the transport work.
+template <class Publish>
+void produce(const BenchConfig& cfg, Result& r, Publish&& publish) {
+    auto start = Clock::now();
+    uint64_t publish_ns = 0;
+    for (uint64_t i = 0; i < cfg.frames; ++i) {
+        if (cfg.rate > 0) {
+            // Sleep rather than spin while ahead, so consumers sharing the
+            // core get to run.
+            auto due = start + std::chrono::nanoseconds(static_cast<int64_t>(i * 1e9 / cfg.rate));
+            if (due > Clock::now()) std::this_thread::sleep_until(due);
+            while (Clock::now() < due) {}
+        }
+        auto frame = makeFrame(nowNs());
+        uint64_t t0 = nowNs();
+        publish(frame);
+        publish_ns += nowNs() - t0;
+    }
+    r.producer_ns_per_frame = double(publish_ns) / cfg.frames;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void finish(Result& r, std::vector<std::vector<double>>& per_consumer) {
+    std::vector<double> all;
+    for (auto& v : per_consumer) {
+        r.delivered += v.size();
+        all.insert(all.end(), v.begin(), v.end());
+    }
+    std::sort(all.begin(), all.end());
+    r.p50_us  = percentile(all, 50);
+    r.p99_us  = percentile(all, 99);
+    r.p999_us = percentile(all, 99.9);
+}
+
+Result runShm(const BenchConfig& cfg, unsigned consumers) {
+    Result r;
+    r.transport = "shm";
+    r.consumers = consumers;
+    r.frames    = cfg.frames;
+
+    const std::string name = "altair_shm_bench_" + std::to_string(::getpid());
+    ShmRingWriter writer(name, 8 << 20);
+
+    std::atomic<bool>     done{false};
+    std::atomic<unsigned> ready{0};
+    std::atomic<uint64_t> lost{0};
+    std::vector<std::vector<double>> latencies(consumers);
+    std::vector<std::thread> threads;
+
+    for (unsigned c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            ShmRingReader reader(name);
+            auto& lat = latencies[c];
+            lat.reserve(cfg.frames);
+            ++ready;
+            for (;;) {
+                while (auto frame = reader.next()) {
+                    lat.push_back((nowNs() - stampOf(frame->second)) / 1e3);
+                }
+                if (done.load(std::memory_order_acquire)) {
+                    if (!reader.next()) break;
+                }
+                reader.wait(std::chrono::milliseconds(1));
+            }
+            lost += reader.lost();
+        });
+    }
+    while (ready < consumers) std::this_thread::yield();
+
+    produce(cfg, r, [&](const std::vector<uint8_t>& frame) {
+        writer.publish(0, frame.data(), frame.size());
+    });
+    done = true;
+    for (auto& t : threads) t.join();
+
+    r.lost = lost;
+    finish(r, latencies);
+    return r;
+}
+
+Result runTcp(const BenchConfig& cfg, unsigned consumers) {
+    Result r;
+    r.transport = "tcp";
+    r.consumers = consumers;
+    r.frames    = cfg.frames;
+
+    int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || ::listen(listener, SOMAXCONN) != 0
+        || ::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        throw std::runtime_error(std::string("listen failed: ") + std::strerror(errno));
+    }
+
+    std::vector<std::vector<double>> latencies(consumers);
+    std::vector<std::thread> threads;
+    for (unsigned c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+                std::cerr << "connect failed: " << std::strerror(errno) << "\n";
+                ::close(fd);
+                return;
+            }
+            auto& lat = latencies[c];
+            lat.reserve(cfg.frames);
+            FrameDecoder decoder;
+            uint8_t buf[16384];
+            ssize_t n;
+            while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0) {
+                decoder.feed(buf, static_cast<size_t>(n));
+                while (auto pkt = decoder.next()) {
+                    lat.push_back((nowNs() - stampOf(*pkt)) / 1e3);
+                }
+            }
+            ::close(fd);
+        });
+    }
+
+    std::vector<int> clients;
+    for (unsigned c = 0; c < consumers; ++c) {
+        int fd = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) throw std::runtime_error(std::string("accept failed: ") + std::strerror(errno));
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        clients.push_back(fd);
+    }
+    ::close(listener);
+
+    produce(cfg, r, [&](const std::vector<uint8_t>& frame) {
+        for (int fd : clients) ::send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+    });
+    for (int fd : clients) ::close(fd);
+    for (auto& t : threads) t.join();
+
+    finish(r, latencies);
+    r.lost = r.frames * consumers - r.delivered;
+    return r;
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(10) << "transport" << std::right
+              << std::setw(10) << "consumers" << std::setw(12) << "fr/s in"
+              << std::setw(14) << "publish ns"
+              << std::setw(10) << "p50 us" << std::setw(10) << "p99 us"
+              << std::setw(10) << "p999 us" << std::setw(10) << "lost" << "\n";
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(10) << r.transport << std::right << std::fixed
+                  << std::setw(10) << r.consumers
+                  << std::setprecision(0) << std::setw(12) << r.frames / r.seconds
+                  << std::setw(14) << r.producer_ns_per_frame
+                  << std::setprecision(1)
+                  << std::setw(10) << r.p50_us << std::setw(10) << r.p99_us
+                  << std::setw(10) << r.p999_us
+                  << std::setw(10) << r.lost << "\n";
+    }
+}
+
+void printJson(std::ostream& os, const BenchConfig& cfg, const Result& r) {
+    os << std::fixed << std::setprecision(3)
+       << "{\"transport\":\"" << r.transport << "\""
+       << ",\"timestamp\":" << std::time(nullptr)
+       << ",\"consumers\":" << r.consumers
+       << ",\"rate\":" << cfg.rate
+       << ",\"frames\":" << r.frames
+       << ",\"seconds\":" << r.seconds
+       << ",\"publish_ns_per_frame\":" << r.producer_ns_per_frame
+       << ",\"delivered\":" << r.delivered
+       << ",\"lost\":" << r.lost
+       << ",\"latency_us\":{\"p50\":" << r.p50_us << ",\"p99\":" << r.p99_us
+       << ",\"p999\":" << r.p999_us << "}}\n";
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " [options]\n"
+              << "  --consumers LIST      comma-separated consumer counts (default 1,32)\n"
+              << "  --frames N            frames per run (default 100000)\n"
+              << "  --rate N              frames per second, 0 = unpaced (default 10000)\n"
+              << "  --json FILE           append one JSON object per run ('-' = stdout)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig cfg;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--consumers") {
+                cfg.consumers.clear();
+                std::istringstream list(value());
+                std::string item;
+                while (std::getline(list, item, ',')) cfg.consumers.push_back(std::stoul(item));
+            }
+            else if (arg == "--frames") cfg.frames = std::stoull(value());
+            else if (arg == "--rate")   cfg.rate = std::stod(value());
+            else if (arg == "--json")   cfg.json_path = value();
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+
+        std::vector<Result> results;
+        for (unsigned n : cfg.consumers) {
+            std::cerr << "Running " << n << " consumer(s)...\n";
+            results.push_back(runShm(cfg, n));
+            results.push_back(runTcp(cfg, n));
+        }
+
+        printTable(results);
+
+        if (!cfg.json_path.empty()) {
+            std::ofstream file;
+            if (cfg.json_path != "-") file.open(cfg.json_path, std::ios::app);
+            std::ostream& os = cfg.json_path == "-" ? std::cout : file;
+            for (const auto& r : results) printJson(os, cfg, r);
+        }
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
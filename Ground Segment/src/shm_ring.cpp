@@ -0,0 +1,268 @@
+#include "shm_ring.hpp"
+#include "protocol.hpp"
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+namespace altair {
+
+namespace {
+
+std::string shmPath(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+void futexWait(std::atomic<uint32_t>* word, uint32_t expected, std::chrono::microseconds timeout) {
+    timespec ts{static_cast<time_t>(timeout.count() / 1000000),
+                static_cast<long>(timeout.count() % 1000000) * 1000};
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts,
+              nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>* word) {
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr,
+              nullptr, 0);
+}
+
+uint32_t recordSize(size_t frame_len) {
+    return static_cast<uint32_t>((kShmRingRecordHead + frame_len + 7) & ~size_t{7});
+}
+
+static_assert(sizeof(ShmRingHeader) <= kShmRingDataOffset, "ring header too large");
+static_assert(std::atomic<uint64_t>::is_always_lock_free
+              && std::atomic<uint32_t>::is_always_lock_free,
+              "ring atomics must be lock-free to be shared between processes");
+
+} // namespace
+
+// ------------------------------------------------------------------------
+// Writer
+// ------------------------------------------------------------------------
+
+ShmRingWriter::ShmRingWriter(const std::string& name, size_t capacity)
+    : name_(shmPath(name))
+{
+    size_t cap = 4096;
+    while (cap < capacity) cap <<= 1;
+    mask_   = cap - 1;
+    mapped_ = kShmRingDataOffset + cap;
+
+    ::shm_unlink(name_.c_str());
+    int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create shared ring " + name_ + ": " + strerror(errno));
+    }
+    if (::ftruncate(fd, static_cast<off_t>(mapped_)) != 0) {
+        ::close(fd);
+        ::shm_unlink(name_.c_str());
+        throw std::runtime_error("Cannot size shared ring " + name_ + ": " + strerror(errno));
+    }
+
+    void* p = ::mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        ::shm_unlink(name_.c_str());
+        throw std::runtime_error("Cannot map shared ring " + name_ + ": " + strerror(errno));
+    }
+
+    // The mapping is zero-filled; construct the header, magic last so a
+    // reader never sees a half-initialised ring.
+    header_ = new (p) ShmRingHeader{};
+    header_->capacity = cap;
+    data_ = static_cast<uint8_t*>(p) + kShmRingDataOffset;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header_->magic, kShmRingMagic, sizeof(kShmRingMagic));
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    if (!header_) return;
+    header_->closed.store(1, std::memory_order_release);
+    header_->notify.fetch_add(1, std::memory_order_release);
+    futexWakeAll(&header_->notify);
+    ::munmap(header_, mapped_);
+    ::shm_unlink(name_.c_str());
+}
+
+bool ShmRingWriter::publish(uint8_t sat, const uint8_t* frame, size_t len) {
+    if (len > kShmRingMaxFrame) return false;
+
+    const uint32_t size = recordSize(len);
+    const uint64_t capacity = mask_ + 1;
+    uint64_t pos = head_;
+    uint64_t idx = pos & mask_;
+    const bool wrap = capacity - idx < size;
+    const uint64_t end = pos + (wrap ? capacity - idx : 0) + size;
+
+    // Claim the bytes before touching them: readers validate against this.
+    header_->reserve.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (wrap) {
+        const uint32_t skip = 0;
+        std::memcpy(data_ + idx, &skip, sizeof(skip));
+        pos += capacity - idx;
+        idx = 0;
+    }
+
+    uint8_t* p = data_ + idx;
+    const uint16_t frame_len = static_cast<uint16_t>(len);
+    std::memcpy(p, &size, sizeof(size));
+    p[4] = sat;
+    p[5] = 0;
+    std::memcpy(p + 6, &frame_len, sizeof(frame_len));
+    std::memcpy(p + 8, &seq_, sizeof(seq_));
+    std::memcpy(p + kShmRingRecordHead, frame, len);
+
+    head_ = end;
+    ++seq_;
+    header_->head.store(end, std::memory_order_release);
+
+    // Pairs with the fence in ShmRingReader::wait(): either the sleeper
+    // sees the new head, or we see it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->waiters.load(std::memory_order_relaxed) != 0) {
+        header_->notify.fetch_add(1, std::memory_order_release);
+        futexWakeAll(&header_->notify);
+    }
+    return true;
+}
+
+// ------------------------------------------------------------------------
+// Reader
+// ------------------------------------------------------------------------
+
+ShmRingReader::ShmRingReader(const std::string& name) {
+    const std::string path = shmPath(name);
+    int fd = ::shm_open(path.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open shared ring " + path + ": " + strerror(errno));
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) <= kShmRingDataOffset) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a shared ring");
+    }
+    mapped_ = static_cast<size_t>(st.st_size);
+
+    // Read-write only for the waiters count and the futex word.
+    void* p = ::mmap(nullptr, mapped_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Cannot map shared ring " + path + ": " + strerror(errno));
+    }
+    header_ = static_cast<ShmRingHeader*>(p);
+    data_   = static_cast<const uint8_t*>(p) + kShmRingDataOffset;
+
+    // The writer stores magic last, after a release fence: read it first,
+    // then fence, so the rest of the header is seen as it was written.
+    char magic[sizeof(kShmRingMagic)];
+    std::memcpy(magic, header_->magic, sizeof(magic));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    capacity_ = header_->capacity;
+    if (std::memcmp(magic, kShmRingMagic, sizeof(kShmRingMagic)) != 0
+        || capacity_ == 0 || (capacity_ & (capacity_ - 1)) != 0
+        || kShmRingDataOffset + capacity_ > mapped_) {
+        ::munmap(p, mapped_);
+        throw std::runtime_error(path + " is not a shared ring");
+    }
+    mask_   = capacity_ - 1;
+    cursor_ = header_->head.load(std::memory_order_acquire);
+}
+
+ShmRingReader::~ShmRingReader() {
+    if (header_) ::munmap(header_, mapped_);
+}
+
+bool ShmRingReader::fetch(Frame& out) {
+    for (;;) {
+        const uint64_t head = header_->head.load(std::memory_order_acquire);
+        if (head == cursor_) return false;
+
+        if (head - cursor_ > capacity_) {
+            // Lapped: everything we had not read is gone.
+            cursor_ = head;
+            synced_ = false;
+            continue;
+        }
+
+        const uint64_t idx = cursor_ & mask_;
+        uint32_t size;
+        uint16_t len;
+        uint64_t seq;
+        std::memcpy(&size, data_ + idx, sizeof(size));
+        if (size == 0) {
+            cursor_ += capacity_ - idx;
+            continue;
+        }
+        out.sat = data_[idx + 4];
+        std::memcpy(&len, data_ + idx + 6, sizeof(len));
+        std::memcpy(&seq, data_ + idx + 8, sizeof(seq));
+        const size_t copy = len <= kShmRingMaxFrame ? len : 0;
+        std::memcpy(frame_, data_ + idx + kShmRingRecordHead, copy);
+
+        // Anything the writer started overwriting after we read it makes
+        // the copy suspect; start again from the newest data.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header_->reserve.load(std::memory_order_relaxed) - cursor_ > capacity_
+            || size != recordSize(len) || copy != len) {
+            cursor_ = header_->head.load(std::memory_order_acquire);
+            synced_ = false;
+            continue;
+        }
+
+        if (synced_ && seq > next_seq_) lost_ += seq - next_seq_;
+        synced_   = true;
+        next_seq_ = seq + 1;
+        cursor_  += size;
+
+        out.seq  = seq;
+        out.data = frame_;
+        out.size = len;
+        return true;
+    }
+}
+
+std::optional<std::pair<uint8_t, Packet>> ShmRingReader::next() {
+    Frame frame;
+    while (fetch(frame)) {
+        if (auto pkt = Protocol::unpack(frame.data, static_cast<uint16_t>(frame.size))) {
+            return std::make_pair(frame.sat, std::move(*pkt));
+        }
+    }
+    return std::nullopt;
+}
+
+bool ShmRingReader::wait(std::chrono::microseconds timeout) {
+    for (int i = 0; i < 256; ++i) {
+        if (available()) return true;
+        if (i >= 64) std::this_thread::yield();
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!available() && !writerClosed()) {
+        auto left = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) return false;
+
+        header_->waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const uint32_t seen = header_->notify.load(std::memory_order_acquire);
+        if (!available()) futexWait(&header_->notify, seen, left);
+        header_->waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return available();
+}
+
+} // namespace altair
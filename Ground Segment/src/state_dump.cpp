@@ -0,0 +1,101 @@
+#include "sat_state.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+
+static std::atomic<bool> running{true};
+
+void signalHandler(int) {
+    running = false;
+}
+
+static void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " NAME [options]\n"
+              << "Prints the satellite state the gateway shares (ALTAIR_STATE_SHM).\n"
+              << "  --sat N              only satellite N\n"
+              << "  --watch MS           print again every MS milliseconds, on changes\n"
+              << "Example: " << prog << " altair_state --watch 500\n";
+}
+
+static std::string age(uint64_t t_ns) {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    double s = (std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() - double(t_ns)) / 1e9;
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%7.1fs ago", s < 0 ? 0.0 : s);
+    return buf;
+}
+
+static void printText(const char* label, const altair::StateText& t) {
+    if (!t.t_ns) return;
+    std::string text(t.view());
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+    std::cout << "  " << label << " " << age(t.t_ns) << "  " << text << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string name;
+    int only = -1;
+    long watch_ms = 0;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if      (arg == "--sat")   only = std::stoi(value()) & 0xFF;
+            else if (arg == "--watch") watch_ms = std::stol(value());
+            else if (arg.rfind("--", 0) != 0 && name.empty()) name = arg;
+            else {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        if (name.empty()) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+
+        // Reads are copies out of the mapping: no syscall, and no wait on
+        // the gateway.
+        altair::SatStateReader reader(name);
+        uint64_t seen[altair::kSatStateSlots] = {};
+        altair::SatState state;
+
+        do {
+            for (size_t sat = 0; sat < altair::kSatStateSlots; ++sat) {
+                if (only >= 0 && int(sat) != only) continue;
+                if (!reader.read(uint8_t(sat), state) || state.updated_ns == seen[sat]) continue;
+                seen[sat] = state.updated_ns;
+
+                std::cout << "[Sat " << sat << "] mode "
+                          << (state.mode[0] ? state.mode : "unknown") << "\n";
+                printText("keep-alive", state.keep_alive);
+                printText("event     ", state.event);
+                printText("sample    ", state.sample);
+            }
+            std::cout << std::flush;
+            if (reader.writerClosed()) {
+                std::cout << "Gateway has stopped\n";
+                break;
+            }
+            if (watch_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(watch_ms));
+        } while (watch_ms > 0 && running);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -1,82 +1,160 @@
 #include "tcpserver.hpp"
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 #include <errno.h>
 
 namespace altair {
 
-TCPServer::TCPServer(uint16_t port)
+TCPServer::TCPServer(uint16_t port, unsigned shards)
   : port_{port}
+  , shard_count_{shards ? shards : std::max(1u, std::thread::hardware_concurrency())}
 {}
 
 TCPServer::~TCPServer() {
     stop();
-    if (accept_thread_.joinable()) accept_thread_.join();
-    if (server_fd_ >= 0) ::close(server_fd_);
 }
 
-void TCPServer::start() {
-    server_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd_ < 0)
+int TCPServer::openListener() {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
         throw std::runtime_error("TCPServer: socket failed");
 
     int opt = 1;
-    ::setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR,
-                 &opt, sizeof(opt));
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        ::close(fd);
+        throw std::runtime_error("TCPServer: SO_REUSEPORT failed");
+    }
 
     sockaddr_in addr{};
     addr.sin_family      = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
     addr.sin_port        = htons(port_);
 
-    if (::bind(server_fd_, (sockaddr*)&addr, sizeof(addr)) < 0)
+    if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        ::close(fd);
         throw std::runtime_error("TCPServer: bind failed");
+    }
 
-    if (::listen(server_fd_, SOMAXCONN) < 0)
+    if (::listen(fd, SOMAXCONN) < 0) {
+        ::close(fd);
         throw std::runtime_error("TCPServer: listen failed");
+    }
+
+    // Port 0: the other shards must join the port the kernel picked.
+    socklen_t len = sizeof(addr);
+    if (::getsockname(fd, (sockaddr*)&addr, &len) == 0)
+        port_ = ntohs(addr.sin_port);
+
+    return fd;
+}
+
+void TCPServer::start() {
+    if (running_) return;
+
+    try {
+        for (unsigned i = 0; i < shard_count_; ++i) {
+            auto shard = std::make_unique<Shard>();
+            shard->listen_fd = openListener();
+            shards_.push_back(std::move(shard));
+        }
+    }
+    catch (...) {
+        for (auto& shard : shards_) ::close(shard->listen_fd);
+        shards_.clear();
+        throw;
+    }
 
     running_ = true;
-    accept_thread_ = std::thread(&TCPServer::acceptLoop, this);
+    for (auto& shard : shards_) {
+        Shard& s = *shard;
+        s.loop.watch(s.listen_fd, EPOLLIN, [this, &s](uint32_t) {
+            acceptPending(s);
+        });
+        s.thread = std::thread([&s]() { s.loop.run(); });
+    }
 }
 
 void TCPServer::setMessageCallback(MessageCallback cb) {
-    messageCb_ = std::move(cb);
+    messageSink_.cb = std::move(cb);
+    setSink(messageSink_);
+}
+
+void TCPServer::instrument(MetricsRegistry& registry) {
+    metrics_   = LinkMetrics::registerIn(registry, "clients");
+    connected_ = &registry.gauge("altair_clients_connected", "TCP clients connected.");
+    slow_      = &registry.counter("altair_clients_slow_total",
+                                   "Clients disconnected for letting their output queue "
+                                   "fill up.");
 }
 
-void TCPServer::acceptLoop() {
+void TCPServer::setOutputLimit(size_t bytes) {
+    output_limit_ = bytes;
+}
+
+void TCPServer::acceptPending(Shard& shard) {
     while (running_) {
         sockaddr_in client_addr{};
         socklen_t   len = sizeof(client_addr);
-        int client_fd = ::accept(server_fd_,
-                                  (sockaddr*)&client_addr, &len);
-        if (client_fd < 0) {
-            if (running_)
-                std::cerr << "TCPServer accept error: "
-                          << strerror(errno) << "\n";
+        int client_fd = ::accept4(shard.listen_fd, (sockaddr*)&client_addr, &len,
+                                  SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd >= 0) {
+            serve(shard, client_fd);
             continue;
         }
 
-        auto conn = std::make_shared<ClientConnection>(client_fd);
-        conn->onMessage([this, conn](const Packet& p){
-            if (messageCb_) messageCb_(conn, p);
-        });
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+        if (errno == EINTR || errno == ECONNABORTED) continue;
+
+        std::cerr << "TCPServer accept error: " << strerror(errno) << "\n";
+        if (errno == EMFILE || errno == ENFILE) {
+            // The pending connection stays queued and would keep the
+            // listener readable; back off instead of spinning.
+            shard.loop.unwatch(shard.listen_fd);
+            shard.loop.addTimer(EventLoop::Clock::now() + std::chrono::milliseconds(100),
+                                [this, &shard]() {
+                shard.loop.watch(shard.listen_fd, EPOLLIN, [this, &shard](uint32_t) {
+                    acceptPending(shard);
+                });
+            });
+        }
+        return;
+    }
+}
 
-        conn->setDisconnectCallback([this](std::shared_ptr<ClientConnection> client) {
-            if (clientDisconnectedCb_) {
-                clientDisconnectedCb_(client);
-            }
-        });
-        
-        conn->start();
-        
-        // Notify Gateway of new client
-        if (clientConnectedCb_) {
-            clientConnectedCb_(conn);
+void TCPServer::serve(Shard& shard, int client_fd) {
+    auto conn = std::make_shared<ClientConnection>(client_fd);
+    if (attachSink_) attachSink_(*conn, sink_);
+    if (connected_) conn->setMetrics(&metrics_);
+    conn->setOutputLimit(output_limit_, slow_);
+
+    conn->setDisconnectCallback([this](std::shared_ptr<ClientConnection> client) {
+        {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            if (clients_.erase(client) && connected_) connected_->add(-1);
+        }
+        if (clientDisconnectedCb_) {
+            clientDisconnectedCb_(client);
         }
+    });
+
+    {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        clients_.insert(conn);
+        if (connected_) connected_->add(1);
+    }
+
+    // Notify Gateway of new client; its reads start once this returns.
+    if (clientConnectedCb_) {
+        clientConnectedCb_(conn);
     }
+
+    conn->start(shard.loop);
 }
 
 void TCPServer::setClientConnectedCallback(ClientCallback cb) {
@@ -94,7 +172,17 @@ void TCPServer::stop() {
         for (auto& client : clients_) {
             client->stop();
         }
+        clients_.clear();
+        if (connected_) connected_->set(0);
+    }
+
+    for (auto& shard : shards_) shard->loop.stop();
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable()) shard->thread.join();
+        if (shard->listen_fd >= 0) ::close(shard->listen_fd);
     }
+    // Dropping the loops releases the connections they were serving.
+    shards_.clear();
 }
 
-} // namespace altair
\ No newline at end of file
+} // namespace altair
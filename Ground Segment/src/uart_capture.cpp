@@ -0,0 +1,146 @@
+#include "uart_capture.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace altair {
+
+namespace {
+
+std::string errnoText() {
+    return std::strerror(errno);
+}
+
+} // namespace
+
+UartCaptureWriter::UartCaptureWriter(const std::string& path, size_t grow_bytes)
+    : path_(path)
+    , grow_bytes_(std::max<size_t>(grow_bytes, 64 * 1024))
+{
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot create capture " + path + ": " + errnoText());
+    }
+
+    try {
+        reserve(kCaptureHeaderSize);
+    }
+    catch (...) {
+        ::close(fd_);
+        throw;
+    }
+    std::memcpy(map_, kCaptureMagic, sizeof(kCaptureMagic));
+    std::memcpy(map_ + 8, &used_, sizeof(used_));
+}
+
+UartCaptureWriter::~UartCaptureWriter() {
+    if (map_) ::munmap(map_, mapped_);
+    if (fd_ >= 0) {
+        // Drop the unused tail of the last growth step.
+        [[maybe_unused]] int rc = ::ftruncate(fd_, static_cast<off_t>(used_));
+        ::close(fd_);
+    }
+}
+
+void UartCaptureWriter::reserve(size_t need) {
+    if (used_ + need <= mapped_) return;
+
+    // Allocated blocks, not a sparse ftruncate(): a full disk fails here,
+    // not as SIGBUS in append()'s memcpy.
+    size_t size = mapped_ + std::max(grow_bytes_, need);
+    int rc = ::posix_fallocate(fd_, static_cast<off_t>(mapped_),
+                               static_cast<off_t>(size - mapped_));
+    if (rc != 0) {
+        throw std::runtime_error("Cannot grow capture " + path_ + ": " + std::strerror(rc));
+    }
+
+    void* p = map_ ? ::mremap(map_, mapped_, size, MREMAP_MAYMOVE)
+                   : ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Cannot map capture " + path_ + ": " + errnoText());
+    }
+    map_    = static_cast<uint8_t*>(p);
+    mapped_ = size;
+}
+
+void UartCaptureWriter::append(uint8_t sat, CaptureDirection dir,
+                               const uint8_t* data, size_t size) {
+    uint64_t t = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    while (size > 0) {
+        uint16_t n = static_cast<uint16_t>(std::min<size_t>(size, UINT16_MAX));
+        reserve(kCaptureRecordHead + n);
+
+        uint8_t* p = map_ + used_;
+        std::memcpy(p, &t, sizeof(t));
+        p[8] = sat;
+        p[9] = static_cast<uint8_t>(dir);
+        std::memcpy(p + 10, &n, sizeof(n));
+        std::memcpy(p + kCaptureRecordHead, data, n);
+
+        // Publish the record only once it is complete.
+        used_ += kCaptureRecordHead + n;
+        std::memcpy(map_ + 8, &used_, sizeof(used_));
+
+        data += n;
+        size -= n;
+    }
+}
+
+UartCaptureReader::UartCaptureReader(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open capture " + path + ": " + errnoText());
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kCaptureHeaderSize) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a UART capture");
+    }
+
+    mapped_ = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr, mapped_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        throw std::runtime_error("Cannot map capture " + path + ": " + errnoText());
+    }
+    map_ = static_cast<const uint8_t*>(p);
+
+    std::memcpy(&end_, map_ + 8, sizeof(end_));
+    if (std::memcmp(map_, kCaptureMagic, sizeof(kCaptureMagic)) != 0
+        || end_ < kCaptureHeaderSize || end_ > mapped_) {
+        ::munmap(const_cast<uint8_t*>(map_), mapped_);
+        throw std::runtime_error(path + " is not a UART capture");
+    }
+}
+
+UartCaptureReader::~UartCaptureReader() {
+    if (map_) ::munmap(const_cast<uint8_t*>(map_), mapped_);
+}
+
+bool UartCaptureReader::next(CaptureRecord& rec) {
+    if (pos_ + kCaptureRecordHead > end_) return false;
+
+    const uint8_t* p = map_ + pos_;
+    std::memcpy(&rec.t_ns, p, sizeof(rec.t_ns));
+    rec.sat = p[8];
+    rec.dir = static_cast<CaptureDirection>(p[9]);
+    std::memcpy(&rec.size, p + 10, sizeof(rec.size));
+    if (pos_ + kCaptureRecordHead + rec.size > end_) return false;
+
+    rec.data = p + kCaptureRecordHead;
+    pos_ += kCaptureRecordHead + rec.size;
+    return true;
+}
+
+} // namespace altair
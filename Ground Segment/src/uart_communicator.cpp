@@ -0,0 +1,183 @@
+#include "uart_communicator.hpp"
+#include "protocol.hpp"
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <errno.h>
+
+namespace altair {
+
+namespace {
+
+speed_t toSpeed(unsigned baud_rate) {
+    switch (baud_rate) {
+        case 9600:    return B9600;
+        case 19200:   return B19200;
+        case 38400:   return B38400;
+        case 57600:   return B57600;
+        case 115200:  return B115200;
+        case 230400:  return B230400;
+        case 460800:  return B460800;
+        case 921600:  return B921600;
+        default:
+            throw std::runtime_error("Unsupported baud rate: " + std::to_string(baud_rate));
+    }
+}
+
+} // namespace
+
+int openSerialPort(std::string const& device, unsigned baud_rate, bool non_blocking) {
+    int flags = O_RDWR | O_NOCTTY | O_CLOEXEC | (non_blocking ? O_NONBLOCK : 0);
+    int fd = ::open(device.c_str(), flags);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open " + device + ": " + strerror(errno));
+    }
+
+    termios tty{};
+    if (::tcgetattr(fd, &tty) != 0) {
+        ::close(fd);
+        throw std::runtime_error("tcgetattr failed on " + device + ": " + strerror(errno));
+    }
+
+    ::cfmakeraw(&tty);
+    ::cfsetispeed(&tty, toSpeed(baud_rate));
+    ::cfsetospeed(&tty, toSpeed(baud_rate));
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cc[VMIN]  = 1;
+    tty.c_cc[VTIME] = 0;
+
+    if (::tcsetattr(fd, TCSANOW, &tty) != 0) {
+        ::close(fd);
+        throw std::runtime_error("tcsetattr failed on " + device + ": " + strerror(errno));
+    }
+
+    // Drop whatever the device sent before we were listening.
+    ::tcflush(fd, TCIFLUSH);
+    return fd;
+}
+
+PseudoTerminal openPseudoTerminal(const std::string& link_path) {
+    PseudoTerminal pty;
+    pty.master_fd = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (pty.master_fd < 0 || ::grantpt(pty.master_fd) != 0 || ::unlockpt(pty.master_fd) != 0) {
+        throw std::runtime_error(std::string("Failed to create pty: ") + strerror(errno));
+    }
+
+    const char* name = ::ptsname(pty.master_fd);
+    if (!name) {
+        throw std::runtime_error(std::string("ptsname failed: ") + strerror(errno));
+    }
+    pty.slave_path = name;
+
+    // Holding the slave open keeps the master from reporting EPOLLHUP while
+    // no gateway is attached, and lets us put the line in raw mode first so
+    // no byte is echoed or translated.
+    pty.slave_fd = ::open(name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (pty.slave_fd < 0) {
+        throw std::runtime_error("Failed to open " + pty.slave_path + ": " + strerror(errno));
+    }
+
+    termios tty{};
+    ::tcgetattr(pty.slave_fd, &tty);
+    ::cfmakeraw(&tty);
+    ::tcsetattr(pty.slave_fd, TCSANOW, &tty);
+
+    if (!link_path.empty()) {
+        ::unlink(link_path.c_str());
+        if (::symlink(name, link_path.c_str()) != 0) {
+            throw std::runtime_error("Failed to link " + link_path + ": " + strerror(errno));
+        }
+    }
+    return pty;
+}
+
+UartCommunicator::UartCommunicator(std::string const& device, unsigned baud_rate)
+    : device_(device)
+    , baud_rate_(baud_rate)
+{}
+
+UartCommunicator::~UartCommunicator() {
+    stop();
+}
+
+void UartCommunicator::start() {
+    if (running_) return;
+
+    fd_ = openSerialPort(device_, baud_rate_);
+
+    running_ = true;
+    reader_ = std::thread([this]() { readLoop(); });
+}
+
+void UartCommunicator::stop() {
+    running_ = false;
+    if (reader_.joinable()) reader_.join();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void UartCommunicator::onReceive(ReceiveCallback cb) {
+    callback_ = std::move(cb);
+}
+
+void UartCommunicator::send(Packet const& pkt) {
+    if (fd_ < 0) {
+        throw std::runtime_error("UART device not open");
+    }
+
+    auto frame = Protocol::pack(pkt);
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t n = ::write(fd_, frame.data() + sent, frame.size() - sent);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("UART write failed: ") + strerror(errno));
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+void UartCommunicator::readLoop() {
+    FrameDecoder decoder;
+    uint8_t chunk[4096];
+
+    while (running_) {
+        // Poll with a timeout so stop() is noticed without closing the fd
+        // under a blocked read.
+        pollfd pfd{fd_, POLLIN, 0};
+        int rc = ::poll(&pfd, 1, 200);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "[UART] poll error: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (rc == 0) continue;
+
+        ssize_t n = ::read(fd_, chunk, sizeof(chunk));
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            std::cerr << "[UART] Read error: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (n == 0) {
+            std::cerr << "[UART] Device closed" << std::endl;
+            break;
+        }
+
+        decoder.feed(chunk, static_cast<size_t>(n));
+        while (auto pkt = decoder.next()) {
+            if (callback_) callback_(*pkt);
+        }
+    }
+
+    running_ = false;
+}
+
+} // namespace altair
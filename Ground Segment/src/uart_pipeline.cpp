@@ -0,0 +1,59 @@
+#include "uart_pipeline.hpp"
+#include "protocol.hpp"
+
+namespace altair {
+
+UartPipeline::UartPipeline(ThreadPool::ThreadPool& pool,
+                           StoreCallback store,
+                           FanoutCallback fanout)
+    : pool_(pool)
+    , store_(std::move(store))
+    , fanout_(std::move(fanout))
+{
+    auto decodeNode = graph_.add([this](UartFrameBatch& b) { decode(b); });
+    auto frameNode  = graph_.add([this](UartFrameBatch& b) { frame(b); });
+    auto storeNode  = graph_.add([this](UartFrameBatch& b) { this->store(b); },
+                                 ThreadPool::Priority::Low);
+    auto fanoutNode = graph_.add([this](UartFrameBatch& b) { this->fanout(b); },
+                                 ThreadPool::Priority::High);
+
+    graph_.precede(decodeNode, frameNode);
+    graph_.precede(frameNode, storeNode);
+    graph_.precede(frameNode, fanoutNode);
+}
+
+ThreadPool::Future<void> UartPipeline::push(std::vector<uint8_t> chunk) {
+    auto batch = std::make_shared<UartFrameBatch>();
+    batch->raw = std::move(chunk);
+    return graph_.run(pool_, std::move(batch));
+}
+
+void UartPipeline::decode(UartFrameBatch& batch) {
+    decoder_.feed(batch.raw.data(), batch.raw.size());
+    while (auto pkt = decoder_.next()) {
+        batch.packets.push_back(std::move(*pkt));
+    }
+}
+
+void UartPipeline::frame(UartFrameBatch& batch) {
+    batch.framed.reserve(batch.packets.size());
+    for (const auto& pkt : batch.packets) {
+        batch.framed.push_back(Protocol::pack(pkt));
+    }
+}
+
+void UartPipeline::store(UartFrameBatch& batch) {
+    if (!store_) return;
+    for (const auto& pkt : batch.packets) {
+        store_(pkt);
+    }
+}
+
+void UartPipeline::fanout(UartFrameBatch& batch) {
+    if (!fanout_) return;
+    for (const auto& raw : batch.framed) {
+        fanout_(raw);
+    }
+}
+
+} // namespace altair
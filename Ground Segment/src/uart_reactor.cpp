@@ -0,0 +1,266 @@
+#include "uart_reactor.hpp"
+#include "latency.hpp"
+#include "uart_communicator.hpp"
+#include "protocol_defs.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace altair {
+
+namespace {
+
+constexpr auto kReopenDelay = std::chrono::seconds(1);
+
+} // namespace
+
+std::vector<SatelliteConfig> loadSatelliteConfig(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open satellite config " + path);
+    }
+
+    std::vector<SatelliteConfig> satellites;
+    std::string line;
+    for (int lineno = 1; std::getline(in, line); ++lineno) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+
+        int id;
+        SatelliteConfig sat;
+        if (!(fields >> id)) continue;      // blank or comment
+        if (!(fields >> sat.device) || id < 0 || id >= PROTO_SAT_ALL) {
+            throw std::runtime_error(path + ":" + std::to_string(lineno)
+                                     + ": expected '<id 0-254> <device> [baud]'");
+        }
+        fields >> sat.baud_rate;
+        sat.id = static_cast<uint8_t>(id);
+
+        for (const auto& other : satellites) {
+            if (other.id == sat.id) {
+                throw std::runtime_error(path + ":" + std::to_string(lineno)
+                                         + ": duplicate satellite id " + std::to_string(id));
+            }
+        }
+        satellites.push_back(sat);
+    }
+
+    if (satellites.empty()) {
+        throw std::runtime_error("No satellites in " + path);
+    }
+    return satellites;
+}
+
+UartReactor::UartReactor(std::vector<SatelliteConfig> satellites) {
+    for (auto& sat : satellites) {
+        order_.push_back(sat.id);
+        auto dev = std::make_unique<Device>();
+        dev->config = std::move(sat);
+        devices_.emplace(dev->config.id, std::move(dev));
+    }
+}
+
+UartReactor::~UartReactor() {
+    stop();
+}
+
+void UartReactor::start() {
+    if (running_) return;
+
+    size_t opened = 0;
+    for (auto& [id, dev] : devices_) {
+        if (open(*dev)) ++opened;
+        else scheduleReopen(*dev);
+    }
+    if (opened == 0) {
+        for (auto& [id, dev] : devices_) close(*dev);
+        throw std::runtime_error("UartReactor: no device could be opened");
+    }
+
+    running_ = true;
+    thread_ = std::thread([this]() {
+        // Devices opened above are announced from the reactor thread, like
+        // later reopens.
+        for (auto& [id, dev] : devices_) {
+            if (dev->fd >= 0 && open_cb_) open_cb_(id);
+        }
+        loop_.run();
+    });
+}
+
+void UartReactor::stop() {
+    if (!running_.exchange(false)) return;
+
+    loop_.stop();
+    if (thread_.joinable()) thread_.join();
+    for (auto& [id, dev] : devices_) close(*dev);
+}
+
+bool UartReactor::send(uint8_t sat, const Packet& pkt) {
+    if (sat != PROTO_SAT_ALL && devices_.find(sat) == devices_.end()) return false;
+
+    auto frame = Protocol::pack(pkt);
+    loop_.post([this, sat, frame = std::move(frame)]() {
+        if (sat == PROTO_SAT_ALL) {
+            for (auto& [id, dev] : devices_) queue(*dev, frame);
+        } else {
+            queue(*devices_.at(sat), frame);
+        }
+    });
+    return true;
+}
+
+void UartReactor::record(const std::string& capture_path) {
+    capture_ = std::make_unique<UartCaptureWriter>(capture_path);
+}
+
+void UartReactor::instrument(MetricsRegistry& registry) {
+    for (auto& [id, dev] : devices_) {
+        dev->metrics    = LinkMetrics::registerIn(registry, "sat" + std::to_string(id));
+        dev->tx_backlog = &registry.gauge("altair_uart_tx_backlog_bytes",
+                                          "Bytes queued for the satellite link, not yet written.",
+                                          {{"sat", std::to_string(id)}});
+    }
+}
+
+bool UartReactor::open(Device& dev) {
+    try {
+        dev.fd = openSerialPort(dev.config.device, dev.config.baud_rate, true);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[UART " << int(dev.config.id) << "] " << e.what() << std::endl;
+        return false;
+    }
+
+    dev.decoder = FrameDecoder{&batch_};
+    dev.tally.reset();
+    dev.tx.clear();
+    dev.tx_pos = 0;
+    if (dev.tx_backlog) dev.tx_backlog->set(0);
+    dev.want_write = false;
+    loop_.watch(dev.fd, EPOLLIN, [this, &dev](uint32_t events) { onEvents(dev, events); });
+    return true;
+}
+
+void UartReactor::close(Device& dev) {
+    if (dev.fd < 0) return;
+    loop_.unwatch(dev.fd);
+    ::close(dev.fd);
+    dev.fd = -1;
+}
+
+void UartReactor::scheduleReopen(Device& dev) {
+    loop_.addTimer(EventLoop::Clock::now() + kReopenDelay, [this, &dev]() {
+        if (!running_ || dev.fd >= 0) return;
+        if (open(dev)) {
+            if (open_cb_) open_cb_(dev.config.id);
+        } else {
+            scheduleReopen(dev);
+        }
+    });
+}
+
+void UartReactor::onEvents(Device& dev, uint32_t events) {
+    if (events & EPOLLIN) {
+        uint8_t chunk[4096];
+        for (;;) {
+            ssize_t n = ::read(dev.fd, chunk, sizeof(chunk));
+            if (n > 0) {
+                capture(dev, CaptureDirection::Rx, chunk, static_cast<size_t>(n));
+                // Drained per read, so each packet is stamped with the
+                // read that completed it.
+                dev.decoder.feed(chunk, static_cast<size_t>(n), monotonicNs());
+                drain_(dev.decoder, dev.config.id, sink_);
+                batch_.release();
+                if (dev.tx_backlog) {
+                    dev.metrics.bytes_in->add(static_cast<uint64_t>(n));
+                    dev.tally.report(dev.decoder, dev.metrics);
+                }
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+            std::cerr << "[UART " << int(dev.config.id) << "] "
+                      << (n == 0 ? "Device closed" : strerror(errno)) << std::endl;
+            close(dev);
+            scheduleReopen(dev);
+            return;
+        }
+    }
+
+    if ((events & (EPOLLERR | EPOLLHUP)) && !(events & EPOLLIN)) {
+        std::cerr << "[UART " << int(dev.config.id) << "] Device hung up" << std::endl;
+        close(dev);
+        scheduleReopen(dev);
+        return;
+    }
+
+    if (events & EPOLLOUT) flush(dev);
+}
+
+void UartReactor::capture(Device& dev, CaptureDirection dir, const uint8_t* data,
+                          size_t size) {
+    if (!capture_) return;
+    try {
+        capture_->append(dev.config.id, dir, data, size);
+    }
+    catch (const std::exception& e) {
+        // Recording is a diagnostic; the links keep running without it.
+        std::cerr << "[UART] " << e.what() << "; capture stopped at "
+                  << capture_->size() << " bytes" << std::endl;
+        capture_.reset();
+    }
+}
+
+void UartReactor::queue(Device& dev, const std::vector<uint8_t>& frame) {
+    if (dev.fd < 0) return;     // link down: commands are not buffered across reopen
+    dev.tx.insert(dev.tx.end(), frame.begin(), frame.end());
+    if (dev.tx_backlog) dev.metrics.frames_out->add();
+    flush(dev);
+}
+
+void UartReactor::flush(Device& dev) {
+    while (dev.tx_pos < dev.tx.size()) {
+        ssize_t n = ::write(dev.fd, dev.tx.data() + dev.tx_pos, dev.tx.size() - dev.tx_pos);
+        if (n > 0) {
+            capture(dev, CaptureDirection::Tx, dev.tx.data() + dev.tx_pos,
+                    static_cast<size_t>(n));
+            dev.tx_pos += static_cast<size_t>(n);
+            if (dev.tx_backlog) dev.metrics.bytes_out->add(static_cast<uint64_t>(n));
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        std::cerr << "[UART " << int(dev.config.id) << "] Write error: "
+                  << strerror(errno) << std::endl;
+        dev.tx.clear();
+        dev.tx_pos = 0;
+        break;
+    }
+
+    if (dev.tx_pos == dev.tx.size()) {
+        dev.tx.clear();
+        dev.tx_pos = 0;
+    }
+    if (dev.tx_backlog) dev.tx_backlog->set(static_cast<int64_t>(dev.tx.size() - dev.tx_pos));
+    rearm(dev);
+}
+
+void UartReactor::rearm(Device& dev) {
+    bool want = !dev.tx.empty();
+    if (want == dev.want_write || dev.fd < 0) return;
+    dev.want_write = want;
+    loop_.watch(dev.fd, want ? (EPOLLIN | EPOLLOUT) : EPOLLIN,
+                [this, &dev](uint32_t events) { onEvents(dev, events); });
+}
+
+} // namespace altair
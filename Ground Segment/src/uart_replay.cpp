@@ -0,0 +1,318 @@
+// Replays a UART capture recorded by the gateway (ALTAIR_UART_CAPTURE).
+//
+// Every satellite in the capture gets a pseudo-terminal; the gateway is
+// pointed at them (--link for one, --config for a satellites.conf) and the
+// recorded RX chunks are written back with their original spacing, N
+// times faster, or as fast as the gateway reads them. Bytes the gateway
+// writes back are counted against the recorded TX traffic.
+
+#include "eventloop.hpp"
+#include "uart_capture.hpp"
+#include "uart_communicator.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace altair;
+using Clock = EventLoop::Clock;
+
+namespace {
+
+struct ReplayOptions {
+    std::string capture;
+    std::string link_path;
+    std::string config_path;
+    double      speed{1.0};                 // 0 = as fast as possible
+    unsigned    loops{1};
+    bool        wait_for_gateway{true};
+    std::chrono::seconds wait_timeout{30};
+};
+
+/// One replayed satellite: its pty and the bytes not yet accepted by it.
+struct Link {
+    PseudoTerminal          pty;
+    std::vector<uint8_t>    pending;
+    size_t                  pending_pos{0};
+    bool                    want_write{false};
+    bool                    attached{false};
+    uint64_t                rx_bytes{0};        // replayed towards the gateway
+    uint64_t                tx_bytes{0};        // received from the gateway
+    uint64_t                tx_recorded{0};
+};
+
+constexpr size_t kMaxPending = 64 * 1024;
+
+class Replayer {
+public:
+    explicit Replayer(const ReplayOptions& options)
+        : options_(options)
+        , reader_(options.capture)
+    {
+        CaptureRecord rec;
+        while (reader_.next(rec)) {
+            if (!first_t_) first_t_ = rec.t_ns;
+            last_t_ = rec.t_ns;
+            auto& link = links_[rec.sat];
+            if (!link) link = std::make_unique<Link>();
+            if (rec.dir == CaptureDirection::Rx) {
+                ++records_;
+                capture_rx_ += rec.size;
+            } else {
+                link->tx_recorded += rec.size;
+            }
+        }
+        reader_.rewind();
+        if (links_.empty()) throw std::runtime_error(options.capture + " holds no records");
+        if (!options.link_path.empty() && links_.size() > 1) {
+            throw std::runtime_error("the capture has several satellites; use --config");
+        }
+
+        for (auto& [sat, link] : links_) {
+            link->pty = openPseudoTerminal(options.link_path);
+            uint8_t id = sat;
+            loop_.watch(link->pty.master_fd, EPOLLIN,
+                        [this, id](uint32_t events) { onEvents(id, events); });
+        }
+
+        if (!options.config_path.empty()) {
+            std::ofstream conf(options.config_path);
+            for (auto& [sat, link] : links_) {
+                conf << int(sat) << " " << link->pty.slave_path << "\n";
+            }
+            if (!conf) throw std::runtime_error("Cannot write " + options.config_path);
+        }
+    }
+
+    ~Replayer() {
+        for (auto& [sat, link] : links_) {
+            ::close(link->pty.master_fd);
+            ::close(link->pty.slave_fd);
+        }
+        if (!options_.link_path.empty()) ::unlink(options_.link_path.c_str());
+    }
+
+    void printLinks() const {
+        for (auto& [sat, link] : links_) {
+            std::cout << "Satellite " << int(sat) << " on " << link->pty.slave_path << "\n";
+        }
+        double secs = (last_t_ - first_t_) / 1e9;
+        std::cout << records_ << " RX chunks, " << capture_rx_ << " bytes over "
+                  << std::fixed << std::setprecision(1) << secs << " s\n" << std::flush;
+    }
+
+    /// Replays the capture; returns false if interrupted or the gateway
+    /// never showed up.
+    bool run(const std::atomic<bool>& running) {
+        // The gateway sends TIME_SYNC when it opens a link; wait for that on
+        // every pty so nothing is replayed into a device no one reads.
+        if (options_.wait_for_gateway) {
+            std::cout << "Waiting for the gateway to open the links...\n" << std::flush;
+            auto deadline = Clock::now() + options_.wait_timeout;
+            while (running && !allAttached()) {
+                if (Clock::now() > deadline) {
+                    std::cerr << "The gateway did not open every link in "
+                              << options_.wait_timeout.count() << " s\n";
+                    return false;
+                }
+                loop_.runOnce(std::chrono::milliseconds(100));
+            }
+        }
+
+        started_ = Clock::now();
+        for (unsigned pass = 0; pass < options_.loops && running; ++pass) {
+            reader_.rewind();
+            auto pass_start = Clock::now();
+            CaptureRecord rec;
+            while (running && reader_.next(rec)) {
+                if (rec.dir != CaptureDirection::Rx) continue;
+
+                if (options_.speed > 0) {
+                    auto offset = std::chrono::nanoseconds(
+                        static_cast<int64_t>((rec.t_ns - first_t_) / options_.speed));
+                    auto due = pass_start + std::chrono::duration_cast<Clock::duration>(offset);
+                    while (running && Clock::now() < due) {
+                        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            due - Clock::now());
+                        loop_.runOnce(std::max(wait, std::chrono::milliseconds(0)));
+                    }
+                }
+
+                Link& link = *links_.at(rec.sat);
+                while (running && link.pending.size() - link.pending_pos > kMaxPending) {
+                    loop_.runOnce(std::chrono::milliseconds(100));
+                }
+                link.pending.insert(link.pending.end(), rec.data, rec.data + rec.size);
+                link.rx_bytes += rec.size;
+                flush(rec.sat, link);
+                loop_.runOnce(std::chrono::milliseconds(0));
+            }
+        }
+
+        // Let the last bytes drain and the gateway answer.
+        auto deadline = Clock::now() + std::chrono::seconds(1);
+        while (running && Clock::now() < deadline && !allFlushed()) {
+            loop_.runOnce(std::chrono::milliseconds(50));
+        }
+        finished_ = Clock::now();
+        loop_.runOnce(std::chrono::milliseconds(200));
+        return running;
+    }
+
+    void printSummary() const {
+        double secs = std::chrono::duration<double>(finished_ - started_).count();
+        double span = (last_t_ - first_t_) / 1e9 * options_.loops;
+        uint64_t rx = 0;
+        std::cout << std::fixed << std::setprecision(2);
+        for (auto& [sat, link] : links_) {
+            rx += link->rx_bytes;
+            std::cout << "Satellite " << int(sat) << ": replayed " << link->rx_bytes
+                      << " bytes, gateway wrote " << link->tx_bytes
+                      << " (recorded " << link->tx_recorded * options_.loops << ")\n";
+        }
+        std::cout << "Replayed " << rx << " bytes in " << secs << " s ("
+                  << (secs > 0 ? rx / secs / 1024 : 0) << " KiB/s, "
+                  << (secs > 0 ? span / secs : 0) << "x real time)\n";
+    }
+
+private:
+
+    bool allAttached() const {
+        for (auto& [sat, link] : links_) if (!link->attached) return false;
+        return true;
+    }
+
+    bool allFlushed() const {
+        for (auto& [sat, link] : links_) if (link->pending_pos < link->pending.size()) return false;
+        return true;
+    }
+
+    void onEvents(uint8_t sat, uint32_t events) {
+        Link& link = *links_.at(sat);
+        if (events & EPOLLIN) {
+            uint8_t buf[4096];
+            ssize_t n;
+            while ((n = ::read(link.pty.master_fd, buf, sizeof(buf))) > 0) {
+                link.tx_bytes += static_cast<uint64_t>(n);
+                link.attached = true;
+            }
+        }
+        if (events & EPOLLOUT) flush(sat, link);
+    }
+
+    void flush(uint8_t sat, Link& link) {
+        while (link.pending_pos < link.pending.size()) {
+            ssize_t n = ::write(link.pty.master_fd, link.pending.data() + link.pending_pos,
+                                link.pending.size() - link.pending_pos);
+            if (n > 0) {
+                link.pending_pos += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            throw std::runtime_error(std::string("pty write failed: ") + std::strerror(errno));
+        }
+
+        if (link.pending_pos == link.pending.size()) {
+            link.pending.clear();
+            link.pending_pos = 0;
+        }
+
+        bool want = !link.pending.empty();
+        if (want != link.want_write) {
+            link.want_write = want;
+            loop_.watch(link.pty.master_fd, want ? (EPOLLIN | EPOLLOUT) : EPOLLIN,
+                        [this, sat](uint32_t events) { onEvents(sat, events); });
+        }
+    }
+
+private:
+
+    ReplayOptions                               options_;
+    UartCaptureReader                           reader_;
+    EventLoop                                   loop_;
+    std::map<uint8_t, std::unique_ptr<Link>>    links_;
+    uint64_t                                    first_t_{0};
+    uint64_t                                    last_t_{0};
+    uint64_t                                    records_{0};
+    uint64_t                                    capture_rx_{0};
+    Clock::time_point                           started_;
+    Clock::time_point                           finished_;
+};
+
+std::atomic<bool> running{true};
+
+void signalHandler(int) {
+    running = false;
+}
+
+void usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <capture> [options]\n"
+              << "  --link PATH          symlink the pty to PATH (single-satellite captures)\n"
+              << "  --config FILE        write a satellites.conf for 'gateway <port> -c FILE'\n"
+              << "  --speed N|max        replay N times faster, or unpaced (default 1)\n"
+              << "  --loop N             replay the capture N times (default 1)\n"
+              << "  --no-wait            start without waiting for the gateway\n"
+              << "  --wait-s N           how long to wait for the gateway (default 30)\n"
+              << "Record with: ALTAIR_UART_CAPTURE=run.cap gateway 8064 /dev/ttyUSB0\n"
+              << "Example: " << prog << " run.cap --link /tmp/ttyALTAIR --speed 10\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    ReplayOptions options;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if      (arg == "--link")    options.link_path = value();
+            else if (arg == "--config")  options.config_path = value();
+            else if (arg == "--speed") {
+                std::string v = value();
+                options.speed = v == "max" ? 0.0 : std::stod(v);
+            }
+            else if (arg == "--loop")    options.loops = std::stoul(value());
+            else if (arg == "--no-wait") options.wait_for_gateway = false;
+            else if (arg == "--wait-s")  options.wait_timeout = std::chrono::seconds(std::stoul(value()));
+            else if (arg.rfind("--", 0) == 0 || !options.capture.empty()) {
+                usage(argv[0]);
+                return 1;
+            }
+            else options.capture = arg;
+        }
+        if (options.capture.empty() || options.speed < 0) {
+            usage(argv[0]);
+            return 1;
+        }
+
+        signal(SIGINT, signalHandler);
+        signal(SIGTERM, signalHandler);
+
+        Replayer replayer(options);
+        replayer.printLinks();
+        bool ok = replayer.run(running);
+        replayer.printSummary();
+        return ok ? 0 : 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}